@@ -12,6 +12,7 @@ SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 DRIVER_NAME="CymaxPhoneOutDriver.driver"
 DRIVER_SOURCE="$SCRIPT_DIR/build/$DRIVER_NAME"
 DRIVER_DEST="/Library/Audio/Plug-Ins/HAL/$DRIVER_NAME"
+SHARED_DIR="/Users/Shared/CymaxPhoneOutShared"
 
 # Colors
 RED='\033[0;31m'
@@ -53,6 +54,12 @@ echo "Setting permissions..."
 chown -R root:wheel "$DRIVER_DEST"
 chmod -R 755 "$DRIVER_DEST"
 
+# Pages shared by the driver (running as _coreaudiod) and the menubar app:
+# only the driver writes the directory; the admin group reaches the pages
+echo "Creating $SHARED_DIR..."
+rm -rf "$SHARED_DIR"
+install -d -o _coreaudiod -g admin -m 0755 "$SHARED_DIR"
+
 # Restart coreaudiod
 echo ""
 echo "Restarting Core Audio daemon..."
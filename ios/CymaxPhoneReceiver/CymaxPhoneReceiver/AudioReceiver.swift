@@ -53,8 +53,18 @@ class AudioReceiver {
     // Packet header magic
     private let packetMagic: UInt32 = 0x584D4143  // 'CMAX'
     
-    init(port: UInt16) {
+    // Packet header flags (kPacketFlag* in the driver's UDPSender.hpp)
+    private let flagDTX: UInt16 = 0x0001  // Keepalive for frameCount silent frames
+    private let flagSpectrum: UInt16 = 0x0002  // Band levels, no audio
+    private let flagFECParity: UInt16 = 0x0004  // XOR of a group, no audio
+    
+    // Capability negotiation (CapabilityNegotiation.hpp in the driver)
+    private let negotiationMagic: UInt32 = 0x47454E43  // 'CNEG'
+    private var preferredBufferMs: UInt16
+    
+    init(port: UInt16, preferredBufferMs: Double = 250) {
         self.port = port
+        self.preferredBufferMs = UInt16(min(preferredBufferMs, Double(UInt16.max)))
     }
     
     deinit {
@@ -112,6 +122,14 @@ class AudioReceiver {
         onPacket = handler
     }
     
+    /// Jitter buffer depth advertised to the driver (applies from its next
+    /// negotiation round)
+    func setPreferredBufferMs(_ ms: Double) {
+        statsLock.lock()
+        preferredBufferMs = UInt16(min(ms, Double(UInt16.max)))
+        statsLock.unlock()
+    }
+    
     func getStats() -> AudioReceiverStats {
         statsLock.lock()
         defer { statsLock.unlock() }
@@ -124,7 +142,7 @@ class AudioReceiver {
         connection.stateUpdateHandler = { state in
             switch state {
             case .ready:
-                self.receivePackets(from: connection)
+                self.receivePackets(from: connection, isFirst: true)
             case .failed(let error):
                 print("AudioReceiver: Connection failed - \(error)")
             default:
@@ -135,11 +153,16 @@ class AudioReceiver {
         connection.start(queue: .global(qos: .userInteractive))
     }
     
-    private func receivePackets(from connection: NWConnection) {
+    private func receivePackets(from connection: NWConnection, isFirst: Bool = false) {
         connection.receiveMessage { [weak self] data, _, isComplete, error in
             guard let self = self else { return }
             
-            if let data = data {
+            if let data = data, !self.handleNegotiation(data, on: connection) {
+                // Joined a stream already running: ask the driver to
+                // renegotiate, since it settled on a profile without us
+                if isFirst {
+                    connection.send(content: self.capabilitiesMessage(round: 0), completion: .idempotent)
+                }
                 self.processPacket(data)
             }
             
@@ -153,6 +176,55 @@ class AudioReceiver {
         }
     }
     
+    /// Answer the driver's capability Query
+    /// - Returns: true if the datagram was a negotiation message
+    private func handleNegotiation(_ data: Data, on connection: NWConnection) -> Bool {
+        guard data.count >= 12 else { return false }
+        
+        let (magic, type, round) = data.withUnsafeBytes { buffer -> (UInt32, UInt16, UInt32) in
+            let ptr = buffer.baseAddress!
+            return (ptr.load(fromByteOffset: 0, as: UInt32.self).littleEndian,
+                    ptr.load(fromByteOffset: 6, as: UInt16.self).littleEndian,
+                    ptr.load(fromByteOffset: 8, as: UInt32.self).littleEndian)
+        }
+        guard magic == negotiationMagic else { return false }
+        
+        // 1 = Query; the Select that follows needs nothing from us, since
+        // packet headers carry the format
+        if type == 1 {
+            connection.send(content: capabilitiesMessage(round: round), completion: .idempotent)
+        }
+        return true
+    }
+    
+    /// Capabilities message for the driver
+    /// AudioPlayer plays every payload as Float32 at 48 kHz and has no FEC
+    /// decoder, so that is all this receiver advertises.
+    private func capabilitiesMessage(round: UInt32) -> Data {
+        statsLock.lock()
+        let bufferMs = preferredBufferMs
+        statsLock.unlock()
+        
+        var data = Data(capacity: 56)
+        func append<T: FixedWidthInteger>(_ value: T) {
+            withUnsafeBytes(of: value.littleEndian) { data.append(contentsOf: $0) }
+        }
+        append(negotiationMagic)
+        append(UInt16(1))       // Version
+        append(UInt16(2))       // Capabilities
+        append(round)
+        for rate: UInt32 in [48000, 0, 0, 0, 0, 0, 0, 0] {
+            append(rate)
+        }
+        append(UInt16(2))       // Max channels
+        append(UInt16(1 << 1))  // Formats: Float32
+        append(UInt16(1 << 0))  // Codecs: PCM
+        append(UInt16(1472))    // Max packet bytes
+        append(UInt16(0))       // Max FEC group: none
+        append(bufferMs)
+        return data
+    }
+    
     private func processPacket(_ data: Data) {
         // Parse header (28 bytes)
         guard data.count >= 28 else {
@@ -176,12 +248,31 @@ class AudioReceiver {
             return (magic, sequence, timestamp, sampleRate, channels, frameCount, format, flags)
         }
         
-        guard let (_, sequence, timestamp, sampleRate, channels, frameCount, _, _) = header else {
+        guard let (_, sequence, timestamp, sampleRate, channels, frameCount, _, flags) = header else {
             return
         }
         
-        // Extract audio data
-        let audioData = data.subdata(in: 28..<data.count)
+        // Spectrum side-channel packets carry band levels, not audio, and
+        // reuse the next audio sequence number: keep them out of playback
+        // and out of the loss, reorder and jitter stats
+        if flags & flagSpectrum != 0 {
+            return
+        }
+        
+        // FEC parity packets carry the first sequence number of the group
+        // they protect, so counting them would look like a reorder and then
+        // like a loss. There is no FEC decoder here (none is advertised).
+        if flags & flagFECParity != 0 {
+            return
+        }
+        
+        // Extract audio data. DTX keepalives are header-only and stand in
+        // for frameCount frames of silence; playing that silence keeps the
+        // buffer level where the driver's clock says it should be.
+        let isKeepalive = flags & flagDTX != 0
+        let audioData = isKeepalive
+            ? Data(count: Int(frameCount) * Int(channels) * MemoryLayout<Float>.size)
+            : data.subdata(in: 28..<data.count)
         
         // Update stats
         statsLock.lock()
@@ -202,23 +293,28 @@ class AudioReceiver {
         stats.lastSequence = sequence
         stats.packetsReceived += 1
         
-        // Calculate jitter
+        // Calculate jitter. Keepalives don't arrive at the audio packet
+        // rate, so they are left out and the next interval starts afresh.
         let currentTime = mach_absolute_time()
-        if lastPacketTime > 0 {
-            let timeDiff = Double(currentTime - lastPacketTime) / 1_000_000.0  // Convert to ms approx
-            let expectedInterval = Double(frameCount) / Double(sampleRate) * 1000.0
-            let jitter = abs(timeDiff - expectedInterval)
-            
-            jitterAccumulator += jitter
-            jitterCount += 1
-            
-            if jitterCount >= 100 {
-                stats.jitterMs = jitterAccumulator / Double(jitterCount)
-                jitterAccumulator = 0
-                jitterCount = 0
+        if isKeepalive {
+            lastPacketTime = 0
+        } else {
+            if lastPacketTime > 0 {
+                let timeDiff = Double(currentTime - lastPacketTime) / 1_000_000.0  // Convert to ms approx
+                let expectedInterval = Double(frameCount) / Double(sampleRate) * 1000.0
+                let jitter = abs(timeDiff - expectedInterval)
+                
+                jitterAccumulator += jitter
+                jitterCount += 1
+                
+                if jitterCount >= 100 {
+                    stats.jitterMs = jitterAccumulator / Double(jitterCount)
+                    jitterAccumulator = 0
+                    jitterCount = 0
+                }
             }
+            lastPacketTime = currentTime
         }
-        lastPacketTime = currentTime
         
         statsLock.unlock()
         
@@ -177,7 +177,7 @@ class ReceiverState: ObservableObject {
         
         // Start UDP receiver
         addLog("Starting UDP audio receiver on port 19620...")
-        audioReceiver = AudioReceiver(port: 19620)
+        audioReceiver = AudioReceiver(port: 19620, preferredBufferMs: latencyMode.jitterBufferMs)
         audioReceiver?.start()
         addLog("UDP audio receiver started")
         
@@ -217,6 +217,7 @@ class ReceiverState: ObservableObject {
     func setLatencyMode(_ mode: LatencyMode) {
         latencyMode = mode
         audioPlayer?.setJitterBufferTarget(mode.jitterBufferMs)
+        audioReceiver?.setPreferredBufferMs(mode.jitterBufferMs)
     }
     
     // MARK: - Handlers
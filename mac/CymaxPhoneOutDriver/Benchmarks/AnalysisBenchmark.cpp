@@ -0,0 +1,140 @@
+//
+//  AnalysisBenchmark.cpp
+//  CymaxPhoneOutDriver Benchmarks
+//
+//  CPU cost of metering per second of audio: the analyzers called
+//  directly (interleaved and planar blocks), then the AnalysisThread
+//  following a live ring as the device runs it, by the thread's own CPU
+//  time
+//
+//  The signal is a full-scale 997 Hz sine on every channel, which reads
+//  -3.01 LUFS short-term per channel.
+//
+//  Usage: AnalysisBenchmark [seconds]
+//
+
+#include "AnalysisThread.hpp"
+#include "Benchmark.hpp"
+#include "LevelMeter.hpp"
+#include "RingBuffer.hpp"
+#include "SampleKernels.hpp"
+#include "SpectrumAnalyzer.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr double kSampleRate = 48000.0;
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFramesPerSecond = 48000;
+static constexpr size_t kChunkFrames = AnalysisThread::kChunkFrames;
+static constexpr size_t kPublishFrames = kFramesPerSecond / AnalysisThread::kDefaultPublishRate;
+static constexpr size_t kRenderFrames = 256;
+
+/// One second of the test signal, interleaved and as planes
+struct Signal {
+    Signal() : interleaved(kFramesPerSecond * kChannels), planes(kChannels, std::vector<float>(kFramesPerSecond)) {
+        for (size_t i = 0; i < kFramesPerSecond; ++i) {
+            const float value = static_cast<float>(std::sin(2.0 * M_PI * 997.0 * static_cast<double>(i) / kSampleRate));
+            for (size_t c = 0; c < kChannels; ++c) {
+                interleaved[i * kChannels + c] = value;
+                planes[c][i] = value;
+            }
+        }
+    }
+
+    std::vector<float> interleaved;
+    std::vector<std::vector<float>> planes;
+};
+
+/// Nanoseconds an analyzer takes per second of audio, fed in the analysis
+/// thread's chunks and published at its default rate
+static double nanosPerAudioSecond(AudioAnalyzer& analyzer, const Signal& signal, bool planar) {
+    analyzer.prepare(kSampleRate, kChannels, kChunkFrames);
+    size_t position = 0;
+    size_t sincePublish = 0;
+    const size_t chunksPerSecond = kFramesPerSecond / kChunkFrames;
+    const double perSecond = Benchmark::nanosPerCall(chunksPerSecond, [&] {
+        if (position + kChunkFrames > kFramesPerSecond) {
+            position = 0;
+        }
+        if (planar) {
+            const float* planes[kChannels];
+            for (size_t c = 0; c < kChannels; ++c) {
+                planes[c] = signal.planes[c].data() + position;
+            }
+            analyzer.processPlanar(planes, kChunkFrames);
+        } else {
+            analyzer.process(signal.interleaved.data() + position * kChannels, kChunkFrames);
+        }
+        position += kChunkFrames;
+        sincePublish += kChunkFrames;
+        if (sincePublish >= kPublishFrames) {
+            analyzer.publish();
+            sincePublish -= kPublishFrames;
+        }
+    }) * static_cast<double>(chunksPerSecond);
+    // Whole chunks fall short of a second by the remainder; scale it back
+    return perSecond * static_cast<double>(kFramesPerSecond) / static_cast<double>(chunksPerSecond * kChunkFrames);
+}
+
+/// The analysis thread on a ring written in render-sized blocks in real time
+static void runThread(RingLayout layout, const Signal& signal, int seconds) {
+    RingBuffer<float> ring(kFramesPerSecond, kChannels, RingStorage::Native, nullptr, layout);
+    LevelMeter levelMeter;
+    SpectrumAnalyzer spectrumAnalyzer;
+    AnalysisThread analysis;
+    analysis.initialize(&ring, kSampleRate);
+    analysis.addAnalyzer(&levelMeter);
+    analysis.addAnalyzer(&spectrumAnalyzer);
+    analysis.start();
+
+    const auto period = std::chrono::nanoseconds(static_cast<int64_t>(1e9 * kRenderFrames / kSampleRate));
+    const auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    size_t position = 0;
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(seconds)) {
+        ring.write(signal.interleaved.data() + position * kChannels, kRenderFrames);
+        position = position + 2 * kRenderFrames <= kFramesPerSecond ? position + kRenderFrames : 0;
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Let the tap catch up
+    analysis.stop();
+
+    const LevelMeterSnapshot meters = levelMeter.latest();
+    std::printf("  %-22s %12.0f %10llu %12.2f\n", layout == RingLayout::Planar ? "planar ring" : "interleaved ring",
+                analysis.cpuMicrosPerAudioSecond() * 1000.0,
+                static_cast<unsigned long long>(analysis.framesSkipped()), meters.shortTermLUFS[0]);
+}
+
+int main(int argc, char** argv) {
+    const int seconds = argc > 1 ? std::atoi(argv[1]) : 5;
+
+    Kernels::initialize();
+    const Signal signal;
+    std::printf("Analysis, %.0f Hz %zu ch, %zu-frame chunks, %u Hz publish, kernels: %s\n", kSampleRate, kChannels,
+                kChunkFrames, AnalysisThread::kDefaultPublishRate, Kernels::active().name);
+
+    std::printf("\nAnalyzers called directly (ns per second of audio)\n");
+    std::printf("  %-22s %12s %12s\n", "analyzer", "interleaved", "planar");
+    LevelMeter levelMeter;
+    const double meterInterleaved = nanosPerAudioSecond(levelMeter, signal, false);
+    const double meterPlanar = nanosPerAudioSecond(levelMeter, signal, true);
+    std::printf("  %-22s %12.0f %12.0f\n", "LevelMeter", meterInterleaved, meterPlanar);
+    SpectrumAnalyzer spectrumAnalyzer;
+    const double spectrumInterleaved = nanosPerAudioSecond(spectrumAnalyzer, signal, false);
+    const double spectrumPlanar = nanosPerAudioSecond(spectrumAnalyzer, signal, true);
+    std::printf("  %-22s %12.0f %12.0f\n", "SpectrumAnalyzer", spectrumInterleaved, spectrumPlanar);
+
+    std::printf("\nAnalysisThread with both, %d s in real time (thread CPU time)\n", seconds);
+    std::printf("  %-22s %12s %10s %12s\n", "ring", "ns/s audio", "skipped", "LUFS (ch 1)");
+    runThread(RingLayout::Interleaved, signal, seconds);
+    runThread(RingLayout::Planar, signal, seconds);
+    return 0;
+}
@@ -0,0 +1,107 @@
+//
+//  Benchmark.hpp
+//  CymaxPhoneOutDriver Benchmarks
+//
+//  Minimal timing helpers shared by the benchmark executables
+//
+
+#ifndef Benchmark_hpp
+#define Benchmark_hpp
+
+#include "MonotonicClock.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Cymax {
+namespace Benchmark {
+
+/// Keep a value alive so the optimizer can't drop the work producing it
+template <typename T>
+inline void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+/// Nanoseconds per call of body(), best of several repetitions (the
+/// least disturbed by other work on the machine)
+template <typename Body>
+double nanosPerCall(size_t iterations, Body&& body, int repetitions = 5) {
+    for (size_t i = 0; i < iterations / 10 + 1; ++i) {
+        body();  // Warm caches and branch predictors
+    }
+    double best = 0.0;
+    for (int r = 0; r < repetitions; ++r) {
+        const uint64_t start = MonotonicClock::nowNanos();
+        for (size_t i = 0; i < iterations; ++i) {
+            body();
+        }
+        const double perCall = static_cast<double>(MonotonicClock::nowNanos() - start) / static_cast<double>(iterations);
+        best = r == 0 ? perCall : std::min(best, perCall);
+    }
+    return best;
+}
+
+/// Resident memory of this process in KB
+inline double residentKB() {
+#if defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) !=
+        KERN_SUCCESS) {
+        return 0.0;
+    }
+    return static_cast<double>(info.resident_size) / 1024.0;
+#else
+    long pages = 0;
+    long resident = 0;
+    if (FILE* statm = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(statm, "%ld %ld", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        std::fclose(statm);
+    }
+    return static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE)) / 1024.0;
+#endif
+}
+
+/// Threads in this process
+inline int threadCount() {
+#if defined(__APPLE__)
+    thread_act_array_t threads = nullptr;
+    mach_msg_type_number_t count = 0;
+    if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    for (mach_msg_type_number_t i = 0; i < count; ++i) {
+        mach_port_deallocate(mach_task_self(), threads[i]);
+    }
+    vm_deallocate(mach_task_self(), reinterpret_cast<vm_address_t>(threads), count * sizeof(thread_act_t));
+    return static_cast<int>(count);
+#else
+    int count = 0;
+    if (FILE* status = std::fopen("/proc/self/status", "r")) {
+        char line[256];
+        while (std::fgets(line, sizeof(line), status)) {
+            if (std::strncmp(line, "Threads:", 8) == 0) {
+                count = std::atoi(line + 8);
+            }
+        }
+        std::fclose(status);
+    }
+    return count;
+#endif
+}
+
+} // namespace Benchmark
+} // namespace Cymax
+
+#endif /* Benchmark_hpp */
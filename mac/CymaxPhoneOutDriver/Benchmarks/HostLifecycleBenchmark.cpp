@@ -0,0 +1,225 @@
+//
+//  HostLifecycleBenchmark.cpp
+//  CymaxPhoneOutDriver Benchmarks
+//
+//  Resident memory and threads of the streaming core through a host's
+//  lifecycle (loaded and idle, a few IO sessions, idle again), with the
+//  stream resources allocated eagerly at load and lazily on first start
+//  and freed after an idle period
+//
+//  SimulatedDevice builds the same pieces AudioDevice does (one locked
+//  arena holding both rings, the sender, the analysis thread and its
+//  analyzers) in the same order, since AudioDevice itself needs CoreAudio.
+//  Its idle teardown runs inline once the gap between sessions has passed
+//  the idle period.
+//
+//  Usage: HostLifecycleBenchmark [sessions] [sessionMs] [gapMs]
+//
+
+#include "AnalysisThread.hpp"
+#include "Benchmark.hpp"
+#include "LevelMeter.hpp"
+#include "PacketRing.hpp"
+#include "RealtimeArena.hpp"
+#include "ReplayBuffer.hpp"
+#include "RingBuffer.hpp"
+#include "SampleKernels.hpp"
+#include "SpectrumAnalyzer.hpp"
+#include "UDPSender.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using namespace Cymax;
+
+static constexpr size_t kRingBufferFrames = 48000;
+static constexpr size_t kFramesPerPacket = 128;
+static constexpr size_t kPacketRingSlots = 128;
+static constexpr size_t kRenderFrames = 256;
+static constexpr double kSampleRate = 48000.0;
+
+/// The device's stream resources, without the HAL object model
+class SimulatedDevice {
+public:
+    explicit SimulatedDevice(bool lazy) : m_lazy(lazy) {
+        if (!m_lazy) {
+            allocate();
+        }
+    }
+
+    ~SimulatedDevice() {
+        stopIO();
+        if (m_analysisThread) {
+            m_analysisThread->stop();
+        }
+        release();
+    }
+
+    bool startIO() {
+        if (!allocate()) {
+            return false;
+        }
+        m_sender.waitUntilIdle();
+        m_ringBuffer->reset();
+        m_packetRing->reset();
+        m_sender.start();
+        m_analysisThread->start();
+        return true;
+    }
+
+    void stopIO() {
+        if (m_ringBuffer) {
+            m_sender.stop();
+            m_analysisThread->stop();
+        }
+    }
+
+    /// What doIOOperation does with a WriteMix buffer
+    void render(const float* audio, size_t frames) {
+        m_ringBuffer->write(audio, frames);
+        m_packetRing->write(audio, frames);
+    }
+
+    /// The idle thread's teardown (lazy only)
+    void idleTeardown() {
+        if (m_lazy) {
+            release();
+        }
+    }
+
+private:
+    bool allocate() {
+        if (m_ringBuffer) {
+            return true;
+        }
+        const RingLayout layout = Kernels::active().isa == Kernels::ISA::Scalar ? RingLayout::Interleaved
+                                                                                 : RingLayout::Planar;
+        const size_t arenaBytes =
+            RealtimeArena::footprint(sizeof(RingBuffer<float>)) +
+            RingBuffer<float>::storageBytes(kRingBufferFrames, 2, RingStorage::Native, layout) +
+            RealtimeArena::footprint(sizeof(PacketRing)) +
+            PacketRing::storageBytes(kPacketRingSlots, kFramesPerPacket, 2, kPacketHeaderBytes);
+        if (!m_arena.reserve(arenaBytes)) {
+            return false;
+        }
+        m_ringBuffer = m_arena.make<RingBuffer<float>>(kRingBufferFrames, 2, RingStorage::Native, &m_arena, layout);
+        m_packetRing = m_arena.make<PacketRing>(kPacketRingSlots, kFramesPerPacket, 2, kPacketHeaderBytes, &m_arena);
+
+        UDPSenderConfig config;
+        config.framesPerPacket = kFramesPerPacket;
+        if (!m_ringBuffer || !m_packetRing || !m_sender.initialize(m_ringBuffer.get(), config) ||
+            !m_sender.setDestination("null:")) {
+            release();
+            return false;
+        }
+        m_sender.setPacketRing(m_packetRing.get());
+
+        // Created once and kept, as in the device
+        if (!m_analysisThread) {
+            m_analysisThread = std::make_unique<AnalysisThread>();
+            m_analysisThread->initialize(m_ringBuffer.get(), kSampleRate);
+            m_analysisThread->addAnalyzer(&m_levelMeter);
+            m_analysisThread->addAnalyzer(&m_spectrumAnalyzer);
+            m_analysisThread->addAnalyzer(&m_replayBuffer);
+        } else {
+            m_analysisThread->initialize(m_ringBuffer.get(), kSampleRate);
+        }
+        return true;
+    }
+
+    void release() {
+        m_sender.releaseResources();
+        m_packetRing.reset();
+        m_ringBuffer.reset();
+        m_arena.release();
+    }
+
+    bool m_lazy;
+    LevelMeter m_levelMeter;
+    SpectrumAnalyzer m_spectrumAnalyzer;
+    ReplayBuffer m_replayBuffer;
+    UDPSender m_sender;
+    RealtimeArena m_arena;
+    ArenaPtr<RingBuffer<float>> m_ringBuffer;
+    ArenaPtr<PacketRing> m_packetRing;
+    std::unique_ptr<AnalysisThread> m_analysisThread;
+};
+
+static double microsSince(uint64_t startNanos) {
+    return static_cast<double>(MonotonicClock::nowNanos() - startNanos) / 1000.0;
+}
+
+static bool run(bool lazy, int sessions, int sessionMs, int gapMs) {
+    std::vector<float> block(kRenderFrames * 2);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = 0.25f * std::sin(static_cast<float>(i) * 0.05f);
+    }
+
+    std::printf("\n%s\n", lazy ? "lazy (allocate on start, free when idle)" : "eager (allocate at load)");
+    const double baseline = Benchmark::residentKB();
+    std::unique_ptr<SimulatedDevice> device = std::make_unique<SimulatedDevice>(lazy);
+    std::printf("  loaded            %+8.0f KB, %d threads\n", Benchmark::residentKB() - baseline,
+                Benchmark::threadCount());
+
+    const auto period = std::chrono::nanoseconds(static_cast<int64_t>(1e9 * kRenderFrames / kSampleRate));
+    for (int session = 0; session < sessions; ++session) {
+        uint64_t faults = currentThreadMinorFaults();
+        const uint64_t began = MonotonicClock::nowNanos();
+        if (!device->startIO()) {
+            std::fprintf(stderr, "HostLifecycleBenchmark: stream resources failed to allocate\n");
+            return false;
+        }
+        const double startMicros = microsSince(began);
+        const uint64_t startFaults = currentThreadMinorFaults() - faults;
+
+        faults = currentThreadMinorFaults();
+        device->render(block.data(), kRenderFrames);
+        const uint64_t firstCycleFaults = currentThreadMinorFaults() - faults;
+
+        const auto start = std::chrono::steady_clock::now();
+        auto next = start;
+        while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(sessionMs)) {
+            next += period;
+            std::this_thread::sleep_until(next);
+            device->render(block.data(), kRenderFrames);
+        }
+        std::printf("  session %d         %+8.0f KB, %d threads; startIO %6.0f us (%llu faults), "
+                    "first cycle %llu faults\n",
+                    session, Benchmark::residentKB() - baseline, Benchmark::threadCount(), startMicros,
+                    static_cast<unsigned long long>(startFaults), static_cast<unsigned long long>(firstCycleFaults));
+
+        device->stopIO();
+        std::this_thread::sleep_for(std::chrono::milliseconds(gapMs));
+        device->idleTeardown();
+        std::printf("  idle              %+8.0f KB, %d threads\n", Benchmark::residentKB() - baseline,
+                    Benchmark::threadCount());
+    }
+    device.reset();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const int sessions = argc > 1 ? std::atoi(argv[1]) : 3;
+    const int sessionMs = argc > 2 ? std::atoi(argv[2]) : 1000;
+    const int gapMs = argc > 3 ? std::atoi(argv[3]) : 500;
+
+    Kernels::initialize();  // As the plug-in entry point does; the ring layout depends on it
+#if defined(__GLIBC__)
+    // macOS malloc hands large blocks back to the system; make glibc do the
+    // same so freed resources show up in the resident size
+    mallopt(M_MMAP_THRESHOLD, 64 * 1024);
+#endif
+
+    std::printf("Stream resources through %d sessions of %d ms, %d ms idle between them (KB vs before load)\n",
+                sessions, sessionMs, gapMs);
+    return run(false, sessions, sessionMs, gapMs) && run(true, sessions, sessionMs, gapMs) ? 0 : 1;
+}
@@ -0,0 +1,231 @@
+//
+//  JoinBenchmark.cpp
+//  CymaxPhoneOutDriver Benchmarks
+//
+//  Measures time-to-first-audio for a receiver that resyncs mid-stream:
+//  a loopback receiver negotiates, listens for a second, then asks to
+//  resync (unsolicited Capabilities) and times how long its emptied
+//  buffer takes to hold its target depth again. Run with the pre-roll
+//  off and on.
+//
+//  Usage: JoinBenchmark [bufferMs] [trials]
+//
+
+#include "Benchmark.hpp"
+#include "CapabilityNegotiation.hpp"
+#include "RingBuffer.hpp"
+#include "UDPSender.hpp"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr size_t kRenderFrames = 256;
+static constexpr int kSettleMs = 1200;  // Past the sender's minimum round interval
+
+static double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// Loopback receiver on the audio port: answers queries, counts frames
+class Receiver {
+public:
+    bool open(uint16_t port, uint16_t bufferMs) {
+        m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        struct sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        if (m_socket < 0 || bind(m_socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            return false;
+        }
+        struct timeval timeout = {0, 10000};
+        setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        m_capabilities = ReceiverCapabilities();
+        m_capabilities.maxChannels = 2;
+        m_capabilities.formats = (1u << kSampleFormatFloat32) | (1u << kSampleFormatInt16);
+        m_capabilities.codecs = 1u << kCodecPCM;
+        m_capabilities.maxPacketBytes = 1500;
+        m_capabilities.bufferMs = bufferMs;
+        return true;
+    }
+
+    ~Receiver() {
+        if (m_socket >= 0) {
+            close(m_socket);
+        }
+    }
+
+    /// Read for a while, answering queries
+    /// @return Audio frames received (DTX keepalives count their frames)
+    uint64_t receive(double forMillis) {
+        const auto start = std::chrono::steady_clock::now();
+        uint64_t frames = 0;
+        while (millisSince(start) < forMillis) {
+            frames += receiveOne();
+        }
+        return frames;
+    }
+
+    /// Ask to resync, then time until frames worth bufferMs arrived
+    /// @return Milliseconds, or a negative value if they never did
+    double timeToDepth(uint32_t sampleRate, double timeoutMs) {
+        sendCapabilities(0);
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t target = static_cast<uint64_t>(m_capabilities.bufferMs) * sampleRate / 1000;
+        uint64_t frames = 0;
+        while (millisSince(start) < timeoutMs) {
+            frames += receiveOne();
+            if (frames >= target) {
+                return millisSince(start);
+            }
+        }
+        return -1.0;
+    }
+
+private:
+    uint64_t receiveOne() {
+        uint8_t packet[2048];
+        struct sockaddr_in from;
+        socklen_t length = sizeof(from);
+        const ssize_t size = recvfrom(m_socket, packet, sizeof(packet), 0, reinterpret_cast<sockaddr*>(&from), &length);
+        if (size < static_cast<ssize_t>(sizeof(uint32_t))) {
+            return 0;
+        }
+        m_sender = from;
+        m_haveSender = true;
+
+        uint32_t magic = 0;
+        std::memcpy(&magic, packet, sizeof(magic));
+        if (magic == NegotiationHeader::kMagic && static_cast<size_t>(size) >= sizeof(NegotiationHeader)) {
+            NegotiationHeader header;
+            std::memcpy(&header, packet, sizeof(header));
+            if (header.type == static_cast<uint16_t>(NegotiationMessage::Query)) {
+                sendCapabilities(header.round);
+            }
+            return 0;
+        }
+        if (size < static_cast<ssize_t>(kPacketHeaderBytes)) {
+            return 0;
+        }
+
+        // frameCount and flags of the audio header (see UDPSender.cpp)
+        uint16_t frameCount = 0;
+        uint16_t flags = 0;
+        std::memcpy(&frameCount, packet + 22, sizeof(frameCount));
+        std::memcpy(&flags, packet + 26, sizeof(flags));
+        return (flags & (kPacketFlagSpectrum | kPacketFlagFECParity)) != 0 ? 0 : frameCount;
+    }
+
+    void sendCapabilities(uint32_t round) {
+        if (!m_haveSender) {
+            return;
+        }
+        NegotiationHeader header;
+        header.magic = NegotiationHeader::kMagic;
+        header.version = NegotiationHeader::kVersion;
+        header.type = static_cast<uint16_t>(NegotiationMessage::Capabilities);
+        header.round = round;
+
+        uint8_t message[sizeof(header) + sizeof(m_capabilities)];
+        std::memcpy(message, &header, sizeof(header));
+        std::memcpy(message + sizeof(header), &m_capabilities, sizeof(m_capabilities));
+        sendto(m_socket, message, sizeof(message), 0, reinterpret_cast<const sockaddr*>(&m_sender), sizeof(m_sender));
+    }
+
+    int m_socket = -1;
+    ReceiverCapabilities m_capabilities = {};
+    struct sockaddr_in m_sender = {};
+    bool m_haveSender = false;
+};
+
+/// One sender session with the given pre-roll; prints its trials
+static bool run(uint16_t preRollMs, uint16_t bufferMs, int trials) {
+    UDPSenderConfig config;
+    config.preRollMs = preRollMs;
+    config.realtimeScheduling = true;  // Falls back if refused
+    RingBuffer<float> ring(config.sampleRate, config.channels);
+
+    Receiver receiver;
+    if (!receiver.open(config.destPort, bufferMs)) {
+        std::fprintf(stderr, "JoinBenchmark: can't bind port %u\n", config.destPort);
+        return false;
+    }
+
+    UDPSender sender;
+    sender.initialize(&ring, config);
+    sender.setDestination("127.0.0.1");
+    if (!sender.start()) {
+        std::fprintf(stderr, "JoinBenchmark: sender failed to start\n");
+        return false;
+    }
+
+    // Render thread stand-in, as in SenderBenchmark
+    std::atomic<bool> rendering{true};
+    std::thread render([&] {
+        std::vector<float> block(kRenderFrames * config.channels);
+        for (size_t i = 0; i < block.size(); ++i) {
+            block[i] = 0.25f * std::sin(static_cast<float>(i) * 0.05f);
+        }
+        const auto period = std::chrono::nanoseconds(1000000000LL * kRenderFrames / config.sampleRate);
+        auto next = std::chrono::steady_clock::now();
+        while (rendering.load(std::memory_order_relaxed)) {
+            ring.write(block.data(), kRenderFrames);
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    std::vector<double> times;
+    int missed = 0;
+    for (int trial = 0; trial < trials; ++trial) {
+        receiver.receive(kSettleMs);
+        const double ms = receiver.timeToDepth(config.sampleRate, 4.0 * bufferMs + 500.0);
+        if (ms < 0.0) {
+            ++missed;
+        } else {
+            times.push_back(ms);
+        }
+    }
+
+    rendering.store(false, std::memory_order_relaxed);
+    render.join();
+    sender.stop();
+    sender.waitUntilIdle();
+
+    double mean = 0.0;
+    double worst = 0.0;
+    for (double ms : times) {
+        mean += ms / static_cast<double>(times.size());
+        worst = std::max(worst, ms);
+    }
+    std::printf("  pre-roll %3u ms: %d trials, time to %u ms buffered mean %6.1f ms, max %6.1f ms, "
+                "%d missed, %llu pre-roll packets in %llu bursts\n",
+                preRollMs, trials, bufferMs, mean, worst, missed,
+                static_cast<unsigned long long>(sender.preRollPacketsSent()),
+                static_cast<unsigned long long>(sender.preRollBursts()));
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const uint16_t bufferMs = static_cast<uint16_t>(argc > 1 ? std::atoi(argv[1]) : 100);
+    const int trials = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    std::printf("UDPSender resync to a %u ms receiver over loopback\n", bufferMs);
+    const UDPSenderConfig defaults;
+    return run(0, bufferMs, trials) && run(defaults.preRollMs, bufferMs, trials) ? 0 : 1;
+}
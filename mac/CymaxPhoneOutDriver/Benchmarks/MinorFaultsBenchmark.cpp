@@ -0,0 +1,120 @@
+//
+//  MinorFaultsBenchmark.cpp
+//  CymaxPhoneOutDriver Benchmarks
+//
+//  Minor page faults taken by the render and sending threads over several
+//  IO sessions, with both rings in a locked RealtimeArena (as the device
+//  allocates them) and with them on the heap
+//
+//  The render thread counts its own faults around its first cycle and
+//  over the rest of the session; the sending thread's are the sender's
+//  steadyStateMinorFaults(). The sender's session buffers always come from
+//  its own arena, so only the rings change between the two runs. macOS
+//  counts faults per process, so there any nonzero count is an upper
+//  bound, and zero is still zero.
+//
+//  Usage: MinorFaultsBenchmark [sessions] [sessionMs]
+//
+
+#include "Benchmark.hpp"
+#include "PacketRing.hpp"
+#include "RealtimeArena.hpp"
+#include "RingBuffer.hpp"
+#include "UDPSender.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr size_t kRingBufferFrames = 48000;
+static constexpr size_t kFramesPerPacket = 128;
+static constexpr size_t kPacketRingSlots = 128;
+static constexpr size_t kRenderFrames = 256;
+
+static bool run(bool useArena, int sessions, int sessionMs) {
+    RealtimeArena arena;
+    if (useArena) {
+        const size_t arenaBytes = RingBuffer<float>::storageBytes(kRingBufferFrames, 2) +
+                                  PacketRing::storageBytes(kPacketRingSlots, kFramesPerPacket, 2, kPacketHeaderBytes);
+        if (!arena.reserve(arenaBytes)) {
+            std::fprintf(stderr, "MinorFaultsBenchmark: can't reserve the arena\n");
+            return false;
+        }
+    }
+    RealtimeArena* ringArena = useArena ? &arena : nullptr;
+    RingBuffer<float> ring(kRingBufferFrames, 2, RingStorage::Native, ringArena);
+    PacketRing packetRing(kPacketRingSlots, kFramesPerPacket, 2, kPacketHeaderBytes, ringArena);
+
+    UDPSenderConfig config;
+    config.framesPerPacket = kFramesPerPacket;
+    UDPSender sender;
+    if (!sender.initialize(&ring, config) || !sender.setDestination("null:")) {
+        std::fprintf(stderr, "MinorFaultsBenchmark: sender failed to initialize\n");
+        return false;
+    }
+    sender.setPacketRing(&packetRing);
+
+    std::printf("\n%s: %zu KB %s\n", useArena ? "rings in the arena" : "rings on the heap",
+                useArena ? arena.capacity() / 1024 : 0, arena.isLocked() ? "locked" : "not locked");
+    std::printf("  %-8s %12s %12s %12s %10s\n", "session", "render 1st", "render rest", "sender", "packets");
+
+    const auto period = std::chrono::nanoseconds(1000000000LL * kRenderFrames / config.sampleRate);
+    // Session -1 isn't printed: the first pass through the render and send
+    // paths faults in their code pages, arena or not
+    for (int session = -1; session < sessions; ++session) {
+        sender.waitUntilIdle();
+        ring.reset();
+        packetRing.reset();
+        sender.start();
+
+        uint64_t firstCycleFaults = 0;
+        uint64_t steadyFaults = 0;
+        std::thread render([&] {
+            std::vector<float> block(kRenderFrames * 2);
+            for (size_t i = 0; i < block.size(); ++i) {
+                block[i] = 0.25f * std::sin(static_cast<float>(i) * 0.05f);
+            }
+            const uint64_t before = currentThreadMinorFaults();
+            ring.write(block.data(), kRenderFrames);
+            packetRing.write(block.data(), kRenderFrames);
+            const uint64_t afterFirst = currentThreadMinorFaults();
+
+            const auto start = std::chrono::steady_clock::now();
+            auto next = start;
+            while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(sessionMs)) {
+                next += period;
+                std::this_thread::sleep_until(next);
+                ring.write(block.data(), kRenderFrames);
+                packetRing.write(block.data(), kRenderFrames);
+            }
+            firstCycleFaults = afterFirst - before;
+            steadyFaults = currentThreadMinorFaults() - afterFirst;
+        });
+        render.join();
+
+        sender.stop();
+        sender.waitUntilIdle();  // Publishes the session's final fault count
+        if (session < 0) {
+            continue;
+        }
+        std::printf("  %-8d %12llu %12llu %12llu %10llu\n", session,
+                    static_cast<unsigned long long>(firstCycleFaults), static_cast<unsigned long long>(steadyFaults),
+                    static_cast<unsigned long long>(sender.steadyStateMinorFaults()),
+                    static_cast<unsigned long long>(sender.packetsSent()));
+    }
+    sender.releaseResources();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const int sessions = argc > 1 ? std::atoi(argv[1]) : 3;
+    const int sessionMs = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+    std::printf("Minor faults per thread, %d sessions of %d ms to null:\n", sessions, sessionMs);
+    return run(true, sessions, sessionMs) && run(false, sessions, sessionMs) ? 0 : 1;
+}
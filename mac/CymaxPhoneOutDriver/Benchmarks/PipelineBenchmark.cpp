@@ -0,0 +1,220 @@
+//
+//  PipelineBenchmark.cpp
+//  CymaxPhoneOutDriver Benchmarks
+//
+//  The whole output path with the replay buffer's lossless codec running,
+//  on an interleaved ring and on a planar one: the render write (sample
+//  ring and packet ring), each analysis tap called directly, then the
+//  device's pipeline in real time (render writes, the sender to null: and
+//  the AnalysisThread with LevelMeter, SpectrumAnalyzer and ReplayBuffer)
+//  measured by the process's CPU time
+//
+//  The signal is a chord with a slow tremolo, so the codec sees something
+//  closer to program material than a single sine.
+//
+//  Usage: PipelineBenchmark [seconds]
+//
+
+#include "AnalysisThread.hpp"
+#include "Benchmark.hpp"
+#include "LevelMeter.hpp"
+#include "PacketRing.hpp"
+#include "ReplayBuffer.hpp"
+#include "RingBuffer.hpp"
+#include "SampleKernels.hpp"
+#include "SpectrumAnalyzer.hpp"
+#include "UDPSender.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr double kSampleRate = 48000.0;
+static constexpr size_t kChannels = 2;
+static constexpr size_t kFramesPerSecond = 48000;
+static constexpr size_t kRingBufferFrames = 48000;
+static constexpr size_t kFramesPerPacket = 128;
+static constexpr size_t kPacketRingSlots = 128;
+static constexpr size_t kRenderFrames = 256;
+static constexpr size_t kChunkFrames = AnalysisThread::kChunkFrames;
+
+static constexpr RingLayout kLayouts[] = {RingLayout::Interleaved, RingLayout::Planar};
+
+static const char* layoutName(RingLayout layout) {
+    return layout == RingLayout::Planar ? "planar" : "interleaved";
+}
+
+/// One second of the test signal, interleaved and as planes
+struct Signal {
+    Signal() : interleaved(kFramesPerSecond * kChannels), planes(kChannels, std::vector<float>(kFramesPerSecond)) {
+        for (size_t i = 0; i < kFramesPerSecond; ++i) {
+            const double t = static_cast<double>(i) / kSampleRate;
+            for (size_t c = 0; c < kChannels; ++c) {
+                const float value = static_cast<float>(0.2 * std::sin(2.0 * M_PI * 220.0 * t) +
+                                                       0.15 * std::sin(2.0 * M_PI * (277.0 + c) * t) +
+                                                       0.1 * std::sin(2.0 * M_PI * 330.0 * t)) *
+                                    static_cast<float>(0.75 + 0.25 * std::sin(2.0 * M_PI * t));
+                interleaved[i * kChannels + c] = value;
+                planes[c][i] = value;
+            }
+        }
+    }
+
+    std::vector<float> interleaved;
+    std::vector<std::vector<float>> planes;
+};
+
+static uint64_t processCpuNanos() {
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+/// Nanoseconds per render block for what doIOOperation writes: the sample
+/// ring (deinterleaved on write when planar) and the packet ring
+static double renderNanos(RingLayout layout, const Signal& signal) {
+    RingBuffer<float> ring(kRingBufferFrames, kChannels, RingStorage::Native, nullptr, layout);
+    PacketRing packetRing(kPacketRingSlots, kFramesPerPacket, kChannels, kPacketHeaderBytes);
+    std::vector<float> sink(kRenderFrames * kChannels);
+    size_t position = 0;
+    return Benchmark::nanosPerCall(20000, [&] {
+        ring.write(signal.interleaved.data() + position * kChannels, kRenderFrames);
+        packetRing.write(signal.interleaved.data() + position * kChannels, kRenderFrames);
+        position = position + 2 * kRenderFrames <= kFramesPerSecond ? position + kRenderFrames : 0;
+        // Nobody reads here; keep the sample ring from filling
+        ring.read(sink.data(), kRenderFrames);
+    });
+}
+
+/// Nanoseconds an analyzer takes per second of audio in the analysis
+/// thread's chunks, handed over as the ring layout would
+static double nanosPerAudioSecond(AudioAnalyzer& analyzer, const Signal& signal, RingLayout layout) {
+    analyzer.prepare(kSampleRate, kChannels, kChunkFrames);
+    const bool planar = layout == RingLayout::Planar && analyzer.acceptsPlanar();
+    size_t position = 0;
+    const size_t chunksPerSecond = kFramesPerSecond / kChunkFrames;
+    const double perSecond = Benchmark::nanosPerCall(chunksPerSecond, [&] {
+        if (position + kChunkFrames > kFramesPerSecond) {
+            position = 0;
+        }
+        if (planar) {
+            const float* planes[kChannels];
+            for (size_t c = 0; c < kChannels; ++c) {
+                planes[c] = signal.planes[c].data() + position;
+            }
+            analyzer.processPlanar(planes, kChunkFrames);
+        } else {
+            analyzer.process(signal.interleaved.data() + position * kChannels, kChunkFrames);
+        }
+        analyzer.publish();
+        position += kChunkFrames;
+    }) * static_cast<double>(chunksPerSecond);
+    return perSecond * static_cast<double>(kFramesPerSecond) / static_cast<double>(chunksPerSecond * kChunkFrames);
+}
+
+/// Render, sender and analysis together in real time
+static bool runPipeline(RingLayout layout, const Signal& signal, int seconds) {
+    RingBuffer<float> ring(kRingBufferFrames, kChannels, RingStorage::Native, nullptr, layout);
+    PacketRing packetRing(kPacketRingSlots, kFramesPerPacket, kChannels, kPacketHeaderBytes);
+
+    UDPSenderConfig config;
+    config.framesPerPacket = kFramesPerPacket;
+    config.realtimeScheduling = false;
+    UDPSender sender;
+    if (!sender.initialize(&ring, config) || !sender.setDestination("null:") || !sender.setPacketRing(&packetRing)) {
+        std::fprintf(stderr, "PipelineBenchmark: sender failed to initialize\n");
+        return false;
+    }
+
+    LevelMeter levelMeter;
+    SpectrumAnalyzer spectrumAnalyzer;
+    ReplayBuffer replayBuffer(1.0);
+    AnalysisThread analysis;
+    analysis.initialize(&ring, kSampleRate);
+    analysis.addAnalyzer(&levelMeter);
+    analysis.addAnalyzer(&spectrumAnalyzer);
+    analysis.addAnalyzer(&replayBuffer);
+
+    sender.start();
+    analysis.start();
+    const uint64_t cpuStart = processCpuNanos();
+    uint64_t renderNanos = 0;
+    uint64_t blocks = 0;
+
+    const auto period = std::chrono::nanoseconds(static_cast<int64_t>(1e9 * kRenderFrames / kSampleRate));
+    const auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    size_t position = 0;
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(seconds)) {
+        const uint64_t began = MonotonicClock::nowNanos();
+        ring.write(signal.interleaved.data() + position * kChannels, kRenderFrames);
+        packetRing.write(signal.interleaved.data() + position * kChannels, kRenderFrames);
+        renderNanos += MonotonicClock::nowNanos() - began;
+        ++blocks;
+        position = position + 2 * kRenderFrames <= kFramesPerSecond ? position + kRenderFrames : 0;
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));  // Let the tap and sender catch up
+    const double audioSeconds = static_cast<double>(blocks * kRenderFrames) / kSampleRate;
+    const double cpuPerSecond = static_cast<double>(processCpuNanos() - cpuStart) / audioSeconds;
+    analysis.stop();
+    sender.stop();
+    sender.waitUntilIdle();
+
+    const ReplayStats replay = replayBuffer.stats();
+    std::printf("  %-12s %10.0f %12.0f %12.0f %10llu %8llu %8.3f\n", layoutName(layout),
+                static_cast<double>(renderNanos) / static_cast<double>(blocks),
+                analysis.cpuMicrosPerAudioSecond() * 1000.0, cpuPerSecond,
+                static_cast<unsigned long long>(sender.packetsSent()),
+                static_cast<unsigned long long>(analysis.framesSkipped()), replay.compressionRatio);
+    sender.releaseResources();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const int seconds = argc > 1 ? std::atoi(argv[1]) : 5;
+
+    Kernels::initialize();
+    const Signal signal;
+    std::printf("Output pipeline with the replay codec, %.0f Hz %zu ch, %zu-frame renders, kernels: %s\n",
+                kSampleRate, kChannels, kRenderFrames, Kernels::active().name);
+
+    std::printf("\nRender write, both rings (ns per %zu-frame block)\n", kRenderFrames);
+    std::printf("  %-22s %12s %12s\n", "", "interleaved", "planar");
+    std::printf("  %-22s %12.0f %12.0f\n", "ring + packet ring", renderNanos(RingLayout::Interleaved, signal),
+                renderNanos(RingLayout::Planar, signal));
+
+    std::printf("\nAnalysis taps called directly (ns per second of audio)\n");
+    std::printf("  %-22s %12s %12s\n", "analyzer", "interleaved", "planar");
+    double totals[2] = {0.0, 0.0};
+    LevelMeter levelMeter;
+    SpectrumAnalyzer spectrumAnalyzer;
+    ReplayBuffer replayBuffer(1.0);
+    AudioAnalyzer* analyzers[] = {&levelMeter, &spectrumAnalyzer, &replayBuffer};
+    for (AudioAnalyzer* analyzer : analyzers) {
+        double nanos[2];
+        for (size_t i = 0; i < 2; ++i) {
+            nanos[i] = nanosPerAudioSecond(*analyzer, signal, kLayouts[i]);
+            totals[i] += nanos[i];
+        }
+        std::printf("  %-22s %12.0f %12.0f\n", analyzer->name(), nanos[0], nanos[1]);
+    }
+    std::printf("  %-22s %12.0f %12.0f\n", "all three", totals[0], totals[1]);
+
+    std::printf("\nFull pipeline to null:, %d s in real time\n", seconds);
+    std::printf("  %-12s %10s %12s %12s %10s %8s %8s\n", "ring", "render ns", "tap ns/s", "CPU ns/s", "packets",
+                "skipped", "ratio");
+    for (RingLayout layout : kLayouts) {
+        if (!runPipeline(layout, signal, seconds)) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+//
+//  ReplayBenchmark.cpp
+//  CymaxPhoneOutDriver Benchmarks
+//
+//  Memory per minute of history, compression ratio, encode cost and seek
+//  cost of the instant-replay buffer for a few kinds of program material
+//
+//  Usage: ReplayBenchmark [minutes]
+//
+
+#include "Benchmark.hpp"
+#include "ReplayBuffer.hpp"
+#include "SampleKernels.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr double kSampleRate = 48000.0;
+static constexpr size_t kChannels = 2;
+static constexpr size_t kChunkFrames = 512;   // What the analysis thread hands over
+static constexpr size_t kSeekFrames = 128;    // One packet's worth
+static constexpr size_t kSeeks = 2000;
+
+enum class Material { Silence, Tones, Noise };
+
+static void fill(Material material, std::vector<float>& chunk, uint64_t frame, std::mt19937& random) {
+    std::uniform_real_distribution<float> noise(-0.5f, 0.5f);
+    for (size_t i = 0; i < chunk.size() / kChannels; ++i) {
+        const double t = static_cast<double>(frame + i) / kSampleRate;
+        for (size_t c = 0; c < kChannels; ++c) {
+            float value = 0.0f;
+            if (material == Material::Tones) {
+                // A chord with a slow tremolo, roughly music-like
+                value = static_cast<float>(0.2 * std::sin(2.0 * M_PI * 220.0 * t) +
+                                           0.15 * std::sin(2.0 * M_PI * (277.2 + c) * t) +
+                                           0.1 * std::sin(2.0 * M_PI * 329.6 * t)) *
+                        static_cast<float>(0.75 + 0.25 * std::sin(2.0 * M_PI * 0.5 * t));
+            } else if (material == Material::Noise) {
+                value = noise(random);
+            }
+            chunk[i * kChannels + c] = value;
+        }
+    }
+}
+
+static void run(const char* name, Material material, double minutes) {
+    ReplayBuffer replay(minutes);
+    replay.prepare(kSampleRate, kChannels, kChunkFrames);
+
+    std::mt19937 random(1);
+    std::vector<float> chunk(kChunkFrames * kChannels);
+    const uint64_t totalFrames = static_cast<uint64_t>(minutes * 60.0 * kSampleRate);
+    uint64_t encodeNanos = 0;
+    for (uint64_t frame = 0; frame < totalFrames; frame += kChunkFrames) {
+        fill(material, chunk, frame, random);
+        const uint64_t start = MonotonicClock::nowNanos();
+        replay.process(chunk.data(), kChunkFrames);
+        encodeNanos += MonotonicClock::nowNanos() - start;
+    }
+    const ReplayStats stats = replay.stats();
+
+    // Random seeks land in a different block almost every time, so each
+    // pays a block decode; sequential reads are served from the cache
+    const uint64_t oldest = replay.oldestPosition();
+    const uint64_t span = replay.newestPosition() - oldest - kSeekFrames;
+    std::vector<float> out(kSeekFrames * kChannels);
+    std::uniform_int_distribution<uint64_t> position(0, span);
+    const double seekNanos = Benchmark::nanosPerCall(kSeeks, [&] {
+        Benchmark::keep(replay.read(oldest + position(random), out.data(), kSeekFrames));
+    }, 3);
+    uint64_t next = oldest;
+    const double sequentialNanos = Benchmark::nanosPerCall(kSeeks, [&] {
+        Benchmark::keep(replay.read(next, out.data(), kSeekFrames));
+        next = next + kSeekFrames <= oldest + span ? next + kSeekFrames : oldest;
+    }, 3);
+
+    const double heldMinutes = static_cast<double>(stats.framesHeld) / kSampleRate / 60.0;
+    std::printf("%-8s %9.2f %9.2f %7.3f %12.0f %10.1f %10.2f\n", name, heldMinutes,
+                stats.bytesPerMinute / (1024.0 * 1024.0), stats.compressionRatio,
+                static_cast<double>(encodeNanos) / (static_cast<double>(totalFrames) / kSampleRate),
+                seekNanos / 1000.0, sequentialNanos / 1000.0);
+}
+
+int main(int argc, char** argv) {
+    const double minutes = argc > 1 ? std::atof(argv[1]) : 2.0;
+
+    Kernels::initialize();
+    const double rawMB = kSampleRate * 60.0 * kChannels * sizeof(float) / (1024.0 * 1024.0);
+    std::printf("ReplayBuffer, %.0f Hz %zu ch, %zu-frame blocks, kernels: %s (raw float: %.1f MB/min)\n",
+                kSampleRate, kChannels, ReplayBuffer::kBlockFrames, Kernels::active().name, rawMB);
+    std::printf("%-8s %9s %9s %7s %12s %10s %10s\n", "material", "held", "MB/min", "ratio",
+                "encode ns", "seek", "sequential");
+    std::printf("%-8s %9s %9s %7s %12s %10s %10s\n", "", "(min)", "", "(/int24)", "/s audio", "(us)", "(us)");
+    run("silence", Material::Silence, minutes);
+    run("tones", Material::Tones, minutes);
+    run("noise", Material::Noise, minutes);
+    return 0;
+}
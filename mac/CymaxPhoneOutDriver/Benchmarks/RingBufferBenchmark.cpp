@@ -0,0 +1,65 @@
+//
+//  RingBufferBenchmark.cpp
+//  CymaxPhoneOutDriver Benchmarks
+//
+//  Cost of one render-sized write and one packet-sized read for each
+//  RingBuffer storage format and layout
+//
+
+#include "Benchmark.hpp"
+#include "RingBuffer.hpp"
+#include "SampleKernels.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kWriteFrames = 256;   // A typical HAL IO buffer
+static constexpr size_t kReadFrames = 128;    // One packet
+static constexpr size_t kIterations = 200000;
+
+static void run(const char* name, RingStorage storage, RingLayout layout) {
+    RingBuffer<float> ring(48000, kChannels, storage, nullptr, layout);
+    std::vector<float> input(kWriteFrames * kChannels);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = 0.5f * std::sin(static_cast<float>(i) * 0.01f);
+    }
+    std::vector<float> output(kWriteFrames * kChannels);
+    std::vector<float> left(kReadFrames), right(kReadFrames);
+    float* planes[kChannels] = {left.data(), right.data()};
+
+    const double writeNanos = Benchmark::nanosPerCall(kIterations, [&] {
+        ring.write(input.data(), kWriteFrames);
+        ring.dropFrames(kWriteFrames);
+    });
+    const double readNanos = Benchmark::nanosPerCall(kIterations, [&] {
+        ring.write(input.data(), kReadFrames);
+        ring.read(output.data(), kReadFrames);
+        Benchmark::keep(output[0]);
+    }) - Benchmark::nanosPerCall(kIterations, [&] {
+        ring.write(input.data(), kReadFrames);
+        ring.dropFrames(kReadFrames);
+    });
+    const double planarNanos = Benchmark::nanosPerCall(kIterations, [&] {
+        ring.write(input.data(), kReadFrames);
+        ring.readPlanar(planes, kReadFrames);
+        Benchmark::keep(left[0]);
+    });
+
+    std::printf("%-22s %10.1f %12.1f %14.1f\n", name, writeNanos, readNanos, planarNanos);
+}
+
+int main() {
+    Kernels::initialize();
+    std::printf("RingBuffer, %zu channels, kernels: %s\n", kChannels, Kernels::active().name);
+    std::printf("%-22s %10s %12s %14s\n", "ring", "write 256", "read 128", "write+planar");
+    std::printf("%-22s %10s %12s %14s\n", "", "(ns)", "(ns)", "128 (ns)");
+    run("float interleaved", RingStorage::Native, RingLayout::Interleaved);
+    run("int16 interleaved", RingStorage::Int16, RingLayout::Interleaved);
+    run("int24 interleaved", RingStorage::Int24, RingLayout::Interleaved);
+    run("float planar", RingStorage::Native, RingLayout::Planar);
+    return 0;
+}
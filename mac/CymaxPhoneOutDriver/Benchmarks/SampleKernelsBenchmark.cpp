@@ -0,0 +1,145 @@
+//
+//  SampleKernelsBenchmark.cpp
+//  CymaxPhoneOutDriver Benchmarks
+//
+//  Cost of every sample kernel for every instruction set this CPU
+//  supports, at the block sizes hosts render with
+//
+
+#include "Benchmark.hpp"
+#include "SampleKernels.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kBlockSizes[] = {32, 128, 512, 2048};
+static constexpr size_t kSamplesPerMeasurement = 5000000;
+static constexpr Kernels::ISA kISAs[] = {Kernels::ISA::Scalar, Kernels::ISA::SSE2, Kernels::ISA::AVX2,
+                                         Kernels::ISA::NEON};
+
+/// Buffers for one block size, shared by every kernel
+struct Buffers {
+    explicit Buffers(size_t frames)
+        : frames(frames), count(frames * kChannels), input(count), output(count), left(frames), right(frames),
+          int16(count), int24(count * Kernels::kInt24Bytes) {
+        for (size_t i = 0; i < count; ++i) {
+            input[i] = 0.9f * std::sin(static_cast<float>(i) * 0.003f);
+        }
+        for (size_t i = 0; i < frames; ++i) {
+            left[i] = input[2 * i];
+            right[i] = input[2 * i + 1];
+        }
+        output = input;
+        Kernels::scalar().floatToInt16(input.data(), int16.data(), count);
+        Kernels::scalar().floatToInt24(input.data(), int24.data(), count);
+    }
+
+    size_t frames;
+    size_t count;
+    std::vector<float> input, output, left, right;
+    std::vector<int16_t> int16;
+    std::vector<uint8_t> int24;
+};
+
+struct Kernel {
+    const char* name;
+    void (*call)(const Kernels::KernelTable& table, Buffers& buffers);
+};
+
+static const Kernel kKernels[] = {
+    {"floatToInt16", [](const Kernels::KernelTable& t, Buffers& b) {
+        t.floatToInt16(b.input.data(), b.int16.data(), b.count);
+        Benchmark::keep(b.int16[0]);
+    }},
+    {"int16ToFloat", [](const Kernels::KernelTable& t, Buffers& b) {
+        t.int16ToFloat(b.int16.data(), b.output.data(), b.count);
+        Benchmark::keep(b.output[0]);
+    }},
+    {"floatToInt24", [](const Kernels::KernelTable& t, Buffers& b) {
+        t.floatToInt24(b.input.data(), b.int24.data(), b.count);
+        Benchmark::keep(b.int24[0]);
+    }},
+    {"int24ToFloat", [](const Kernels::KernelTable& t, Buffers& b) {
+        t.int24ToFloat(b.int24.data(), b.output.data(), b.count);
+        Benchmark::keep(b.output[0]);
+    }},
+    // The gain kernels run in place over and over, so they use gains that
+    // keep the samples where they are instead of decaying into denormals
+    {"applyGain", [](const Kernels::KernelTable& t, Buffers& b) {
+        t.applyGain(b.output.data(), b.count, -1.0f);
+        Benchmark::keep(b.output[0]);
+    }},
+    {"applyGainRamp", [](const Kernels::KernelTable& t, Buffers& b) {
+        t.applyGainRamp(b.output.data(), b.frames, kChannels, 1.0f, 1.0f);
+        Benchmark::keep(b.output[0]);
+    }},
+    {"multiply", [](const Kernels::KernelTable& t, Buffers& b) {
+        t.multiply(b.input.data(), b.input.data(), b.output.data(), b.count);
+        Benchmark::keep(b.output[0]);
+    }},
+    {"peakAbs", [](const Kernels::KernelTable& t, Buffers& b) {
+        Benchmark::keep(t.peakAbs(b.input.data(), b.count));
+    }},
+    {"sumOfSquares", [](const Kernels::KernelTable& t, Buffers& b) {
+        Benchmark::keep(t.sumOfSquares(b.input.data(), b.count));
+    }},
+    {"interleave", [](const Kernels::KernelTable& t, Buffers& b) {
+        const float* planes[kChannels] = {b.left.data(), b.right.data()};
+        t.interleave(planes, b.output.data(), b.frames, kChannels);
+        Benchmark::keep(b.output[0]);
+    }},
+    {"deinterleave", [](const Kernels::KernelTable& t, Buffers& b) {
+        float* planes[kChannels] = {b.left.data(), b.right.data()};
+        t.deinterleave(b.input.data(), planes, b.frames, kChannels);
+        Benchmark::keep(b.left[0]);
+    }},
+    {"downmixToMono", [](const Kernels::KernelTable& t, Buffers& b) {
+        t.downmixToMono(b.input.data(), b.left.data(), b.frames, kChannels);
+        Benchmark::keep(b.left[0]);
+    }},
+    {"sanitize", [](const Kernels::KernelTable& t, Buffers& b) {
+        // Clean input, the common case: every sample is checked, none replaced
+        Benchmark::keep(t.sanitize(b.input.data(), b.count, 1.0f));
+    }},
+};
+
+int main() {
+    std::vector<const Kernels::KernelTable*> tables;
+    for (Kernels::ISA isa : kISAs) {
+        if (const Kernels::KernelTable* table = Kernels::forISA(isa)) {
+            tables.push_back(table);
+        }
+    }
+
+    std::printf("Sample kernels, %zu-channel blocks, ns per call (x: speedup over scalar)\n", kChannels);
+    for (size_t frames : kBlockSizes) {
+        Buffers buffers(frames);
+        const size_t iterations = kSamplesPerMeasurement / buffers.count;
+
+        std::printf("\n%zu frames\n%-14s", frames, "kernel");
+        for (const Kernels::KernelTable* table : tables) {
+            std::printf(" %10s %6s", table->name, "");
+        }
+        std::printf("\n");
+
+        for (const Kernel& kernel : kKernels) {
+            std::printf("%-14s", kernel.name);
+            double scalarNanos = 0.0;
+            for (const Kernels::KernelTable* table : tables) {
+                const double nanos = Benchmark::nanosPerCall(iterations, [&] {
+                    kernel.call(*table, buffers);
+                });
+                if (table->isa == Kernels::ISA::Scalar) {
+                    scalarNanos = nanos;
+                }
+                std::printf(" %10.1f %5.1fx", nanos, scalarNanos / nanos);
+            }
+            std::printf("\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+//
+//  SenderBenchmark.cpp
+//  CymaxPhoneOutDriver Benchmarks
+//
+//  Runs the sender against loopback for a few seconds with a simulated
+//  render thread and reports per-stage latency, wake lateness and rates,
+//  then feeds it unpaced (the ring kept full) into a NullTransport for
+//  the packets per second the sending path itself can build and hand off:
+//  one stream, then many concurrent ones (a sender and ring each, as
+//  separate devices would have)
+//
+//  Usage: SenderBenchmark [seconds] [inline|pipelined] [destination] [streams]
+//  destination defaults to 127.0.0.1; "null:", "shm:" or "file:name"
+//  measure the pipeline without the kernel's UDP path
+//
+
+#include "Benchmark.hpp"
+#include "RingBuffer.hpp"
+#include "SampleKernels.hpp"
+#include "UDPSender.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr size_t kRenderFrames = 256;
+
+/// Senders for several streams, each fed as fast as it reads, to null:
+static bool runUnpaced(bool pipelined, int seconds, size_t streamCount, const std::vector<float>& block) {
+    UDPSenderConfig config;
+    config.pipelined = pipelined;
+    config.realtimeScheduling = false;  // Throughput, not wake latency
+    std::vector<std::unique_ptr<RingBuffer<float>>> rings;
+    std::vector<std::unique_ptr<UDPSender>> senders;
+    for (size_t i = 0; i < streamCount; ++i) {
+        rings.push_back(std::make_unique<RingBuffer<float>>(config.sampleRate, config.channels));
+        senders.push_back(std::make_unique<UDPSender>());
+        if (!senders[i]->initialize(rings[i].get(), config) || !senders[i]->setDestination("null:") ||
+            !senders[i]->start()) {
+            std::fprintf(stderr, "SenderBenchmark: unpaced sender failed to start\n");
+            return false;
+        }
+    }
+    const int threads = Benchmark::threadCount();
+
+    // Top each ring up whenever a render block fits, so no sender waits
+    // for audio and the writer never overwrites what it hasn't read
+    const auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(seconds)) {
+        bool wrote = false;
+        for (const std::unique_ptr<RingBuffer<float>>& ring : rings) {
+            if (ring->availableForWrite() >= kRenderFrames) {
+                ring->write(block.data(), kRenderFrames);
+                wrote = true;
+            }
+        }
+        if (!wrote) {
+            std::this_thread::yield();
+        }
+    }
+    for (const std::unique_ptr<UDPSender>& sender : senders) {
+        sender->stop();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t total = 0;
+    uint64_t fewest = UINT64_MAX;
+    uint64_t most = 0;
+    uint64_t framesDropped = 0;
+    for (const std::unique_ptr<UDPSender>& sender : senders) {
+        sender->waitUntilIdle();
+        total += sender->packetsSent();
+        fewest = std::min(fewest, sender->packetsSent());
+        most = std::max(most, sender->packetsSent());
+        framesDropped += sender->framesDropped();
+    }
+    const double realTime = static_cast<double>(config.sampleRate) / config.framesPerPacket;
+    const double perStream = static_cast<double>(total) / elapsed / static_cast<double>(streamCount);
+    std::printf("  %-8zu %8d %12.0f %12.0f %10.1f %12.0f %12.0f %10llu\n", streamCount, threads,
+                static_cast<double>(total) / elapsed, perStream, perStream / realTime,
+                static_cast<double>(fewest) / elapsed, static_cast<double>(most) / elapsed,
+                static_cast<unsigned long long>(framesDropped));
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const int seconds = argc > 1 ? std::atoi(argv[1]) : 5;
+    const bool pipelined = argc > 2 && std::strcmp(argv[2], "pipelined") == 0;
+    const char* destination = argc > 3 ? argv[3] : "127.0.0.1";
+    const size_t streams = argc > 4 ? static_cast<size_t>(std::atoi(argv[4])) : 8;
+
+    Kernels::initialize();
+    UDPSenderConfig config;
+    config.pipelined = pipelined;
+    config.realtimeScheduling = true;  // Falls back if refused
+    RingBuffer<float> ring(config.sampleRate, config.channels);
+
+    UDPSender sender;
+    sender.initialize(&ring, config);
+    if (!sender.setDestination(destination)) {
+        std::fprintf(stderr, "SenderBenchmark: bad destination %s\n", destination);
+        return 1;
+    }
+    if (!sender.start()) {
+        std::fprintf(stderr, "SenderBenchmark: sender failed to start\n");
+        return 1;
+    }
+
+    // Render thread stand-in: one IO buffer per period, on an absolute
+    // schedule so sleep overshoot doesn't accumulate
+    std::vector<float> block(kRenderFrames * config.channels);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = 0.25f * std::sin(static_cast<float>(i) * 0.05f);
+    }
+    const auto period = std::chrono::nanoseconds(1000000000LL * kRenderFrames / config.sampleRate);
+    const auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(seconds)) {
+        ring.write(block.data(), kRenderFrames);
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+    const SenderRateSnapshot rates = sender.rateStats();
+    sender.stop();
+    sender.waitUntilIdle();
+
+    std::printf("UDPSender (%s) to %s, %d s, kernels: %s\n", pipelined ? "pipelined" : "inline",
+                destination, seconds, Kernels::active().name);
+    static const char* const kStageNames[] = {"encode", "fec", "transmit"};
+    for (size_t i = 0; i < static_cast<size_t>(SenderStage::Count); ++i) {
+        const SenderStageStats stats = sender.stageStats(static_cast<SenderStage>(i));
+        if (stats.packets == 0) {
+            continue;
+        }
+        std::printf("  %-9s %8llu packets, latency mean %7.2f us, max %8.1f us\n", kStageNames[i],
+                    static_cast<unsigned long long>(stats.packets), stats.meanLatencyMicros, stats.maxLatencyMicros);
+    }
+    const LatenessStats lateness = sender.wakeLateness();
+    std::printf("  wake lateness p50 <= %.0f us, p99 <= %.0f us, max %.1f us\n",
+                lateness.percentileMicros(50.0), lateness.percentileMicros(99.0), lateness.maxMicros);
+    const SenderRateWindow& window = rates.windows[1];
+    std::printf("  last %u s: %.1f packets/s, %.2f Mbit/s, loss %.2f%%, fill mean %.0f max %u frames\n",
+                window.seconds, window.packetsPerSecond, window.bitsPerSecond / 1e6, window.lossPercent,
+                window.meanFillFrames, window.maxFillFrames);
+    std::printf("  first packet %.0f us after start, %llu dropped\n", sender.timeToFirstPacketMicros(),
+                static_cast<unsigned long long>(sender.packetsDropped()));
+
+    std::printf("\nUnpaced (%s) to null:, %d s per run (packets/s)\n", pipelined ? "pipelined" : "inline", seconds);
+    std::printf("  %-8s %8s %12s %12s %10s %12s %12s %10s\n", "streams", "threads", "total", "per stream",
+                "x realtime", "slowest", "fastest", "dropped");
+    return runUnpaced(pipelined, seconds, 1, block) && (streams <= 1 || runUnpaced(pipelined, seconds, streams, block))
+        ? 0
+        : 1;
+}
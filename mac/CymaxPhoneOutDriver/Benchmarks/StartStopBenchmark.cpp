@@ -0,0 +1,115 @@
+//
+//  StartStopBenchmark.cpp
+//  CymaxPhoneOutDriver Benchmarks
+//
+//  Cost of the sender's stop() and start() and the time from start() to
+//  the first audio packet, over many short IO sessions, with the sender's
+//  threads parked between sessions and with everything released and
+//  created again (what the device does after an idle teardown)
+//
+//  Each session mimics startIO: reset the ring, start(), then one render
+//  block arrives. The first-packet time is the sender's own
+//  timeToFirstPacketMicros(), stamped as the packet leaves the socket.
+//
+//  Usage: StartStopBenchmark [cycles] [gapMs] [destination]
+//
+
+#include "Benchmark.hpp"
+#include "RingBuffer.hpp"
+#include "UDPSender.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr size_t kRenderFrames = 256;
+static constexpr int kSessionMs = 20;  // Long enough for a few packets
+
+static double microsSince(uint64_t startNanos) {
+    return static_cast<double>(MonotonicClock::nowNanos() - startNanos) / 1000.0;
+}
+
+/// p50, p99 and max of one column
+static void printColumn(const char* name, std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const auto at = [&](double percentile) {
+        return values[std::min(values.size() - 1, static_cast<size_t>(percentile / 100.0 * values.size()))];
+    };
+    std::printf("    %-13s p50 %8.1f us, p99 %8.1f us, max %8.1f us\n", name, at(50.0), at(99.0), values.back());
+}
+
+/// Run the cycles; cold releases and re-initializes the sender between them
+static bool run(bool cold, int cycles, int gapMs, const char* destination) {
+    UDPSenderConfig config;
+    config.realtimeScheduling = true;  // Falls back if refused
+    RingBuffer<float> ring(config.sampleRate, config.channels);
+    std::vector<float> block(kRenderFrames * config.channels);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = 0.25f * std::sin(static_cast<float>(i) * 0.05f);
+    }
+
+    UDPSender sender;
+    std::vector<double> stops, starts, firstPackets;
+    int missed = 0;
+    for (int cycle = 0; cycle < cycles; ++cycle) {
+        uint64_t began = MonotonicClock::nowNanos();
+        if (cold || cycle == 0) {
+            if (!sender.initialize(&ring, config) || !sender.setDestination(destination)) {
+                std::fprintf(stderr, "StartStopBenchmark: can't send to %s\n", destination);
+                return false;
+            }
+        }
+        sender.waitUntilIdle();
+        ring.reset();
+        if (!sender.start()) {
+            std::fprintf(stderr, "StartStopBenchmark: sender failed to start\n");
+            return false;
+        }
+        if (cycle > 0) {
+            starts.push_back(microsSince(began));
+        }
+        ring.write(block.data(), kRenderFrames);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kSessionMs));
+
+        const double firstPacket = sender.timeToFirstPacketMicros();
+        if (firstPacket > 0.0) {
+            firstPackets.push_back(firstPacket);
+        } else {
+            ++missed;
+        }
+
+        began = MonotonicClock::nowNanos();
+        sender.stop();
+        stops.push_back(microsSince(began));
+        if (cold) {
+            sender.releaseResources();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(gapMs));
+    }
+    sender.waitUntilIdle();
+    sender.releaseResources();
+
+    // The first cycle creates the threads either way, so it isn't counted
+    std::printf("  %s: %d cycles, %d without a packet\n",
+                cold ? "cold (releaseResources, initialize)" : "parked threads", cycles, missed);
+    printColumn("stop", stops);
+    printColumn("start", starts);
+    printColumn("first packet", firstPackets);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const int cycles = std::max(2, argc > 1 ? std::atoi(argv[1]) : 200);
+    const int gapMs = argc > 2 ? std::atoi(argv[2]) : 2;
+    const char* destination = argc > 3 ? argv[3] : "127.0.0.1";
+
+    std::printf("UDPSender start/stop to %s, %d ms sessions, %d ms between them\n", destination, kSessionMs,
+                gapMs);
+    return run(false, cycles, gapMs, destination) && run(true, cycles, gapMs, destination) ? 0 : 1;
+}
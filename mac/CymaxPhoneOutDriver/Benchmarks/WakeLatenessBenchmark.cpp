@@ -0,0 +1,115 @@
+//
+//  WakeLatenessBenchmark.cpp
+//  CymaxPhoneOutDriver Benchmarks
+//
+//  How late the sender's paced wake-ups run with and without the
+//  real-time reservation (UDPSenderConfig::realtimeScheduling), on an idle
+//  machine and with every CPU kept busy by ordinary threads
+//
+//  The sender streams to null: so only scheduling is measured, not the
+//  network stack.
+//
+//  Usage: WakeLatenessBenchmark [seconds] [loadThreads]
+//  loadThreads defaults to one per CPU
+//
+
+#include "Benchmark.hpp"
+#include "RingBuffer.hpp"
+#include "ThreadPriority.hpp"
+#include "UDPSender.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr size_t kRenderFrames = 256;
+
+/// What setRealtime() grants a thread asking for the sender's reservation
+static ThreadSchedulingClass probeSchedulingClass(const UDPSenderConfig& config) {
+    ThreadSchedulingClass obtained = ThreadSchedulingClass::Interactive;
+    std::thread probe([&] {
+        const uint64_t period = 1000000000ULL * config.framesPerPacket / config.sampleRate;
+        RealtimeSchedule schedule;  // Same fractions as UDPSender
+        schedule.periodNanos = period;
+        schedule.computationNanos = period / 4;
+        schedule.constraintNanos = period / 2;
+        obtained = ThreadPriority::setRealtime(schedule);
+    });
+    probe.join();
+    return obtained;
+}
+
+/// Stream for a while; print the sender's wake lateness
+static void run(bool realtime, unsigned loadThreads, int seconds) {
+    UDPSenderConfig config;
+    config.realtimeScheduling = realtime;
+    RingBuffer<float> ring(config.sampleRate, config.channels);
+
+    // Ordinary threads competing for every CPU
+    std::atomic<bool> loaded{true};
+    std::vector<std::thread> load;
+    for (unsigned i = 0; i < loadThreads; ++i) {
+        load.emplace_back([&loaded, i] {
+            uint64_t x = i;
+            while (loaded.load(std::memory_order_relaxed)) {
+                x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+                Benchmark::keep(x);
+            }
+        });
+    }
+
+    UDPSender sender;
+    sender.initialize(&ring, config);
+    sender.setDestination("null:");
+    sender.start();
+
+    // Render thread stand-in, as in SenderBenchmark
+    std::vector<float> block(kRenderFrames * config.channels);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = 0.25f * std::sin(static_cast<float>(i) * 0.05f);
+    }
+    const auto period = std::chrono::nanoseconds(1000000000LL * kRenderFrames / config.sampleRate);
+    const auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(seconds)) {
+        ring.write(block.data(), kRenderFrames);
+        next += period;
+        std::this_thread::sleep_until(next);
+    }
+    const LatenessStats lateness = sender.wakeLateness();
+    sender.stop();
+    sender.waitUntilIdle();
+
+    loaded.store(false, std::memory_order_relaxed);
+    for (std::thread& thread : load) {
+        thread.join();
+    }
+
+    std::printf("  %-9s %2u %9llu %9.0f %9.0f %9.0f %10.1f\n", realtime ? "realtime" : "QoS only", loadThreads,
+                static_cast<unsigned long long>(lateness.samples), lateness.percentileMicros(50.0),
+                lateness.percentileMicros(99.0), lateness.percentileMicros(99.9), lateness.maxMicros);
+}
+
+int main(int argc, char** argv) {
+    const int seconds = argc > 1 ? std::atoi(argv[1]) : 5;
+    const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned loadThreads = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : cpus;
+
+    const UDPSenderConfig defaults;
+    std::printf("UDPSender wake lateness to null:, %d s per run, %u CPUs, reservation granted here: %s\n",
+                seconds, cpus, ThreadPriority::className(probeSchedulingClass(defaults)));
+    std::printf("  %-9s %2s %9s %9s %9s %9s %10s\n", "policy", "ld", "wakes", "p50 <=", "p99 <=", "p99.9 <=",
+                "max (us)");
+    for (unsigned load : {0u, loadThreads}) {
+        run(false, load, seconds);
+        run(true, load, seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,200 @@
+//
+//  AnalysisThread.cpp
+//  CymaxPhoneOutDriver
+//
+//  Analysis host thread implementation
+//
+
+#include "AnalysisThread.hpp"
+#include "Logging.hpp"
+#include "ThreadPriority.hpp"
+#include "SampleKernels.hpp"
+#include "MonotonicClock.hpp"
+
+#include <algorithm>
+#include <time.h>
+
+namespace Cymax {
+
+static uint64_t threadCPUNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+AnalysisThread::AnalysisThread() = default;
+
+AnalysisThread::~AnalysisThread() {
+    stop();
+}
+
+bool AnalysisThread::initialize(RingBuffer<float>* ringBuffer, double sampleRate) {
+    if (!ringBuffer) {
+        CYMAX_LOG_ERROR("AnalysisThread::initialize - null ring buffer");
+        return false;
+    }
+    if (m_running.load(std::memory_order_acquire)) {
+        CYMAX_LOG_ERROR("AnalysisThread: cannot initialize while running");
+        return false;
+    }
+
+    m_ringBuffer = ringBuffer;
+    m_sampleRate = sampleRate;
+    m_channels = ringBuffer->channelCount();
+    m_chunk.assign(kChunkFrames * m_channels, 0.0f);
+
+    m_planar = ringBuffer->layout() == RingLayout::Planar;
+    m_planeStorage.assign(m_planar ? kChunkFrames * m_channels : 0, 0.0f);
+    m_planes.assign(m_planar ? m_channels : 0, nullptr);
+    for (size_t c = 0; c < m_planes.size(); ++c) {
+        m_planes[c] = m_planeStorage.data() + c * kChunkFrames;
+    }
+
+    for (size_t i = 0; i < m_analyzerCount; ++i) {
+        m_analyzers[i]->prepare(m_sampleRate, m_channels, kChunkFrames);
+    }
+    return true;
+}
+
+bool AnalysisThread::addAnalyzer(AudioAnalyzer* analyzer) {
+    if (!analyzer || m_running.load(std::memory_order_acquire) || m_analyzerCount == kMaxAnalyzers) {
+        return false;
+    }
+    analyzer->prepare(m_sampleRate, m_channels, kChunkFrames);
+    m_analyzers[m_analyzerCount++] = analyzer;
+    CYMAX_LOG_INFO("AnalysisThread: added %{public}s", analyzer->name());
+    return true;
+}
+
+void AnalysisThread::setPublishRate(uint32_t hz) {
+    m_publishRate = std::min<uint32_t>(60, std::max<uint32_t>(30, hz));
+}
+
+bool AnalysisThread::start() {
+    if (m_running.load(std::memory_order_acquire)) {
+        return true;
+    }
+    if (!m_ringBuffer || m_analyzerCount == 0) {
+        return false;
+    }
+
+    // Fresh state for the new stream
+    for (size_t i = 0; i < m_analyzerCount; ++i) {
+        m_analyzers[i]->prepare(m_sampleRate, m_channels, kChunkFrames);
+    }
+    m_tap = m_ringBuffer->makeTap();
+    m_framesAnalyzed.store(0, std::memory_order_relaxed);
+    m_framesSkipped.store(0, std::memory_order_relaxed);
+    m_cpuNanos.store(0, std::memory_order_relaxed);
+
+    m_shouldStop.store(false, std::memory_order_release);
+    m_thread = std::thread(&AnalysisThread::threadFunc, this);
+    m_running.store(true, std::memory_order_release);
+
+    CYMAX_LOG_INFO("AnalysisThread: started (%u Hz publish)", m_publishRate);
+    return true;
+}
+
+void AnalysisThread::stop() {
+    if (!m_running.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    m_shouldStop.store(true, std::memory_order_release);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_running.store(false, std::memory_order_release);
+
+    CYMAX_LOG_INFO("AnalysisThread: stopped (analyzed: %llu frames, skipped: %llu, %.1f us CPU per audio second)",
+                   framesAnalyzed(), framesSkipped(), cpuMicrosPerAudioSecond());
+}
+
+double AnalysisThread::cpuMicrosPerAudioSecond() const {
+    const uint64_t frames = framesAnalyzed();
+    if (frames == 0) {
+        return 0.0;
+    }
+    const double audioSeconds = static_cast<double>(frames) / m_sampleRate;
+    return static_cast<double>(cpuNanos()) / 1000.0 / audioSeconds;
+}
+
+size_t AnalysisThread::processChunk() {
+    const size_t got = m_ringBuffer->tapRead(m_tap, m_chunk.data(), kChunkFrames);
+    if (got == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < m_analyzerCount; ++i) {
+        m_analyzers[i]->process(m_chunk.data(), got);
+    }
+    return got;
+}
+
+size_t AnalysisThread::processPlanarChunk() {
+    const size_t got = m_ringBuffer->tapReadPlanar(m_tap, m_planes.data(), kChunkFrames);
+    if (got == 0) {
+        return 0;
+    }
+    bool interleaved = false;
+    for (size_t i = 0; i < m_analyzerCount; ++i) {
+        AudioAnalyzer* analyzer = m_analyzers[i];
+        if (analyzer->acceptsPlanar()) {
+            analyzer->processPlanar(m_planes.data(), got);
+            continue;
+        }
+        if (!interleaved) {
+            Kernels::active().interleave(m_planes.data(), m_chunk.data(), got, m_channels);
+            interleaved = true;
+        }
+        analyzer->process(m_chunk.data(), got);
+    }
+    return got;
+}
+
+void AnalysisThread::threadFunc() {
+    CYMAX_LOG_INFO("AnalysisThread: thread started");
+
+    // Below the sender: analysis may lag, audio may not
+    ThreadPriority::setUtility();
+
+    const uint64_t periodNanos = 1000000000ULL / m_publishRate;
+    uint64_t nextTick = MonotonicClock::nowNanos() + periodNanos;
+
+    while (!m_shouldStop.load(std::memory_order_acquire)) {
+        const uint64_t cpuStart = threadCPUNanos();
+
+        // Drain everything written since the last tick
+        uint64_t frames = 0;
+        for (;;) {
+            const size_t got = m_planar ? processPlanarChunk() : processChunk();
+            if (got == 0) break;
+            frames += got;
+        }
+
+        for (size_t i = 0; i < m_analyzerCount; ++i) {
+            m_analyzers[i]->publish();
+        }
+
+        m_cpuNanos.fetch_add(threadCPUNanos() - cpuStart, std::memory_order_relaxed);
+        m_framesAnalyzed.fetch_add(frames, std::memory_order_relaxed);
+        m_framesSkipped.store(m_tap.framesSkipped, std::memory_order_relaxed);
+
+        // Sleep to the next tick; if we overran, don't try to catch up
+        const uint64_t now = MonotonicClock::nowNanos();
+        if (nextTick > now) {
+            const uint64_t wait = nextTick - now;
+            struct timespec ts = {
+                static_cast<time_t>(wait / 1000000000ULL),
+                static_cast<long>(wait % 1000000000ULL)
+            };
+            nanosleep(&ts, nullptr);
+            nextTick += periodNanos;
+        } else {
+            nextTick = now + periodNanos;
+        }
+    }
+
+    CYMAX_LOG_INFO("AnalysisThread: thread exiting");
+}
+
+} // namespace Cymax
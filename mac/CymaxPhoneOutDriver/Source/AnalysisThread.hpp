@@ -0,0 +1,108 @@
+//
+//  AnalysisThread.hpp
+//  CymaxPhoneOutDriver
+//
+//  Non-real-time thread feeding device audio to analyzers
+//
+//  Reads the ring buffer through a TapCursor, so it neither consumes
+//  frames from the UDP sender nor adds any work to doIOOperation.
+//  Analyzers publish their results at a fixed rate (30-60 Hz).
+//
+//  From a planar ring the tap is read as planes, which analyzers that
+//  accept planar input take as is; an interleaved copy is only built
+//  when some analyzer still wants one.
+//
+
+#ifndef AnalysisThread_hpp
+#define AnalysisThread_hpp
+
+#include "AudioAnalyzer.hpp"
+#include "RingBuffer.hpp"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace Cymax {
+
+/// Analysis host thread
+class AnalysisThread {
+public:
+    AnalysisThread();
+    ~AnalysisThread();
+
+    // Non-copyable
+    AnalysisThread(const AnalysisThread&) = delete;
+    AnalysisThread& operator=(const AnalysisThread&) = delete;
+
+    /// Set the ring buffer and stream format (call when not running)
+    /// @return true if initialization succeeded
+    bool initialize(RingBuffer<float>* ringBuffer, double sampleRate);
+
+    /// Register an analyzer (call when not running; not owned)
+    /// @return false if the analyzer table is full
+    bool addAnalyzer(AudioAnalyzer* analyzer);
+
+    /// Set how often analyzers publish, clamped to 30-60 Hz
+    void setPublishRate(uint32_t hz);
+
+    /// Start the analysis thread
+    bool start();
+
+    /// Stop the analysis thread
+    void stop();
+
+    bool isRunning() const { return m_running.load(std::memory_order_acquire); }
+
+    /// Frames analyzed since start
+    uint64_t framesAnalyzed() const { return m_framesAnalyzed.load(std::memory_order_relaxed); }
+
+    /// Frames the tap skipped because the thread fell behind
+    uint64_t framesSkipped() const { return m_framesSkipped.load(std::memory_order_relaxed); }
+
+    /// Thread CPU time spent in analyzers since start, in nanoseconds
+    uint64_t cpuNanos() const { return m_cpuNanos.load(std::memory_order_relaxed); }
+
+    /// Analysis CPU cost per second of audio, in microseconds
+    double cpuMicrosPerAudioSecond() const;
+
+    static constexpr uint32_t kDefaultPublishRate = 30;
+    static constexpr size_t kMaxAnalyzers = 4;
+    static constexpr size_t kChunkFrames = 1024;
+
+private:
+    void threadFunc();
+
+    /// Tap one chunk and run every analyzer on it
+    /// @return Frames processed (0 = caught up with the writer)
+    size_t processChunk();
+    size_t processPlanarChunk();
+
+    RingBuffer<float>* m_ringBuffer = nullptr;
+    double m_sampleRate = 48000.0;
+    size_t m_channels = 2;
+    uint32_t m_publishRate = kDefaultPublishRate;
+
+    AudioAnalyzer* m_analyzers[kMaxAnalyzers] = {};
+    size_t m_analyzerCount = 0;
+
+    // Tap position and chunk buffers (analysis thread only)
+    TapCursor m_tap;
+    std::vector<float> m_chunk;
+    bool m_planar = false;              // Ring is planar: tap reads planes
+    std::vector<float> m_planeStorage;
+    std::vector<float*> m_planes;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_shouldStop{false};
+
+    // Statistics
+    std::atomic<uint64_t> m_framesAnalyzed{0};
+    std::atomic<uint64_t> m_framesSkipped{0};
+    std::atomic<uint64_t> m_cpuNanos{0};
+};
+
+} // namespace Cymax
+
+#endif /* AnalysisThread_hpp */
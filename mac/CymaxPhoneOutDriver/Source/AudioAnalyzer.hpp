@@ -0,0 +1,52 @@
+//
+//  AudioAnalyzer.hpp
+//  CymaxPhoneOutDriver
+//
+//  Interface for analysis stages hosted by the AnalysisThread
+//
+
+#ifndef AudioAnalyzer_hpp
+#define AudioAnalyzer_hpp
+
+#include <cstddef>
+
+namespace Cymax {
+
+/// An analysis stage fed with device audio on the analysis thread
+/// All methods are called from one non-real-time thread.
+class AudioAnalyzer {
+public:
+    virtual ~AudioAnalyzer() = default;
+
+    /// Name for logging
+    virtual const char* name() const = 0;
+
+    /// Configure for a stream format; may allocate
+    /// Called before the analysis thread starts
+    /// @param sampleRate Sample rate in Hz
+    /// @param channels Interleaved channel count
+    /// @param maxFrames Largest block process() will be given
+    virtual void prepare(double sampleRate, size_t channels, size_t maxFrames) = 0;
+
+    /// Consume a block of interleaved samples; must not allocate
+    virtual void process(const float* samples, size_t frames) = 0;
+
+    /// Prefers per-channel planes (processPlanar) over interleaved frames
+    /// The host then skips interleaving for it when the ring is planar.
+    virtual bool acceptsPlanar() const { return false; }
+
+    /// Consume a block as one plane per channel; must not allocate
+    /// Only called when acceptsPlanar() is true.
+    virtual void processPlanar(const float* const* planes, size_t frames) {
+        (void)planes;
+        (void)frames;
+    }
+
+    /// Publish results accumulated since the last call
+    /// Called at the analysis publish rate
+    virtual void publish() = 0;
+};
+
+} // namespace Cymax
+
+#endif /* AudioAnalyzer_hpp */
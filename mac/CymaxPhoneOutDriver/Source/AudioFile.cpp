@@ -0,0 +1,204 @@
+//
+//  AudioFile.cpp
+//  CymaxPhoneOutDriver
+//
+//  WAV/CAF header implementation
+//
+
+#include "AudioFile.hpp"
+#include "Logging.hpp"
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <strings.h>
+#include <cstdio>
+#include <cstring>
+
+namespace Cymax {
+namespace AudioFile {
+
+#pragma mark - Byte helpers
+
+static void put16LE(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+static void put32LE(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static void put32BE(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (24 - 8 * i));
+}
+
+static void put64BE(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(v >> (56 - 8 * i));
+}
+
+static void putTag(uint8_t* p, const char* tag) {
+    std::memcpy(p, tag, 4);
+}
+
+// WAV layout: RIFF(12) fmt(8+18) fact(8+4) JUNK(8+n) data(8) | samples
+static constexpr size_t kWAVRiffSizeOffset = 4;
+static constexpr size_t kWAVFactFramesOffset = 12 + 26 + 8;
+static constexpr size_t kWAVDataSizeOffset = kHeaderBytes - 4;
+
+// CAF layout: caff(8) desc(12+32) free(12+n) data(12+4) | samples
+static constexpr size_t kCAFDataSizeOffset = kHeaderBytes - 16 + 4;
+
+#pragma mark - AudioFile
+
+bool isPlainFileName(const char* name) {
+    return name && name[0] != '\0' && name[0] != '.' && std::strchr(name, '/') == nullptr &&
+           std::strlen(name) <= NAME_MAX;
+}
+
+int createOutputFile(const char* name, char* path, size_t pathSize) {
+    if (!isPlainFileName(name)) {
+        CYMAX_LOG_ERROR("AudioFile: rejected output name (plain file names only)");
+        errno = EINVAL;
+        return -1;
+    }
+    if (mkdir(kOutputDirectory, 0755) < 0 && errno != EEXIST) {
+        CYMAX_LOG_ERROR("AudioFile: cannot create %{public}s: %{public}s", kOutputDirectory, strerror(errno));
+        return -1;
+    }
+
+    // Someone else may have made the directory (or a symlink in its place)
+    const int directory = ::open(kOutputDirectory, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+    if (directory < 0) {
+        CYMAX_LOG_ERROR("AudioFile: cannot open %{public}s: %{public}s", kOutputDirectory, strerror(errno));
+        return -1;
+    }
+    struct stat info;
+    if (fstat(directory, &info) < 0 || info.st_uid != geteuid() || (info.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+        CYMAX_LOG_ERROR("AudioFile: %{public}s isn't ours alone, not writing to it", kOutputDirectory);
+        ::close(directory);
+        errno = EPERM;
+        return -1;
+    }
+
+    const int fd = openat(directory, name, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0644);
+    const int error = errno;
+    ::close(directory);
+    if (fd < 0) {
+        CYMAX_LOG_ERROR("AudioFile: cannot create %{public}s in %{public}s: %{public}s",
+                        name, kOutputDirectory, strerror(error));
+        errno = error;
+        return -1;
+    }
+    if (path && pathSize > 0) {
+        snprintf(path, pathSize, "%s/%s", kOutputDirectory, name);
+    }
+    return fd;
+}
+
+RecordingFormat formatForPath(const char* path) {
+    const char* dot = path ? std::strrchr(path, '.') : nullptr;
+    if (dot && strcasecmp(dot, ".caf") == 0) {
+        return RecordingFormat::CAF;
+    }
+    return RecordingFormat::WAV;
+}
+
+const char* formatName(RecordingFormat format) {
+    return format == RecordingFormat::CAF ? "CAF" : "WAV";
+}
+
+bool writeAt(int fd, const void* data, size_t bytes, uint64_t offset) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (bytes > 0) {
+        const ssize_t written = pwrite(fd, p, bytes, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            CYMAX_LOG_ERROR("AudioFile: write failed: %{public}s", strerror(errno));
+            return false;
+        }
+        p += written;
+        bytes -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+bool writeHeader(int fd, RecordingFormat format, double sampleRate, size_t channelCount) {
+    alignas(16) uint8_t header[kHeaderBytes];
+    std::memset(header, 0, sizeof(header));
+
+    const uint32_t channels = static_cast<uint32_t>(channelCount);
+    const uint32_t bytesPerFrame = channels * sizeof(float);
+
+    if (format == RecordingFormat::WAV) {
+        uint8_t* p = header;
+        putTag(p, "RIFF"); put32LE(p + 4, 0); putTag(p + 8, "WAVE"); p += 12;
+
+        putTag(p, "fmt "); put32LE(p + 4, 18);
+        put16LE(p + 8, 3);  // WAVE_FORMAT_IEEE_FLOAT
+        put16LE(p + 10, static_cast<uint16_t>(channels));
+        put32LE(p + 12, static_cast<uint32_t>(sampleRate));
+        put32LE(p + 16, static_cast<uint32_t>(sampleRate) * bytesPerFrame);
+        put16LE(p + 20, static_cast<uint16_t>(bytesPerFrame));
+        put16LE(p + 22, 32);
+        put16LE(p + 24, 0);  // cbSize
+        p += 26;
+
+        putTag(p, "fact"); put32LE(p + 4, 4); put32LE(p + 8, 0); p += 12;
+
+        // Pad so the samples start on an aligned offset
+        const size_t junk = kHeaderBytes - static_cast<size_t>(p - header) - 8 - 8;
+        putTag(p, "JUNK"); put32LE(p + 4, static_cast<uint32_t>(junk)); p += 8 + junk;
+
+        putTag(p, "data"); put32LE(p + 4, 0);
+    } else {
+        uint8_t* p = header;
+        putTag(p, "caff"); p[5] = 1; p += 8;  // Version 1 (big-endian), flags 0
+
+        putTag(p, "desc"); put64BE(p + 4, 32); p += 12;
+        uint64_t rateBits;
+        std::memcpy(&rateBits, &sampleRate, sizeof(rateBits));
+        put64BE(p, rateBits);
+        putTag(p + 8, "lpcm");
+        put32BE(p + 12, 1 | 2);  // IsFloat | IsLittleEndian
+        put32BE(p + 16, bytesPerFrame);
+        put32BE(p + 20, 1);
+        put32BE(p + 24, channels);
+        put32BE(p + 28, 32);
+        p += 32;
+
+        const size_t freeBytes = kHeaderBytes - static_cast<size_t>(p - header) - 12 - 16;
+        putTag(p, "free"); put64BE(p + 4, freeBytes); p += 12 + freeBytes;
+
+        // Size -1 means "to end of file" until finalizeHeader() patches it
+        putTag(p, "data"); put64BE(p + 4, ~0ULL); put32BE(p + 12, 0);  // edit count
+    }
+
+    return writeAt(fd, header, sizeof(header), 0);
+}
+
+bool finalizeHeader(int fd, RecordingFormat format, uint64_t dataBytes, size_t channels) {
+    if (fd < 0) {
+        return false;
+    }
+
+    uint8_t field[8];
+    if (format == RecordingFormat::WAV) {
+        const uint32_t size = static_cast<uint32_t>(dataBytes);
+        put32LE(field, static_cast<uint32_t>(kHeaderBytes - 8) + size);
+        bool ok = writeAt(fd, field, 4, kWAVRiffSizeOffset);
+        put32LE(field, static_cast<uint32_t>(dataBytes / (channels * sizeof(float))));
+        ok = writeAt(fd, field, 4, kWAVFactFramesOffset) && ok;
+        put32LE(field, size);
+        return writeAt(fd, field, 4, kWAVDataSizeOffset) && ok;
+    }
+
+    put64BE(field, dataBytes + 4);  // Includes the edit count
+    return writeAt(fd, field, 8, kCAFDataSizeOffset);
+}
+
+} // namespace AudioFile
+} // namespace Cymax
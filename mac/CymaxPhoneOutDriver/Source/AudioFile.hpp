@@ -0,0 +1,78 @@
+//
+//  AudioFile.hpp
+//  CymaxPhoneOutDriver
+//
+//  WAV/CAF header writing for 32-bit float files
+//
+//  Headers are padded to kHeaderBytes so sample data starts on an aligned
+//  file offset. writeHeader() leaves the sizes open; finalizeHeader()
+//  patches them once the data length is known.
+//
+//  Files the driver writes on a client's behalf (recordings, replay saves,
+//  packet captures) only ever go into kOutputDirectory: the driver runs as
+//  coreaudiod, and any HAL client can set the properties that name them.
+//
+
+#ifndef AudioFile_hpp
+#define AudioFile_hpp
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Cymax {
+
+/// Recording file format
+enum class RecordingFormat {
+    WAV,  // RIFF, 32-bit float
+    CAF   // Core Audio Format, 32-bit float little-endian
+};
+
+namespace AudioFile {
+
+/// Header size; sample data starts at this offset
+constexpr size_t kHeaderBytes = 4096;
+
+/// Largest WAV data chunk (32-bit RIFF sizes)
+constexpr uint64_t kMaxWAVDataBytes = 0xFFFFFFFFULL - kHeaderBytes;
+
+/// Directory for files written on a client's behalf, created on first use
+#if defined(__APPLE__)
+constexpr const char* kOutputDirectory = "/Users/Shared/CymaxPhoneOut";
+#else
+constexpr const char* kOutputDirectory = "/tmp/CymaxPhoneOut";
+#endif
+
+/// Whether a client-supplied name can be used in kOutputDirectory: not
+/// empty, no '/', and not starting with '.' (so never "." or "..")
+bool isPlainFileName(const char* name);
+
+/// Create a new file in kOutputDirectory for writing
+/// The directory must belong to this process's user and not be writable by
+/// others; neither it nor the file may be a symlink, and an existing file
+/// is never reused or truncated.
+/// @param name A plain file name (isPlainFileName)
+/// @param path Receives the full path (may be nullptr)
+/// @return File descriptor, or -1 with errno set
+int createOutputFile(const char* name, char* path, size_t pathSize);
+
+/// Format for a path (by extension): ".caf" selects CAF, anything else WAV
+RecordingFormat formatForPath(const char* path);
+
+/// Short display name ("WAV" / "CAF")
+const char* formatName(RecordingFormat format);
+
+/// Write all of a buffer at an offset, retrying short writes
+bool writeAt(int fd, const void* data, size_t bytes, uint64_t offset);
+
+/// Write a header with open-ended sizes
+bool writeHeader(int fd, RecordingFormat format, double sampleRate, size_t channels);
+
+/// Patch the sizes in a header written by writeHeader()
+/// @param dataBytes Bytes of sample data following the header
+bool finalizeHeader(int fd, RecordingFormat format, uint64_t dataBytes, size_t channels);
+
+} // namespace AudioFile
+
+} // namespace Cymax
+
+#endif /* AudioFile_hpp */
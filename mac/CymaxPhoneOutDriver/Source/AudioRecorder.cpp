@@ -0,0 +1,242 @@
+//
+//  AudioRecorder.cpp
+//  CymaxPhoneOutDriver
+//
+//  Background recorder implementation
+//
+
+#include "AudioRecorder.hpp"
+#include "AudioFile.hpp"
+#include "UDPSender.hpp"
+#include "SampleKernels.hpp"
+#include "Logging.hpp"
+#include "ThreadPriority.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+namespace Cymax {
+
+// Frames per discard read while both buffers are busy
+static constexpr size_t kDiscardFrames = 1024;
+
+#pragma mark - AudioRecorder
+
+AudioRecorder::AudioRecorder() {
+    for (WriteBuffer& buffer : m_buffers) {
+        buffer.samples = static_cast<float*>(std::aligned_alloc(kWriteAlignment, kBufferBytes));
+    }
+}
+
+AudioRecorder::~AudioRecorder() {
+    stop();
+    for (WriteBuffer& buffer : m_buffers) {
+        std::free(buffer.samples);
+    }
+}
+
+void AudioRecorder::initialize(RingBuffer<float>* ringBuffer, double sampleRate,
+                               const OutputControlState* controlState) {
+    if (isRecording()) {
+        CYMAX_LOG_ERROR("AudioRecorder: cannot initialize while recording");
+        return;
+    }
+    m_ringBuffer = ringBuffer;
+    m_sampleRate = sampleRate;
+    m_controlState = controlState;
+    m_channels = ringBuffer ? ringBuffer->channelCount() : 2;
+    m_bufferFrames = kBufferBytes / (m_channels * sizeof(float));
+}
+
+bool AudioRecorder::start(const char* name) {
+    if (isRecording()) {
+        stop();
+    }
+    if (!m_ringBuffer || !AudioFile::isPlainFileName(name)) {
+        return false;
+    }
+
+    m_fd = AudioFile::createOutputFile(name, m_path, sizeof(m_path));
+    if (m_fd < 0) {
+        return false;
+    }
+    m_format = AudioFile::formatForPath(m_path);
+#ifdef F_NOCACHE
+    // Streaming write-once data; don't push other files out of the cache
+    fcntl(m_fd, F_NOCACHE, 1);
+#endif
+
+    m_dataBytes = 0;
+    m_diskFull = false;
+    if (!AudioFile::writeHeader(m_fd, m_format, m_sampleRate, m_channels)) {
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+
+    for (WriteBuffer& buffer : m_buffers) {
+        buffer.frames = 0;
+        buffer.full.store(false, std::memory_order_relaxed);
+    }
+    m_active = 0;
+    m_framesWritten.store(0, std::memory_order_relaxed);
+    m_framesDropped.store(0, std::memory_order_relaxed);
+    m_tap = m_ringBuffer->makeTap();
+
+    m_shouldStop.store(false, std::memory_order_release);
+    m_captureDone.store(false, std::memory_order_release);
+    m_writerThread = std::thread(&AudioRecorder::writerThreadFunc, this);
+    m_captureThread = std::thread(&AudioRecorder::captureThreadFunc, this);
+    m_recording.store(true, std::memory_order_release);
+
+    CYMAX_LOG_INFO("AudioRecorder: recording to %{public}s (%{public}s)",
+                   m_path, AudioFile::formatName(m_format));
+    return true;
+}
+
+void AudioRecorder::stop() {
+    if (!m_recording.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    // Capture submits its partial buffer on the way out, then the writer
+    // drains and exits
+    m_shouldStop.store(true, std::memory_order_release);
+    if (m_captureThread.joinable()) {
+        m_captureThread.join();
+    }
+    m_captureDone.store(true, std::memory_order_release);
+    m_writerWake.notify_one();
+    if (m_writerThread.joinable()) {
+        m_writerThread.join();
+    }
+
+    AudioFile::finalizeHeader(m_fd, m_format, m_dataBytes, m_channels);
+    close(m_fd);
+    m_fd = -1;
+
+    m_recording.store(false, std::memory_order_release);
+    CYMAX_LOG_INFO("AudioRecorder: stopped %{public}s (written: %llu frames, dropped: %llu)",
+                   m_path, framesWritten(), framesDropped());
+}
+
+bool AudioRecorder::submitActive() {
+    const size_t other = 1 - m_active;
+    if (m_buffers[other].full.load(std::memory_order_acquire)) {
+        return false;
+    }
+    m_buffers[m_active].full.store(true, std::memory_order_release);
+    m_writerWake.notify_one();
+    m_active = other;
+    m_buffers[m_active].frames = 0;
+    return true;
+}
+
+void AudioRecorder::captureThreadFunc() {
+    ThreadPriority::setUtility();
+
+    const Kernels::KernelTable& kernels = Kernels::active();
+    float discard[kDiscardFrames * 8];
+    const size_t discardFrames = sizeof(discard) / sizeof(float) / m_channels;
+    uint64_t skippedSeen = 0;
+
+    for (;;) {
+        const bool stopping = m_shouldStop.load(std::memory_order_acquire);
+
+        for (;;) {
+            WriteBuffer& buffer = m_buffers[m_active];
+            if (buffer.frames == m_bufferFrames && !submitActive()) {
+                // Both buffers busy: the disk is behind. Keep up with the
+                // ring and count what we can't keep.
+                const size_t got = m_ringBuffer->tapRead(m_tap, discard, discardFrames);
+                if (got == 0) break;
+                m_framesDropped.fetch_add(got, std::memory_order_relaxed);
+                continue;
+            }
+
+            WriteBuffer& target = m_buffers[m_active];
+            float* dest = target.samples + target.frames * m_channels;
+            const size_t got = m_ringBuffer->tapRead(m_tap, dest, m_bufferFrames - target.frames);
+            if (got == 0) break;
+
+            // Match what the sender transmits (without its 10 ms ramp)
+            if (m_controlState) {
+                const float scalar = m_controlState->volumeScalar.load(std::memory_order_relaxed);
+                const float gain = m_controlState->muted.load(std::memory_order_relaxed) ? 0.0f : scalar * scalar;
+                if (gain != 1.0f) {
+                    kernels.applyGain(dest, got * m_channels, gain);
+                }
+            }
+            target.frames += got;
+        }
+
+        if (m_tap.framesSkipped != skippedSeen) {
+            m_framesDropped.fetch_add(m_tap.framesSkipped - skippedSeen, std::memory_order_relaxed);
+            skippedSeen = m_tap.framesSkipped;
+        }
+
+        if (stopping) {
+            break;
+        }
+
+        struct timespec ts = {0, 10000000};  // 10ms
+        nanosleep(&ts, nullptr);
+    }
+
+    // Flush the partial buffer, waiting (off every audio path) for the writer
+    if (m_buffers[m_active].frames > 0) {
+        while (!submitActive()) {
+            struct timespec ts = {0, 1000000};  // 1ms
+            nanosleep(&ts, nullptr);
+        }
+    }
+}
+
+void AudioRecorder::writerThreadFunc() {
+    ThreadPriority::setUtility();
+
+    for (;;) {
+        // At most one buffer is full at a time, so order is preserved
+        WriteBuffer* pending = nullptr;
+        for (WriteBuffer& buffer : m_buffers) {
+            if (buffer.full.load(std::memory_order_acquire)) {
+                pending = &buffer;
+            }
+        }
+
+        if (!pending) {
+            if (m_captureDone.load(std::memory_order_acquire)) {
+                break;
+            }
+            // Timed wait: the capture thread notifies without the lock
+            std::unique_lock<std::mutex> lock(m_writerMutex);
+            m_writerWake.wait_for(lock, std::chrono::milliseconds(50));
+            continue;
+        }
+
+        const size_t bytes = pending->frames * m_channels * sizeof(float);
+        const bool overLimit = m_format == RecordingFormat::WAV && m_dataBytes + bytes > AudioFile::kMaxWAVDataBytes;
+
+        if (!m_diskFull && !overLimit &&
+            AudioFile::writeAt(m_fd, pending->samples, bytes, AudioFile::kHeaderBytes + m_dataBytes)) {
+            m_dataBytes += bytes;
+            m_framesWritten.fetch_add(pending->frames, std::memory_order_relaxed);
+        } else {
+            if (overLimit && !m_diskFull) {
+                CYMAX_LOG_ERROR("AudioRecorder: WAV size limit reached, dropping further audio");
+            }
+            m_diskFull = true;
+            m_framesDropped.fetch_add(pending->frames, std::memory_order_relaxed);
+        }
+
+        pending->full.store(false, std::memory_order_release);
+    }
+}
+
+} // namespace Cymax
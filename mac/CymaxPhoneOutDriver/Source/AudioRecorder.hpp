@@ -0,0 +1,122 @@
+//
+//  AudioRecorder.hpp
+//  CymaxPhoneOutDriver
+//
+//  Background recorder of device output to WAV or CAF
+//
+//  A capture thread follows the ring buffer with its own TapCursor and
+//  fills one of two preallocated, page-aligned buffers; a writer thread
+//  writes full buffers to disk with large aligned pwrite() calls. The
+//  file header is padded to kWriteAlignment so every data write starts on
+//  an aligned file offset.
+//
+//  If the disk stalls long enough that both buffers are full, incoming
+//  frames are dropped and counted. Neither the render thread nor the
+//  UDP sender ever waits on the recorder.
+//
+
+#ifndef AudioRecorder_hpp
+#define AudioRecorder_hpp
+
+#include "RingBuffer.hpp"
+#include "AudioFile.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace Cymax {
+
+struct OutputControlState;
+
+/// Recorder of device output
+class AudioRecorder {
+public:
+    AudioRecorder();
+    ~AudioRecorder();
+
+    // Non-copyable
+    AudioRecorder(const AudioRecorder&) = delete;
+    AudioRecorder& operator=(const AudioRecorder&) = delete;
+
+    /// Set the audio source (call when not recording)
+    /// @param ringBuffer Device ring buffer to tap
+    /// @param sampleRate Sample rate in Hz
+    /// @param controlState Volume/mute to apply so the file matches what is
+    ///        sent; may be nullptr
+    void initialize(RingBuffer<float>* ringBuffer, double sampleRate,
+                    const OutputControlState* controlState);
+
+    /// Start recording to a new file in AudioFile::kOutputDirectory
+    /// @param name File name, no directories; ".caf" selects CAF, anything
+    ///        else WAV. An existing file is never overwritten.
+    /// @return true if the file was created and recording started
+    bool start(const char* name);
+
+    /// Stop recording, flush and finalize the file header
+    void stop();
+
+    bool isRecording() const { return m_recording.load(std::memory_order_acquire); }
+
+    /// Path of the current (or last) recording
+    const char* path() const { return m_path; }
+
+    /// Frames written to disk
+    uint64_t framesWritten() const { return m_framesWritten.load(std::memory_order_relaxed); }
+
+    /// Frames dropped because the disk fell behind (or the tap lagged)
+    uint64_t framesDropped() const { return m_framesDropped.load(std::memory_order_relaxed); }
+
+    static constexpr size_t kWriteAlignment = AudioFile::kHeaderBytes;
+    static constexpr size_t kBufferBytes = 256 * 1024;
+
+private:
+    struct WriteBuffer {
+        float* samples = nullptr;
+        size_t frames = 0;
+        std::atomic<bool> full{false};
+    };
+
+    void captureThreadFunc();
+    void writerThreadFunc();
+
+    /// Hand the filling buffer to the writer and switch to the other one
+    /// @return false if the other buffer is still being written
+    bool submitActive();
+
+    RingBuffer<float>* m_ringBuffer = nullptr;
+    const OutputControlState* m_controlState = nullptr;
+    double m_sampleRate = 48000.0;
+    size_t m_channels = 2;
+    size_t m_bufferFrames = 0;
+
+    // File
+    int m_fd = -1;
+    RecordingFormat m_format = RecordingFormat::WAV;
+    char m_path[256] = {0};
+    uint64_t m_dataBytes = 0;  // Writer thread only
+    bool m_diskFull = false;   // Writer thread only
+
+    // Double buffer
+    WriteBuffer m_buffers[2];
+    size_t m_active = 0;  // Capture thread only
+    TapCursor m_tap;
+
+    // Threads
+    std::thread m_captureThread;
+    std::thread m_writerThread;
+    std::atomic<bool> m_recording{false};
+    std::atomic<bool> m_shouldStop{false};
+    std::atomic<bool> m_captureDone{false};
+    std::mutex m_writerMutex;
+    std::condition_variable m_writerWake;
+
+    // Statistics
+    std::atomic<uint64_t> m_framesWritten{0};
+    std::atomic<uint64_t> m_framesDropped{0};
+};
+
+} // namespace Cymax
+
+#endif /* AudioRecorder_hpp */
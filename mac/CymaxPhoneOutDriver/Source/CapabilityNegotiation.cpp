@@ -0,0 +1,312 @@
+//
+//  CapabilityNegotiation.cpp
+//  CymaxPhoneOutDriver
+//
+//  Stream profile negotiation implementation
+//
+
+#include "CapabilityNegotiation.hpp"
+#include "PacketTransport.hpp"
+#include "UDPSender.hpp"
+#include "Logging.hpp"
+
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstring>
+
+namespace Cymax {
+
+// Replies read per poll (one per destination, with room for stragglers)
+static constexpr size_t kMaxRepliesPerPoll = 2 * CapabilityNegotiator::kMaxPeers;
+
+static uint16_t sampleFormat(bool float32) {
+    return float32 ? kSampleFormatFloat32 : kSampleFormatInt16;
+}
+
+static uint32_t addressIP(uint64_t address) {
+    return static_cast<uint32_t>(address >> 16);
+}
+
+#pragma mark - Profile choice
+
+double wireBytesPerSecond(uint32_t sampleRate, uint16_t channels, uint16_t framesPerPacket,
+                          bool float32, uint16_t fecGroupSize) {
+    const size_t sampleBytes = float32 ? sizeof(float) : sizeof(int16_t);
+    const double packetBytes = static_cast<double>(kPacketHeaderBytes + framesPerPacket * channels * sampleBytes);
+    const double packetsPerSecond = static_cast<double>(sampleRate) / static_cast<double>(framesPerPacket);
+    const double parityShare = fecGroupSize > 0 ? 1.0 / static_cast<double>(fecGroupSize) : 0.0;
+    return packetsPerSecond * packetBytes * (1.0 + parityShare);
+}
+
+static bool canPlay(const ReceiverCapabilities& capabilities, const NegotiationOffer& offer,
+                    bool float32, uint16_t fecGroupSize) {
+    bool anyRate = true;
+    bool rateListed = false;
+    for (uint32_t rate : capabilities.sampleRates) {
+        anyRate = anyRate && rate == 0;
+        rateListed = rateListed || rate == offer.sampleRate;
+    }
+
+    const size_t sampleBytes = float32 ? sizeof(float) : sizeof(int16_t);
+    const size_t packetBytes = kPacketHeaderBytes + offer.framesPerPacket * offer.channels * sampleBytes;
+    return (anyRate || rateListed) &&
+           offer.channels <= capabilities.maxChannels &&
+           (capabilities.codecs & (1u << kCodecPCM)) != 0 &&
+           (capabilities.formats & (1u << sampleFormat(float32))) != 0 &&
+           packetBytes <= capabilities.maxPacketBytes &&
+           fecGroupSize <= capabilities.maxFECGroup;
+}
+
+bool chooseProfile(const NegotiationOffer& offer, const ReceiverCapabilities* capabilities, size_t count,
+                   size_t legacyCount, NegotiatedProfile& profile) {
+    profile = NegotiatedProfile();
+    profile.useFloat32 = offer.legacyFloat32;
+    profile.fecGroupSize = offer.legacyFECGroup;
+    profile.responders = count;
+    profile.legacy = legacyCount;
+
+    // Largest parity group everyone decodes
+    uint16_t fecGroupSize = offer.maxFECGroup;
+    for (size_t i = 0; i < count; ++i) {
+        fecGroupSize = std::min(fecGroupSize, capabilities[i].maxFECGroup);
+        profile.bufferMs = std::max(profile.bufferMs, capabilities[i].bufferMs);
+    }
+
+    // Receivers that didn't answer only take what they always got
+    struct Candidate {
+        bool float32;
+        uint16_t fecGroupSize;
+    };
+    Candidate candidates[2];
+    size_t candidateCount = 0;
+    if (legacyCount > 0) {
+        candidates[candidateCount++] = {offer.legacyFloat32, offer.legacyFECGroup};
+    } else {
+        candidates[candidateCount++] = {false, fecGroupSize};
+        candidates[candidateCount++] = {true, fecGroupSize};
+    }
+
+    double cheapest = 0.0;
+    for (size_t c = 0; c < candidateCount; ++c) {
+        const Candidate& candidate = candidates[c];
+        bool everyone = true;
+        for (size_t i = 0; i < count && everyone; ++i) {
+            everyone = canPlay(capabilities[i], offer, candidate.float32, candidate.fecGroupSize);
+        }
+        if (!everyone) {
+            continue;
+        }
+
+        const double cost = wireBytesPerSecond(offer.sampleRate, offer.channels, offer.framesPerPacket,
+                                               candidate.float32, candidate.fecGroupSize);
+        if (!profile.agreed || cost < cheapest) {
+            profile.useFloat32 = candidate.float32;
+            profile.fecGroupSize = candidate.fecGroupSize;
+            profile.agreed = true;
+            cheapest = cost;
+        }
+    }
+    return profile.agreed;
+}
+
+#pragma mark - Negotiator
+
+void CapabilityNegotiator::reset() {
+    m_open = false;
+    m_started = false;
+    m_roundsFinished = 0;
+    m_peerCount = 0;
+    m_resyncCount = 0;
+    m_nextReceiveNanos = 0;
+    m_haveSendErrorMark = false;
+    m_sawSendErrors = false;
+    m_restartRequested.store(true, std::memory_order_release);
+}
+
+bool CapabilityNegotiator::poll(uint64_t now, UDPTransport& udp, const uint64_t* destinations, size_t count,
+                                const NegotiationOffer& offer, uint64_t sendErrors, NegotiatedProfile& profile) {
+    // Failures and then a quiet spell: the receiver went away and came back
+    if (!m_haveSendErrorMark) {
+        m_sendErrorMark = sendErrors;
+        m_haveSendErrorMark = true;
+    } else if (sendErrors != m_sendErrorMark) {
+        m_sendErrorMark = sendErrors;
+        m_lastSendErrorNanos = now;
+        m_sawSendErrors = true;
+    } else if (m_sawSendErrors && now - m_lastSendErrorNanos >= kRecoveryNanos) {
+        m_sawSendErrors = false;
+        CYMAX_LOG_INFO("CapabilityNegotiator: sends recovered, renegotiating");
+        restart();
+    }
+
+    if (m_open || now >= m_nextReceiveNanos) {
+        receive(udp, destinations, count);
+        m_nextReceiveNanos = now + kIdleReceiveIntervalNanos;
+    }
+
+    if (m_restartRequested.load(std::memory_order_acquire) &&
+        (!m_started || now - m_roundStartNanos >= kMinRoundIntervalNanos)) {
+        m_restartRequested.store(false, std::memory_order_relaxed);
+        begin(now, destinations, count);
+    }
+    if (!m_open) {
+        return false;
+    }
+
+    const bool everyoneAnswered = std::all_of(m_peers, m_peers + m_peerCount,
+                                              [](const Peer& peer) { return peer.answered; });
+    if (everyoneAnswered || (m_queriesSent == kQueryAttempts && now >= m_nextQueryNanos)) {
+        return finish(udp, offer, profile);
+    }
+
+    if (now >= m_nextQueryNanos) {
+        // Tell receivers what they'd get by default
+        StreamDescription stream;
+        stream.sampleRate = offer.sampleRate;
+        stream.channels = offer.channels;
+        stream.format = sampleFormat(offer.legacyFloat32);
+        stream.codec = kCodecPCM;
+        stream.framesPerPacket = offer.framesPerPacket;
+        stream.fecGroupSize = offer.legacyFECGroup;
+        stream.bufferMs = 0;
+        for (size_t i = 0; i < m_peerCount; ++i) {
+            if (!m_peers[i].answered) {
+                send(udp, m_peers[i].address, NegotiationMessage::Query, stream);
+            }
+        }
+        ++m_queriesSent;
+        m_nextQueryNanos = now + kQueryIntervalNanos;
+    }
+    return false;
+}
+
+bool CapabilityNegotiator::takeResync(uint64_t& address) {
+    if (m_resyncCount == 0) {
+        return false;
+    }
+    address = m_resyncs[--m_resyncCount];
+    return true;
+}
+
+void CapabilityNegotiator::begin(uint64_t now, const uint64_t* destinations, size_t count) {
+    m_peerCount = std::min(count, kMaxPeers);
+    m_open = m_peerCount > 0;
+    if (!m_open) {
+        return;  // Nothing to ask; a destination change restarts the round
+    }
+
+    m_round = m_round == UINT32_MAX ? 1 : m_round + 1;  // 0 marks unsolicited replies
+    m_started = true;
+    m_roundStartNanos = now;
+    m_nextQueryNanos = now;
+    m_queriesSent = 0;
+    for (size_t i = 0; i < m_peerCount; ++i) {
+        m_peers[i] = Peer();
+        m_peers[i].address = destinations[i];
+    }
+}
+
+void CapabilityNegotiator::receive(UDPTransport& udp, const uint64_t* destinations, size_t count) {
+    uint8_t message[128];
+    for (size_t i = 0; i < kMaxRepliesPerPoll; ++i) {
+        uint64_t from = 0;
+        const ssize_t size = udp.receive(message, sizeof(message), from);
+        if (size < 0) {
+            return;
+        }
+
+        // Later versions may append fields
+        NegotiationHeader header;
+        ReceiverCapabilities capabilities;
+        if (static_cast<size_t>(size) < sizeof(header) + sizeof(capabilities)) {
+            continue;
+        }
+        std::memcpy(&header, message, sizeof(header));
+        if (header.magic != NegotiationHeader::kMagic || header.version < NegotiationHeader::kVersion ||
+            header.type != static_cast<uint16_t>(NegotiationMessage::Capabilities)) {
+            continue;
+        }
+        std::memcpy(&capabilities, message + sizeof(header), sizeof(capabilities));
+
+        if (header.round == 0) {
+            // Only a configured destination may restart the round and get
+            // a pre-roll burst; anyone else on the network is ignored
+            const uint64_t* destination = std::find_if(destinations, destinations + count, [from](uint64_t address) {
+                return addressIP(address) == addressIP(from);
+            });
+            if (destination == destinations + count) {
+                continue;
+            }
+            char ip[INET_ADDRSTRLEN] = {0};
+            struct in_addr addr;
+            addr.s_addr = addressIP(from);
+            inet_ntop(AF_INET, &addr, ip, sizeof(ip));
+            CYMAX_LOG_INFO("CapabilityNegotiator: %{public}s asked to renegotiate", ip);
+            restart();
+            if (m_resyncCount < kMaxPeers) {
+                m_resyncs[m_resyncCount++] = *destination;
+            }
+            continue;
+        }
+        if (!m_open || header.round != m_round) {
+            continue;  // Late answer to an earlier round
+        }
+
+        // Receivers answer from the audio port, so match on the address alone
+        for (size_t p = 0; p < m_peerCount; ++p) {
+            if (addressIP(m_peers[p].address) == addressIP(from)) {
+                m_peers[p].answered = true;
+                m_peers[p].capabilities = capabilities;
+            }
+        }
+    }
+}
+
+void CapabilityNegotiator::send(UDPTransport& udp, uint64_t address, NegotiationMessage type,
+                                const StreamDescription& stream) {
+    NegotiationHeader header;
+    header.magic = NegotiationHeader::kMagic;
+    header.version = NegotiationHeader::kVersion;
+    header.type = static_cast<uint16_t>(type);
+    header.round = m_round;
+
+    uint8_t message[sizeof(header) + sizeof(stream)];
+    std::memcpy(message, &header, sizeof(header));
+    std::memcpy(message + sizeof(header), &stream, sizeof(stream));
+
+    // Lost or pushed back: the next query retries, and a lost Select only
+    // costs the receiver the announcement (the packet headers say the same)
+    udp.send(message, sizeof(message), address);
+}
+
+bool CapabilityNegotiator::finish(UDPTransport& udp, const NegotiationOffer& offer, NegotiatedProfile& profile) {
+    ReceiverCapabilities answered[kMaxPeers];
+    size_t count = 0;
+    for (size_t i = 0; i < m_peerCount; ++i) {
+        if (m_peers[i].answered) {
+            answered[count++] = m_peers[i].capabilities;
+        }
+    }
+    chooseProfile(offer, answered, count, m_peerCount - count, profile);
+
+    StreamDescription stream;
+    stream.sampleRate = offer.sampleRate;
+    stream.channels = offer.channels;
+    stream.format = sampleFormat(profile.useFloat32);
+    stream.codec = kCodecPCM;
+    stream.framesPerPacket = offer.framesPerPacket;
+    stream.fecGroupSize = profile.fecGroupSize;
+    stream.bufferMs = profile.bufferMs;
+    for (size_t i = 0; i < m_peerCount; ++i) {
+        if (m_peers[i].answered) {
+            send(udp, m_peers[i].address, NegotiationMessage::Select, stream);
+        }
+    }
+
+    m_open = false;
+    ++m_roundsFinished;
+    return true;
+}
+
+} // namespace Cymax
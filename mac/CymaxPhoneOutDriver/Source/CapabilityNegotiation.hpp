@@ -0,0 +1,213 @@
+//
+//  CapabilityNegotiation.hpp
+//  CymaxPhoneOutDriver
+//
+//  Stream profile negotiation between the sender and its receivers
+//
+//  When a session starts, the sender sends a Query to every UDP
+//  destination. The Query goes from the audio socket to the audio port.
+//  A receiver that knows the exchange answers from that port with its
+//  Capabilities. The sender then picks the cheapest profile every
+//  destination can play and announces it with a Select.
+//
+//  A receiver that doesn't answer within the query window gets the
+//  configured profile, so receivers that predate negotiation see exactly
+//  the stream they always did. Negotiation messages have their own magic
+//  ('CNEG'), which those receivers discard as not-audio.
+//
+//  Audio keeps flowing in the current profile while a round is open, and
+//  the choice applies from the next packet. The packet size is fixed for
+//  the session, so only the sample format and the FEC group change.
+//
+//  A round restarts when:
+//  - the destinations change
+//  - sends start failing and then recover (e.g. the network was
+//    unreachable while Wi-Fi reconnected)
+//  - a destination sends unsolicited Capabilities (it restarted or
+//    resynced); from any other address they are ignored
+//
+//  Wire format mirrored in Negotiation.swift (CymaxAudioProtocol).
+//
+
+#ifndef CapabilityNegotiation_hpp
+#define CapabilityNegotiation_hpp
+
+#include "ControlBlock.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Cymax {
+
+class UDPTransport;
+
+/// Sample formats in the audio packet header's format field
+static constexpr uint16_t kSampleFormatFloat32 = 1;
+static constexpr uint16_t kSampleFormatInt16 = 2;
+
+/// Payload codecs (PCM is the only one the packet path produces)
+static constexpr uint16_t kCodecPCM = 0;
+
+/// Negotiation message types
+enum class NegotiationMessage : uint16_t {
+    Query = 1,         // Sender -> receiver: StreamDescription of the default profile
+    Capabilities = 2,  // Receiver -> sender: ReceiverCapabilities
+    Select = 3         // Sender -> receiver: StreamDescription of the chosen profile
+};
+
+#pragma pack(push, 1)
+struct NegotiationHeader {
+    static constexpr uint32_t kMagic = 0x47454E43;  // 'CNEG' in LE
+    static constexpr uint16_t kVersion = 1;
+
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;   // NegotiationMessage
+    uint32_t round;  // Sender's round; Capabilities echo it, or send 0 unasked
+};
+
+/// A stream as the sender will send it
+struct StreamDescription {
+    uint32_t sampleRate;
+    uint16_t channels;
+    uint16_t format;           // kSampleFormat*
+    uint16_t codec;            // kCodec*
+    uint16_t framesPerPacket;
+    uint16_t fecGroupSize;     // Audio packets per parity packet (0 = none)
+    uint16_t bufferMs;         // Receiver's preferred depth (Select only)
+};
+
+/// What a receiver can play
+struct ReceiverCapabilities {
+    static constexpr size_t kMaxSampleRates = 8;
+
+    uint32_t sampleRates[kMaxSampleRates];  // 0 = unused; all 0 = any rate
+    uint16_t maxChannels;
+    uint16_t formats;          // Bit (1 << kSampleFormat*) per format played
+    uint16_t codecs;           // Bit (1 << kCodec*) per codec decoded
+    uint16_t maxPacketBytes;   // Largest datagram accepted, header included
+    uint16_t maxFECGroup;      // Largest parity group decoded (0 = no FEC)
+    uint16_t bufferMs;         // Preferred jitter buffer depth
+};
+#pragma pack(pop)
+
+static_assert(sizeof(NegotiationHeader) == 12 && sizeof(StreamDescription) == 16 &&
+              sizeof(ReceiverCapabilities) == 44, "Negotiation messages are read by other apps");
+
+/// What the sender can vary this session
+struct NegotiationOffer {
+    uint32_t sampleRate = 0;
+    uint16_t channels = 0;
+    uint16_t framesPerPacket = 0;
+    bool legacyFloat32 = true;     // Format for receivers that don't negotiate
+    uint16_t legacyFECGroup = 0;   // FEC group for receivers that don't negotiate
+    uint16_t maxFECGroup = 0;      // Largest parity group the sender uses (0 = never)
+};
+
+/// Outcome of a round
+struct NegotiatedProfile {
+    bool useFloat32 = true;
+    uint16_t fecGroupSize = 0;
+    uint16_t bufferMs = 0;         // Deepest preferred buffer among receivers (0 = unknown)
+    bool agreed = false;           // false: no common profile, legacy kept
+    size_t responders = 0;         // Destinations that answered
+    size_t legacy = 0;             // Destinations that didn't
+};
+
+/// Bytes per second on the wire for a profile, parity included
+double wireBytesPerSecond(uint32_t sampleRate, uint16_t channels, uint16_t framesPerPacket,
+                          bool float32, uint16_t fecGroupSize);
+
+/// Cheapest profile every receiver can play
+/// With any legacy receivers, only the legacy profile qualifies. Otherwise
+/// the cheaper format wins, with FEC at the largest group every receiver
+/// decodes (least parity overhead). bufferMs is the deepest preference.
+/// @param capabilities One per receiver that answered
+/// @param legacyCount Receivers that didn't answer
+/// @return false if they share none (profile then holds the legacy profile)
+bool chooseProfile(const NegotiationOffer& offer, const ReceiverCapabilities* capabilities, size_t count,
+                   size_t legacyCount, NegotiatedProfile& profile);
+
+/// Runs negotiation rounds for one sender
+/// Owned by the thread that builds packets; restart() may be called from
+/// any thread.
+class CapabilityNegotiator {
+public:
+    static constexpr size_t kMaxPeers = ControlBlockPage::kMaxDestinations;
+
+    /// Queries per round, and the gap between them (the window is ~200 ms)
+    static constexpr uint32_t kQueryAttempts = 4;
+    static constexpr uint64_t kQueryIntervalNanos = 50000000;
+
+    /// Rounds start no more often than this
+    static constexpr uint64_t kMinRoundIntervalNanos = 1000000000;
+
+    /// Sends count as recovered after this long without a failure
+    static constexpr uint64_t kRecoveryNanos = 250000000;
+
+    /// Between rounds the socket is read for unsolicited Capabilities only
+    /// this often (a recvfrom() per packet would be wasted)
+    static constexpr uint64_t kIdleReceiveIntervalNanos = 20000000;
+
+    /// Forget every round (session start)
+    void reset();
+
+    /// Start a new round at the next poll()
+    void restart() { m_restartRequested.store(true, std::memory_order_release); }
+
+    /// Send due queries, read replies and decide when the round is over
+    /// @param destinations Packed UDP destinations (UDPTransport::packAddress)
+    /// @param sendErrors Failed sends so far (a run of failures followed by
+    ///        success restarts the round)
+    /// @return true when a round finished; profile then holds its outcome
+    bool poll(uint64_t now, UDPTransport& udp, const uint64_t* destinations, size_t count,
+              const NegotiationOffer& offer, uint64_t sendErrors, NegotiatedProfile& profile);
+
+    /// Rounds finished since reset()
+    uint32_t rounds() const { return m_roundsFinished; }
+
+    /// Next receiver that asked to resync (unsolicited Capabilities) since
+    /// the last call, for the pre-roll burst
+    /// @param address Its packed address
+    /// @return false if there are none
+    bool takeResync(uint64_t& address);
+
+private:
+    struct Peer {
+        uint64_t address = 0;
+        bool answered = false;
+        ReceiverCapabilities capabilities = {};
+    };
+
+    void begin(uint64_t now, const uint64_t* destinations, size_t count);
+    /// Read Capabilities; unsolicited ones count only from a destination
+    void receive(UDPTransport& udp, const uint64_t* destinations, size_t count);
+    void send(UDPTransport& udp, uint64_t address, NegotiationMessage type, const StreamDescription& stream);
+    bool finish(UDPTransport& udp, const NegotiationOffer& offer, NegotiatedProfile& profile);
+
+    std::atomic<bool> m_restartRequested{false};
+    bool m_open = false;
+    uint32_t m_round = 0;
+    uint32_t m_roundsFinished = 0;
+    uint32_t m_queriesSent = 0;
+    uint64_t m_nextQueryNanos = 0;
+    uint64_t m_roundStartNanos = 0;
+    uint64_t m_nextReceiveNanos = 0;
+    bool m_started = false;
+    Peer m_peers[kMaxPeers];
+    size_t m_peerCount = 0;
+
+    // Receivers that asked to resync, not yet taken
+    uint64_t m_resyncs[kMaxPeers] = {};
+    size_t m_resyncCount = 0;
+
+    // Disruption tracking: failures seen, and when the last one was
+    uint64_t m_sendErrorMark = 0;
+    uint64_t m_lastSendErrorNanos = 0;
+    bool m_haveSendErrorMark = false;
+    bool m_sawSendErrors = false;
+};
+
+} // namespace Cymax
+
+#endif /* CapabilityNegotiation_hpp */
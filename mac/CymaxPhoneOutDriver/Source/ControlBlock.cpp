@@ -0,0 +1,76 @@
+//
+//  ControlBlock.cpp
+//  CymaxPhoneOutDriver
+//
+//  Shared control block implementation
+//
+
+#include "ControlBlock.hpp"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <new>
+
+namespace Cymax {
+
+bool ControlBlock::open(const char* name) {
+    m_page = nullptr;
+    if (!m_region.open(name, sizeof(ControlBlockPage), 0660)) {
+        return false;
+    }
+
+    ControlBlockPage* page = static_cast<ControlBlockPage*>(m_region.data());
+    if (page->magic != ControlBlockPage::kMagic) {
+        // Fresh file: publish an empty block the menubar app can fill in
+        page = new (m_region.data()) ControlBlockPage;
+        page->version = ControlBlockPage::kVersion;
+        page->generation.store(0, std::memory_order_relaxed);
+        page->destPort = 0;
+        page->profile = static_cast<uint16_t>(StreamProfile::Float32);
+        page->destinationCount = 0;
+        std::fill(std::begin(page->destinations), std::end(page->destinations), 0u);
+        page->idleTeardownSeconds.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        page->magic = ControlBlockPage::kMagic;
+    } else if (page->version != ControlBlockPage::kVersion) {
+        CYMAX_LOG_ERROR("ControlBlock: unsupported version %u", page->version);
+        m_region.close();
+        return false;
+    }
+
+    m_page = page;
+    return true;
+}
+
+bool ControlBlock::readIfChanged(uint32_t& generation, ControlSettings& out) const {
+    if (!m_page) {
+        return false;
+    }
+
+    const uint32_t before = m_page->generation.load(std::memory_order_acquire);
+    if (before == generation || (before & 1) != 0) {
+        return false;  // Unchanged, or mid-write (picked up next packet)
+    }
+
+    ControlSettings settings;
+    settings.generation = before;
+    settings.destPort = m_page->destPort;
+    const uint16_t profile = m_page->profile;
+    settings.destinationCount = std::min<size_t>(m_page->destinationCount, ControlBlockPage::kMaxDestinations);
+    for (size_t i = 0; i < settings.destinationCount; ++i) {
+        settings.destinations[i] = m_page->destinations[i];
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_page->generation.load(std::memory_order_relaxed) != before) {
+        return false;
+    }
+
+    settings.profile = profile == static_cast<uint16_t>(StreamProfile::Int16) ? StreamProfile::Int16
+                                                                              : StreamProfile::Float32;
+    generation = before;
+    out = settings;
+    return true;
+}
+
+} // namespace Cymax
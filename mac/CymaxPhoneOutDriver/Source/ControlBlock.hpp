@@ -0,0 +1,103 @@
+//
+//  ControlBlock.hpp
+//  CymaxPhoneOutDriver
+//
+//  Shared control block written by the menubar app
+//
+//  Replaces the /tmp/cymax_dest_ip.txt handoff, which was read with
+//  blocking file I/O in startIO and only took effect on the next start.
+//  The menubar app writes destinations, port and stream profile into a
+//  small shared page (kName in SharedMemoryRegion::kDirectory) and bumps
+//  its generation; the sender compares the generation once per packet
+//  (one load, no system calls) and applies changes immediately.
+//
+//  The driver creates the page, mode 0660: the menubar app writes it
+//  through the directory's group, and other local users can neither
+//  redirect the audio nor truncate the page under coreaudiod.
+//
+
+#ifndef ControlBlock_hpp
+#define ControlBlock_hpp
+
+#include "SharedMemoryRegion.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Cymax {
+
+/// Audio payload format selected by the menubar app
+enum class StreamProfile : uint16_t {
+    Float32 = 0,
+    Int16 = 1
+};
+
+/// Layout of the shared control page (mirrored in DriverCommunication.swift)
+/// Seqlock: generation is odd while the menubar app is writing and 0 until
+/// it first writes. Readers copy the fields and discard the copy if the
+/// generation was odd or changed meanwhile.
+struct ControlBlockPage {
+    static constexpr uint32_t kMagic = 0x4C544343;  // 'CCTL'
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kMaxDestinations = 4;
+
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> generation;
+    uint16_t destPort;                            // 0 = keep the configured port
+    uint16_t profile;                             // StreamProfile
+    uint32_t destinationCount;
+    uint32_t destinations[kMaxDestinations];      // IPv4, network byte order
+    std::atomic<uint32_t> idleTeardownSeconds;    // 0 = driver default (read outside the seqlock)
+    uint8_t reserved[24];
+};
+
+static_assert(sizeof(ControlBlockPage) == 64, "ControlBlockPage layout is shared with the menubar app");
+
+/// Validated copy of the control page
+struct ControlSettings {
+    uint32_t generation = 0;
+    uint16_t destPort = 0;
+    StreamProfile profile = StreamProfile::Float32;
+    size_t destinationCount = 0;
+    uint32_t destinations[ControlBlockPage::kMaxDestinations] = {0};
+};
+
+/// Reader side of the shared control page
+class ControlBlock {
+public:
+    ControlBlock() = default;
+
+    // Non-copyable
+    ControlBlock(const ControlBlock&) = delete;
+    ControlBlock& operator=(const ControlBlock&) = delete;
+
+    /// Map the page, creating and initializing it if needed
+    /// @param name Page name in SharedMemoryRegion::kDirectory
+    bool open(const char* name);
+
+    bool isOpen() const { return m_page != nullptr; }
+
+    /// Copy the settings if the menubar app has published since generation
+    /// Lock-free and system-call free; safe on the sender's hot path.
+    /// @param generation Last generation applied; updated on success
+    /// @return true if out holds newer, valid settings
+    bool readIfChanged(uint32_t& generation, ControlSettings& out) const;
+
+    /// Idle period after which the device frees its stream resources
+    /// A single field, read on its own rather than through readIfChanged()
+    /// @return Seconds, or 0 for the driver default
+    uint32_t idleTeardownSeconds() const {
+        return m_page ? m_page->idleTeardownSeconds.load(std::memory_order_relaxed) : 0;
+    }
+
+    static constexpr const char* kName = "control.shm";
+
+private:
+    SharedMemoryRegion m_region;
+    ControlBlockPage* m_page = nullptr;
+};
+
+} // namespace Cymax
+
+#endif /* ControlBlock_hpp */
@@ -0,0 +1,387 @@
+//
+//  CymaxAudioControl.cpp
+//  CymaxPhoneOutDriver
+//
+//  Volume and mute control implementation
+//
+
+#include "CymaxAudioControl.hpp"
+#include "Logging.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Cymax {
+
+#pragma mark - VolumeControl
+
+VolumeControl::VolumeControl(AudioObjectID controlID, AudioObjectID owningDeviceID,
+                             OutputControlState& state)
+    : AudioObject(controlID)
+    , m_owningDeviceID(owningDeviceID)
+    , m_state(state)
+{
+    CYMAX_LOG_DEBUG("VolumeControl created: ID=%u, device=%u", controlID, owningDeviceID);
+}
+
+Float32 VolumeControl::scalarToDecibels(Float32 scalar) {
+    if (scalar <= 0.0f) {
+        return kMinDecibels;
+    }
+    return std::max(kMinDecibels, std::min(kMaxDecibels, 40.0f * std::log10(scalar)));
+}
+
+Float32 VolumeControl::decibelsToScalar(Float32 decibels) {
+    if (decibels <= kMinDecibels) {
+        return 0.0f;
+    }
+    return std::pow(10.0f, std::min(decibels, kMaxDecibels) / 40.0f);
+}
+
+Float32 VolumeControl::getScalarValue() const {
+    return m_state.volumeScalar.load(std::memory_order_relaxed);
+}
+
+void VolumeControl::setScalarValue(Float32 scalar) {
+    scalar = std::max(0.0f, std::min(1.0f, scalar));
+    m_state.volumeScalar.store(scalar, std::memory_order_relaxed);
+    CYMAX_LOG_INFO("Volume set to %.3f (%.1f dB)", scalar, scalarToDecibels(scalar));
+}
+
+Boolean VolumeControl::hasProperty(const AudioObjectPropertyAddress* address) const {
+    switch (address->mSelector) {
+        case kAudioObjectPropertyBaseClass:
+        case kAudioObjectPropertyClass:
+        case kAudioObjectPropertyOwner:
+        case kAudioObjectPropertyOwnedObjects:
+        case kAudioControlPropertyScope:
+        case kAudioControlPropertyElement:
+        case kAudioLevelControlPropertyScalarValue:
+        case kAudioLevelControlPropertyDecibelValue:
+        case kAudioLevelControlPropertyDecibelRange:
+        case kAudioLevelControlPropertyConvertScalarToDecibels:
+        case kAudioLevelControlPropertyConvertDecibelsToScalar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+OSStatus VolumeControl::isPropertySettable(const AudioObjectPropertyAddress* address,
+                                           Boolean* outIsSettable) const {
+    switch (address->mSelector) {
+        case kAudioLevelControlPropertyScalarValue:
+        case kAudioLevelControlPropertyDecibelValue:
+            *outIsSettable = true;
+            return noErr;
+
+        case kAudioObjectPropertyBaseClass:
+        case kAudioObjectPropertyClass:
+        case kAudioObjectPropertyOwner:
+        case kAudioObjectPropertyOwnedObjects:
+        case kAudioControlPropertyScope:
+        case kAudioControlPropertyElement:
+        case kAudioLevelControlPropertyDecibelRange:
+        case kAudioLevelControlPropertyConvertScalarToDecibels:
+        case kAudioLevelControlPropertyConvertDecibelsToScalar:
+            *outIsSettable = false;
+            return noErr;
+
+        default:
+            return kAudioHardwareUnknownPropertyError;
+    }
+}
+
+OSStatus VolumeControl::getPropertyDataSize(const AudioObjectPropertyAddress* address,
+                                            UInt32 qualifierDataSize,
+                                            const void* qualifierData,
+                                            UInt32* outDataSize) const {
+    switch (address->mSelector) {
+        case kAudioObjectPropertyBaseClass:
+        case kAudioObjectPropertyClass:
+            *outDataSize = sizeof(AudioClassID);
+            return noErr;
+
+        case kAudioObjectPropertyOwner:
+            *outDataSize = sizeof(AudioObjectID);
+            return noErr;
+
+        case kAudioObjectPropertyOwnedObjects:
+            *outDataSize = 0;  // Controls own nothing
+            return noErr;
+
+        case kAudioControlPropertyScope:
+        case kAudioControlPropertyElement:
+            *outDataSize = sizeof(UInt32);
+            return noErr;
+
+        case kAudioLevelControlPropertyScalarValue:
+        case kAudioLevelControlPropertyDecibelValue:
+        case kAudioLevelControlPropertyConvertScalarToDecibels:
+        case kAudioLevelControlPropertyConvertDecibelsToScalar:
+            *outDataSize = sizeof(Float32);
+            return noErr;
+
+        case kAudioLevelControlPropertyDecibelRange:
+            *outDataSize = sizeof(AudioValueRange);
+            return noErr;
+
+        default:
+            return kAudioHardwareUnknownPropertyError;
+    }
+}
+
+OSStatus VolumeControl::getPropertyData(const AudioObjectPropertyAddress* address,
+                                        UInt32 qualifierDataSize,
+                                        const void* qualifierData,
+                                        UInt32 inDataSize,
+                                        UInt32* outDataSize,
+                                        void* outData) const {
+    switch (address->mSelector) {
+        case kAudioObjectPropertyBaseClass:
+            if (inDataSize < sizeof(AudioClassID)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<AudioClassID*>(outData) = kAudioLevelControlClassID;
+            *outDataSize = sizeof(AudioClassID);
+            return noErr;
+
+        case kAudioObjectPropertyClass:
+            if (inDataSize < sizeof(AudioClassID)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<AudioClassID*>(outData) = kAudioVolumeControlClassID;
+            *outDataSize = sizeof(AudioClassID);
+            return noErr;
+
+        case kAudioObjectPropertyOwner:
+            if (inDataSize < sizeof(AudioObjectID)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<AudioObjectID*>(outData) = m_owningDeviceID;
+            *outDataSize = sizeof(AudioObjectID);
+            return noErr;
+
+        case kAudioObjectPropertyOwnedObjects:
+            *outDataSize = 0;
+            return noErr;
+
+        case kAudioControlPropertyScope:
+            if (inDataSize < sizeof(UInt32)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<UInt32*>(outData) = kAudioObjectPropertyScopeOutput;
+            *outDataSize = sizeof(UInt32);
+            return noErr;
+
+        case kAudioControlPropertyElement:
+            if (inDataSize < sizeof(UInt32)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<UInt32*>(outData) = kAudioObjectPropertyElementMain;
+            *outDataSize = sizeof(UInt32);
+            return noErr;
+
+        case kAudioLevelControlPropertyScalarValue:
+            if (inDataSize < sizeof(Float32)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<Float32*>(outData) = getScalarValue();
+            *outDataSize = sizeof(Float32);
+            return noErr;
+
+        case kAudioLevelControlPropertyDecibelValue:
+            if (inDataSize < sizeof(Float32)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<Float32*>(outData) = scalarToDecibels(getScalarValue());
+            *outDataSize = sizeof(Float32);
+            return noErr;
+
+        case kAudioLevelControlPropertyDecibelRange: {
+            if (inDataSize < sizeof(AudioValueRange)) return kAudioHardwareBadPropertySizeError;
+            AudioValueRange* range = static_cast<AudioValueRange*>(outData);
+            range->mMinimum = kMinDecibels;
+            range->mMaximum = kMaxDecibels;
+            *outDataSize = sizeof(AudioValueRange);
+            return noErr;
+        }
+
+        // The value to convert is passed in, and returned in, outData
+        case kAudioLevelControlPropertyConvertScalarToDecibels: {
+            if (inDataSize < sizeof(Float32)) return kAudioHardwareBadPropertySizeError;
+            Float32* value = static_cast<Float32*>(outData);
+            *value = scalarToDecibels(std::max(0.0f, std::min(1.0f, *value)));
+            *outDataSize = sizeof(Float32);
+            return noErr;
+        }
+
+        case kAudioLevelControlPropertyConvertDecibelsToScalar: {
+            if (inDataSize < sizeof(Float32)) return kAudioHardwareBadPropertySizeError;
+            Float32* value = static_cast<Float32*>(outData);
+            *value = decibelsToScalar(*value);
+            *outDataSize = sizeof(Float32);
+            return noErr;
+        }
+
+        default:
+            return kAudioHardwareUnknownPropertyError;
+    }
+}
+
+OSStatus VolumeControl::setPropertyData(const AudioObjectPropertyAddress* address,
+                                        UInt32 qualifierDataSize,
+                                        const void* qualifierData,
+                                        UInt32 inDataSize,
+                                        const void* inData) {
+    switch (address->mSelector) {
+        case kAudioLevelControlPropertyScalarValue: {
+            if (inDataSize < sizeof(Float32)) return kAudioHardwareBadPropertySizeError;
+            setScalarValue(*static_cast<const Float32*>(inData));
+            return noErr;
+        }
+
+        case kAudioLevelControlPropertyDecibelValue: {
+            if (inDataSize < sizeof(Float32)) return kAudioHardwareBadPropertySizeError;
+            setScalarValue(decibelsToScalar(*static_cast<const Float32*>(inData)));
+            return noErr;
+        }
+
+        default:
+            return kAudioHardwareUnknownPropertyError;
+    }
+}
+
+#pragma mark - MuteControl
+
+MuteControl::MuteControl(AudioObjectID controlID, AudioObjectID owningDeviceID,
+                         OutputControlState& state)
+    : AudioObject(controlID)
+    , m_owningDeviceID(owningDeviceID)
+    , m_state(state)
+{
+    CYMAX_LOG_DEBUG("MuteControl created: ID=%u, device=%u", controlID, owningDeviceID);
+}
+
+Boolean MuteControl::hasProperty(const AudioObjectPropertyAddress* address) const {
+    switch (address->mSelector) {
+        case kAudioObjectPropertyBaseClass:
+        case kAudioObjectPropertyClass:
+        case kAudioObjectPropertyOwner:
+        case kAudioObjectPropertyOwnedObjects:
+        case kAudioControlPropertyScope:
+        case kAudioControlPropertyElement:
+        case kAudioBooleanControlPropertyValue:
+            return true;
+        default:
+            return false;
+    }
+}
+
+OSStatus MuteControl::isPropertySettable(const AudioObjectPropertyAddress* address,
+                                         Boolean* outIsSettable) const {
+    switch (address->mSelector) {
+        case kAudioBooleanControlPropertyValue:
+            *outIsSettable = true;
+            return noErr;
+
+        case kAudioObjectPropertyBaseClass:
+        case kAudioObjectPropertyClass:
+        case kAudioObjectPropertyOwner:
+        case kAudioObjectPropertyOwnedObjects:
+        case kAudioControlPropertyScope:
+        case kAudioControlPropertyElement:
+            *outIsSettable = false;
+            return noErr;
+
+        default:
+            return kAudioHardwareUnknownPropertyError;
+    }
+}
+
+OSStatus MuteControl::getPropertyDataSize(const AudioObjectPropertyAddress* address,
+                                          UInt32 qualifierDataSize,
+                                          const void* qualifierData,
+                                          UInt32* outDataSize) const {
+    switch (address->mSelector) {
+        case kAudioObjectPropertyBaseClass:
+        case kAudioObjectPropertyClass:
+            *outDataSize = sizeof(AudioClassID);
+            return noErr;
+
+        case kAudioObjectPropertyOwner:
+            *outDataSize = sizeof(AudioObjectID);
+            return noErr;
+
+        case kAudioObjectPropertyOwnedObjects:
+            *outDataSize = 0;
+            return noErr;
+
+        case kAudioControlPropertyScope:
+        case kAudioControlPropertyElement:
+        case kAudioBooleanControlPropertyValue:
+            *outDataSize = sizeof(UInt32);
+            return noErr;
+
+        default:
+            return kAudioHardwareUnknownPropertyError;
+    }
+}
+
+OSStatus MuteControl::getPropertyData(const AudioObjectPropertyAddress* address,
+                                      UInt32 qualifierDataSize,
+                                      const void* qualifierData,
+                                      UInt32 inDataSize,
+                                      UInt32* outDataSize,
+                                      void* outData) const {
+    switch (address->mSelector) {
+        case kAudioObjectPropertyBaseClass:
+            if (inDataSize < sizeof(AudioClassID)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<AudioClassID*>(outData) = kAudioBooleanControlClassID;
+            *outDataSize = sizeof(AudioClassID);
+            return noErr;
+
+        case kAudioObjectPropertyClass:
+            if (inDataSize < sizeof(AudioClassID)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<AudioClassID*>(outData) = kAudioMuteControlClassID;
+            *outDataSize = sizeof(AudioClassID);
+            return noErr;
+
+        case kAudioObjectPropertyOwner:
+            if (inDataSize < sizeof(AudioObjectID)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<AudioObjectID*>(outData) = m_owningDeviceID;
+            *outDataSize = sizeof(AudioObjectID);
+            return noErr;
+
+        case kAudioObjectPropertyOwnedObjects:
+            *outDataSize = 0;
+            return noErr;
+
+        case kAudioControlPropertyScope:
+            if (inDataSize < sizeof(UInt32)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<UInt32*>(outData) = kAudioObjectPropertyScopeOutput;
+            *outDataSize = sizeof(UInt32);
+            return noErr;
+
+        case kAudioControlPropertyElement:
+            if (inDataSize < sizeof(UInt32)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<UInt32*>(outData) = kAudioObjectPropertyElementMain;
+            *outDataSize = sizeof(UInt32);
+            return noErr;
+
+        case kAudioBooleanControlPropertyValue:
+            if (inDataSize < sizeof(UInt32)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<UInt32*>(outData) = m_state.muted.load(std::memory_order_relaxed) ? 1 : 0;
+            *outDataSize = sizeof(UInt32);
+            return noErr;
+
+        default:
+            return kAudioHardwareUnknownPropertyError;
+    }
+}
+
+OSStatus MuteControl::setPropertyData(const AudioObjectPropertyAddress* address,
+                                      UInt32 qualifierDataSize,
+                                      const void* qualifierData,
+                                      UInt32 inDataSize,
+                                      const void* inData) {
+    switch (address->mSelector) {
+        case kAudioBooleanControlPropertyValue: {
+            if (inDataSize < sizeof(UInt32)) return kAudioHardwareBadPropertySizeError;
+            const bool muted = *static_cast<const UInt32*>(inData) != 0;
+            m_state.muted.store(muted, std::memory_order_relaxed);
+            CYMAX_LOG_INFO("Mute %{public}s", muted ? "on" : "off");
+            return noErr;
+        }
+
+        default:
+            return kAudioHardwareUnknownPropertyError;
+    }
+}
+
+} // namespace Cymax
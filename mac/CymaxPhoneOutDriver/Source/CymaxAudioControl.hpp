@@ -0,0 +1,98 @@
+//
+//  CymaxAudioControl.hpp
+//  CymaxPhoneOutDriver
+//
+//  Output volume and mute control objects
+//
+//  The HAL exposes these to apps (and the menu bar volume keys) through
+//  the device's kAudioObjectPropertyControlList. They only store the
+//  requested values; the gain itself is applied on the sender thread.
+//
+
+#ifndef CymaxAudioControl_hpp
+#define CymaxAudioControl_hpp
+
+#include "CymaxAudioObject.hpp"
+#include "UDPSender.hpp"
+#include <CoreAudio/AudioServerPlugIn.h>
+
+namespace Cymax {
+
+/// Output volume control (kAudioVolumeControlClassID)
+class VolumeControl : public AudioObject {
+public:
+    VolumeControl(AudioObjectID controlID, AudioObjectID owningDeviceID,
+                  OutputControlState& state);
+    virtual ~VolumeControl() = default;
+
+    // AudioObject overrides
+    Boolean hasProperty(const AudioObjectPropertyAddress* address) const override;
+    OSStatus isPropertySettable(const AudioObjectPropertyAddress* address,
+                               Boolean* outIsSettable) const override;
+    OSStatus getPropertyDataSize(const AudioObjectPropertyAddress* address,
+                                UInt32 qualifierDataSize,
+                                const void* qualifierData,
+                                UInt32* outDataSize) const override;
+    OSStatus getPropertyData(const AudioObjectPropertyAddress* address,
+                            UInt32 qualifierDataSize,
+                            const void* qualifierData,
+                            UInt32 inDataSize,
+                            UInt32* outDataSize,
+                            void* outData) const override;
+    OSStatus setPropertyData(const AudioObjectPropertyAddress* address,
+                            UInt32 qualifierDataSize,
+                            const void* qualifierData,
+                            UInt32 inDataSize,
+                            const void* inData) override;
+
+    /// Volume slider position (0.0 - 1.0)
+    Float32 getScalarValue() const;
+    void setScalarValue(Float32 scalar);
+
+    // Volume curve: gain = scalar^2, i.e. dB = 40 * log10(scalar)
+    static Float32 scalarToDecibels(Float32 scalar);
+    static Float32 decibelsToScalar(Float32 decibels);
+
+    static constexpr Float32 kMinDecibels = -96.0f;
+    static constexpr Float32 kMaxDecibels = 0.0f;
+
+private:
+    AudioObjectID m_owningDeviceID;
+    OutputControlState& m_state;
+};
+
+/// Output mute control (kAudioMuteControlClassID)
+class MuteControl : public AudioObject {
+public:
+    MuteControl(AudioObjectID controlID, AudioObjectID owningDeviceID,
+                OutputControlState& state);
+    virtual ~MuteControl() = default;
+
+    // AudioObject overrides
+    Boolean hasProperty(const AudioObjectPropertyAddress* address) const override;
+    OSStatus isPropertySettable(const AudioObjectPropertyAddress* address,
+                               Boolean* outIsSettable) const override;
+    OSStatus getPropertyDataSize(const AudioObjectPropertyAddress* address,
+                                UInt32 qualifierDataSize,
+                                const void* qualifierData,
+                                UInt32* outDataSize) const override;
+    OSStatus getPropertyData(const AudioObjectPropertyAddress* address,
+                            UInt32 qualifierDataSize,
+                            const void* qualifierData,
+                            UInt32 inDataSize,
+                            UInt32* outDataSize,
+                            void* outData) const override;
+    OSStatus setPropertyData(const AudioObjectPropertyAddress* address,
+                            UInt32 qualifierDataSize,
+                            const void* qualifierData,
+                            UInt32 inDataSize,
+                            const void* inData) override;
+
+private:
+    AudioObjectID m_owningDeviceID;
+    OutputControlState& m_state;
+};
+
+} // namespace Cymax
+
+#endif /* CymaxAudioControl_hpp */
@@ -22,7 +22,10 @@
 // Plugin = 1 (kAudioObjectPlugInObject, but we use a different value)
 // Device = 2
 // Stream = 3
+// Volume control = 4, mute control = 5
 static constexpr AudioObjectID kOutputStreamObjectID = 3;
+static constexpr AudioObjectID kVolumeControlObjectID = 4;
+static constexpr AudioObjectID kMuteControlObjectID = 5;
 
 namespace Cymax {
 
@@ -37,20 +40,33 @@ AudioDevice::AudioDevice(AudioObjectID deviceID, AudioObjectID pluginID)
     // Create output stream
     m_outputStream = std::make_unique<AudioStream>(kOutputStreamObjectID, deviceID, false);
     
-    // Create ring buffer (2 channels, Float32)
-    m_ringBuffer = std::make_unique<RingBuffer<float>>(kRingBufferFrames, 2);
+    // Create volume and mute controls
+    m_volumeControl = std::make_unique<VolumeControl>(kVolumeControlObjectID, deviceID, m_controlState);
+    m_muteControl = std::make_unique<MuteControl>(kMuteControlObjectID, deviceID, m_controlState);
     
-    // Create UDP sender
+    // coreaudiod loads the plug-in whether or not the device is ever used:
+    // the rings, the sender's threads, socket and buffers, and the analysis
+    // thread are created on the first startIO (allocateStreamResources)
     m_udpSender = std::make_unique<UDPSender>();
+    m_udpSender->setControlState(&m_controlState);
     
-    UDPSenderConfig config;
-    config.sampleRate = static_cast<uint32_t>(m_sampleRate);
-    config.channels = 2;
-    config.framesPerPacket = 128;  // MTU-safe: 28 header + 128*2*4 = 1052 bytes
-    config.destPort = 19620;
-    config.useFloat32 = true;
+    // Destinations come from the menubar app's control block; the sender
+    // follows it while running, so startIO never touches the filesystem
+    m_controlBlock = std::make_unique<ControlBlock>();
+    if (m_controlBlock->open(ControlBlock::kName)) {
+        m_udpSender->setControlBlock(m_controlBlock.get());
+    }
+    m_udpSender->openStatsPage(SenderTimeSeries::kSharedPageName);  // Non-fatal
     
-    m_udpSender->initialize(m_ringBuffer.get(), config);
+    // Create metering and spectrum analysis
+    m_levelMeter = std::make_unique<LevelMeter>();
+    m_spectrumAnalyzer = std::make_unique<SpectrumAnalyzer>();
+    m_spectrumAnalyzer->openSharedPage(SpectrumAnalyzer::kSharedPageName);  // Non-fatal
+    m_replayBuffer = std::make_unique<ReplayBuffer>(kReplaySaveSeconds / 60.0);
+    m_udpSender->setSpectrumSource(m_spectrumAnalyzer.get());
+    
+    // Create recorder (idle until kRecordingPathProperty is set)
+    m_recorder = std::make_unique<AudioRecorder>();
     
     CYMAX_LOG_INFO("AudioDevice created: %{public}s", kDeviceName);
 }
@@ -60,8 +76,27 @@ AudioDevice::~AudioDevice() {
     
     stopIO();
     
+    {
+        std::lock_guard<std::mutex> lock(m_resourceMutex);
+        m_shuttingDown = true;
+    }
+    m_idleCondition.notify_all();
+    if (m_idleThread.joinable()) {
+        m_idleThread.join();
+    }
+    
+    m_recorder.reset();
+    m_analysisThread.reset();
+    m_levelMeter.reset();
+    m_replayBuffer.reset();
     m_udpSender.reset();
+    m_controlBlock.reset();
+    m_spectrumAnalyzer.reset();
+    m_packetRing.reset();
     m_ringBuffer.reset();
+    m_streamArena.release();
+    m_muteControl.reset();
+    m_volumeControl.reset();
     m_outputStream.reset();
     
     releaseCFStrings();
@@ -85,6 +120,14 @@ AudioObjectID AudioDevice::getOutputStreamID() const {
     return m_outputStream ? m_outputStream->getObjectID() : kAudioObjectUnknown;
 }
 
+AudioObjectID AudioDevice::getVolumeControlID() const {
+    return m_volumeControl ? m_volumeControl->getObjectID() : kAudioObjectUnknown;
+}
+
+AudioObjectID AudioDevice::getMuteControlID() const {
+    return m_muteControl ? m_muteControl->getObjectID() : kAudioObjectUnknown;
+}
+
 void AudioDevice::setSampleRate(Float64 rate) {
     // Only 48000Hz is supported - iOS hardware requires it
     if (rate != 48000.0) {
@@ -99,13 +142,16 @@ void AudioDevice::setSampleRate(Float64 rate) {
     
     // Update UDP sender config
     if (m_udpSender) {
-        UDPSenderConfig config;
-        config.sampleRate = static_cast<uint32_t>(rate);
-        config.channels = 2;
-        config.framesPerPacket = 128;  // MTU-safe: 28 header + 128*2*4 = 1052 bytes
-        config.destPort = 19620;
-        config.useFloat32 = true;
-        m_udpSender->updateConfig(config);
+        m_udpSender->updateConfig(senderConfig());
+    }
+    
+    // Without stream resources the new rate is applied when they're created
+    std::lock_guard<std::mutex> lock(m_resourceMutex);
+    if (m_ringBuffer && m_analysisThread && !m_analysisThread->isRunning()) {
+        m_analysisThread->initialize(m_ringBuffer.get(), rate);
+    }
+    if (m_ringBuffer && m_recorder && !m_recorder->isRecording()) {
+        m_recorder->initialize(m_ringBuffer.get(), rate, &m_controlState);
     }
     
     CYMAX_LOG_INFO("Sample rate set to %.0f Hz", rate);
@@ -138,68 +184,198 @@ bool AudioDevice::setDestinationIP(const char* ipAddress) {
     return false;
 }
 
-// Helper to write debug status
-static void writeDebugStatus(const char* status) {
-    FILE* f = fopen("/tmp/cymax_driver_status.txt", "a");
-    if (f) {
-        time_t now = time(nullptr);
-        fprintf(f, "[%ld] %s\n", now, status);
-        fclose(f);
+UDPSenderConfig AudioDevice::senderConfig() const {
+    UDPSenderConfig config;
+    config.sampleRate = static_cast<uint32_t>(m_sampleRate);
+    config.channels = 2;
+    config.framesPerPacket = kFramesPerPacket;
+    config.destPort = 19620;
+    config.useFloat32 = true;
+    return config;
+}
+
+bool AudioDevice::allocateStreamResources() {
+    if (m_ringBuffer) {
+        return true;
+    }
+    
+    // The idle thread exits after a teardown; reap it before starting another
+    if (m_idleThread.joinable()) {
+        m_idleThread.join();
+    }
+    
+    // Everything the render thread touches (both rings, their counters and
+    // storage) lives in one arena that is faulted in and locked here, so
+    // neither first use nor memory pressure can fault the render thread
+    const RingStorage storage = sampleRingStorage();
+    const RingLayout layout = sampleRingLayout();
+    size_t arenaBytes = RealtimeArena::footprint(sizeof(RingBuffer<float>)) +
+                        RingBuffer<float>::storageBytes(kRingBufferFrames, 2, storage, layout);
+    if (kUsePacketRing) {
+        arenaBytes += RealtimeArena::footprint(sizeof(PacketRing)) +
+                      PacketRing::storageBytes(kPacketRingSlots, kFramesPerPacket, 2, kPacketHeaderBytes);
+    }
+    if (!m_streamArena.reserve(arenaBytes, kUseHugePages)) {
+        return false;
+    }
+    m_ringBuffer = m_streamArena.make<RingBuffer<float>>(kRingBufferFrames, 2, storage, &m_streamArena, layout);
+    if (kUsePacketRing) {
+        m_packetRing = m_streamArena.make<PacketRing>(kPacketRingSlots, kFramesPerPacket, 2, kPacketHeaderBytes,
+                                                      &m_streamArena);
+    }
+    
+    if (!m_ringBuffer || !m_udpSender->initialize(m_ringBuffer.get(), senderConfig())) {
+        m_packetRing.reset();
+        m_ringBuffer.reset();
+        m_streamArena.release();
+        return false;
+    }
+    static_assert(UDPSender::slotFitsPacket(kPacketHeaderBytes, kFramesPerPacket, 2),
+                  "Packet ring slots must hold a whole packet");
+    if (!m_udpSender->setPacketRing(m_packetRing.get())) {
+        m_packetRing.reset();  // The sender reads the sample ring, so render must write it
+    }
+    
+    // The analysis thread outlives teardowns: the replay buffer's history
+    // is kept across them
+    if (!m_analysisThread) {
+        m_analysisThread = std::make_unique<AnalysisThread>();
+        m_analysisThread->initialize(m_ringBuffer.get(), m_sampleRate);
+        m_analysisThread->addAnalyzer(m_levelMeter.get());
+        m_analysisThread->addAnalyzer(m_spectrumAnalyzer.get());
+        m_analysisThread->addAnalyzer(m_replayBuffer.get());
+    } else {
+        m_analysisThread->initialize(m_ringBuffer.get(), m_sampleRate);
+    }
+    m_recorder->initialize(m_ringBuffer.get(), m_sampleRate, &m_controlState);
+    
+    m_idleSince = std::chrono::steady_clock::now();
+    m_idleThread = std::thread(&AudioDevice::idleThreadFunc, this);
+    
+    CYMAX_LOG_INFO("Stream resources allocated (%zu KB arena%{public}s, %{public}s %{public}s sample ring)",
+                   m_streamArena.capacity() / 1024, m_streamArena.isLocked() ? ", locked" : "",
+                   m_ringBuffer->storage() == RingStorage::Int16 ? "int16" : "float32",
+                   m_ringBuffer->layout() == RingLayout::Planar ? "planar" : "interleaved");
+    return true;
+}
+
+RingLayout AudioDevice::sampleRingLayout() const {
+    // Planar only pays off when the sender doesn't read the ring: the
+    // analyzers then take planes as they are and only the recorder has to
+    // re-interleave. The scalar deinterleave is too slow for the render
+    // thread.
+    if (!kUsePacketRing || !kPlanarSampleRing || Kernels::active().isa == Kernels::ISA::Scalar) {
+        return RingLayout::Interleaved;
+    }
+    return RingLayout::Planar;
+}
+
+RingStorage AudioDevice::sampleRingStorage() const {
+    // With the packet ring the sample ring only feeds the taps, and the
+    // recorder writes float32 files
+    if (kUsePacketRing) {
+        return RingStorage::Native;
+    }
+    
+    // Otherwise the sender reads it: int16 storage loses nothing when the
+    // wire format is int16 anyway (kept until the resources are next created).
+    // The scalar conversion is too slow for the render thread.
+    if (Kernels::active().isa == Kernels::ISA::Scalar) {
+        return RingStorage::Native;
+    }
+    uint32_t generation = 0;
+    ControlSettings settings;
+    if (m_controlBlock && m_controlBlock->readIfChanged(generation, settings) &&
+        settings.profile == StreamProfile::Int16) {
+        return RingStorage::Int16;
+    }
+    return RingStorage::Native;
+}
+
+void AudioDevice::releaseStreamResources() {
+    // Sender first: its threads are the last readers of the rings
+    m_udpSender->releaseResources();
+    m_recorder->initialize(nullptr, m_sampleRate, &m_controlState);
+    m_packetRing.reset();
+    m_ringBuffer.reset();
+    m_streamArena.release();
+    
+    CYMAX_LOG_INFO("Stream resources released after %u s idle",
+                   static_cast<unsigned>(idleTeardownPeriod().count()));
+}
+
+void AudioDevice::updateSampleRingTapped() {
+    const bool tapped = (m_analysisThread && m_analysisThread->isRunning()) ||
+                        (m_recorder && m_recorder->isRecording());
+    m_sampleRingTapped.store(tapped, std::memory_order_relaxed);
+}
+
+std::chrono::seconds AudioDevice::idleTeardownPeriod() const {
+    const uint32_t seconds = m_controlBlock ? m_controlBlock->idleTeardownSeconds() : 0;
+    return std::chrono::seconds(seconds != 0 ? seconds : kDefaultIdleTeardownSeconds);
+}
+
+void AudioDevice::idleThreadFunc() {
+    std::unique_lock<std::mutex> lock(m_resourceMutex);
+    while (!m_shuttingDown) {
+        const auto now = std::chrono::steady_clock::now();
+        const bool busy = m_ioRunning.load(std::memory_order_acquire) ||
+                          m_recorder->isRecording();
+        if (busy) {
+            // stopIO and the recording property notify; the recheck also
+            // catches a recording that ended on its own (disk full)
+            m_idleSince = now;
+            m_idleCondition.wait_for(lock, kIdleRecheckInterval);
+            continue;
+        }
+        
+        // Re-read the period each pass so a changed setting applies
+        // to the current idle stretch
+        const auto deadline = m_idleSince + idleTeardownPeriod();
+        if (now >= deadline) {
+            releaseStreamResources();
+            return;
+        }
+        m_idleCondition.wait_until(lock, std::min(deadline, now + kIdleRecheckInterval));
     }
 }
 
+void AudioDevice::warmUp() {
+    std::lock_guard<std::mutex> lock(m_resourceMutex);
+    if (!allocateStreamResources()) {
+        CYMAX_LOG_ERROR("Failed to allocate stream resources");
+    }
+    m_idleSince = std::chrono::steady_clock::now();
+}
+
 OSStatus AudioDevice::startIO() {
-    writeDebugStatus("startIO called");
+    std::lock_guard<std::mutex> lock(m_resourceMutex);
     
     if (m_ioRunning.load(std::memory_order_acquire)) {
         CYMAX_LOG_DEBUG("IO already running");
-        writeDebugStatus("IO already running");
         return noErr;
     }
     
     CYMAX_LOG_INFO("Starting IO");
-    writeDebugStatus("Starting IO - reading IP file");
-    
-    // Try to read destination IP from shared file (set by menubar app)
-    // Using /tmp which is accessible to coreaudiod
-    const char* homePaths[] = {
-        "/tmp/cymax_dest_ip.txt",
-        nullptr
-    };
-    
-    bool foundIP = false;
-    for (int i = 0; homePaths[i] != nullptr && !foundIP; i++) {
-        FILE* file = fopen(homePaths[i], "r");
-        if (file) {
-            char ipBuffer[64] = {0};
-            if (fgets(ipBuffer, sizeof(ipBuffer), file)) {
-                // Remove trailing newline if present
-                size_t len = strlen(ipBuffer);
-                if (len > 0 && ipBuffer[len-1] == '\n') {
-                    ipBuffer[len-1] = '\0';
-                }
-                if (strlen(ipBuffer) > 0) {
-                    CYMAX_LOG_INFO("Read destination IP from %{public}s: %{public}s", homePaths[i], ipBuffer);
-                    char msg[128];
-                    snprintf(msg, sizeof(msg), "Found IP: %s", ipBuffer);
-                    writeDebugStatus(msg);
-                    setDestinationIP(ipBuffer);
-                    foundIP = true;
-                }
-            }
-            fclose(file);
-        }
+    
+    if (!allocateStreamResources()) {
+        CYMAX_LOG_ERROR("Failed to allocate stream resources");
+        return kAudioHardwareUnspecifiedError;
     }
     
-    if (!foundIP) {
-        CYMAX_LOG_INFO("No destination IP file found");
-        writeDebugStatus("No IP file found!");
+    // stopIO doesn't wait for the sender; make sure it has let go of the
+    // rings before they are reset (constant time, no memset)
+    if (m_udpSender) {
+        m_udpSender->waitUntilIdle();
     }
     
-    // Reset ring buffer
+    // Reset ring buffers
     if (m_ringBuffer) {
         m_ringBuffer->reset();
     }
+    if (m_packetRing) {
+        m_packetRing->reset();
+    }
     
     // Start UDP sender
     if (m_udpSender) {
@@ -209,11 +385,19 @@ OSStatus AudioDevice::startIO() {
         }
     }
     
+    // Start metering (non-fatal)
+    if (m_analysisThread) {
+        m_analysisThread->start();
+    }
+    updateSampleRingTapped();
+    
     m_ioRunning.store(true, std::memory_order_release);
     return noErr;
 }
 
 void AudioDevice::stopIO() {
+    std::unique_lock<std::mutex> lock(m_resourceMutex);
+    
     if (!m_ioRunning.load(std::memory_order_acquire)) {
         return;
     }
@@ -226,6 +410,21 @@ void AudioDevice::stopIO() {
     if (m_udpSender) {
         m_udpSender->stop();
     }
+    
+    if (m_analysisThread) {
+        m_analysisThread->stop();
+    }
+    
+    // A recording covers one IO session; the ring is reset on the next start
+    if (m_recorder) {
+        m_recorder->stop();
+    }
+    updateSampleRingTapped();
+    
+    // Start the idle clock
+    m_idleSince = std::chrono::steady_clock::now();
+    lock.unlock();
+    m_idleCondition.notify_all();
 }
 
 OSStatus AudioDevice::doIOOperation(UInt32 inIOBufferFrameSize,
@@ -243,10 +442,16 @@ OSStatus AudioDevice::doIOOperation(UInt32 inIOBufferFrameSize,
     }
     
     // ioMainBuffer contains interleaved Float32 stereo samples
-    // Write directly to ring buffer
+    // Write directly to the packet ring the sender reads, and to the sample
+    // ring when something taps it (or the sender reads that instead)
     if (m_ringBuffer && ioMainBuffer) {
         const float* audioData = static_cast<const float*>(ioMainBuffer);
-        m_ringBuffer->write(audioData, inIOBufferFrameSize);
+        if (m_packetRing) {
+            m_packetRing->write(audioData, inIOBufferFrameSize);
+        }
+        if (!m_packetRing || m_sampleRingTapped.load(std::memory_order_relaxed)) {
+            m_ringBuffer->write(audioData, inIOBufferFrameSize);
+        }
     }
     
     // CYMAX_LOG_RENDER is disabled by default, this is a no-op:
@@ -298,6 +503,11 @@ Boolean AudioDevice::hasProperty(const AudioObjectPropertyAddress* address) cons
         
         // Custom property
         case kDestinationIPProperty:
+        case kLevelMetersProperty:
+        case kSenderRatesProperty:
+        case kSpectrumSideChannelProperty:
+        case kRecordingPathProperty:
+        case kReplaySavePathProperty:
             return true;
         
         default:
@@ -311,6 +521,9 @@ OSStatus AudioDevice::isPropertySettable(const AudioObjectPropertyAddress* addre
         case kAudioDevicePropertyNominalSampleRate:
         case kAudioDevicePropertyBufferFrameSize:
         case kDestinationIPProperty:
+        case kSpectrumSideChannelProperty:
+        case kRecordingPathProperty:
+        case kReplaySavePathProperty:
             *outIsSettable = true;
             return noErr;
         
@@ -339,6 +552,8 @@ OSStatus AudioDevice::isPropertySettable(const AudioObjectPropertyAddress* addre
         case kAudioDevicePropertyPreferredChannelLayout:
         case kAudioDevicePropertyZeroTimeStampPeriod:
         case kAudioDevicePropertyBufferFrameSizeRange:
+        case kLevelMetersProperty:
+        case kSenderRatesProperty:
             *outIsSettable = false;
             return noErr;
         
@@ -371,8 +586,8 @@ OSStatus AudioDevice::getPropertyDataSize(const AudioObjectPropertyAddress* addr
             return noErr;
         
         case kAudioObjectPropertyOwnedObjects:
-            // One output stream
-            *outDataSize = sizeof(AudioObjectID);
+            // One output stream plus volume and mute controls
+            *outDataSize = 3 * sizeof(AudioObjectID);
             return noErr;
         
         case kAudioDevicePropertyStreams:
@@ -390,7 +605,8 @@ OSStatus AudioDevice::getPropertyDataSize(const AudioObjectPropertyAddress* addr
             return noErr;
         
         case kAudioObjectPropertyControlList:
-            *outDataSize = 0;  // No controls
+            // Volume and mute
+            *outDataSize = 2 * sizeof(AudioObjectID);
             return noErr;
         
         case kAudioObjectPropertyName:
@@ -432,6 +648,23 @@ OSStatus AudioDevice::getPropertyDataSize(const AudioObjectPropertyAddress* addr
             *outDataSize = sizeof(m_destinationIP);
             return noErr;
         
+        case kLevelMetersProperty:
+            *outDataSize = sizeof(LevelMeterSnapshot);
+            return noErr;
+        
+        case kSenderRatesProperty:
+            *outDataSize = sizeof(SenderRateSnapshot);
+            return noErr;
+        
+        case kSpectrumSideChannelProperty:
+            *outDataSize = sizeof(UInt32);
+            return noErr;
+        
+        case kRecordingPathProperty:
+        case kReplaySavePathProperty:
+            *outDataSize = kRecordingPathSize;
+            return noErr;
+        
         default:
             return kAudioHardwareUnknownPropertyError;
     }
@@ -462,11 +695,15 @@ OSStatus AudioDevice::getPropertyData(const AudioObjectPropertyAddress* address,
             *outDataSize = sizeof(AudioObjectID);
             return noErr;
         
-        case kAudioObjectPropertyOwnedObjects:
-            if (inDataSize < sizeof(AudioObjectID)) return kAudioHardwareBadPropertySizeError;
-            *static_cast<AudioObjectID*>(outData) = getOutputStreamID();
-            *outDataSize = sizeof(AudioObjectID);
+        case kAudioObjectPropertyOwnedObjects: {
+            if (inDataSize < 3 * sizeof(AudioObjectID)) return kAudioHardwareBadPropertySizeError;
+            AudioObjectID* ids = static_cast<AudioObjectID*>(outData);
+            ids[0] = getOutputStreamID();
+            ids[1] = getVolumeControlID();
+            ids[2] = getMuteControlID();
+            *outDataSize = 3 * sizeof(AudioObjectID);
             return noErr;
+        }
         
         case kAudioObjectPropertyName:
             if (inDataSize < sizeof(CFStringRef)) return kAudioHardwareBadPropertySizeError;
@@ -567,9 +804,14 @@ OSStatus AudioDevice::getPropertyData(const AudioObjectPropertyAddress* address,
             }
             return noErr;
         
-        case kAudioObjectPropertyControlList:
-            *outDataSize = 0;
+        case kAudioObjectPropertyControlList: {
+            if (inDataSize < 2 * sizeof(AudioObjectID)) return kAudioHardwareBadPropertySizeError;
+            AudioObjectID* ids = static_cast<AudioObjectID*>(outData);
+            ids[0] = getVolumeControlID();
+            ids[1] = getMuteControlID();
+            *outDataSize = 2 * sizeof(AudioObjectID);
             return noErr;
+        }
         
         case kAudioDevicePropertySafetyOffset:
             if (inDataSize < sizeof(UInt32)) return kAudioHardwareBadPropertySizeError;
@@ -666,6 +908,50 @@ OSStatus AudioDevice::getPropertyData(const AudioObjectPropertyAddress* address,
             *outDataSize = sizeof(m_destinationIP);
             return noErr;
         
+        case kLevelMetersProperty: {
+            if (inDataSize < sizeof(LevelMeterSnapshot)) return kAudioHardwareBadPropertySizeError;
+            const LevelMeterSnapshot snapshot = m_levelMeter ? m_levelMeter->latest() : LevelMeterSnapshot{};
+            memcpy(outData, &snapshot, sizeof(snapshot));
+            *outDataSize = sizeof(LevelMeterSnapshot);
+            return noErr;
+        }
+        
+        case kSenderRatesProperty: {
+            if (inDataSize < sizeof(SenderRateSnapshot)) return kAudioHardwareBadPropertySizeError;
+            const SenderRateSnapshot snapshot = m_udpSender ? m_udpSender->rateStats() : SenderRateSnapshot{};
+            memcpy(outData, &snapshot, sizeof(snapshot));
+            *outDataSize = sizeof(SenderRateSnapshot);
+            return noErr;
+        }
+        
+        case kSpectrumSideChannelProperty:
+            if (inDataSize < sizeof(UInt32)) return kAudioHardwareBadPropertySizeError;
+            *static_cast<UInt32*>(outData) = (m_udpSender && m_udpSender->spectrumSideChannel()) ? 1 : 0;
+            *outDataSize = sizeof(UInt32);
+            return noErr;
+        
+        case kRecordingPathProperty: {
+            if (inDataSize < kRecordingPathSize) return kAudioHardwareBadPropertySizeError;
+            char* path = static_cast<char*>(outData);
+            std::memset(path, 0, kRecordingPathSize);
+            if (m_recorder && m_recorder->isRecording()) {
+                strncpy(path, m_recorder->path(), kRecordingPathSize - 1);
+            }
+            *outDataSize = kRecordingPathSize;
+            return noErr;
+        }
+        
+        case kReplaySavePathProperty: {
+            if (inDataSize < kRecordingPathSize) return kAudioHardwareBadPropertySizeError;
+            char* path = static_cast<char*>(outData);
+            std::memset(path, 0, kRecordingPathSize);
+            if (m_replayBuffer) {
+                strncpy(path, m_replayBuffer->savePath(), kRecordingPathSize - 1);
+            }
+            *outDataSize = kRecordingPathSize;
+            return noErr;
+        }
+        
         default:
             return kAudioHardwareUnknownPropertyError;
     }
@@ -702,6 +988,59 @@ OSStatus AudioDevice::setPropertyData(const AudioObjectPropertyAddress* address,
             return noErr;
         }
         
+        case kSpectrumSideChannelProperty: {
+            if (inDataSize < sizeof(UInt32)) return kAudioHardwareBadPropertySizeError;
+            const bool enabled = *static_cast<const UInt32*>(inData) != 0;
+            if (m_udpSender) {
+                m_udpSender->setSpectrumSideChannel(enabled);
+            }
+            CYMAX_LOG_INFO("Spectrum side channel %{public}s", enabled ? "enabled" : "disabled");
+            return noErr;
+        }
+        
+        case kRecordingPathProperty: {
+            if (inDataSize > kRecordingPathSize) return kAudioHardwareBadPropertySizeError;
+            if (!m_recorder) return kAudioHardwareUnspecifiedError;
+            char name[kRecordingPathSize] = {0};
+            memcpy(name, inData, inDataSize);
+            name[kRecordingPathSize - 1] = '\0';
+            std::unique_lock<std::mutex> lock(m_resourceMutex);
+            if (name[0] == '\0') {
+                m_recorder->stop();
+                updateSampleRingTapped();
+                m_idleSince = std::chrono::steady_clock::now();
+                lock.unlock();
+                m_idleCondition.notify_all();
+                return noErr;
+            }
+            // Any client can set this: a file name only, never a path
+            if (!AudioFile::isPlainFileName(name)) {
+                CYMAX_LOG_ERROR("Rejecting recording name (plain file names only)");
+                return kAudioHardwareIllegalOperationError;
+            }
+            // Recording taps the ring, which may not exist yet (or any more)
+            if (!allocateStreamResources()) {
+                return kAudioHardwareUnspecifiedError;
+            }
+            const bool started = m_recorder->start(name);
+            updateSampleRingTapped();
+            return started ? noErr : kAudioHardwareIllegalOperationError;
+        }
+        
+        case kReplaySavePathProperty: {
+            if (inDataSize > kRecordingPathSize) return kAudioHardwareBadPropertySizeError;
+            if (!m_replayBuffer) return kAudioHardwareUnspecifiedError;
+            char name[kRecordingPathSize] = {0};
+            memcpy(name, inData, inDataSize);
+            name[kRecordingPathSize - 1] = '\0';
+            // Any client can set this: a file name only, never a path
+            if (!AudioFile::isPlainFileName(name)) {
+                CYMAX_LOG_ERROR("Rejecting replay save name (plain file names only)");
+                return kAudioHardwareIllegalOperationError;
+            }
+            return m_replayBuffer->saveLastAsync(kReplaySaveSeconds, name) ? noErr : kAudioHardwareIllegalOperationError;
+        }
+        
         default:
             return kAudioHardwareUnknownPropertyError;
     }
@@ -10,11 +10,23 @@
 
 #include "CymaxAudioObject.hpp"
 #include "CymaxAudioStream.hpp"
+#include "CymaxAudioControl.hpp"
 #include "RingBuffer.hpp"
+#include "PacketRing.hpp"
 #include "UDPSender.hpp"
+#include "ControlBlock.hpp"
+#include "AnalysisThread.hpp"
+#include "LevelMeter.hpp"
+#include "SpectrumAnalyzer.hpp"
+#include "AudioRecorder.hpp"
+#include "ReplayBuffer.hpp"
 #include <CoreAudio/AudioServerPlugIn.h>
 #include <memory>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 namespace Cymax {
 
@@ -49,6 +61,10 @@ public:
     void stopIO();
     bool isIORunning() const { return m_ioRunning.load(std::memory_order_acquire); }
     
+    /// Allocate and pre-fault the stream resources ahead of startIO (a
+    /// client attached); freed again if IO doesn't start within the idle period
+    void warmUp();
+    
     /// Process audio in the render callback
     /// CRITICAL: This is called from the real-time audio thread
     /// It MUST NOT allocate, lock, log, or make system calls
@@ -64,6 +80,12 @@ public:
     const AudioStream* getOutputStream() const { return m_outputStream.get(); }
     AudioObjectID getOutputStreamID() const;
     
+    // Control access
+    VolumeControl* getVolumeControl() { return m_volumeControl.get(); }
+    MuteControl* getMuteControl() { return m_muteControl.get(); }
+    AudioObjectID getVolumeControlID() const;
+    AudioObjectID getMuteControlID() const;
+    
     // Configuration
     Float64 getSampleRate() const { return m_sampleRate; }
     UInt32 getBufferFrameSize() const { return m_bufferFrameSize; }
@@ -74,6 +96,30 @@ public:
     // Property selector for destination IP address (custom property)
     static constexpr AudioObjectPropertySelector kDestinationIPProperty = 'DstI';
     
+    // Property selector for level meters (read-only, LevelMeterSnapshot)
+    static constexpr AudioObjectPropertySelector kLevelMetersProperty = 'CMtr';
+    
+    // Property selector for sender rates over 1/10/60 s and the last
+    // minute per second (read-only, SenderRateSnapshot; also published in
+    // SenderTimeSeries::kSharedPageName)
+    static constexpr AudioObjectPropertySelector kSenderRatesProperty = 'CRat';
+    
+    // Property selector for spectrum side-channel packets (UInt32 0/1)
+    // The spectrum itself is published in SpectrumAnalyzer::kSharedPageName
+    static constexpr AudioObjectPropertySelector kSpectrumSideChannelProperty = 'CSpS';
+    
+    // Property selector for recording (char[256] file name, created in
+    // AudioFile::kOutputDirectory; set to start, set empty to stop; reads
+    // back the active path or empty)
+    static constexpr AudioObjectPropertySelector kRecordingPathProperty = 'CRec';
+    static constexpr UInt32 kRecordingPathSize = 256;
+    
+    // Property selector for instant replay (char[256] file name, created in
+    // AudioFile::kOutputDirectory; set to save the last kReplaySaveSeconds
+    // of output; reads back the current/last save's path)
+    static constexpr AudioObjectPropertySelector kReplaySavePathProperty = 'CRpl';
+    static constexpr Float64 kReplaySaveSeconds = 5.0 * 60.0;
+    
     /// Set the UDP destination IP address
     bool setDestinationIP(const char* ipAddress);
     
@@ -81,6 +127,12 @@ public:
     static constexpr UInt32 kDefaultBufferFrameSize = 256;
     static constexpr Float64 kDefaultSampleRate = 48000.0;
     static constexpr UInt32 kRingBufferFrames = 48000;  // 1 second at 48kHz for DAW compatibility
+    static constexpr UInt32 kFramesPerPacket = 128;     // MTU-safe: 28 header + 128*2*4 = 1052 bytes
+    static constexpr UInt32 kPacketRingSlots = 128;     // ~340 ms of 128-frame packets at 48kHz
+    static constexpr bool kUsePacketRing = true;        // Render fills packet slots the sender sends in place
+    static constexpr UInt32 kDefaultIdleTeardownSeconds = 60;  // Free stream resources after this long without IO
+    static constexpr bool kUseHugePages = false;        // Back the ring arena with huge pages (Linux; rounds up to 2 MB)
+    static constexpr bool kPlanarSampleRing = true;     // Sample ring keeps planes for the analyzers (packet ring only)
     
     // Device name
     static constexpr const char* kDeviceName = "Cymax Phone Out (MVP)";
@@ -94,9 +146,45 @@ private:
     // Stream
     std::unique_ptr<AudioStream> m_outputStream;
     
+    // Controls (write m_controlState, which the sender reads)
+    OutputControlState m_controlState;
+    std::unique_ptr<VolumeControl> m_volumeControl;
+    std::unique_ptr<MuteControl> m_muteControl;
+    
     // Audio processing
-    std::unique_ptr<RingBuffer<float>> m_ringBuffer;
+    RealtimeArena m_streamArena;                       // Locked, pre-faulted memory for both rings
+    ArenaPtr<RingBuffer<float>> m_ringBuffer;          // Sample ring (taps; sender if no packet ring)
+    ArenaPtr<PacketRing> m_packetRing;                 // Packet slots for the sender (kUsePacketRing)
     std::unique_ptr<UDPSender> m_udpSender;
+    std::unique_ptr<ControlBlock> m_controlBlock;      // Destinations/profile from the menubar app
+    
+    // Analysis (reads the ring through a tap, off the render thread)
+    std::unique_ptr<AnalysisThread> m_analysisThread;
+    std::unique_ptr<LevelMeter> m_levelMeter;
+    std::unique_ptr<SpectrumAnalyzer> m_spectrumAnalyzer;
+    std::unique_ptr<ReplayBuffer> m_replayBuffer;
+    
+    // Recording (own tap and threads)
+    std::unique_ptr<AudioRecorder> m_recorder;
+    
+    // With a packet ring the sample ring only feeds taps: the render
+    // callback writes it only while the analysis thread or the recorder
+    // reads it, so a session with neither copies each buffer once
+    std::atomic<bool> m_sampleRingTapped{false};
+    
+    // Stream resource lifetime: the rings and the sender's threads, socket
+    // and buffers exist from the first startIO (or recording) until the
+    // device has been idle for idleTeardownPeriod(). Guarded by
+    // m_resourceMutex, which startIO, stopIO and the idle thread hold;
+    // the render callback only runs between startIO and stopIO.
+    std::mutex m_resourceMutex;
+    std::condition_variable m_idleCondition;
+    std::thread m_idleThread;                          // Frees resources when idle, then exits
+    std::chrono::steady_clock::time_point m_idleSince;
+    bool m_shuttingDown = false;
+    
+    // How often the idle thread re-checks the period and the recorder
+    static constexpr std::chrono::seconds kIdleRecheckInterval{5};
     
     // State
     std::atomic<bool> m_ioRunning{false};
@@ -114,6 +202,31 @@ private:
     
     void createCFStrings();
     void releaseCFStrings();
+    
+    UDPSenderConfig senderConfig() const;
+    
+    /// Create the rings and hand them to the sender, analysis thread and
+    /// recorder; starts the idle thread (caller holds m_resourceMutex)
+    /// @return true if the resources exist
+    bool allocateStreamResources();
+    
+    /// Free the rings and the sender's threads, socket and buffers (idle
+    /// thread, with m_resourceMutex held and IO stopped)
+    void releaseStreamResources();
+    
+    /// Refresh m_sampleRingTapped after the analysis thread or recorder
+    /// started or stopped (caller holds m_resourceMutex)
+    void updateSampleRingTapped();
+    
+    /// Sample format for the sample ring: int16 only if the sender reads it
+    /// and the wire format is int16
+    RingStorage sampleRingStorage() const;
+    RingLayout sampleRingLayout() const;
+    
+    /// Idle period from the control block, or kDefaultIdleTeardownSeconds
+    std::chrono::seconds idleTeardownPeriod() const;
+    
+    void idleThreadFunc();
 };
 
 } // namespace Cymax
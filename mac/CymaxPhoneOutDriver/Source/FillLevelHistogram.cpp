@@ -0,0 +1,82 @@
+//
+//  FillLevelHistogram.cpp
+//  CymaxPhoneOutDriver
+//
+//  Fill-level histogram implementation
+//
+
+#include "FillLevelHistogram.hpp"
+
+#include <algorithm>
+
+namespace Cymax {
+
+size_t FillLevelSummary::percentileFrames(double percentile, size_t bucketFrames) const {
+    if (samples == 0) {
+        return 0;
+    }
+    const double target = static_cast<double>(samples) * percentile / 100.0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets - 1; ++i) {
+        seen += counts[i];
+        if (static_cast<double>(seen) >= target) {
+            return std::min(maxFrames, (i + 1) * bucketFrames);
+        }
+    }
+    return maxFrames;
+}
+
+void FillLevelHistogram::configure(size_t capacityFrames, size_t bucketFrames) {
+    m_capacityFrames = capacityFrames;
+    m_bucketFrames = std::max<size_t>(1, bucketFrames);
+    m_window = FillLevelSummary();
+    m_windowSum = 0;
+    m_session = FillLevelSummary();
+    m_sessionSum = 0;
+    m_windows = 0;
+
+    FillLevelStats& out = m_published.writeSlot();
+    out = FillLevelStats();
+    out.capacityFrames = m_capacityFrames;
+    out.bucketFrames = m_bucketFrames;
+    m_published.publish();
+}
+
+FillLevelSummary FillLevelHistogram::closeWindow() {
+    if (m_window.samples == 0) {
+        return m_window;
+    }
+    m_window.meanFrames = static_cast<double>(m_windowSum) / static_cast<double>(m_window.samples);
+
+    // Fold the window into the session totals
+    for (size_t i = 0; i < FillLevelSummary::kBuckets; ++i) {
+        m_session.counts[i] += m_window.counts[i];
+    }
+    if (m_session.samples == 0 || m_window.minFrames < m_session.minFrames) {
+        m_session.minFrames = m_window.minFrames;
+    }
+    m_session.maxFrames = std::max(m_session.maxFrames, m_window.maxFrames);
+    m_session.samples += m_window.samples;
+    m_sessionSum += m_windowSum;
+    m_session.meanFrames = static_cast<double>(m_sessionSum) / static_cast<double>(m_session.samples);
+    ++m_windows;
+
+    FillLevelStats& out = m_published.writeSlot();
+    out.capacityFrames = m_capacityFrames;
+    out.bucketFrames = m_bucketFrames;
+    out.windows = m_windows;
+    out.window = m_window;
+    out.session = m_session;
+    m_published.publish();
+
+    const FillLevelSummary closed = m_window;
+    m_window = FillLevelSummary();
+    m_windowSum = 0;
+    return closed;
+}
+
+FillLevelStats FillLevelHistogram::latest() const {
+    return m_published.read();
+}
+
+} // namespace Cymax
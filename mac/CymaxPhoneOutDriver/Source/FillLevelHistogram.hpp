@@ -0,0 +1,110 @@
+//
+//  FillLevelHistogram.hpp
+//  CymaxPhoneOutDriver
+//
+//  Distribution of a ring's fill level as seen by its consumer
+//
+//  The consumer samples the fill every time it looks for audio, so the
+//  producer (the render thread) does no bookkeeping at all. Samples go
+//  into kBuckets fixed-width buckets, normally one packet each (a ring
+//  sized for a second rarely holds more than a few packets), plus
+//  min/mean/max. Every window the accumulators are published through a
+//  triple buffer and restarted, alongside totals for the whole session,
+//  so buffer sizing can use the real distribution rather than one peak.
+//
+
+#ifndef FillLevelHistogram_hpp
+#define FillLevelHistogram_hpp
+
+#include "TripleBuffer.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace Cymax {
+
+/// Fill-level distribution over some span of time
+struct FillLevelSummary {
+    static constexpr size_t kBuckets = 32;
+
+    /// Bucket i counts fills in [i, i + 1) * bucketFrames; the last bucket
+    /// holds everything from (kBuckets - 1) * bucketFrames up
+    uint64_t counts[kBuckets] = {0};
+    uint64_t samples = 0;
+    size_t minFrames = 0;
+    size_t maxFrames = 0;
+    double meanFrames = 0.0;
+
+    /// Upper bound of the bucket holding the given percentile (0-100),
+    /// in frames, clamped to maxFrames
+    size_t percentileFrames(double percentile, size_t bucketFrames) const;
+};
+
+/// Published fill-level statistics
+struct FillLevelStats {
+    size_t capacityFrames = 0;
+    size_t bucketFrames = 0;
+    uint64_t windows = 0;            // Windows completed this session
+    FillLevelSummary window;         // The last completed window
+    FillLevelSummary session;        // Everything since configure()
+};
+
+/// Fill-level histogram of one ring
+/// record() and closeWindow() from the consumer thread only; latest()
+/// from any thread.
+class FillLevelHistogram {
+public:
+    FillLevelHistogram() = default;
+
+    // Non-copyable
+    FillLevelHistogram(const FillLevelHistogram&) = delete;
+    FillLevelHistogram& operator=(const FillLevelHistogram&) = delete;
+
+    /// Start a new session
+    /// Call while the consumer isn't running.
+    /// @param capacityFrames Ring capacity (reported only)
+    /// @param bucketFrames Bucket width, e.g. the frames the consumer reads at once
+    void configure(size_t capacityFrames, size_t bucketFrames);
+
+    /// Record one observation of the fill level
+    void record(size_t fillFrames) {
+        size_t bucket = m_bucketFrames > 0 ? fillFrames / m_bucketFrames : 0;
+        if (bucket >= FillLevelSummary::kBuckets) {
+            bucket = FillLevelSummary::kBuckets - 1;
+        }
+        ++m_window.counts[bucket];
+        if (m_window.samples == 0 || fillFrames < m_window.minFrames) {
+            m_window.minFrames = fillFrames;
+        }
+        if (fillFrames > m_window.maxFrames) {
+            m_window.maxFrames = fillFrames;
+        }
+        ++m_window.samples;
+        m_windowSum += fillFrames;
+    }
+
+    /// Publish the current window and start the next (publishes nothing
+    /// when empty)
+    /// @return The window just closed (samples == 0 if empty)
+    FillLevelSummary closeWindow();
+
+    /// Latest published statistics
+    FillLevelStats latest() const;
+
+private:
+    size_t m_capacityFrames = 0;
+    size_t m_bucketFrames = 0;
+
+    // Consumer thread only
+    FillLevelSummary m_window;
+    uint64_t m_windowSum = 0;
+    FillLevelSummary m_session;
+    uint64_t m_sessionSum = 0;
+    uint64_t m_windows = 0;
+
+    // latest() may be called from several threads
+    SharedTripleBuffer<FillLevelStats> m_published;
+};
+
+} // namespace Cymax
+
+#endif /* FillLevelHistogram_hpp */
@@ -0,0 +1,203 @@
+//
+//  LevelMeter.cpp
+//  CymaxPhoneOutDriver
+//
+//  Peak, RMS and short-term loudness metering implementation
+//
+
+#include "LevelMeter.hpp"
+#include "SampleKernels.hpp"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Cymax {
+
+LevelMeter::LevelMeter() {
+    designKWeighting(48000.0);
+}
+
+void LevelMeter::designKWeighting(double sampleRate) {
+    // BS.1770 pre-filter, re-derived for any sample rate from its
+    // analog prototype (matches the published 48 kHz coefficients)
+    const double pi = 3.14159265358979323846;
+
+    {
+        const double f0 = 1681.974450955533;
+        const double gainDB = 3.999843853973347;
+        const double q = 0.7071752369554196;
+        const double k = std::tan(pi * f0 / sampleRate);
+        const double vh = std::pow(10.0, gainDB / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+        m_shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        m_shelf.b1 = 2.0 * (k * k - vh) / a0;
+        m_shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        m_shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        m_shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+        const double k = std::tan(pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+        m_highPass.b0 = 1.0;
+        m_highPass.b1 = -2.0;
+        m_highPass.b2 = 1.0;
+        m_highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        m_highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+}
+
+void LevelMeter::prepare(double sampleRate, size_t channels, size_t maxFrames) {
+    m_streamChannels = channels;
+    m_channels = std::min<size_t>(channels, LevelMeterSnapshot::kMaxChannels);
+    designKWeighting(sampleRate);
+
+    m_planeStorage.assign(m_channels * maxFrames, 0.0f);
+    for (size_t c = 0; c < m_channels; ++c) {
+        m_planes[c] = m_planeStorage.data() + c * maxFrames;
+    }
+    m_weighted.assign(maxFrames, 0.0f);
+
+    for (size_t c = 0; c < LevelMeterSnapshot::kMaxChannels; ++c) {
+        m_shelfState[c] = BiquadState();
+        m_highPassState[c] = BiquadState();
+        m_peak[c] = 0.0f;
+        m_sumSquares[c] = 0.0;
+        m_currentBlock[c] = 0.0;
+    }
+    std::memset(m_blocks, 0, sizeof(m_blocks));
+    m_intervalFrames = 0;
+    m_blockFrames = std::max<size_t>(1, static_cast<size_t>(sampleRate / 10.0));
+    m_blockFill = 0;
+    m_blockIndex = 0;
+    m_blocksFilled = 0;
+
+    CYMAX_LOG_DEBUG("LevelMeter prepared: %.0f Hz, %zu ch", sampleRate, m_channels);
+}
+
+void LevelMeter::filter(const Biquad& bq, BiquadState& state, float* data, size_t count) {
+    double x1 = state.x1, x2 = state.x2, y1 = state.y1, y2 = state.y2;
+    for (size_t i = 0; i < count; ++i) {
+        const double x = data[i];
+        const double y = bq.b0 * x + bq.b1 * x1 + bq.b2 * x2 - bq.a1 * y1 - bq.a2 * y2;
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        data[i] = static_cast<float>(y);
+    }
+    // Flush denormals so silence doesn't slow the filter down
+    if (std::fabs(y1) < 1e-30) y1 = 0.0;
+    if (std::fabs(y2) < 1e-30) y2 = 0.0;
+    state.x1 = x1; state.x2 = x2; state.y1 = y1; state.y2 = y2;
+}
+
+void LevelMeter::process(const float* samples, size_t frames) {
+    if (m_channels == 0 || frames == 0) {
+        return;
+    }
+
+    const Kernels::KernelTable& kernels = Kernels::active();
+    if (m_streamChannels == m_channels) {
+        kernels.deinterleave(samples, m_planes, frames, m_channels);
+    } else {
+        // More channels than we meter; take the first kMaxChannels
+        for (size_t f = 0; f < frames; ++f) {
+            for (size_t c = 0; c < m_channels; ++c) {
+                m_planes[c][f] = samples[f * m_streamChannels + c];
+            }
+        }
+    }
+
+    measure(m_planes, frames);
+}
+
+void LevelMeter::processPlanar(const float* const* planes, size_t frames) {
+    if (m_channels == 0 || frames == 0) {
+        return;
+    }
+    // Only the first m_channels planes are metered
+    measure(planes, frames);
+}
+
+void LevelMeter::measure(const float* const* planes, size_t frames) {
+    const Kernels::KernelTable& kernels = Kernels::active();
+    for (size_t c = 0; c < m_channels; ++c) {
+        m_peak[c] = std::max(m_peak[c], kernels.peakAbs(planes[c], frames));
+        m_sumSquares[c] += kernels.sumOfSquares(planes[c], frames);
+    }
+    m_intervalFrames += frames;
+
+    // K-weighted energy, split at 100 ms block boundaries
+    size_t offset = 0;
+    while (offset < frames) {
+        const size_t run = std::min(frames - offset, m_blockFrames - m_blockFill);
+        for (size_t c = 0; c < m_channels; ++c) {
+            float* weighted = m_weighted.data();
+            std::memcpy(weighted, planes[c] + offset, run * sizeof(float));
+            filter(m_shelf, m_shelfState[c], weighted, run);
+            filter(m_highPass, m_highPassState[c], weighted, run);
+            m_currentBlock[c] += kernels.sumOfSquares(weighted, run);
+        }
+        m_blockFill += run;
+        offset += run;
+
+        if (m_blockFill == m_blockFrames) {
+            for (size_t c = 0; c < m_channels; ++c) {
+                m_blocks[m_blockIndex][c] = m_currentBlock[c];
+                m_currentBlock[c] = 0.0;
+            }
+            m_blockIndex = (m_blockIndex + 1) % kLoudnessBlocks;
+            m_blocksFilled = std::min(m_blocksFilled + 1, kLoudnessBlocks);
+            m_blockFill = 0;
+        }
+    }
+}
+
+void LevelMeter::publish() {
+    LevelMeterSnapshot& out = m_published.writeSlot();
+    std::memset(&out, 0, sizeof(out));
+    out.sequence = ++m_sequence;
+    out.channels = static_cast<uint32_t>(m_channels);
+
+    auto toLUFS = [](double meanSquare) {
+        if (meanSquare <= 0.0) return kSilenceLUFS;
+        return std::max(kSilenceLUFS, static_cast<float>(-0.691 + 10.0 * std::log10(meanSquare)));
+    };
+
+    const double windowFrames = static_cast<double>(m_blocksFilled * m_blockFrames);
+    double total = 0.0;
+    for (size_t c = 0; c < m_channels; ++c) {
+        out.peak[c] = m_peak[c];
+        out.rms[c] = m_intervalFrames > 0
+            ? static_cast<float>(std::sqrt(m_sumSquares[c] / static_cast<double>(m_intervalFrames)))
+            : 0.0f;
+
+        double energy = 0.0;
+        for (size_t b = 0; b < m_blocksFilled; ++b) {
+            energy += m_blocks[b][c];
+        }
+        const double meanSquare = windowFrames > 0.0 ? energy / windowFrames : 0.0;
+        out.shortTermLUFS[c] = toLUFS(meanSquare);
+        // BS.1770 channel weights are 1.0 for left/right/centre
+        total += meanSquare;
+
+        m_peak[c] = 0.0f;
+        m_sumSquares[c] = 0.0;
+    }
+    out.shortTermLUFSTotal = toLUFS(total);
+    m_intervalFrames = 0;
+
+    m_published.publish();
+}
+
+LevelMeterSnapshot LevelMeter::latest() const {
+    return m_published.read();
+}
+
+} // namespace Cymax
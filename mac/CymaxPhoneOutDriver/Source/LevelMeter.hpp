@@ -0,0 +1,121 @@
+//
+//  LevelMeter.hpp
+//  CymaxPhoneOutDriver
+//
+//  Peak, RMS and short-term loudness metering
+//
+//  Peak and RMS cover the interval since the previous publish. Loudness
+//  follows ITU-R BS.1770: K-weighting, then mean square over a sliding
+//  3 second window kept as 100 ms blocks (short-term loudness, no gating).
+//
+
+#ifndef LevelMeter_hpp
+#define LevelMeter_hpp
+
+#include "AudioAnalyzer.hpp"
+#include "TripleBuffer.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace Cymax {
+
+/// Published meter values
+/// Plain data; returned as-is through the device's kLevelMetersProperty
+struct LevelMeterSnapshot {
+    static constexpr uint32_t kMaxChannels = 8;
+
+    /// Incremented on every publish (0 = never published)
+    uint32_t sequence;
+
+    /// Valid entries in the per-channel arrays
+    uint32_t channels;
+
+    /// Linear sample peak per channel
+    float peak[kMaxChannels];
+
+    /// Linear RMS per channel
+    float rms[kMaxChannels];
+
+    /// Short-term loudness per channel, LUFS
+    float shortTermLUFS[kMaxChannels];
+
+    /// Short-term loudness of all channels combined, LUFS
+    float shortTermLUFSTotal;
+};
+
+// DriverCommunication.swift reads this layout byte for byte
+static_assert(sizeof(LevelMeterSnapshot) == 8 + 3 * LevelMeterSnapshot::kMaxChannels * 4 + 4,
+              "LevelMeterSnapshot layout changed");
+
+/// Meter analyzer
+class LevelMeter : public AudioAnalyzer {
+public:
+    LevelMeter();
+    ~LevelMeter() override = default;
+
+    // AudioAnalyzer overrides
+    const char* name() const override { return "level meter"; }
+    void prepare(double sampleRate, size_t channels, size_t maxFrames) override;
+    void process(const float* samples, size_t frames) override;
+    bool acceptsPlanar() const override { return true; }
+    void processPlanar(const float* const* planes, size_t frames) override;
+    void publish() override;
+
+    /// Latest published values (any thread)
+    LevelMeterSnapshot latest() const;
+
+    /// Loudness reported for silence
+    static constexpr float kSilenceLUFS = -144.0f;
+
+private:
+    /// Direct form I biquad (coefficients normalized by a0)
+    struct Biquad {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+    struct BiquadState {
+        double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+    };
+
+    static void filter(const Biquad& bq, BiquadState& state, float* data, size_t count);
+    void designKWeighting(double sampleRate);
+
+    /// Peak, RMS and loudness of one block of the first m_channels planes
+    void measure(const float* const* planes, size_t frames);
+
+    static constexpr size_t kLoudnessBlocks = 30;  // 30 x 100 ms = 3 s
+
+    size_t m_streamChannels = 0;
+    size_t m_channels = 0;  // Metered: min(stream, kMaxChannels)
+
+    // K-weighting: high shelf then high pass
+    Biquad m_shelf;
+    Biquad m_highPass;
+    BiquadState m_shelfState[LevelMeterSnapshot::kMaxChannels];
+    BiquadState m_highPassState[LevelMeterSnapshot::kMaxChannels];
+
+    // Per-publish accumulators
+    float m_peak[LevelMeterSnapshot::kMaxChannels] = {};
+    double m_sumSquares[LevelMeterSnapshot::kMaxChannels] = {};
+    size_t m_intervalFrames = 0;
+
+    // Loudness blocks: K-weighted sum of squares per channel
+    size_t m_blockFrames = 4800;
+    size_t m_blockFill = 0;
+    size_t m_blockIndex = 0;
+    size_t m_blocksFilled = 0;
+    double m_currentBlock[LevelMeterSnapshot::kMaxChannels] = {};
+    double m_blocks[kLoudnessBlocks][LevelMeterSnapshot::kMaxChannels] = {};
+
+    // Planar scratch (allocated in prepare)
+    std::vector<float> m_planeStorage;
+    float* m_planes[LevelMeterSnapshot::kMaxChannels] = {};
+    std::vector<float> m_weighted;
+
+    // Published values; latest() may be called from several HAL threads
+    SharedTripleBuffer<LevelMeterSnapshot> m_published;
+    uint32_t m_sequence = 0;
+};
+
+} // namespace Cymax
+
+#endif /* LevelMeter_hpp */
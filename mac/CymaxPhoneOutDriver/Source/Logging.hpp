@@ -11,13 +11,22 @@
 //  - For MVP, we use os_log which is lock-free and designed for real-time contexts
 //    BUT we still disable it in the render path to be extra safe
 //
+//  Off Apple platforms (the portable core on Linux) messages go to stderr
+//  instead, with os_log privacy annotations ("%{public}s") stripped.
+//  Errors are always written; set CYMAX_LOG=info or CYMAX_LOG=debug in
+//  the environment to see more.
+//
 
 #ifndef Logging_hpp
 #define Logging_hpp
 
+#if defined(__APPLE__)
 #include <os/log.h>
+#endif
 #include <cstdio>
 #include <cstdarg>
+#include <cstdlib>
+#include <cstring>
 
 // Compile-time switches for logging levels
 // Set to 0 to completely remove logging code from binary
@@ -31,6 +40,8 @@
 
 namespace CymaxLog {
 
+#if defined(__APPLE__)
+
 // os_log subsystem and categories
 inline os_log_t getLogHandle() {
     static os_log_t log = os_log_create("com.cymax.phoneoutdriver", "driver");
@@ -47,22 +58,84 @@ inline os_log_t getNetworkLogHandle() {
     return log;
 }
 
+#define CYMAX_LOG_WRITE_ERROR(handle, fmt, ...) os_log_error(CymaxLog::handle(), fmt, ##__VA_ARGS__)
+#define CYMAX_LOG_WRITE_INFO(handle, fmt, ...) os_log_info(CymaxLog::handle(), fmt, ##__VA_ARGS__)
+#define CYMAX_LOG_WRITE_DEBUG(handle, fmt, ...) os_log_debug(CymaxLog::handle(), fmt, ##__VA_ARGS__)
+
+#else
+
+enum class Level { Error, Info, Debug };
+
+// Categories, written in front of each line
+inline const char* getLogHandle() { return "driver"; }
+inline const char* getAudioLogHandle() { return "audio"; }
+inline const char* getNetworkLogHandle() { return "network"; }
+
+/// Most detailed level written (from CYMAX_LOG, read once)
+inline Level maximumLevel() {
+    static const Level level = [] {
+        const char* setting = std::getenv("CYMAX_LOG");
+        if (setting && std::strcmp(setting, "debug") == 0) {
+            return Level::Debug;
+        }
+        return setting && std::strcmp(setting, "info") == 0 ? Level::Info : Level::Error;
+    }();
+    return level;
+}
+
+/// Write one line to stderr (no allocation: the format is rewritten on
+/// the stack)
+inline void write(Level level, const char* category, const char* format, ...) {
+    if (level > maximumLevel()) {
+        return;
+    }
+
+    // "%{public}s" -> "%s"
+    char plain[512];
+    size_t length = 0;
+    for (const char* p = format; *p != '\0' && length < sizeof(plain) - 1; ++p) {
+        plain[length++] = *p;
+        if (p[0] == '%' && p[1] == '{') {
+            if (const char* close = std::strchr(p, '}')) {
+                p = close;
+            }
+        }
+    }
+    plain[length] = '\0';
+
+    char line[1024];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(line, sizeof(line), plain, args);
+    va_end(args);
+    std::fprintf(stderr, "[%s] %s\n", category, line);
+}
+
+#define CYMAX_LOG_WRITE_ERROR(handle, fmt, ...) \
+    CymaxLog::write(CymaxLog::Level::Error, CymaxLog::handle(), fmt, ##__VA_ARGS__)
+#define CYMAX_LOG_WRITE_INFO(handle, fmt, ...) \
+    CymaxLog::write(CymaxLog::Level::Info, CymaxLog::handle(), fmt, ##__VA_ARGS__)
+#define CYMAX_LOG_WRITE_DEBUG(handle, fmt, ...) \
+    CymaxLog::write(CymaxLog::Level::Debug, CymaxLog::handle(), fmt, ##__VA_ARGS__)
+
+#endif
+
 } // namespace CymaxLog
 
 // Main logging macros
 #if CYMAX_LOG_ENABLED
 
 #define CYMAX_LOG_ERROR(fmt, ...) \
-    os_log_error(CymaxLog::getLogHandle(), fmt, ##__VA_ARGS__)
+    CYMAX_LOG_WRITE_ERROR(getLogHandle, fmt, ##__VA_ARGS__)
 
 #define CYMAX_LOG_INFO(fmt, ...) \
-    os_log_info(CymaxLog::getLogHandle(), fmt, ##__VA_ARGS__)
+    CYMAX_LOG_WRITE_INFO(getLogHandle, fmt, ##__VA_ARGS__)
 
 #define CYMAX_LOG_AUDIO(fmt, ...) \
-    os_log_info(CymaxLog::getAudioLogHandle(), fmt, ##__VA_ARGS__)
+    CYMAX_LOG_WRITE_INFO(getAudioLogHandle, fmt, ##__VA_ARGS__)
 
 #define CYMAX_LOG_NETWORK(fmt, ...) \
-    os_log_info(CymaxLog::getNetworkLogHandle(), fmt, ##__VA_ARGS__)
+    CYMAX_LOG_WRITE_INFO(getNetworkLogHandle, fmt, ##__VA_ARGS__)
 
 #else
 
@@ -77,7 +150,7 @@ inline os_log_t getNetworkLogHandle() {
 #if CYMAX_LOG_ENABLED && CYMAX_LOG_DEBUG_ENABLED
 
 #define CYMAX_LOG_DEBUG(fmt, ...) \
-    os_log_debug(CymaxLog::getLogHandle(), fmt, ##__VA_ARGS__)
+    CYMAX_LOG_WRITE_DEBUG(getLogHandle, fmt, ##__VA_ARGS__)
 
 #else
 
@@ -89,7 +162,7 @@ inline os_log_t getNetworkLogHandle() {
 #if CYMAX_LOG_ENABLED && CYMAX_LOG_VERBOSE_ENABLED
 
 #define CYMAX_LOG_VERBOSE(fmt, ...) \
-    os_log_debug(CymaxLog::getLogHandle(), fmt, ##__VA_ARGS__)
+    CYMAX_LOG_WRITE_DEBUG(getLogHandle, fmt, ##__VA_ARGS__)
 
 #else
 
@@ -103,7 +176,7 @@ inline os_log_t getNetworkLogHandle() {
 #if CYMAX_LOG_RENDER_CALLBACK
 
 #define CYMAX_LOG_RENDER(fmt, ...) \
-    os_log_debug(CymaxLog::getAudioLogHandle(), fmt, ##__VA_ARGS__)
+    CYMAX_LOG_WRITE_DEBUG(getAudioLogHandle, fmt, ##__VA_ARGS__)
 
 #else
 
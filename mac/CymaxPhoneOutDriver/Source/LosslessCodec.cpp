@@ -0,0 +1,336 @@
+//
+//  LosslessCodec.cpp
+//  CymaxPhoneOutDriver
+//
+//  Lossless block codec implementation
+//
+
+#include "LosslessCodec.hpp"
+
+#include <algorithm>
+
+namespace Cymax {
+
+namespace {
+
+/// MSB-first bit writer
+struct BitWriter {
+    uint8_t* out;
+    size_t pos = 0;
+    uint64_t acc = 0;
+    unsigned bits = 0;
+
+    explicit BitWriter(uint8_t* o) : out(o) {}
+
+    void write(uint32_t value, unsigned n) {
+        if (n == 0) return;
+        acc = (acc << n) | (value & (n == 32 ? 0xFFFFFFFFu : ((1u << n) - 1)));
+        bits += n;
+        while (bits >= 8) {
+            bits -= 8;
+            out[pos++] = static_cast<uint8_t>(acc >> bits);
+        }
+        acc &= (1ULL << bits) - 1;
+    }
+
+    void writeUnary(uint32_t zeros) {
+        while (zeros >= 32) {
+            write(0, 32);
+            zeros -= 32;
+        }
+        write(1, zeros + 1);
+    }
+
+    size_t finish() {
+        if (bits > 0) {
+            out[pos++] = static_cast<uint8_t>(acc << (8 - bits));
+            bits = 0;
+            acc = 0;
+        }
+        return pos;
+    }
+};
+
+/// MSB-first bit reader with a 64-bit cache
+struct BitReader {
+    const uint8_t* in;
+    size_t size;
+    size_t bytePos = 0;
+    uint64_t cache = 0;
+    unsigned cacheBits = 0;
+    uint64_t bitsConsumed = 0;
+
+    BitReader(const uint8_t* i, size_t s) : in(i), size(s) {}
+
+    void refill() {
+        while (cacheBits <= 56) {
+            const uint64_t byte = bytePos < size ? in[bytePos] : 0;
+            cache |= byte << (56 - cacheBits);
+            ++bytePos;
+            cacheBits += 8;
+        }
+    }
+
+    uint32_t read(unsigned n) {
+        if (n == 0) return 0;
+        if (cacheBits < n) refill();
+        const uint32_t value = static_cast<uint32_t>(cache >> (64 - n));
+        cache <<= n;
+        cacheBits -= n;
+        bitsConsumed += n;
+        return value;
+    }
+
+    uint32_t readUnary() {
+        uint32_t zeros = 0;
+        for (;;) {
+            refill();
+            if (cache == 0) {
+                zeros += cacheBits;
+                bitsConsumed += cacheBits;
+                cacheBits = 0;
+                if (overrun()) return zeros;
+                continue;
+            }
+            const unsigned lz = static_cast<unsigned>(__builtin_clzll(cache));
+            zeros += lz;
+            cache <<= (lz + 1);
+            cacheBits -= (lz + 1);
+            bitsConsumed += lz + 1;
+            return zeros;
+        }
+    }
+
+    bool overrun() const {
+        return bitsConsumed > static_cast<uint64_t>(size) * 8;
+    }
+};
+
+inline uint32_t zigzag(int32_t v) {
+    return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+}
+
+inline int32_t unzigzag(uint32_t u) {
+    return static_cast<int32_t>(u >> 1) ^ -static_cast<int32_t>(u & 1);
+}
+
+inline int64_t fixedPrediction(const int32_t* x, size_t i, unsigned order) {
+    switch (order) {
+        case 0: return 0;
+        case 1: return x[i - 1];
+        case 2: return 2 * static_cast<int64_t>(x[i - 1]) - x[i - 2];
+        default: return 3 * static_cast<int64_t>(x[i - 1]) - 3 * static_cast<int64_t>(x[i - 2]) + x[i - 3];
+    }
+}
+
+/// Pick the fixed order with the smallest residual magnitude
+/// @return Sum of |residual| for the chosen order
+uint64_t chooseOrder(const int32_t* x, size_t n, unsigned& outOrder) {
+    uint64_t cost[4] = {0, 0, 0, 0};
+    for (size_t i = 3; i < n; ++i) {
+        const int64_t e0 = x[i];
+        const int64_t e1 = e0 - x[i - 1];
+        const int64_t e2 = e1 - (static_cast<int64_t>(x[i - 1]) - x[i - 2]);
+        const int64_t e3 = e2 - ((static_cast<int64_t>(x[i - 1]) - x[i - 2]) - (static_cast<int64_t>(x[i - 2]) - x[i - 3]));
+        cost[0] += static_cast<uint64_t>(e0 < 0 ? -e0 : e0);
+        cost[1] += static_cast<uint64_t>(e1 < 0 ? -e1 : e1);
+        cost[2] += static_cast<uint64_t>(e2 < 0 ? -e2 : e2);
+        cost[3] += static_cast<uint64_t>(e3 < 0 ? -e3 : e3);
+    }
+    unsigned best = 0;
+    for (unsigned o = 1; o < 4; ++o) {
+        if (cost[o] < cost[best]) best = o;
+    }
+    outOrder = n > 3 ? best : 0;
+    return cost[outOrder];
+}
+
+} // namespace
+
+LosslessCodec::LosslessCodec(size_t maxFrames, size_t channels)
+    : m_maxFrames(maxFrames)
+    , m_channels(channels)
+    , m_planes(maxFrames * channels)
+    , m_residual(maxFrames)
+    , m_side(channels == 2 ? maxFrames : 0)
+    , m_rows(channels)
+{
+}
+
+size_t LosslessCodec::maxEncodedBytes(size_t frames) const {
+    const size_t headerBits = 1 + m_channels * (3 + 5 + 3 * kSampleBits);
+    const size_t sampleBits = frames * m_channels * (kEscapeQuotient + 1 + 32);
+    return (headerBits + sampleBits) / 8 + 8;
+}
+
+size_t LosslessCodec::encode(const int32_t* samples, size_t frames, uint8_t* out) {
+    frames = std::min(frames, m_maxFrames);
+
+    // Deinterleave
+    for (size_t c = 0; c < m_channels; ++c) {
+        int32_t* plane = m_planes.data() + c * m_maxFrames;
+        for (size_t f = 0; f < frames; ++f) {
+            plane[f] = samples[f * m_channels + c];
+        }
+        m_rows[c] = plane;
+    }
+    return encodeRows(frames, out);
+}
+
+size_t LosslessCodec::encodePlanar(const int32_t* const* planes, size_t frames, uint8_t* out) {
+    frames = std::min(frames, m_maxFrames);
+    std::copy(planes, planes + m_channels, m_rows.begin());
+    return encodeRows(frames, out);
+}
+
+size_t LosslessCodec::encodeRows(size_t frames, uint8_t* out) {
+    // Stereo: code the right channel as side if that's cheaper
+    bool useSide = false;
+    if (m_channels == 2 && frames > 3) {
+        const int32_t* left = m_rows[0];
+        const int32_t* right = m_rows[1];
+        int32_t* side = m_side.data();
+        for (size_t f = 0; f < frames; ++f) {
+            side[f] = left[f] - right[f];
+        }
+        unsigned orderR = 0, orderS = 0;
+        const uint64_t costR = chooseOrder(right, frames, orderR);
+        const uint64_t costS = chooseOrder(side, frames, orderS);
+        if (costS < costR) {
+            m_rows[1] = side;
+            useSide = true;
+        }
+    }
+
+    BitWriter writer(out);
+    writer.write(useSide ? 1 : 0, 1);
+
+    for (size_t c = 0; c < m_channels; ++c) {
+        const int32_t* x = m_rows[c];
+
+        // Constant run (silence, DC)
+        bool constant = true;
+        for (size_t f = 1; f < frames && constant; ++f) {
+            constant = x[f] == x[0];
+        }
+        if (constant) {
+            writer.write(0, 3);
+            writer.write(0, 5);
+            writer.write(static_cast<uint32_t>(frames ? x[0] : 0), kSampleBits);
+            continue;
+        }
+
+        unsigned order = 0;
+        const uint64_t cost = chooseOrder(x, frames, order);
+
+        // Rice parameter near log2(mean residual), then best of neighbours
+        const size_t coded = frames - order;
+        const uint64_t mean = cost / std::max<size_t>(1, coded);
+        unsigned estimate = 0;
+        while (estimate < 30 && (2ULL << estimate) <= mean) ++estimate;
+
+        int32_t* residual = m_residual.data();
+        for (size_t f = order; f < frames; ++f) {
+            residual[f] = static_cast<int32_t>(x[f] - fixedPrediction(x, f, order));
+        }
+
+        unsigned k = estimate;
+        uint64_t bestBits = ~0ULL;
+        for (unsigned candidate = estimate > 0 ? estimate - 1 : 0; candidate <= std::min(30u, estimate + 1); ++candidate) {
+            uint64_t bits = 0;
+            for (size_t f = order; f < frames; ++f) {
+                const uint32_t q = zigzag(residual[f]) >> candidate;
+                bits += q < kEscapeQuotient ? q + 1 + candidate : kEscapeQuotient + 1 + 32;
+            }
+            if (bits < bestBits) {
+                bestBits = bits;
+                k = candidate;
+            }
+        }
+
+        writer.write(order + 1, 3);
+        writer.write(k, 5);
+        for (size_t f = 0; f < order; ++f) {
+            writer.write(static_cast<uint32_t>(x[f]), kSampleBits);
+        }
+        for (size_t f = order; f < frames; ++f) {
+            const uint32_t u = zigzag(residual[f]);
+            const uint32_t q = u >> k;
+            if (q < kEscapeQuotient) {
+                writer.writeUnary(q);
+                writer.write(u, k);
+            } else {
+                writer.writeUnary(kEscapeQuotient);
+                writer.write(u, 32);
+            }
+        }
+    }
+
+    return writer.finish();
+}
+
+bool LosslessCodec::decode(const uint8_t* in, size_t bytes, size_t frames, int32_t* samples) {
+    if (frames > m_maxFrames) {
+        return false;
+    }
+
+    BitReader reader(in, bytes);
+    const bool useSide = reader.read(1) != 0;
+
+    auto signExtend = [](uint32_t v) {
+        return static_cast<int32_t>(v << (32 - kSampleBits)) >> (32 - kSampleBits);
+    };
+
+    for (size_t c = 0; c < m_channels; ++c) {
+        int32_t* x = m_planes.data() + c * m_maxFrames;
+        const unsigned kind = reader.read(3);
+        const unsigned k = reader.read(5);
+
+        if (kind == 0) {
+            const int32_t value = signExtend(reader.read(kSampleBits));
+            std::fill(x, x + frames, value);
+            continue;
+        }
+        if (kind > 4) {
+            return false;
+        }
+
+        const unsigned order = std::min<unsigned>(kind - 1, static_cast<unsigned>(frames));
+        for (size_t f = 0; f < order; ++f) {
+            x[f] = signExtend(reader.read(kSampleBits));
+        }
+        for (size_t f = order; f < frames; ++f) {
+            const uint32_t q = reader.readUnary();
+            uint32_t u;
+            if (q < kEscapeQuotient) {
+                u = (q << k) | reader.read(k);
+            } else if (q == kEscapeQuotient) {
+                u = reader.read(32);
+            } else {
+                return false;
+            }
+            x[f] = static_cast<int32_t>(fixedPrediction(x, f, order) + unzigzag(u));
+        }
+        if (reader.overrun()) {
+            return false;
+        }
+    }
+
+    if (useSide && m_channels == 2) {
+        int32_t* left = m_planes.data();
+        int32_t* right = left + m_maxFrames;
+        for (size_t f = 0; f < frames; ++f) {
+            right[f] = left[f] - right[f];
+        }
+    }
+
+    for (size_t c = 0; c < m_channels; ++c) {
+        const int32_t* plane = m_planes.data() + c * m_maxFrames;
+        for (size_t f = 0; f < frames; ++f) {
+            samples[f * m_channels + c] = plane[f];
+        }
+    }
+    return true;
+}
+
+} // namespace Cymax
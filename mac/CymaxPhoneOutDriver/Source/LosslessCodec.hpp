@@ -0,0 +1,89 @@
+//
+//  LosslessCodec.hpp
+//  CymaxPhoneOutDriver
+//
+//  Lossless block codec for 24-bit PCM
+//
+//  FLAC-style: per channel, the best of the fixed polynomial predictors
+//  (order 0-3) or a constant run, with residuals Rice coded using one
+//  parameter per channel per block. Stereo blocks may code the second
+//  channel as side (L - R). No allocation after construction.
+//
+//  Block layout (bitstream, MSB first):
+//    stereo mode (1 bit)
+//    per channel: kind (3 bits: 0 constant, 1-4 fixed order 0-3)
+//                 rice parameter (5 bits)
+//                 warm-up samples (kind - 1, 26 bits each) or constant
+//                 residuals (unary quotient, rice-bit remainder; a
+//                 quotient of kEscapeQuotient is followed by 32 raw bits)
+//
+
+#ifndef LosslessCodec_hpp
+#define LosslessCodec_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Cymax {
+
+/// Lossless codec for blocks of interleaved 24-bit samples held in int32
+class LosslessCodec {
+public:
+    /// @param maxFrames Largest block size
+    /// @param channels Interleaved channel count
+    LosslessCodec(size_t maxFrames, size_t channels);
+
+    // Non-copyable
+    LosslessCodec(const LosslessCodec&) = delete;
+    LosslessCodec& operator=(const LosslessCodec&) = delete;
+
+    /// Worst-case encoded size of a block
+    size_t maxEncodedBytes(size_t frames) const;
+
+    /// Encode a block
+    /// @param samples Interleaved samples in [-2^23, 2^23)
+    /// @param frames Frames in the block (<= maxFrames)
+    /// @param out Output buffer of at least maxEncodedBytes(frames)
+    /// @return Encoded size in bytes
+    size_t encode(const int32_t* samples, size_t frames, uint8_t* out);
+
+    /// Encode a block held as one plane per channel (same bitstream as encode)
+    /// @param planes channels() planes of samples in [-2^23, 2^23)
+    /// @param frames Frames in the block (<= maxFrames)
+    /// @param out Output buffer of at least maxEncodedBytes(frames)
+    /// @return Encoded size in bytes
+    size_t encodePlanar(const int32_t* const* planes, size_t frames, uint8_t* out);
+
+    /// Decode a block
+    /// @param in Encoded block
+    /// @param bytes Encoded size
+    /// @param frames Frames in the block (as encoded)
+    /// @param samples Output, frames * channels interleaved samples
+    /// @return false if the block is malformed
+    bool decode(const uint8_t* in, size_t bytes, size_t frames, int32_t* samples);
+
+    size_t channels() const { return m_channels; }
+
+private:
+    static constexpr uint32_t kEscapeQuotient = 24;
+    static constexpr unsigned kSampleBits = 26;  // Room for side channel + sign
+
+    /// Encode the channels m_rows points at
+    size_t encodeRows(size_t frames, uint8_t* out);
+
+    size_t m_maxFrames;
+    size_t m_channels;
+
+    // Planar scratch: one row per channel, plus residuals
+    std::vector<int32_t> m_planes;
+    std::vector<int32_t> m_residual;
+    std::vector<int32_t> m_side;        // Stereo side channel
+
+    // Rows being encoded: m_planes, the caller's planes, or m_side
+    std::vector<const int32_t*> m_rows;
+};
+
+} // namespace Cymax
+
+#endif /* LosslessCodec_hpp */
@@ -0,0 +1,105 @@
+//
+//  MonotonicClock.hpp
+//  CymaxPhoneOutDriver
+//
+//  Monotonic clock in ticks and nanoseconds
+//
+//  macOS counts mach_absolute_time() ticks, the clock the HAL timestamps
+//  IO with; Linux reads CLOCK_MONOTONIC, whose ticks are nanoseconds.
+//  Neither call enters the kernel on current systems, so this is safe on
+//  real-time threads.
+//
+//  The tick-to-nanosecond ratio is read once, on first use, and cached
+//  (a function-local static, so concurrent first calls are safe).
+//  Conversions multiply in 128 bits, so they are exact for any 64-bit
+//  tick count and saturate instead of wrapping when the result doesn't
+//  fit. Code that timestamps relative to some start point (a stream, a
+//  session) can keep raw ticks - one clock read and a subtraction - and
+//  convert only the difference when it needs nanoseconds.
+//
+
+#ifndef MonotonicClock_hpp
+#define MonotonicClock_hpp
+
+#include <cstdint>
+#include <limits>
+#include <time.h>
+
+#if defined(__APPLE__)
+#include <mach/mach_time.h>
+#endif
+
+namespace Cymax {
+
+namespace MonotonicClock {
+
+/// nanoseconds = ticks * numer / denom
+struct Timebase {
+    uint32_t numer;
+    uint32_t denom;
+};
+
+/// Ticks to nanoseconds with an explicit timebase (saturates at UINT64_MAX)
+constexpr uint64_t ticksToNanos(uint64_t ticks, Timebase timebase) {
+    const unsigned __int128 nanos = static_cast<unsigned __int128>(ticks) * timebase.numer / timebase.denom;
+    return nanos > std::numeric_limits<uint64_t>::max() ? std::numeric_limits<uint64_t>::max()
+                                                         : static_cast<uint64_t>(nanos);
+}
+
+/// Nanoseconds to ticks with an explicit timebase (saturates at UINT64_MAX)
+constexpr uint64_t nanosToTicks(uint64_t nanos, Timebase timebase) {
+    const unsigned __int128 ticks = static_cast<unsigned __int128>(nanos) * timebase.denom / timebase.numer;
+    return ticks > std::numeric_limits<uint64_t>::max() ? std::numeric_limits<uint64_t>::max()
+                                                         : static_cast<uint64_t>(ticks);
+}
+
+/// The system's timebase (cached after the first call)
+inline Timebase timebase() {
+#if defined(__APPLE__)
+    static const Timebase cached = [] {
+        mach_timebase_info_data_t info = {0, 0};
+        mach_timebase_info(&info);
+        return info.denom != 0 ? Timebase{info.numer, info.denom} : Timebase{1, 1};
+    }();
+    return cached;
+#else
+    return Timebase{1, 1};
+#endif
+}
+
+/// Raw clock ticks since an arbitrary fixed point (boot on both platforms)
+inline uint64_t nowTicks() {
+#if defined(__APPLE__)
+    return mach_absolute_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
+/// System ticks to nanoseconds
+inline uint64_t toNanos(uint64_t ticks) {
+    return ticksToNanos(ticks, timebase());
+}
+
+/// Nanoseconds to system ticks
+inline uint64_t toTicks(uint64_t nanos) {
+    return nanosToTicks(nanos, timebase());
+}
+
+/// Nanoseconds since the same fixed point as nowTicks()
+inline uint64_t nowNanos() {
+    return toNanos(nowTicks());
+}
+
+/// Nanoseconds since startTicks (a value nowTicks() returned earlier)
+inline uint64_t nanosSince(uint64_t startTicks) {
+    return toNanos(nowTicks() - startTicks);
+}
+
+} // namespace MonotonicClock
+
+} // namespace Cymax
+
+#endif /* MonotonicClock_hpp */
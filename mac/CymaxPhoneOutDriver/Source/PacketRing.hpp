@@ -0,0 +1,201 @@
+//
+//  PacketRing.hpp
+//  CymaxPhoneOutDriver
+//
+//  Lock-free SPSC ring of preallocated, packet-sized slots
+//
+//  Each slot is one UDP packet: headerRoom bytes reserved in front,
+//  followed by framesPerSlot interleaved frames. The render thread
+//  appends samples into the slot being filled and publishes it when it
+//  is full; the sender fills in the header in place and passes the slot
+//  straight to sendto(), so nothing is copied or re-framed after render.
+//
+//  CRITICAL SAFETY GUARANTEES (same as RingBuffer):
+//  - No memory allocation after construction
+//  - No locks or system calls in write()
+//  - The writer NEVER blocks
+//
+//  OVERFLOW POLICY:
+//  A published slot belongs to the reader until release(), so the writer
+//  cannot overwrite it. When every slot is published the writer drops
+//  incoming frames (counted in framesOverrun()). To keep latency bounded
+//  the reader should discard old slots with dropSlots() when it falls
+//  behind, which gives drop-oldest behaviour under sustained lag.
+//
+
+#ifndef PacketRing_hpp
+#define PacketRing_hpp
+
+#include "RealtimeArena.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+namespace Cymax {
+
+/// Lock-free SPSC ring of packet slots
+class PacketRing {
+public:
+    /// @param slotCount Number of slots (rounded up to a power of 2)
+    /// @param framesPerSlot Frames of audio per slot (one packet)
+    /// @param channelCount Interleaved channels per frame
+    /// @param headerRoom Bytes reserved in front of each slot's samples
+    /// @param arena Take the slots from this locked, pre-faulted arena
+    ///              (must outlive the ring); nullptr = heap
+    PacketRing(size_t slotCount, size_t framesPerSlot, size_t channelCount, size_t headerRoom,
+               RealtimeArena* arena = nullptr)
+        : m_framesPerSlot(framesPerSlot)
+        , m_channelCount(channelCount)
+        , m_headerRoom(headerRoom)
+    {
+        m_slotCount = 1;
+        while (m_slotCount < slotCount) m_slotCount <<= 1;
+        m_mask = m_slotCount - 1;
+
+        // Cache-line stride so adjacent slots never share a line
+        const size_t bytes = m_headerRoom + m_framesPerSlot * m_channelCount * sizeof(float);
+        m_slotStride = (bytes + 63) & ~static_cast<size_t>(63);
+        m_storage = arena ? arena->allocateArray<uint8_t>(m_slotStride * m_slotCount) : nullptr;
+        m_ownsStorage = m_storage == nullptr;
+        if (m_ownsStorage) {
+            m_storage = static_cast<uint8_t*>(std::aligned_alloc(64, m_slotStride * m_slotCount));
+            std::memset(m_storage, 0, m_slotStride * m_slotCount);
+        }
+    }
+
+    ~PacketRing() {
+        if (m_ownsStorage) {
+            std::free(m_storage);
+        }
+    }
+
+    /// Arena bytes a ring of this size takes (slots only)
+    static size_t storageBytes(size_t slotCount, size_t framesPerSlot, size_t channelCount, size_t headerRoom) {
+        size_t slots = 1;
+        while (slots < slotCount) slots <<= 1;
+        const size_t bytes = headerRoom + framesPerSlot * channelCount * sizeof(float);
+        return RealtimeArena::footprint(slots * ((bytes + 63) & ~static_cast<size_t>(63)));
+    }
+
+    // Non-copyable, non-movable
+    PacketRing(const PacketRing&) = delete;
+    PacketRing& operator=(const PacketRing&) = delete;
+    PacketRing(PacketRing&&) = delete;
+    PacketRing& operator=(PacketRing&&) = delete;
+
+    /// Append frames (called from render callback)
+    /// @param frames Interleaved audio frames
+    /// @param frameCount Number of frames
+    /// @return Number of frames stored; the rest were dropped (ring full)
+    size_t write(const float* frames, size_t frameCount) {
+        size_t written = 0;
+        while (written < frameCount) {
+            const size_t writeSlot = m_writeSlot.load(std::memory_order_relaxed);
+            const size_t readSlot = m_readSlot.load(std::memory_order_acquire);
+            if (writeSlot - readSlot >= m_slotCount) {
+                // Every slot is waiting to be sent
+                m_framesOverrun.fetch_add(frameCount - written, std::memory_order_relaxed);
+                break;
+            }
+
+            float* payload = samplesOf(writeSlot);
+            const size_t n = std::min(frameCount - written, m_framesPerSlot - m_fillFrames);
+            std::memcpy(payload + m_fillFrames * m_channelCount,
+                        frames + written * m_channelCount,
+                        n * m_channelCount * sizeof(float));
+            m_fillFrames += n;
+            written += n;
+
+            if (m_fillFrames == m_framesPerSlot) {
+                m_fillFrames = 0;
+                m_writeSlot.store(writeSlot + 1, std::memory_order_release);
+            }
+        }
+        return written;
+    }
+
+    /// Oldest published slot (called from sender thread)
+    /// @return Start of the slot (header room, then samples), or nullptr
+    ///         if none is ready; valid until release()
+    uint8_t* peek() const {
+        const size_t readSlot = m_readSlot.load(std::memory_order_relaxed);
+        if (m_writeSlot.load(std::memory_order_acquire) == readSlot) {
+            return nullptr;
+        }
+        return slotAt(readSlot);
+    }
+
+    /// Return the slot from peek() to the writer
+    void release() {
+        m_readSlot.store(m_readSlot.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// Discard up to slotCount published slots, oldest first
+    /// @return Slots discarded
+    size_t dropSlots(size_t slotCount) {
+        const size_t readSlot = m_readSlot.load(std::memory_order_relaxed);
+        const size_t available = m_writeSlot.load(std::memory_order_acquire) - readSlot;
+        const size_t toDrop = std::min(slotCount, available);
+        m_readSlot.store(readSlot + toDrop, std::memory_order_release);
+        return toDrop;
+    }
+
+    /// Published slots waiting to be read
+    size_t availableSlots() const {
+        return m_writeSlot.load(std::memory_order_acquire) - m_readSlot.load(std::memory_order_relaxed);
+    }
+
+    /// Reset to empty (called from startIO, before the sender starts)
+    /// @warning Only call when no read/write operations are in progress
+    void reset() {
+        m_writeSlot.store(0, std::memory_order_relaxed);
+        m_readSlot.store(0, std::memory_order_relaxed);
+        m_fillFrames = 0;
+        m_framesOverrun.store(0, std::memory_order_relaxed);
+    }
+
+    size_t slotCount() const { return m_slotCount; }
+    size_t framesPerSlot() const { return m_framesPerSlot; }
+    size_t channelCount() const { return m_channelCount; }
+    size_t headerRoom() const { return m_headerRoom; }
+
+    /// Header room plus samples: the packet size of a full slot
+    size_t slotBytes() const { return m_headerRoom + m_framesPerSlot * m_channelCount * sizeof(float); }
+
+    /// Frames the writer dropped because every slot was in use
+    uint64_t framesOverrun() const { return m_framesOverrun.load(std::memory_order_relaxed); }
+
+private:
+    uint8_t* slotAt(size_t slot) const {
+        return m_storage + (slot & m_mask) * m_slotStride;
+    }
+
+    float* samplesOf(size_t slot) const {
+        return reinterpret_cast<float*>(slotAt(slot) + m_headerRoom);
+    }
+
+    uint8_t* m_storage;
+    bool m_ownsStorage;     // Heap storage (no arena)
+    size_t m_slotCount;
+    size_t m_mask;
+    size_t m_slotStride;
+    size_t m_framesPerSlot;
+    size_t m_channelCount;
+    size_t m_headerRoom;
+
+    // Frames in the slot being filled (writer only)
+    size_t m_fillFrames = 0;
+
+    // Monotonic slot counters on separate cache lines to avoid false sharing
+    alignas(64) std::atomic<size_t> m_writeSlot{0};
+    alignas(64) std::atomic<size_t> m_readSlot{0};
+
+    // Statistics
+    std::atomic<uint64_t> m_framesOverrun{0};
+};
+
+} // namespace Cymax
+
+#endif /* PacketRing_hpp */
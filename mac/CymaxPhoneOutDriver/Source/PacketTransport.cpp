@@ -0,0 +1,271 @@
+//
+//  PacketTransport.cpp
+//  CymaxPhoneOutDriver
+//
+//  Transport backend implementations
+//
+
+#include "PacketTransport.hpp"
+#include "SenderEnvironment.hpp"
+#include "AudioFile.hpp"
+#include "Logging.hpp"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace Cymax {
+
+// Local backends are polled for room in steps of this
+static constexpr uint64_t kLocalPollNanos = 100000;
+
+static bool isBackpressure(int error) {
+    // ENOBUFS is how macOS reports a full interface queue for UDP
+    return error == EAGAIN || error == EWOULDBLOCK || error == ENOBUFS;
+}
+
+#pragma mark - UDP
+
+bool UDPTransport::open() {
+    if (m_socket >= 0) {
+        return true;  // Already created
+    }
+    
+    m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (m_socket < 0) {
+        CYMAX_LOG_ERROR("UDPTransport: failed to create socket: %{public}s", strerror(errno));
+        return false;
+    }
+    
+    // Set non-blocking mode
+    int flags = fcntl(m_socket, F_GETFL, 0);
+    if (flags < 0 || fcntl(m_socket, F_SETFL, flags | O_NONBLOCK) < 0) {
+        CYMAX_LOG_ERROR("UDPTransport: failed to set non-blocking: %{public}s", strerror(errno));
+        close();
+        return false;
+    }
+    
+    // Disable SIGPIPE (Linux has no SO_NOSIGPIPE, and never raises it for
+    // datagram sends)
+#if defined(SO_NOSIGPIPE)
+    int nosigpipe = 1;
+    setsockopt(m_socket, SOL_SOCKET, SO_NOSIGPIPE, &nosigpipe, sizeof(nosigpipe));
+#endif
+    
+    CYMAX_LOG_INFO("UDPTransport: socket created");
+    return true;
+}
+
+void UDPTransport::close() {
+    if (m_socket >= 0) {
+        ::close(m_socket);
+        m_socket = -1;
+        CYMAX_LOG_INFO("UDPTransport: socket closed");
+    }
+}
+
+void UDPTransport::setSendBufferBytes(int bytes) {
+    if (setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, &bytes, sizeof(bytes)) < 0) {
+        CYMAX_LOG_DEBUG("UDPTransport: couldn't set send buffer size (non-fatal)");
+    }
+    
+    int actual = 0;
+    socklen_t length = sizeof(actual);
+    getsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, &actual, &length);
+    CYMAX_LOG_INFO("UDPTransport: send buffer %d bytes (requested %d)", actual, bytes);
+}
+
+TransportResult UDPTransport::send(const uint8_t* packet, size_t size, uint64_t address) {
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = static_cast<uint32_t>(address >> 16);
+    addr.sin_port = htons(static_cast<uint16_t>(address & 0xFFFF));
+    
+    if (SenderEnvironment::sendTo(m_socket, packet, size, addr) >= 0) {
+        return TransportResult::Sent;
+    }
+    return isBackpressure(errno) ? TransportResult::WouldBlock : TransportResult::Failed;
+}
+
+ssize_t UDPTransport::receive(uint8_t* buffer, size_t capacity, uint64_t& from) {
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    const ssize_t size = SenderEnvironment::receiveFrom(m_socket, buffer, capacity, addr);
+    if (size >= 0) {
+        from = packAddress(addr.sin_addr.s_addr, ntohs(addr.sin_port));
+    }
+    return size;
+}
+
+bool UDPTransport::waitWritable(uint64_t timeoutNanos) {
+    return SenderEnvironment::waitWritable(m_socket, timeoutNanos);
+}
+
+#pragma mark - Shared memory
+
+bool SharedMemoryTransport::open(const char* name) {
+    if (!m_region.open(name, sizeof(SharedPacketRingPage), 0660)) {
+        return false;
+    }
+    
+    // A consumer attaching later starts from readCount == writeCount
+    SharedPacketRingPage* ring = new (m_region.data()) SharedPacketRingPage;
+    ring->magic = SharedPacketRingPage::kMagic;
+    ring->version = SharedPacketRingPage::kVersion;
+    ring->slotCount = SharedPacketRingPage::kSlotCount;
+    ring->slotBytes = sizeof(SharedPacketRingPage::Slot);
+    ring->writeCount.store(0, std::memory_order_relaxed);
+    ring->readCount.store(0, std::memory_order_release);
+    
+    CYMAX_LOG_INFO("SharedMemoryTransport: %u-slot packet ring at %{public}s/%{public}s",
+                   SharedPacketRingPage::kSlotCount, SharedMemoryRegion::kDirectory, name);
+    return true;
+}
+
+TransportResult SharedMemoryTransport::send(const uint8_t* packet, size_t size, uint64_t address) {
+    SharedPacketRingPage* ring = page();
+    if (size > SharedPacketRingPage::kMaxPacketBytes) {
+        errno = EMSGSIZE;
+        return TransportResult::Failed;
+    }
+    
+    const uint64_t written = ring->writeCount.load(std::memory_order_relaxed);
+    if (written - ring->readCount.load(std::memory_order_acquire) >= SharedPacketRingPage::kSlotCount) {
+        return TransportResult::WouldBlock;
+    }
+    
+    SharedPacketRingPage::Slot& slot = ring->slots[written % SharedPacketRingPage::kSlotCount];
+    slot.size = static_cast<uint32_t>(size);
+    slot.sendNanos = SenderEnvironment::nowNanos();
+    std::memcpy(slot.data, packet, size);
+    ring->writeCount.store(written + 1, std::memory_order_release);
+    return TransportResult::Sent;
+}
+
+bool SharedMemoryTransport::waitWritable(uint64_t timeoutNanos) {
+    SharedPacketRingPage* ring = page();
+    const uint64_t until = SenderEnvironment::nowNanos() + timeoutNanos;
+    for (;;) {
+        const uint64_t backlog = ring->writeCount.load(std::memory_order_relaxed) -
+                                 ring->readCount.load(std::memory_order_acquire);
+        if (backlog < SharedPacketRingPage::kSlotCount) {
+            return true;
+        }
+        const uint64_t now = SenderEnvironment::nowNanos();
+        if (now >= until) {
+            return false;
+        }
+        SenderEnvironment::sleepNanos(std::min(until - now, kLocalPollNanos));
+    }
+}
+
+#pragma mark - File
+
+FileTransport::~FileTransport() {
+    if (m_fd >= 0) {
+        flush();
+        ::close(m_fd);
+    }
+}
+
+bool FileTransport::open(const char* name) {
+    char path[256];
+    m_fd = AudioFile::createOutputFile(name, path, sizeof(path));
+    if (m_fd < 0) {
+        return false;
+    }
+    
+    m_buffer.reset(new (std::nothrow) uint8_t[kBufferBytes]);
+    if (!m_buffer) {
+        return false;
+    }
+    
+    CaptureFileHeader header;
+    header.magic = CaptureFileHeader::kMagic;
+    header.version = CaptureFileHeader::kVersion;
+    std::memcpy(m_buffer.get(), &header, sizeof(header));
+    m_buffered = sizeof(header);
+    
+    CYMAX_LOG_INFO("FileTransport: capturing to %{public}s", path);
+    return true;
+}
+
+TransportResult FileTransport::send(const uint8_t* packet, size_t size, uint64_t address) {
+    const size_t recordBytes = sizeof(CaptureRecordHeader) + size;
+    if (recordBytes > kBufferBytes) {
+        errno = EMSGSIZE;
+        return TransportResult::Failed;
+    }
+    if (m_buffered + recordBytes > kBufferBytes && !writeBuffer()) {
+        return TransportResult::Failed;
+    }
+    
+    CaptureRecordHeader record;
+    record.sendNanos = SenderEnvironment::nowNanos();
+    record.size = static_cast<uint32_t>(size);
+    std::memcpy(m_buffer.get() + m_buffered, &record, sizeof(record));
+    std::memcpy(m_buffer.get() + m_buffered + sizeof(record), packet, size);
+    m_buffered += recordBytes;
+    return TransportResult::Sent;
+}
+
+void FileTransport::flush() {
+    writeBuffer();
+}
+
+bool FileTransport::writeBuffer() {
+    if (m_buffered == 0) {
+        return true;
+    }
+    const bool written = AudioFile::writeAt(m_fd, m_buffer.get(), m_buffered, m_fileBytes);
+    if (written) {
+        m_fileBytes += m_buffered;
+    }
+    m_buffered = 0;  // A failed write loses this buffer, not every later one
+    return written;
+}
+
+#pragma mark - Selection
+
+static const char* localTransportPath(const char* destination, const char* scheme) {
+    const size_t length = std::strlen(scheme);
+    return std::strncmp(destination, scheme, length) == 0 ? destination + length : nullptr;
+}
+
+bool isLocalTransportSpec(const char* destination) {
+    return destination && (localTransportPath(destination, "shm:") || localTransportPath(destination, "file:") ||
+                           localTransportPath(destination, "null:"));
+}
+
+std::unique_ptr<PacketTransport> createLocalTransport(const char* destination) {
+    if (!destination) {
+        return nullptr;
+    }
+    
+    // Destinations come from HAL clients, and the driver runs as
+    // coreaudiod: the ring only ever lives at its fixed name, and captures
+    // only ever go to new files in the output directory
+    if (const char* path = localTransportPath(destination, "shm:")) {
+        auto transport = std::make_unique<SharedMemoryTransport>();
+        if ((*path == '\0' || std::strcmp(path, SharedMemoryTransport::kDefaultName) == 0) &&
+            transport->open(SharedMemoryTransport::kDefaultName)) {
+            return transport;
+        }
+    } else if (const char* name = localTransportPath(destination, "file:")) {
+        auto transport = std::make_unique<FileTransport>();
+        if (transport->open(name)) {
+            return transport;
+        }
+    } else if (localTransportPath(destination, "null:")) {
+        return std::make_unique<NullTransport>();
+    }
+    return nullptr;
+}
+
+} // namespace Cymax
@@ -0,0 +1,224 @@
+//
+//  PacketTransport.hpp
+//  CymaxPhoneOutDriver
+//
+//  Where built packets go: the sender's transport backends
+//
+//  UDPSender builds each packet once and hands it to the transport of
+//  every destination. A transport either takes the packet, pushes back
+//  (the sender holds it and retries within the latency budget, exactly as
+//  for a full socket), or fails it. Backends:
+//  - UDPTransport: the non-blocking datagram socket (the default)
+//  - SharedMemoryTransport: a packet ring in a shared page that a local
+//    consumer reads in place, no kernel involved
+//  - FileTransport: appends packets with their send times to a capture
+//    file
+//  - NullTransport: counts and discards, for measuring the pipeline alone
+//
+//  Local backends are chosen by destination string (see
+//  createLocalTransport()); plain IPv4 addresses go to the UDP socket.
+//
+
+#ifndef PacketTransport_hpp
+#define PacketTransport_hpp
+
+#include "SharedMemoryRegion.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <sys/types.h>
+
+namespace Cymax {
+
+/// Result of handing a packet to a transport
+enum class TransportResult : uint8_t {
+    Sent,        // Taken
+    WouldBlock,  // No room right now; retry later
+    Failed       // Error (errno set); drop the packet
+};
+
+/// A packet destination backend
+/// send() and waitWritable() are called from the transmitting thread only.
+class PacketTransport {
+public:
+    virtual ~PacketTransport() = default;
+
+    /// Short name for logs ("udp", "shm", ...)
+    virtual const char* name() const = 0;
+
+    /// Hand one packet over
+    /// @param address Destination within the transport (UDP: packed
+    ///        address and port, see UDPTransport::packAddress(); 0 otherwise)
+    virtual TransportResult send(const uint8_t* packet, size_t size, uint64_t address) = 0;
+
+    /// Wait until send() may succeed again, or the timeout passes
+    /// @return true if there is room now
+    virtual bool waitWritable(uint64_t timeoutNanos) { return true; }
+
+    /// End of a session: write out anything buffered
+    virtual void flush() {}
+};
+
+/// Non-blocking UDP socket
+class UDPTransport : public PacketTransport {
+public:
+    UDPTransport() = default;
+    ~UDPTransport() override { close(); }
+
+    // Non-copyable
+    UDPTransport(const UDPTransport&) = delete;
+    UDPTransport& operator=(const UDPTransport&) = delete;
+
+    /// Create the socket (no-op if already open)
+    bool open();
+
+    /// Close the socket
+    void close();
+
+    bool isOpen() const { return m_socket >= 0; }
+
+    /// Request a send buffer size and log what the kernel granted
+    void setSendBufferBytes(int bytes);
+
+    /// Pack an IPv4 address (network order) and port into one value, so
+    /// destination lists can be replaced while another thread reads them
+    static uint64_t packAddress(uint32_t address, uint16_t port) {
+        return (static_cast<uint64_t>(address) << 16) | port;
+    }
+
+    /// Read one datagram sent to the socket, without waiting
+    /// @param from Sender's packed address
+    /// @return Bytes read, or -1 if there was none
+    ssize_t receive(uint8_t* buffer, size_t capacity, uint64_t& from);
+
+    const char* name() const override { return "udp"; }
+    TransportResult send(const uint8_t* packet, size_t size, uint64_t address) override;
+    bool waitWritable(uint64_t timeoutNanos) override;
+
+private:
+    int m_socket = -1;
+};
+
+/// Layout of the shared packet ring
+/// The driver writes slot (writeCount % kSlotCount) and then publishes by
+/// bumping writeCount; the consumer reads slots in place up to writeCount
+/// and bumps readCount when done with them. A full ring pushes back.
+struct SharedPacketRingPage {
+    static constexpr uint32_t kMagic = 0x43504B54;  // 'CPKT'
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kSlotCount = 256;     // ~0.7 s at 128 frames/packet, 48 kHz
+    static constexpr uint32_t kMaxPacketBytes = 1500;
+
+    struct Slot {
+        uint32_t size;
+        uint32_t reserved;
+        uint64_t sendNanos;
+        uint8_t data[kMaxPacketBytes];
+    };
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotBytes;
+    alignas(64) std::atomic<uint64_t> writeCount;   // Driver
+    alignas(64) std::atomic<uint64_t> readCount;    // Consumer
+    alignas(64) Slot slots[kSlotCount];
+};
+
+/// Packet ring in a shared page for a local consumer
+class SharedMemoryTransport : public PacketTransport {
+public:
+    static constexpr const char* kDefaultName = "packets.shm";
+
+    /// Map the ring in SharedMemoryRegion::kDirectory (0660: the consumer
+    /// moves readCount, so it must share the directory's group; others
+    /// can't read the audio or truncate the ring)
+    bool open(const char* name);
+
+    const char* name() const override { return "shm"; }
+    TransportResult send(const uint8_t* packet, size_t size, uint64_t address) override;
+    bool waitWritable(uint64_t timeoutNanos) override;
+
+private:
+    SharedPacketRingPage* page() const { return static_cast<SharedPacketRingPage*>(m_region.data()); }
+
+    SharedMemoryRegion m_region;
+};
+
+/// Capture file layout: CaptureFileHeader, then per packet a
+/// CaptureRecordHeader and the packet bytes (little-endian, unpadded)
+#pragma pack(push, 1)
+struct CaptureFileHeader {
+    static constexpr uint32_t kMagic = 0x50414343;  // 'CCAP'
+    static constexpr uint32_t kVersion = 1;
+    uint32_t magic;
+    uint32_t version;
+};
+
+struct CaptureRecordHeader {
+    uint64_t sendNanos;  // Monotonic clock at send
+    uint32_t size;       // Packet bytes that follow
+};
+#pragma pack(pop)
+
+static_assert(sizeof(CaptureFileHeader) == 8 && sizeof(CaptureRecordHeader) == 12,
+              "Capture files are read by other tools");
+
+/// Appends packets to a capture file
+/// Records are collected in a buffer and written kBufferBytes at a time,
+/// so a packet costs a memcpy and the file a write() every ~60 packets.
+class FileTransport : public PacketTransport {
+public:
+    static constexpr size_t kBufferBytes = 64 * 1024;
+
+    ~FileTransport() override;
+
+    /// Create the file in AudioFile::kOutputDirectory and write its header
+    /// @param name File name, no directories (an existing file is never
+    ///        overwritten: destinations come from HAL clients)
+    bool open(const char* name);
+
+    const char* name() const override { return "file"; }
+    TransportResult send(const uint8_t* packet, size_t size, uint64_t address) override;
+    void flush() override;
+
+private:
+    bool writeBuffer();
+
+    int m_fd = -1;
+    std::unique_ptr<uint8_t[]> m_buffer;
+    size_t m_buffered = 0;
+    uint64_t m_fileBytes = 0;  // Written so far
+};
+
+/// Discards packets, counting them
+class NullTransport : public PacketTransport {
+public:
+    const char* name() const override { return "null"; }
+    TransportResult send(const uint8_t* packet, size_t size, uint64_t address) override {
+        m_packets.fetch_add(1, std::memory_order_relaxed);
+        m_bytes.fetch_add(size, std::memory_order_relaxed);
+        return TransportResult::Sent;
+    }
+
+    uint64_t packets() const { return m_packets.load(std::memory_order_relaxed); }
+    uint64_t bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_packets{0};
+    std::atomic<uint64_t> m_bytes{0};
+};
+
+/// Whether a destination names a local backend rather than an address:
+/// "shm:" (ring at SharedMemoryTransport::kDefaultName), "file:name"
+/// (capture in AudioFile::kOutputDirectory) or "null:"
+bool isLocalTransportSpec(const char* destination);
+
+/// Create and open the local backend a destination names
+/// @return nullptr if it names none or can't be opened
+std::unique_ptr<PacketTransport> createLocalTransport(const char* destination);
+
+} // namespace Cymax
+
+#endif /* PacketTransport_hpp */
@@ -11,11 +11,12 @@
 #include "CymaxPluginInterface.hpp"
 #include "CymaxAudioDevice.hpp"
 #include "CymaxAudioStream.hpp"
+#include "SampleKernels.hpp"
 #include "Logging.hpp"
+#include "MonotonicClock.hpp"
 
 #include <CoreAudio/AudioServerPlugIn.h>
 #include <CoreFoundation/CoreFoundation.h>
-#include <mach/mach_time.h>
 #include <mutex>
 #include <memory>
 
@@ -23,6 +24,8 @@
 static constexpr AudioObjectID kPluginObjectID = kAudioObjectPlugInObject;  // Usually 1
 static constexpr AudioObjectID kDeviceObjectID = 2;
 static constexpr AudioObjectID kOutputStreamObjectID = 3;
+static constexpr AudioObjectID kVolumeControlObjectID = 4;
+static constexpr AudioObjectID kMuteControlObjectID = 5;
 
 // Plugin state
 static std::unique_ptr<Cymax::AudioDevice> gDevice;
@@ -152,6 +155,9 @@ static OSStatus CymaxInitialize(AudioServerPlugInDriverRef inDriver, AudioServer
     
     gHost = inHost;
     
+    // Pick SIMD kernels before any IO thread can use them
+    Cymax::Kernels::initialize();
+    
     // Create the device
     gDevice = std::make_unique<Cymax::AudioDevice>(kDeviceObjectID, kPluginObjectID);
     
@@ -172,6 +178,11 @@ static OSStatus CymaxDestroyDevice(AudioServerPlugInDriverRef inDriver, AudioObj
 static OSStatus CymaxAddDeviceClient(AudioServerPlugInDriverRef inDriver, AudioObjectID inDeviceObjectID, 
                                      const AudioServerPlugInClientInfo* inClientInfo) {
     CYMAX_LOG_DEBUG("CymaxAddDeviceClient: device=%u, pid=%d", inDeviceObjectID, inClientInfo->mProcessID);
+    
+    // A client usually starts IO soon after attaching
+    if (inDeviceObjectID == kDeviceObjectID && gDevice) {
+        gDevice->warmUp();
+    }
     return noErr;
 }
 
@@ -202,6 +213,10 @@ static Cymax::AudioObject* GetObjectForID(AudioObjectID objectID) {
             return gDevice.get();
         case kOutputStreamObjectID:
             return gDevice ? gDevice->getOutputStream() : nullptr;
+        case kVolumeControlObjectID:
+            return gDevice ? gDevice->getVolumeControl() : nullptr;
+        case kMuteControlObjectID:
+            return gDevice ? gDevice->getMuteControl() : nullptr;
         default:
             return nullptr;
     }
@@ -367,12 +382,31 @@ static OSStatus CymaxSetPropertyData(AudioServerPlugInDriverRef inDriver, AudioO
     }
     
     Cymax::AudioObject* obj = GetObjectForID(inObjectID);
-    if (obj) {
-        return obj->setPropertyData(inAddress, inQualifierDataSize, inQualifierData, 
-                                   inDataSize, inData);
+    if (!obj) {
+        return kAudioHardwareBadObjectError;
     }
     
-    return kAudioHardwareBadObjectError;
+    OSStatus status = obj->setPropertyData(inAddress, inQualifierDataSize, inQualifierData, 
+                                           inDataSize, inData);
+    
+    // Control values are observable; tell the HAL so other clients
+    // (e.g. the menu bar volume slider) follow the change
+    if (status == noErr && gHost) {
+        if (inObjectID == kVolumeControlObjectID) {
+            AudioObjectPropertyAddress changed[2] = {
+                { kAudioLevelControlPropertyScalarValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain },
+                { kAudioLevelControlPropertyDecibelValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain },
+            };
+            gHost->PropertiesChanged(gHost, inObjectID, 2, changed);
+        } else if (inObjectID == kMuteControlObjectID) {
+            AudioObjectPropertyAddress changed = {
+                kAudioBooleanControlPropertyValue, kAudioObjectPropertyScopeGlobal, kAudioObjectPropertyElementMain
+            };
+            gHost->PropertiesChanged(gHost, inObjectID, 1, &changed);
+        }
+    }
+    
+    return status;
 }
 
 #pragma mark - IO Methods
@@ -411,7 +445,7 @@ static OSStatus CymaxGetZeroTimeStamp(AudioServerPlugInDriverRef inDriver, Audio
     }
     
     // Get current host time
-    uint64_t currentHostTime = mach_absolute_time();
+    uint64_t currentHostTime = Cymax::MonotonicClock::nowTicks();
     
     // Initialize zero timestamp if needed
     if (gZeroTimeStampHostTime == 0) {
@@ -423,22 +457,15 @@ static OSStatus CymaxGetZeroTimeStamp(AudioServerPlugInDriverRef inDriver, Audio
     // Calculate elapsed time and samples
     Float64 sampleRate = gDevice->getSampleRate();
     
-    // Convert mach time to seconds
-    static mach_timebase_info_data_t timebaseInfo = {0, 0};
-    if (timebaseInfo.denom == 0) {
-        mach_timebase_info(&timebaseInfo);
-    }
-    
-    Float64 elapsedNanos = static_cast<Float64>(currentHostTime - gZeroTimeStampHostTime) * 
-                          timebaseInfo.numer / timebaseInfo.denom;
+    // Only the ticks since the last zero timestamp are converted
+    Float64 elapsedNanos = static_cast<Float64>(Cymax::MonotonicClock::toNanos(currentHostTime - gZeroTimeStampHostTime));
     Float64 elapsedSamples = (elapsedNanos / 1e9) * sampleRate;
     
     // Advance the zero timestamp periodically (once per second of samples)
     Float64 zeroTimeStampPeriod = sampleRate;  // 1 second worth of samples
     while (gZeroTimeStampSampleTime + zeroTimeStampPeriod < elapsedSamples) {
         gZeroTimeStampSampleTime += zeroTimeStampPeriod;
-        gZeroTimeStampHostTime += static_cast<uint64_t>((zeroTimeStampPeriod / sampleRate) * 1e9 * 
-                                                        timebaseInfo.denom / timebaseInfo.numer);
+        gZeroTimeStampHostTime += Cymax::MonotonicClock::toTicks(static_cast<uint64_t>((zeroTimeStampPeriod / sampleRate) * 1e9));
         gZeroTimeStampSeed++;
     }
     
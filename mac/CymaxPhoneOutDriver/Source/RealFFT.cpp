@@ -0,0 +1,119 @@
+//
+//  RealFFT.cpp
+//  CymaxPhoneOutDriver
+//
+//  Radix-2 real FFT implementation
+//
+
+#include "RealFFT.hpp"
+
+#include <cmath>
+
+namespace Cymax {
+
+RealFFT::RealFFT(size_t size)
+    : m_size(size)
+    , m_half(size / 2)
+{
+    const double pi = 3.14159265358979323846;
+
+    size_t bits = 0;
+    while ((size_t(1) << bits) < m_half) {
+        ++bits;
+    }
+    m_bitReverse.resize(m_half);
+    for (size_t i = 0; i < m_half; ++i) {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; ++b) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_bitReverse[i] = r;
+    }
+
+    m_stageCos.resize(m_half > 1 ? m_half - 1 : 1);
+    m_stageSin.resize(m_stageCos.size());
+    for (size_t h = 1; h < m_half; h <<= 1) {
+        for (size_t j = 0; j < h; ++j) {
+            const double angle = -pi * static_cast<double>(j) / static_cast<double>(h);
+            m_stageCos[h - 1 + j] = static_cast<float>(std::cos(angle));
+            m_stageSin[h - 1 + j] = static_cast<float>(std::sin(angle));
+        }
+    }
+
+    m_splitCos.resize(m_half + 1);
+    m_splitSin.resize(m_half + 1);
+    for (size_t k = 0; k <= m_half; ++k) {
+        const double angle = -2.0 * pi * static_cast<double>(k) / static_cast<double>(m_size);
+        m_splitCos[k] = static_cast<float>(std::cos(angle));
+        m_splitSin[k] = static_cast<float>(std::sin(angle));
+    }
+
+    m_re.resize(m_half);
+    m_im.resize(m_half);
+    m_outRe.resize(m_half + 1);
+    m_outIm.resize(m_half + 1);
+}
+
+void RealFFT::complexFFT() {
+    float* re = m_re.data();
+    float* im = m_im.data();
+
+    for (size_t h = 1; h < m_half; h <<= 1) {
+        const float* wr = m_stageCos.data() + (h - 1);
+        const float* wi = m_stageSin.data() + (h - 1);
+        for (size_t g = 0; g < m_half; g += 2 * h) {
+            float* aRe = re + g;
+            float* aIm = im + g;
+            float* bRe = aRe + h;
+            float* bIm = aIm + h;
+            for (size_t j = 0; j < h; ++j) {
+                const float tr = bRe[j] * wr[j] - bIm[j] * wi[j];
+                const float ti = bRe[j] * wi[j] + bIm[j] * wr[j];
+                bRe[j] = aRe[j] - tr;
+                bIm[j] = aIm[j] - ti;
+                aRe[j] += tr;
+                aIm[j] += ti;
+            }
+        }
+    }
+}
+
+void RealFFT::forward(const float* input, float* outReal, float* outImag) {
+    // Pack even/odd samples as one complex sequence, in bit-reversed order
+    for (size_t k = 0; k < m_half; ++k) {
+        const size_t r = m_bitReverse[k];
+        m_re[r] = input[2 * k];
+        m_im[r] = input[2 * k + 1];
+    }
+
+    complexFFT();
+
+    // Split Z into the even and odd half-spectra and recombine:
+    // X[k] = E[k] + W^k O[k], with Z[M] == Z[0]
+    for (size_t k = 0; k <= m_half; ++k) {
+        const size_t a = (k == m_half) ? 0 : k;
+        const size_t b = (k == 0) ? 0 : m_half - k;
+        const float ar = m_re[a], ai = m_im[a];
+        const float br = m_re[b], bi = m_im[b];
+
+        const float er = 0.5f * (ar + br);
+        const float ei = 0.5f * (ai - bi);
+        const float orr = 0.5f * (ai + bi);
+        const float oi = -0.5f * (ar - br);
+
+        const float wr = m_splitCos[k];
+        const float wi = m_splitSin[k];
+        outReal[k] = er + wr * orr - wi * oi;
+        outImag[k] = ei + wr * oi + wi * orr;
+    }
+}
+
+void RealFFT::powerSpectrum(const float* input, float* outPower) {
+    forward(input, m_outRe.data(), m_outIm.data());
+    const size_t bins = binCount();
+    for (size_t k = 0; k < bins; ++k) {
+        outPower[k] = m_outRe[k] * m_outRe[k] + m_outIm[k] * m_outIm[k];
+    }
+}
+
+} // namespace Cymax
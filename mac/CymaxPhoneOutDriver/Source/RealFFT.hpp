@@ -0,0 +1,71 @@
+//
+//  RealFFT.hpp
+//  CymaxPhoneOutDriver
+//
+//  Radix-2 FFT of real input
+//
+//  An N-point real transform is computed as an N/2-point complex FFT on
+//  the even/odd samples followed by a split step. Data is kept in split
+//  (separate real/imaginary) arrays and every stage's twiddles are stored
+//  contiguously, so the butterfly loops are unit-stride and vectorize.
+//  All memory is allocated in the constructor.
+//
+
+#ifndef RealFFT_hpp
+#define RealFFT_hpp
+
+#include <cstddef>
+#include <vector>
+
+namespace Cymax {
+
+/// Real-input FFT of fixed power-of-2 size
+class RealFFT {
+public:
+    /// @param size Transform size, power of 2, at least 4
+    explicit RealFFT(size_t size);
+
+    // Non-copyable
+    RealFFT(const RealFFT&) = delete;
+    RealFFT& operator=(const RealFFT&) = delete;
+
+    size_t size() const { return m_size; }
+
+    /// Number of output bins (size / 2 + 1, DC to Nyquist)
+    size_t binCount() const { return m_size / 2 + 1; }
+
+    /// Forward transform
+    /// @param input size() real samples
+    /// @param outReal binCount() real parts
+    /// @param outImag binCount() imaginary parts
+    void forward(const float* input, float* outReal, float* outImag);
+
+    /// Forward transform, returning |X[k]|^2 for each bin
+    void powerSpectrum(const float* input, float* outPower);
+
+private:
+    void complexFFT();
+
+    size_t m_size;
+    size_t m_half;  // Complex FFT length
+
+    std::vector<size_t> m_bitReverse;
+
+    // Per-stage twiddles, stage s (half-length h) at offset h - 1
+    std::vector<float> m_stageCos;
+    std::vector<float> m_stageSin;
+
+    // Split twiddles for the real post-processing step
+    std::vector<float> m_splitCos;
+    std::vector<float> m_splitSin;
+
+    // Complex work buffers
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+    std::vector<float> m_outRe;
+    std::vector<float> m_outIm;
+};
+
+} // namespace Cymax
+
+#endif /* RealFFT_hpp */
@@ -0,0 +1,114 @@
+//
+//  RealtimeArena.cpp
+//  CymaxPhoneOutDriver
+//
+//  Locked, pre-faulted arena implementation
+//
+
+#include "RealtimeArena.hpp"
+#include "Logging.hpp"
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <errno.h>
+#include <unistd.h>
+#include <cstring>
+
+namespace Cymax {
+
+#if defined(__linux__)
+static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+#endif
+
+bool RealtimeArena::reserve(size_t bytes, bool hugePages) {
+    release();
+
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t mappedBytes = (bytes + pageSize - 1) / pageSize * pageSize;
+    void* base = MAP_FAILED;
+
+#if defined(__linux__)
+    if (hugePages) {
+        // Explicit huge pages need a reserved pool (vm.nr_hugepages)
+        const size_t hugeBytes = (bytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+        base = mmap(nullptr, hugeBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) {
+            mappedBytes = hugeBytes;
+            m_hugePages = true;
+        }
+    }
+#endif
+    if (base == MAP_FAILED) {
+        base = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            CYMAX_LOG_ERROR("RealtimeArena: can't map %zu bytes: %{public}s", mappedBytes, strerror(errno));
+            return false;
+        }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (hugePages && madvise(base, mappedBytes, MADV_HUGEPAGE) == 0) {
+            m_hugePages = true;
+        }
+#endif
+    }
+
+    m_base = static_cast<uint8_t*>(base);
+    m_mappedBytes = mappedBytes;
+    m_used = 0;
+
+    // Write every page: a fresh anonymous mapping is only backed on first
+    // touch, and the copy-on-write zero page would fault again on a write
+    for (size_t offset = 0; offset < mappedBytes; offset += pageSize) {
+        m_base[offset] = 0;
+    }
+
+    m_locked = mlock(m_base, m_mappedBytes) == 0;
+    if (!m_locked) {
+        CYMAX_LOG_ERROR("RealtimeArena: mlock of %zu bytes refused (%{public}s); pages may be reclaimed",
+                        m_mappedBytes, strerror(errno));
+    }
+
+    CYMAX_LOG_INFO("RealtimeArena: %zu KB%{public}s%{public}s", m_mappedBytes / 1024,
+                   m_locked ? ", locked" : "", m_hugePages ? ", huge pages" : "");
+    return true;
+}
+
+void RealtimeArena::release() {
+    if (!m_base) {
+        return;
+    }
+    if (m_locked) {
+        munlock(m_base, m_mappedBytes);
+    }
+    munmap(m_base, m_mappedBytes);
+    m_base = nullptr;
+    m_mappedBytes = 0;
+    m_used = 0;
+    m_locked = false;
+    m_hugePages = false;
+}
+
+void* RealtimeArena::allocate(size_t bytes, size_t alignment) {
+    const size_t offset = (m_used + alignment - 1) / alignment * alignment;
+    if (!m_base || offset + bytes > m_mappedBytes) {
+        CYMAX_LOG_ERROR("RealtimeArena: out of space (%zu bytes requested, %zu of %zu used)",
+                        bytes, m_used, m_mappedBytes);
+        return nullptr;
+    }
+    m_used = offset + bytes;
+    return m_base + offset;
+}
+
+uint64_t currentThreadMinorFaults() {
+    struct rusage usage;
+#if defined(RUSAGE_THREAD)
+    const int who = RUSAGE_THREAD;
+#else
+    const int who = RUSAGE_SELF;
+#endif
+    if (getrusage(who, &usage) != 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(usage.ru_minflt);
+}
+
+} // namespace Cymax
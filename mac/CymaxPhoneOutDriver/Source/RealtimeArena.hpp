@@ -0,0 +1,119 @@
+//
+//  RealtimeArena.hpp
+//  CymaxPhoneOutDriver
+//
+//  Locked, pre-faulted memory for buffers the real-time threads touch
+//
+//  malloc'd memory is mapped on first touch and can be paged out again;
+//  either way the next access is a page fault, which under memory
+//  pressure can stall the render thread for milliseconds. An arena maps
+//  one region up front, writes every page, mlock()s it and then hands out
+//  aligned pieces with a bump pointer. Pieces are never freed one by one:
+//  the region goes when the arena is released.
+//
+//  On Linux the region can be backed by huge pages (MAP_HUGETLB, or a
+//  transparent huge page hint when none are reserved). mlock() failing
+//  (RLIMIT_MEMLOCK) is logged and not fatal: the pages are still faulted in.
+//
+
+#ifndef RealtimeArena_hpp
+#define RealtimeArena_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace Cymax {
+
+/// Destroys an object constructed in an arena without freeing its memory
+template<typename T>
+struct ArenaDelete {
+    void operator()(T* object) const { object->~T(); }
+};
+
+/// Owning pointer to an object living in a RealtimeArena
+/// The arena must outlive it.
+template<typename T>
+using ArenaPtr = std::unique_ptr<T, ArenaDelete<T>>;
+
+/// Bump allocator over one locked, pre-faulted region
+/// Not thread-safe: allocate before handing the memory to other threads.
+class RealtimeArena {
+public:
+    RealtimeArena() = default;
+    ~RealtimeArena() { release(); }
+
+    // Non-copyable
+    RealtimeArena(const RealtimeArena&) = delete;
+    RealtimeArena& operator=(const RealtimeArena&) = delete;
+
+    /// Map, pre-fault and lock a region, replacing any previous one
+    /// @param bytes Usable size (rounded up to whole pages)
+    /// @param hugePages Back the region with huge pages if possible (Linux)
+    /// @return false if the region couldn't be mapped
+    bool reserve(size_t bytes, bool hugePages = false);
+
+    /// Unmap the region; everything allocated from it is gone
+    void release();
+
+    /// Start allocating from the beginning again (contents are kept)
+    void rewind() { m_used = 0; }
+
+    /// Carve out memory
+    /// @return nullptr if the region is exhausted
+    void* allocate(size_t bytes, size_t alignment = kCacheLine);
+
+    /// Carve out and value-initialize an array
+    template<typename T>
+    T* allocateArray(size_t count) {
+        T* array = static_cast<T*>(allocate(count * sizeof(T), alignof(T) > kCacheLine ? alignof(T) : kCacheLine));
+        if (array) {
+            std::uninitialized_value_construct_n(array, count);
+        }
+        return array;
+    }
+
+    /// Construct an object in the arena
+    /// @return Empty pointer if the region is exhausted
+    template<typename T, typename... Args>
+    ArenaPtr<T> make(Args&&... args) {
+        void* memory = allocate(sizeof(T), alignof(T) > kCacheLine ? alignof(T) : kCacheLine);
+        return ArenaPtr<T>(memory ? new (memory) T(std::forward<Args>(args)...) : nullptr);
+    }
+
+    size_t capacity() const { return m_mappedBytes; }
+    size_t used() const { return m_used; }
+    bool isReserved() const { return m_base != nullptr; }
+
+    /// Region is wired (mlock succeeded)
+    bool isLocked() const { return m_locked; }
+
+    /// Region is backed by huge pages (or advised to be)
+    bool usesHugePages() const { return m_hugePages; }
+
+    /// Bytes a piece of the given size takes, including alignment padding
+    /// (for sizing reserve())
+    static constexpr size_t footprint(size_t bytes, size_t alignment = kCacheLine) {
+        return (bytes + alignment - 1) / alignment * alignment;
+    }
+
+    static constexpr size_t kCacheLine = 64;
+
+private:
+    uint8_t* m_base = nullptr;
+    size_t m_mappedBytes = 0;
+    size_t m_used = 0;
+    bool m_locked = false;
+    bool m_hugePages = false;
+};
+
+/// Minor (no I/O) page faults taken by the calling thread so far
+/// Linux counts per thread; macOS only per process, which over-counts but
+/// still proves zero. A system call: not for the render thread.
+uint64_t currentThreadMinorFaults();
+
+} // namespace Cymax
+
+#endif /* RealtimeArena_hpp */
@@ -0,0 +1,332 @@
+//
+//  ReplayBuffer.cpp
+//  CymaxPhoneOutDriver
+//
+//  Instant-replay buffer implementation
+//
+
+#include "ReplayBuffer.hpp"
+#include "SampleKernels.hpp"
+#include "Logging.hpp"
+#include "ThreadPriority.hpp"
+
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace Cymax {
+
+// Inverse of the floatToInt24 kernel's scale
+static constexpr float kInt24ToFloat = 1.0f / 8388608.0f;
+
+// One packed little-endian int24, sign-extended
+static inline int32_t unpackInt24(const uint8_t* p) {
+    const uint32_t v = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+                       (static_cast<uint32_t>(p[2]) << 16);
+    return static_cast<int32_t>(v << 8) >> 8;
+}
+
+ReplayBuffer::ReplayBuffer(double minutes)
+    : m_minutes(std::max(0.1, minutes))
+{
+}
+
+ReplayBuffer::~ReplayBuffer() {
+    if (m_saveThread.joinable()) {
+        m_saveThread.join();
+    }
+}
+
+void ReplayBuffer::prepare(double sampleRate, size_t channels, size_t /*maxFrames*/) {
+    channels = std::max<size_t>(1, channels);
+    // Keep history across stop/start unless the format changed
+    if (m_arena && sampleRate == m_sampleRate && channels == m_channels) {
+        return;
+    }
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    allocate();
+}
+
+void ReplayBuffer::allocate() {
+    // A running save reads the history being replaced
+    if (m_saveThread.joinable()) {
+        m_saveThread.join();
+    }
+
+    const double historyFrames = m_minutes * 60.0 * m_sampleRate;
+    const size_t indexCapacity = static_cast<size_t>(std::ceil(historyFrames / kBlockFrames));
+
+    m_encoder = std::make_unique<LosslessCodec>(kBlockFrames, m_channels);
+    m_staging.assign(kBlockFrames * m_channels, 0);
+    m_stagingRows.assign(m_channels, nullptr);
+    for (size_t c = 0; c < m_channels; ++c) {
+        m_stagingRows[c] = m_staging.data() + c * kBlockFrames;
+    }
+    m_packed.assign(kBlockFrames * m_channels * 3, 0);
+    m_encoded.assign(m_encoder->maxEncodedBytes(kBlockFrames), 0);
+    m_stagingFrames = 0;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_arenaBytes = std::max(static_cast<size_t>(historyFrames * m_channels * 3 * kExpectedRatio),
+                            2 * m_encoded.size());
+    // Left uninitialized: pages become resident as history fills
+    m_arena.reset(new uint8_t[m_arenaBytes]);
+    m_writeOffset = 0;
+    m_index.assign(indexCapacity, BlockEntry{0, 0, 0});
+    m_indexHead = 0;
+    m_indexCount = 0;
+    m_bytesHeld = 0;
+    m_blocksEvicted = 0;
+
+    m_decoder = std::make_unique<LosslessCodec>(kBlockFrames, m_channels);
+    m_decoded.assign(kBlockFrames * m_channels, 0);
+    m_decodedStart = UINT64_MAX;
+
+    CYMAX_LOG_INFO("ReplayBuffer: %.1f min, %zu block index, %.1f MB arena",
+                   m_minutes, indexCapacity, static_cast<double>(m_arenaBytes) / (1024.0 * 1024.0));
+}
+
+void ReplayBuffer::process(const float* samples, size_t frames) {
+    const Kernels::KernelTable& kernels = Kernels::active();
+
+    while (frames > 0) {
+        const size_t n = std::min(frames, kBlockFrames - m_stagingFrames);
+        const size_t count = n * m_channels;
+
+        kernels.floatToInt24(samples, m_packed.data(), count);
+        for (size_t c = 0; c < m_channels; ++c) {
+            int32_t* dst = m_stagingRows[c] + m_stagingFrames;
+            const uint8_t* p = m_packed.data() + c * Kernels::kInt24Bytes;
+            for (size_t f = 0; f < n; ++f, p += m_channels * Kernels::kInt24Bytes) {
+                dst[f] = unpackInt24(p);
+            }
+        }
+
+        samples += count;
+        frames -= n;
+        advanceStaging(n);
+    }
+}
+
+void ReplayBuffer::processPlanar(const float* const* planes, size_t frames) {
+    const Kernels::KernelTable& kernels = Kernels::active();
+
+    size_t offset = 0;
+    while (offset < frames) {
+        const size_t n = std::min(frames - offset, kBlockFrames - m_stagingFrames);
+
+        for (size_t c = 0; c < m_channels; ++c) {
+            kernels.floatToInt24(planes[c] + offset, m_packed.data(), n);
+            int32_t* dst = m_stagingRows[c] + m_stagingFrames;
+            const uint8_t* p = m_packed.data();
+            for (size_t f = 0; f < n; ++f, p += Kernels::kInt24Bytes) {
+                dst[f] = unpackInt24(p);
+            }
+        }
+
+        offset += n;
+        advanceStaging(n);
+    }
+}
+
+void ReplayBuffer::advanceStaging(size_t frames) {
+    m_stagingFrames += frames;
+    if (m_stagingFrames == kBlockFrames) {
+        appendBlock();
+        m_stagingFrames = 0;
+    }
+}
+
+void ReplayBuffer::appendBlock() {
+    // Encode outside the lock; readers only wait for the copy
+    const size_t bytes = m_encoder->encodePlanar(m_stagingRows.data(), kBlockFrames, m_encoded.data());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    uint64_t offset = m_writeOffset;
+    if (offset + bytes > m_arenaBytes) {
+        // Wrap; everything past the write offset is older than anything before it
+        while (m_indexCount > 0 && m_index[m_indexHead].offset >= offset) {
+            evictOldest();
+        }
+        offset = 0;
+    }
+    // The oldest block is the first one at or after the write offset
+    while (m_indexCount > 0 &&
+           (m_indexCount == m_index.size() ||
+            (m_index[m_indexHead].offset >= offset && m_index[m_indexHead].offset < offset + bytes))) {
+        evictOldest();
+    }
+
+    std::memcpy(m_arena.get() + offset, m_encoded.data(), bytes);
+    m_index[(m_indexHead + m_indexCount) % m_index.size()] =
+        BlockEntry{m_nextFrame, offset, static_cast<uint32_t>(bytes)};
+    ++m_indexCount;
+    m_bytesHeld += bytes;
+    m_writeOffset = offset + bytes;
+    m_nextFrame += kBlockFrames;
+}
+
+void ReplayBuffer::evictOldest() {
+    m_bytesHeld -= m_index[m_indexHead].bytes;
+    m_indexHead = (m_indexHead + 1) % m_index.size();
+    --m_indexCount;
+    ++m_blocksEvicted;
+}
+
+uint64_t ReplayBuffer::oldestPosition() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_indexCount > 0 ? m_index[m_indexHead].startFrame : m_nextFrame;
+}
+
+uint64_t ReplayBuffer::newestPosition() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nextFrame;
+}
+
+bool ReplayBuffer::loadBlock(size_t logicalIndex) {
+    const BlockEntry& entry = m_index[(m_indexHead + logicalIndex) % m_index.size()];
+    if (entry.startFrame == m_decodedStart) {
+        return true;
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    if (!m_decoder->decode(m_arena.get() + entry.offset, entry.bytes, kBlockFrames, m_decoded.data())) {
+        CYMAX_LOG_ERROR("ReplayBuffer: corrupt block at frame %llu", entry.startFrame);
+        m_decodedStart = UINT64_MAX;
+        return false;
+    }
+    m_lastSeekMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+    m_decodedStart = entry.startFrame;
+    return true;
+}
+
+size_t ReplayBuffer::read(uint64_t position, float* out, size_t frames) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t total = 0;
+    while (total < frames && m_indexCount > 0) {
+        const uint64_t oldest = m_index[m_indexHead].startFrame;
+        if (position < oldest || position >= m_nextFrame) {
+            break;
+        }
+        // Blocks are contiguous, so the block is found by arithmetic
+        const size_t logicalIndex = static_cast<size_t>((position - oldest) / kBlockFrames);
+        if (!loadBlock(logicalIndex)) {
+            break;
+        }
+
+        const size_t within = static_cast<size_t>(position - m_decodedStart);
+        const size_t n = std::min(kBlockFrames - within, frames - total);
+        const int32_t* src = m_decoded.data() + within * m_channels;
+        float* dst = out + total * m_channels;
+        for (size_t i = 0; i < n * m_channels; ++i) {
+            dst[i] = static_cast<float>(src[i]) * kInt24ToFloat;
+        }
+
+        total += n;
+        position += n;
+    }
+    return total;
+}
+
+bool ReplayBuffer::saveLastAsync(double seconds, const char* name) {
+    if (isSaving() || !AudioFile::isPlainFileName(name)) {
+        return false;
+    }
+    if (m_saveThread.joinable()) {
+        m_saveThread.join();
+    }
+
+    const uint64_t end = newestPosition();
+    const uint64_t wanted = static_cast<uint64_t>(std::max(0.0, seconds) * m_sampleRate);
+    const uint64_t start = std::max(oldestPosition(), end > wanted ? end - wanted : 0);
+    if (start >= end) {
+        CYMAX_LOG_ERROR("ReplayBuffer: nothing to save");
+        return false;
+    }
+
+    // Created here so the caller hears about a bad name or an existing file
+    const int fd = AudioFile::createOutputFile(name, m_savePath, sizeof(m_savePath));
+    if (fd < 0) {
+        return false;
+    }
+    m_saveFormat = AudioFile::formatForPath(m_savePath);
+
+    m_saving.store(true, std::memory_order_release);
+    m_saveThread = std::thread(&ReplayBuffer::saveThreadFunc, this, fd, start, end);
+    return true;
+}
+
+void ReplayBuffer::saveThreadFunc(int fd, uint64_t start, uint64_t end) {
+    ThreadPriority::setUtility();
+
+    const auto started = std::chrono::steady_clock::now();
+
+    const size_t bytesPerFrame = m_channels * sizeof(float);
+    std::vector<float> chunk(kBlockFrames * m_channels);
+    uint64_t dataBytes = 0;
+    uint64_t framesLost = 0;
+    bool ok = AudioFile::writeHeader(fd, m_saveFormat, m_sampleRate, m_channels);
+
+    uint64_t position = start;
+    while (ok && position < end) {
+        const size_t wanted = static_cast<size_t>(std::min<uint64_t>(kBlockFrames, end - position));
+        const size_t got = read(position, chunk.data(), wanted);
+        if (got == 0) {
+            // Evicted while saving; continue from what is still held
+            const uint64_t oldest = oldestPosition();
+            if (oldest <= position || oldest >= end) {
+                break;
+            }
+            framesLost += oldest - position;
+            position = oldest;
+            continue;
+        }
+
+        const size_t bytes = got * bytesPerFrame;
+        if (m_saveFormat == RecordingFormat::WAV && dataBytes + bytes > AudioFile::kMaxWAVDataBytes) {
+            CYMAX_LOG_ERROR("ReplayBuffer: WAV size limit reached");
+            break;
+        }
+        ok = AudioFile::writeAt(fd, chunk.data(), bytes, AudioFile::kHeaderBytes + dataBytes);
+        dataBytes += bytes;
+        position += got;
+    }
+
+    AudioFile::finalizeHeader(fd, m_saveFormat, dataBytes, m_channels);
+    close(fd);
+
+    const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    const ReplayStats s = stats();
+    CYMAX_LOG_INFO("ReplayBuffer: saved %.1f s to %{public}s (%{public}s) in %.0f ms, %llu frames lost; "
+                   "%.2f MB/min held, ratio %.2f, seek %.1f us",
+                   static_cast<double>(dataBytes / bytesPerFrame) / m_sampleRate, m_savePath,
+                   AudioFile::formatName(m_saveFormat), elapsedMs, framesLost,
+                   s.bytesPerMinute / (1024.0 * 1024.0), s.compressionRatio, s.lastSeekMicros);
+
+    m_saving.store(false, std::memory_order_release);
+}
+
+ReplayStats ReplayBuffer::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ReplayStats s;
+    s.framesHeld = static_cast<uint64_t>(m_indexCount) * kBlockFrames;
+    s.bytesHeld = m_bytesHeld;
+    s.capacityBytes = m_arenaBytes;
+    s.blocksEvicted = m_blocksEvicted;
+    s.lastSeekMicros = m_lastSeekMicros;
+    if (s.framesHeld > 0) {
+        const double minutes = static_cast<double>(s.framesHeld) / m_sampleRate / 60.0;
+        s.bytesPerMinute = static_cast<double>(m_bytesHeld) / minutes;
+        s.compressionRatio = static_cast<double>(m_bytesHeld) / static_cast<double>(s.framesHeld * m_channels * 3);
+    }
+    return s;
+}
+
+} // namespace Cymax
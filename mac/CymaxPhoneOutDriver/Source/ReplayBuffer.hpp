@@ -0,0 +1,159 @@
+//
+//  ReplayBuffer.hpp
+//  CymaxPhoneOutDriver
+//
+//  Compressed instant-replay history of device output
+//
+//  Runs as an analyzer on the AnalysisThread: audio is quantized to 24-bit
+//  and encoded with LosslessCodec in kBlockFrames blocks, appended to a
+//  fixed-size byte arena used as a ring. The oldest blocks are evicted
+//  when either the arena or the block index is full, so history is bounded
+//  by time (the configured minutes) and by memory (the arena, sized for
+//  the expected compression ratio; incompressible audio shortens history).
+//
+//  Positions are frame counts since the buffer was created and keep
+//  counting across stop/start. Blocks are contiguous and equal-sized, so
+//  a seek is index arithmetic plus one block decode; the last decoded
+//  block is cached for sequential reads.
+//
+
+#ifndef ReplayBuffer_hpp
+#define ReplayBuffer_hpp
+
+#include "AudioAnalyzer.hpp"
+#include "AudioFile.hpp"
+#include "LosslessCodec.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Cymax {
+
+/// Replay buffer statistics
+struct ReplayStats {
+    uint64_t framesHeld = 0;
+    uint64_t bytesHeld = 0;
+    uint64_t capacityBytes = 0;
+    uint64_t blocksEvicted = 0;
+    double bytesPerMinute = 0.0;     // Encoded bytes per minute of history
+    double compressionRatio = 0.0;   // Encoded size / raw 24-bit size
+    double lastSeekMicros = 0.0;     // Cost of the last uncached block decode
+};
+
+/// Instant-replay buffer
+class ReplayBuffer : public AudioAnalyzer {
+public:
+    /// @param minutes History to keep
+    explicit ReplayBuffer(double minutes = kDefaultMinutes);
+    ~ReplayBuffer() override;
+
+    // Non-copyable
+    ReplayBuffer(const ReplayBuffer&) = delete;
+    ReplayBuffer& operator=(const ReplayBuffer&) = delete;
+
+    // AudioAnalyzer
+    const char* name() const override { return "ReplayBuffer"; }
+    void prepare(double sampleRate, size_t channels, size_t maxFrames) override;
+    void process(const float* samples, size_t frames) override;
+    bool acceptsPlanar() const override { return true; }
+    void processPlanar(const float* const* planes, size_t frames) override;
+    void publish() override {}
+
+    /// First frame still held
+    uint64_t oldestPosition() const;
+
+    /// One past the last frame held
+    uint64_t newestPosition() const;
+
+    /// Read history starting at a frame position
+    /// @param position Frame position (>= oldestPosition())
+    /// @param out Interleaved output, frames * channels floats
+    /// @return Frames read; short if the range leaves the history
+    size_t read(uint64_t position, float* out, size_t frames);
+
+    /// Write the last seconds of history to a new file in
+    /// AudioFile::kOutputDirectory on a background thread
+    /// @param name File name, no directories; ".caf" selects CAF, anything
+    ///        else WAV. An existing file is never overwritten.
+    /// @return false if a save is already running, nothing is held or the
+    ///         file couldn't be created
+    bool saveLastAsync(double seconds, const char* name);
+
+    bool isSaving() const { return m_saving.load(std::memory_order_acquire); }
+
+    /// Path of the current (or last) save
+    const char* savePath() const { return m_savePath; }
+
+    ReplayStats stats() const;
+
+    size_t channels() const { return m_channels; }
+    double sampleRate() const { return m_sampleRate; }
+
+    static constexpr double kDefaultMinutes = 5.0;
+    static constexpr size_t kBlockFrames = 4096;
+
+    /// Expected encoded/raw 24-bit ratio used to size the arena
+    static constexpr double kExpectedRatio = 0.75;
+
+private:
+    struct BlockEntry {
+        uint64_t startFrame;
+        uint64_t offset;  // In the arena
+        uint32_t bytes;
+    };
+
+    void allocate();
+    void appendBlock();
+
+    /// Count frames staged; encodes the block once full
+    void advanceStaging(size_t frames);
+    void evictOldest();
+
+    /// Decode a held block into m_decoded (caller holds m_mutex)
+    bool loadBlock(size_t logicalIndex);
+
+    void saveThreadFunc(int fd, uint64_t start, uint64_t end);
+
+    double m_minutes;
+    double m_sampleRate = 48000.0;
+    size_t m_channels = 2;
+
+    // Staging block, one kBlockFrames plane per channel (analysis thread only)
+    std::vector<int32_t> m_staging;
+    std::vector<int32_t*> m_stagingRows;
+    std::vector<uint8_t> m_packed;
+    std::vector<uint8_t> m_encoded;
+    size_t m_stagingFrames = 0;
+    std::unique_ptr<LosslessCodec> m_encoder;
+
+    // History (guarded by m_mutex)
+    mutable std::mutex m_mutex;
+    std::unique_ptr<uint8_t[]> m_arena;
+    size_t m_arenaBytes = 0;
+    uint64_t m_writeOffset = 0;
+    std::vector<BlockEntry> m_index;
+    size_t m_indexHead = 0;   // Oldest entry
+    size_t m_indexCount = 0;
+    uint64_t m_nextFrame = 0;
+    uint64_t m_bytesHeld = 0;
+    uint64_t m_blocksEvicted = 0;
+
+    // Decode cache (guarded by m_mutex)
+    std::unique_ptr<LosslessCodec> m_decoder;
+    std::vector<int32_t> m_decoded;
+    uint64_t m_decodedStart = UINT64_MAX;
+    double m_lastSeekMicros = 0.0;
+
+    // Save
+    std::thread m_saveThread;
+    std::atomic<bool> m_saving{false};
+    char m_savePath[256] = {0};
+    RecordingFormat m_saveFormat = RecordingFormat::WAV;
+};
+
+} // namespace Cymax
+
+#endif /* ReplayBuffer_hpp */
@@ -15,29 +15,94 @@
 //  - The reader (sender) advances its read index to keep up
 //  - The writer (render callback) NEVER blocks
 //
+//  TAPS:
+//  Observers (meters, analyzers) follow the write index with their own
+//  TapCursor instead of consuming. They cost the writer nothing; a tap
+//  that falls too far behind skips ahead rather than read torn data.
+//
+//  STORAGE:
+//  A float ring can hold int16 or packed int24 instead of float32
+//  (RingStorage). The writer converts with the active sample kernel while
+//  the block is still hot in cache and readers convert back, which halves
+//  (int16) or cuts by a quarter (int24) the ring's memory and the cache
+//  lines both sides touch. Samples are clamped to [-1, 1] and quantized,
+//  so only use it where that costs nothing, e.g. the wire is int16 anyway.
+//
+//  LAYOUT:
+//  A float ring can also keep each channel in its own contiguous plane
+//  (RingLayout::Planar). The writer deinterleaves once with the active
+//  sample kernel, and readPlanar()/tapReadPlanar() hand consumers that
+//  work per channel (meters, codecs) straight memcpy'd planes instead of
+//  every one of them deinterleaving again. read()/tapRead() still return
+//  interleaved frames, re-interleaving on the way out. Planar rings are
+//  always Native storage.
+//
+//  RESET:
+//  reset() is O(1): it starts a new epoch at the current write index
+//  instead of clearing the buffer. Readers only ever see frames between
+//  their position and the write index, and taps from an earlier epoch
+//  jump to the epoch start, so frames from before the reset are never
+//  exposed.
+//
 
 #ifndef RingBuffer_hpp
 #define RingBuffer_hpp
 
+#include "RealtimeArena.hpp"
+#include "SampleKernels.hpp"
 #include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <type_traits>
 
 namespace Cymax {
 
+/// Sample format a RingBuffer keeps in memory (int formats: float rings only)
+enum class RingStorage : uint8_t {
+    Native,   // As the ring's sample type
+    Int16,    // int16, half the memory of float32
+    Int24     // Packed little-endian int24, three quarters
+};
+
+/// How a RingBuffer arranges channels in memory (planar: float rings only)
+enum class RingLayout : uint8_t {
+    Interleaved,  // Frames of channelCount samples
+    Planar        // One contiguous plane per channel
+};
+
+/// Read position of a non-consuming observer (see RingBuffer::tapRead)
+struct TapCursor {
+    size_t index = 0;
+    uint32_t epoch = 0;
+    uint64_t framesSkipped = 0;
+};
+
 /// Lock-free SPSC ring buffer for audio frames
 /// Template parameter T should be the sample type (float or int16_t)
 template<typename T>
 class RingBuffer {
 public:
+    /// Most channels a planar ring, readPlanar() or tapReadPlanar() supports
+    /// (plane pointers live on the stack)
+    static constexpr size_t kMaxPlanarChannels = 16;
+    
     /// Construct a ring buffer with the given capacity
     /// @param frameCapacity Number of frames (not samples) the buffer can hold
     /// @param channelCount Number of interleaved channels per frame
+    /// @param storage In-memory sample format (see STORAGE above)
+    /// @param arena Take the samples from this locked, pre-faulted arena
+    ///              (must outlive the ring); nullptr = heap
+    /// @param layout Channel arrangement in memory (see LAYOUT above)
     /// @note Capacity will be rounded up to the nearest power of 2
-    RingBuffer(size_t frameCapacity, size_t channelCount)
-        : m_channelCount(channelCount)
+    RingBuffer(size_t frameCapacity, size_t channelCount,
+               RingStorage storage = RingStorage::Native, RealtimeArena* arena = nullptr,
+               RingLayout layout = RingLayout::Interleaved)
+        : m_layout(supportsPlanar(channelCount) ? layout : RingLayout::Interleaved)
+        , m_storageFormat(std::is_same_v<T, float> && m_layout == RingLayout::Interleaved
+                              ? storage : RingStorage::Native)
+        , m_channelCount(channelCount)
         , m_writeIndex(0)
         , m_readIndex(0)
     {
@@ -45,16 +110,33 @@ public:
         m_frameCapacity = nextPowerOf2(frameCapacity);
         m_mask = m_frameCapacity - 1;
         
-        // Allocate sample buffer
+        // Allocate sample buffer (arena memory is already zeroed)
         m_sampleCapacity = m_frameCapacity * m_channelCount;
-        m_buffer = static_cast<T*>(std::aligned_alloc(64, m_sampleCapacity * sizeof(T)));
-        
-        // Zero-initialize
-        std::memset(m_buffer, 0, m_sampleCapacity * sizeof(T));
+        m_bytesPerSample = bytesPerSample(m_storageFormat);
+        const size_t bytes = m_sampleCapacity * m_bytesPerSample;
+        m_buffer = arena ? arena->allocateArray<uint8_t>(bytes) : nullptr;
+        m_ownsBuffer = m_buffer == nullptr;
+        if (m_ownsBuffer) {
+            // aligned_alloc wants a multiple of the alignment
+            m_buffer = static_cast<uint8_t*>(std::aligned_alloc(64, RealtimeArena::footprint(bytes)));
+            std::memset(m_buffer, 0, bytes);
+        }
     }
     
     ~RingBuffer() {
-        std::free(m_buffer);
+        if (m_ownsBuffer) {
+            std::free(m_buffer);
+        }
+    }
+    
+    /// Arena bytes a ring of this size takes (storage only)
+    static size_t storageBytes(size_t frameCapacity, size_t channelCount,
+                               RingStorage storage = RingStorage::Native,
+                               RingLayout layout = RingLayout::Interleaved) {
+        if (layout == RingLayout::Planar && supportsPlanar(channelCount)) {
+            storage = RingStorage::Native;
+        }
+        return RealtimeArena::footprint(nextPowerOf2(frameCapacity) * channelCount * bytesPerSample(storage));
     }
     
     // Non-copyable, non-movable
@@ -75,15 +157,8 @@ public:
         
         const size_t writeIdx = m_writeIndex.load(std::memory_order_relaxed);
         
-        // Calculate how many frames we can write
         // If we would overwrite unread data, we still write (dropping old frames)
-        const size_t samplesToWrite = frameCount * m_channelCount;
-        
-        // Write the samples with wrap-around
-        for (size_t i = 0; i < samplesToWrite; ++i) {
-            const size_t bufferIdx = ((writeIdx * m_channelCount) + i) & (m_sampleCapacity - 1);
-            m_buffer[bufferIdx] = frames[i];
-        }
+        storeFrames(writeIdx, frames, frameCount);
         
         // Update write index (with wrap using mask)
         const size_t newWriteIdx = (writeIdx + frameCount) & m_mask;
@@ -108,12 +183,7 @@ public:
             return 0;
         }
         
-        // Read the samples with wrap-around
-        const size_t samplesToRead = toRead * m_channelCount;
-        for (size_t i = 0; i < samplesToRead; ++i) {
-            const size_t bufferIdx = ((readIdx * m_channelCount) + i) & (m_sampleCapacity - 1);
-            frames[i] = m_buffer[bufferIdx];
-        }
+        loadFrames(readIdx, frames, toRead);
         
         // Update read index
         const size_t newReadIdx = (readIdx + toRead) & m_mask;
@@ -123,21 +193,12 @@ public:
     }
     
     /// Get number of frames available for reading
+    /// Pure query: fill statistics are the consumer's business (see
+    /// FillLevelHistogram)
     size_t availableForRead() const {
         const size_t writeIdx = m_writeIndex.load(std::memory_order_acquire);
         const size_t readIdx = m_readIndex.load(std::memory_order_relaxed);
-        const size_t available = (writeIdx - readIdx) & m_mask;
-        
-        // Update high water mark (relaxed is fine, this is just stats)
-        size_t current = m_highWaterMark.load(std::memory_order_relaxed);
-        while (available > current) {
-            if (m_highWaterMark.compare_exchange_weak(current, available, 
-                    std::memory_order_relaxed, std::memory_order_relaxed)) {
-                break;
-            }
-        }
-        
-        return available;
+        return (writeIdx - readIdx) & m_mask;
     }
     
     /// Get number of frames available for writing (before overwrite)
@@ -160,23 +221,80 @@ public:
         return m_channelCount;
     }
     
-    /// Get the high water mark (peak buffer fill level in frames)
-    size_t highWaterMark() const {
-        return m_highWaterMark.load(std::memory_order_relaxed);
+    /// Get the in-memory sample format
+    RingStorage storage() const {
+        return m_storageFormat;
     }
     
-    /// Reset high water mark (call periodically to get peak over time window)
-    void resetHighWaterMark() {
-        m_highWaterMark.store(0, std::memory_order_relaxed);
+    /// Get the in-memory channel arrangement
+    RingLayout layout() const {
+        return m_layout;
     }
     
-    /// Reset the buffer (called when stopping IO)
-    /// @warning Only call when no read/write operations are in progress
+    /// Empty the buffer in constant time (called when starting IO)
+    /// Old samples stay in memory but can no longer be read.
+    /// @warning Only call when no write() or read() is in progress; taps
+    ///          may keep running
     void reset() {
-        m_writeIndex.store(0, std::memory_order_relaxed);
-        m_readIndex.store(0, std::memory_order_relaxed);
-        m_highWaterMark.store(0, std::memory_order_relaxed);
-        std::memset(m_buffer, 0, m_sampleCapacity * sizeof(T));
+        const size_t writeIdx = m_writeIndex.load(std::memory_order_relaxed);
+        m_readIndex.store(writeIdx, std::memory_order_relaxed);
+        m_epochStart.store(writeIdx, std::memory_order_relaxed);
+        m_epoch.fetch_add(1, std::memory_order_release);
+    }
+    
+    /// Create a tap positioned at the current write index
+    /// Only frames written after this call are observed
+    TapCursor makeTap() const {
+        TapCursor cursor;
+        cursor.epoch = m_epoch.load(std::memory_order_acquire);
+        cursor.index = m_writeIndex.load(std::memory_order_acquire);
+        return cursor;
+    }
+    
+    /// Read frames behind a tap without consuming them
+    /// Safe to call from any single non-RT thread per cursor, concurrently
+    /// with the writer and the consuming reader.
+    /// @param cursor Tap position, advanced by the frames returned
+    /// @param frames Output buffer for interleaved audio frames
+    /// @param frameCount Maximum number of frames to read
+    /// @return Number of frames actually read
+    size_t tapRead(TapCursor& cursor, T* frames, size_t frameCount) const {
+        const size_t toRead = tapAdvance(cursor, frameCount);
+        loadFrames(cursor.index, frames, toRead);
+        
+        cursor.index = (cursor.index + toRead) & m_mask;
+        return toRead;
+    }
+    
+    /// Read frames into per-channel planes (called from sender thread)
+    /// Straight copies from a planar ring; an interleaved ring deinterleaves.
+    /// @warning channelCount() must not exceed kMaxPlanarChannels
+    /// @param planes channelCount() output planes of at least frameCount samples
+    /// @param frameCount Maximum number of frames to read
+    /// @return Number of frames actually read
+    size_t readPlanar(T* const* planes, size_t frameCount) {
+        const size_t writeIdx = m_writeIndex.load(std::memory_order_acquire);
+        const size_t readIdx = m_readIndex.load(std::memory_order_relaxed);
+        const size_t toRead = std::min(frameCount, (writeIdx - readIdx) & m_mask);
+        if (toRead == 0) {
+            return 0;
+        }
+        
+        loadPlanes(readIdx, planes, toRead);
+        m_readIndex.store((readIdx + toRead) & m_mask, std::memory_order_release);
+        return toRead;
+    }
+    
+    /// tapRead() into per-channel planes
+    /// @param cursor Tap position, advanced by the frames returned
+    /// @param planes channelCount() output planes of at least frameCount samples
+    /// @param frameCount Maximum number of frames to read
+    /// @return Number of frames actually read
+    size_t tapReadPlanar(TapCursor& cursor, T* const* planes, size_t frameCount) const {
+        const size_t toRead = tapAdvance(cursor, frameCount);
+        loadPlanes(cursor.index, planes, toRead);
+        cursor.index = (cursor.index + toRead) & m_mask;
+        return toRead;
     }
     
     /// Advance read index, dropping frames
@@ -189,6 +307,161 @@ public:
     }
     
 private:
+    static constexpr size_t kBounceFrames = 64;
+    
+    static constexpr bool supportsPlanar(size_t channelCount) {
+        return std::is_same_v<T, float> && channelCount > 0 && channelCount <= kMaxPlanarChannels;
+    }
+    
+    /// Bring a tap into the current epoch and skip what the writer may lap
+    /// @return Frames that can be copied from cursor.index (at most frameCount)
+    size_t tapAdvance(TapCursor& cursor, size_t frameCount) const {
+        // A reset since the last read: nothing before the epoch start is valid
+        const uint32_t epoch = m_epoch.load(std::memory_order_acquire);
+        if (cursor.epoch != epoch) {
+            cursor.index = m_epochStart.load(std::memory_order_relaxed);
+            cursor.epoch = epoch;
+        }
+        
+        const size_t writeIdx = m_writeIndex.load(std::memory_order_acquire);
+        size_t available = (writeIdx - cursor.index) & m_mask;
+        
+        // Keep a quarter of the ring between us and the writer so it can't
+        // lap the frames we copy; anything older is skipped, not read
+        const size_t maxLag = m_frameCapacity - m_frameCapacity / 4;
+        if (available > maxLag) {
+            const size_t skip = available - maxLag;
+            cursor.index = (cursor.index + skip) & m_mask;
+            cursor.framesSkipped += skip;
+            available = maxLag;
+        }
+        
+        return std::min(frameCount, available);
+    }
+    
+    static size_t bytesPerSample(RingStorage storage) {
+        switch (storage) {
+            case RingStorage::Int16: return sizeof(int16_t);
+            case RingStorage::Int24: return Kernels::kInt24Bytes;
+            case RingStorage::Native: break;
+        }
+        return sizeof(T);
+    }
+    
+    /// Copy frames in at a frame index, splitting at the wrap
+    void storeFrames(size_t frameIndex, const T* frames, size_t frameCount) {
+        while (frameCount > 0) {
+            const size_t position = frameIndex & m_mask;
+            const size_t run = std::min(frameCount, m_frameCapacity - position);
+            const size_t samples = run * m_channelCount;
+            if constexpr (std::is_same_v<T, float>) {
+                if (m_layout == RingLayout::Planar) {
+                    float* planes[kMaxPlanarChannels];
+                    for (size_t c = 0; c < m_channelCount; ++c) {
+                        planes[c] = plane(c) + position;
+                    }
+                    Kernels::active().deinterleave(frames, planes, run, m_channelCount);
+                    frameIndex += run;
+                    frames += samples;
+                    frameCount -= run;
+                    continue;
+                }
+            }
+            uint8_t* dst = m_buffer + position * m_channelCount * m_bytesPerSample;
+            if constexpr (std::is_same_v<T, float>) {
+                if (m_storageFormat == RingStorage::Int16) {
+                    Kernels::active().floatToInt16(frames, reinterpret_cast<int16_t*>(dst), samples);
+                } else if (m_storageFormat == RingStorage::Int24) {
+                    Kernels::active().floatToInt24(frames, dst, samples);
+                } else {
+                    std::memcpy(dst, frames, samples * sizeof(T));
+                }
+            } else {
+                std::memcpy(dst, frames, samples * sizeof(T));
+            }
+            frameIndex += run;
+            frames += samples;
+            frameCount -= run;
+        }
+    }
+    
+    /// Copy frames out from a frame index, splitting at the wrap
+    void loadFrames(size_t frameIndex, T* frames, size_t frameCount) const {
+        while (frameCount > 0) {
+            const size_t position = frameIndex & m_mask;
+            const size_t run = std::min(frameCount, m_frameCapacity - position);
+            const size_t samples = run * m_channelCount;
+            if constexpr (std::is_same_v<T, float>) {
+                if (m_layout == RingLayout::Planar) {
+                    const float* planes[kMaxPlanarChannels];
+                    for (size_t c = 0; c < m_channelCount; ++c) {
+                        planes[c] = plane(c) + position;
+                    }
+                    Kernels::active().interleave(planes, frames, run, m_channelCount);
+                    frameIndex += run;
+                    frames += samples;
+                    frameCount -= run;
+                    continue;
+                }
+            }
+            const uint8_t* src = m_buffer + position * m_channelCount * m_bytesPerSample;
+            if constexpr (std::is_same_v<T, float>) {
+                if (m_storageFormat == RingStorage::Int16) {
+                    Kernels::active().int16ToFloat(reinterpret_cast<const int16_t*>(src), frames, samples);
+                } else if (m_storageFormat == RingStorage::Int24) {
+                    Kernels::active().int24ToFloat(src, frames, samples);
+                } else {
+                    std::memcpy(frames, src, samples * sizeof(T));
+                }
+            } else {
+                std::memcpy(frames, src, samples * sizeof(T));
+            }
+            frameIndex += run;
+            frames += samples;
+            frameCount -= run;
+        }
+    }
+    
+    /// Copy frames out into per-channel planes, splitting at the wrap
+    void loadPlanes(size_t frameIndex, T* const* planes, size_t frameCount) const {
+        size_t done = 0;
+        while (done < frameCount) {
+            const size_t position = (frameIndex + done) & m_mask;
+            const size_t run = std::min(frameCount - done, m_frameCapacity - position);
+            if (m_layout == RingLayout::Planar) {
+                for (size_t c = 0; c < m_channelCount; ++c) {
+                    std::memcpy(planes[c] + done, plane(c) + position, run * sizeof(T));
+                }
+            } else {
+                // Interleaved: unpack a few frames at a time and scatter them
+                T bounce[kBounceFrames * kMaxPlanarChannels];
+                for (size_t f = 0; f < run; f += kBounceFrames) {
+                    const size_t n = std::min(kBounceFrames, run - f);
+                    loadFrames(position + f, bounce, n);
+                    T* out[kMaxPlanarChannels];
+                    for (size_t c = 0; c < m_channelCount; ++c) {
+                        out[c] = planes[c] + done + f;
+                    }
+                    if constexpr (std::is_same_v<T, float>) {
+                        Kernels::active().deinterleave(bounce, out, n, m_channelCount);
+                    } else {
+                        for (size_t i = 0; i < n; ++i) {
+                            for (size_t c = 0; c < m_channelCount; ++c) {
+                                out[c][i] = bounce[i * m_channelCount + c];
+                            }
+                        }
+                    }
+                }
+            }
+            done += run;
+        }
+    }
+    
+    /// Start of channel c's plane (planar layout)
+    T* plane(size_t c) const {
+        return reinterpret_cast<T*>(m_buffer) + c * m_frameCapacity;
+    }
+    
     /// Round up to next power of 2
     static size_t nextPowerOf2(size_t v) {
         v--;
@@ -202,7 +475,11 @@ private:
         return v;
     }
     
-    T* m_buffer;
+    uint8_t* m_buffer;          // m_sampleCapacity samples of m_bytesPerSample
+    bool m_ownsBuffer;          // Heap storage (no arena)
+    RingLayout m_layout;
+    RingStorage m_storageFormat;
+    size_t m_bytesPerSample;
     size_t m_frameCapacity;     // Number of frames (power of 2)
     size_t m_sampleCapacity;    // Number of samples (frames * channels)
     size_t m_channelCount;
@@ -212,8 +489,9 @@ private:
     alignas(64) std::atomic<size_t> m_writeIndex;
     alignas(64) std::atomic<size_t> m_readIndex;
     
-    // Statistics
-    mutable std::atomic<size_t> m_highWaterMark{0};
+    // Reset epoch and the write index it started at (see reset())
+    std::atomic<uint32_t> m_epoch{0};
+    std::atomic<size_t> m_epochStart{0};
 };
 
 } // namespace Cymax
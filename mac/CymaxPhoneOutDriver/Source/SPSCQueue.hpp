@@ -0,0 +1,106 @@
+//
+//  SPSCQueue.hpp
+//  CymaxPhoneOutDriver
+//
+//  Bounded lock-free single-producer single-consumer queue
+//
+//  Fixed capacity (power of 2), no allocation after construction. Used to
+//  hand preallocated buffers between threads; T should be cheap to copy
+//  (pointers, indices).
+//
+//  A consumer that finds the queue empty can block in waitForData(); the
+//  producer's push() wakes it. Waiting uses C++20 atomic wait/notify, so
+//  an uncontended push costs one atomic increment.
+//
+
+#ifndef SPSCQueue_hpp
+#define SPSCQueue_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Cymax {
+
+/// Bounded SPSC queue
+template<typename T>
+class SPSCQueue {
+public:
+    /// @param capacity Maximum queued items (rounded up to a power of 2)
+    explicit SPSCQueue(size_t capacity) {
+        m_capacity = 1;
+        while (m_capacity < capacity) m_capacity <<= 1;
+        m_mask = m_capacity - 1;
+        m_items = std::make_unique<T[]>(m_capacity);
+    }
+
+    // Non-copyable
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    /// Append an item (producer)
+    /// @return false if the queue is full
+    bool tryPush(const T& item) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_capacity) {
+            return false;
+        }
+        m_items[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        m_signal.fetch_add(1, std::memory_order_release);
+        m_signal.notify_one();
+        return true;
+    }
+
+    /// Remove the oldest item (consumer)
+    /// @return false if the queue is empty
+    bool tryPop(T& item) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (m_tail.load(std::memory_order_acquire) == head) {
+            return false;
+        }
+        item = m_items[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Block the consumer until an item may be available or wake() is called
+    /// Returns immediately if anything was pushed since the queue was last
+    /// seen empty, so wakeups aren't lost.
+    void waitForData() {
+        const uint32_t seen = m_signal.load(std::memory_order_acquire);
+        if (m_tail.load(std::memory_order_acquire) != m_head.load(std::memory_order_relaxed)) {
+            return;
+        }
+        m_signal.wait(seen, std::memory_order_acquire);
+    }
+
+    /// Wake a consumer blocked in waitForData() (e.g. to stop it)
+    void wake() {
+        m_signal.fetch_add(1, std::memory_order_release);
+        m_signal.notify_all();
+    }
+
+    /// Items queued (approximate while both sides are active)
+    size_t size() const {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return m_capacity; }
+
+private:
+    std::unique_ptr<T[]> m_items;
+    size_t m_capacity;
+    size_t m_mask;
+
+    // Monotonic counters on separate cache lines to avoid false sharing
+    alignas(64) std::atomic<size_t> m_tail{0};
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<uint32_t> m_signal{0};
+};
+
+} // namespace Cymax
+
+#endif /* SPSCQueue_hpp */
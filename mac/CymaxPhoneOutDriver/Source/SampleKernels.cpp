@@ -0,0 +1,247 @@
+//
+//  SampleKernels.cpp
+//  CymaxPhoneOutDriver
+//
+//  Scalar reference kernels and runtime ISA dispatch
+//
+
+#include "SampleKernels.hpp"
+#include "SampleKernelsInternal.hpp"
+#include "Logging.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace Cymax {
+namespace Kernels {
+
+namespace Scalar {
+
+static inline float clampUnit(float x) {
+    return std::min(std::max(x, -1.0f), 1.0f);
+}
+
+void floatToInt16(const float* in, int16_t* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<int16_t>(std::lrintf(clampUnit(in[i]) * kInt16Scale));
+    }
+}
+
+void int16ToFloat(const int16_t* in, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = static_cast<float>(in[i]) * kInt16InvScale;
+    }
+}
+
+void floatToInt24(const float* in, uint8_t* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const int32_t v = static_cast<int32_t>(std::lrintf(clampUnit(in[i]) * kInt24Scale));
+        out[i * 3 + 0] = static_cast<uint8_t>(v);
+        out[i * 3 + 1] = static_cast<uint8_t>(v >> 8);
+        out[i * 3 + 2] = static_cast<uint8_t>(v >> 16);
+    }
+}
+
+void int24ToFloat(const uint8_t* in, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t u = static_cast<uint32_t>(in[i * 3 + 0]) << 8 |
+                           static_cast<uint32_t>(in[i * 3 + 1]) << 16 |
+                           static_cast<uint32_t>(in[i * 3 + 2]) << 24;
+        // Arithmetic shift sign-extends the 24-bit value
+        const int32_t v = static_cast<int32_t>(u) >> 8;
+        out[i] = static_cast<float>(v) * kInt24InvScale;
+    }
+}
+
+void applyGain(float* data, size_t count, float gain) {
+    for (size_t i = 0; i < count; ++i) {
+        data[i] *= gain;
+    }
+}
+
+void applyGainRampFrom(float* data, size_t firstFrame, size_t frames, size_t channels,
+                       float startGain, float step) {
+    // data points at frame firstFrame of the ramp
+    for (size_t f = 0; f < frames; ++f) {
+        // Kept as two statements so the compiler cannot fuse them into an
+        // FMA the SIMD paths don't use
+        const float delta = step * static_cast<float>(firstFrame + f);
+        const float gain = startGain + delta;
+        for (size_t c = 0; c < channels; ++c) {
+            data[f * channels + c] *= gain;
+        }
+    }
+}
+
+void applyGainRamp(float* data, size_t frames, size_t channels,
+                   float startGain, float endGain) {
+    if (frames == 0) return;
+    const float step = (endGain - startGain) / static_cast<float>(frames);
+    applyGainRampFrom(data, 0, frames, channels, startGain, step);
+}
+
+void multiply(const float* a, const float* b, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+float peakAbs(const float* data, size_t count) {
+    float peak = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        peak = std::max(peak, std::fabs(data[i]));
+    }
+    return peak;
+}
+
+double sumOfSquares(const float* data, size_t count) {
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        sum += static_cast<double>(data[i] * data[i]);
+    }
+    return sum;
+}
+
+void interleave(const float* const* planes, float* out, size_t frames, size_t channels) {
+    for (size_t f = 0; f < frames; ++f) {
+        for (size_t c = 0; c < channels; ++c) {
+            out[f * channels + c] = planes[c][f];
+        }
+    }
+}
+
+void deinterleave(const float* in, float* const* planes, size_t frames, size_t channels) {
+    for (size_t f = 0; f < frames; ++f) {
+        for (size_t c = 0; c < channels; ++c) {
+            planes[c][f] = in[f * channels + c];
+        }
+    }
+}
+
+void downmixToMono(const float* in, float* out, size_t frames, size_t channels) {
+    if (channels == 0) return;
+    const float scale = 1.0f / static_cast<float>(channels);
+    for (size_t f = 0; f < frames; ++f) {
+        float sum = in[f * channels];
+        for (size_t c = 1; c < channels; ++c) {
+            sum += in[f * channels + c];
+        }
+        out[f] = sum * scale;
+    }
+}
+
+size_t sanitize(float* data, size_t count, float limit) {
+    size_t replaced = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const float a = std::fabs(data[i]);
+        if (!(a <= FLT_MAX)) {
+            // NaN or Inf
+            data[i] = 0.0f;
+            ++replaced;
+        } else if (a < FLT_MIN) {
+            // Denormal (or signed zero)
+            data[i] = 0.0f;
+        } else {
+            data[i] = std::min(std::max(data[i], -limit), limit);
+        }
+    }
+    return replaced;
+}
+
+} // namespace Scalar
+
+static const KernelTable kScalarTable = {
+    ISA::Scalar,
+    "scalar",
+    Scalar::floatToInt16,
+    Scalar::int16ToFloat,
+    Scalar::floatToInt24,
+    Scalar::int24ToFloat,
+    Scalar::applyGain,
+    Scalar::applyGainRamp,
+    Scalar::multiply,
+    Scalar::peakAbs,
+    Scalar::sumOfSquares,
+    Scalar::interleave,
+    Scalar::deinterleave,
+    Scalar::downmixToMono,
+    Scalar::sanitize,
+};
+
+static std::atomic<const KernelTable*> gActiveTable{&kScalarTable};
+
+static bool cpuSupports(ISA isa) {
+    switch (isa) {
+        case ISA::Scalar:
+            return true;
+#if defined(__x86_64__) || defined(__i386__)
+        case ISA::SSE2:
+            // Baseline on x86_64
+            return __builtin_cpu_supports("sse2");
+        case ISA::AVX2:
+            // Also false under Rosetta, which does not translate AVX
+            return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        case ISA::NEON:
+            // Mandatory on arm64
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+const KernelTable* forISA(ISA isa) {
+    const KernelTable* table = nullptr;
+    switch (isa) {
+        case ISA::Scalar: table = &kScalarTable; break;
+        case ISA::SSE2:   table = sse2Table(); break;
+        case ISA::AVX2:   table = avx2Table(); break;
+        case ISA::NEON:   table = neonTable(); break;
+    }
+    if (!table || !cpuSupports(isa)) {
+        return nullptr;
+    }
+    return table;
+}
+
+void initialize() {
+    // Preference order: widest first
+    static const ISA kPreference[] = { ISA::AVX2, ISA::NEON, ISA::SSE2, ISA::Scalar };
+
+    const KernelTable* selected = &kScalarTable;
+    for (ISA isa : kPreference) {
+        if (const KernelTable* table = forISA(isa)) {
+            selected = table;
+            break;
+        }
+    }
+
+    gActiveTable.store(selected, std::memory_order_release);
+    CYMAX_LOG_INFO("Sample kernels: %{public}s", selected->name);
+}
+
+const KernelTable& active() {
+    return *gActiveTable.load(std::memory_order_acquire);
+}
+
+const KernelTable& scalar() {
+    return kScalarTable;
+}
+
+const char* isaName(ISA isa) {
+    switch (isa) {
+        case ISA::Scalar: return "scalar";
+        case ISA::SSE2:   return "sse2";
+        case ISA::AVX2:   return "avx2";
+        case ISA::NEON:   return "neon";
+    }
+    return "unknown";
+}
+
+} // namespace Kernels
+} // namespace Cymax
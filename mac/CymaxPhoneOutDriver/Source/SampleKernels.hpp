@@ -0,0 +1,125 @@
+//
+//  SampleKernels.hpp
+//  CymaxPhoneOutDriver
+//
+//  Runtime-dispatched sample processing kernels
+//
+//  One table of function pointers per instruction set (scalar, SSE2, AVX2,
+//  NEON). The best table the CPU supports is selected once at startup via
+//  Kernels::initialize() and then read lock-free from any thread.
+//
+//  SAFETY GUARANTEES (all kernels):
+//  - No memory allocation, no locks, no system calls
+//  - Safe to call from the real-time render callback
+//  - Pointers need no particular alignment
+//
+//  The scalar table is the reference implementation. Every SIMD kernel
+//  produces bit-identical results to it except sumOfSquares, whose
+//  summation order differs (results agree to within float rounding).
+//  Conversion kernels expect finite input; run sanitize() first when the
+//  source cannot be trusted.
+//
+
+#ifndef SampleKernels_hpp
+#define SampleKernels_hpp
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Cymax {
+namespace Kernels {
+
+/// Instruction set a kernel table is implemented with
+enum class ISA : uint8_t {
+    Scalar = 0,
+    SSE2,
+    AVX2,
+    NEON,
+};
+
+/// Bytes per packed little-endian 24-bit sample
+static constexpr size_t kInt24Bytes = 3;
+
+/// Table of sample processing kernels for one instruction set
+struct KernelTable {
+    ISA isa;
+    const char* name;
+
+    // --- Format conversion -------------------------------------------------
+
+    /// Float [-1, 1] to int16, clamped, round-to-nearest-even
+    void (*floatToInt16)(const float* in, int16_t* out, size_t count);
+
+    /// int16 to float (scale 1/32768)
+    void (*int16ToFloat)(const int16_t* in, float* out, size_t count);
+
+    /// Float [-1, 1] to packed little-endian int24 (3 bytes per sample)
+    void (*floatToInt24)(const float* in, uint8_t* out, size_t count);
+
+    /// Packed little-endian int24 to float (scale 1/8388608)
+    void (*int24ToFloat)(const uint8_t* in, float* out, size_t count);
+
+    // --- Gain --------------------------------------------------------------
+
+    /// Multiply every sample by a constant gain (in place)
+    void (*applyGain)(float* data, size_t count, float gain);
+
+    /// Linear per-frame gain ramp over interleaved frames (in place)
+    /// Frame i is scaled by startGain + (endGain - startGain) * i / frames
+    void (*applyGainRamp)(float* data, size_t frames, size_t channels,
+                          float startGain, float endGain);
+
+    /// Element-wise product out[i] = a[i] * b[i] (out may alias a)
+    void (*multiply)(const float* a, const float* b, float* out, size_t count);
+
+    // --- Metering ----------------------------------------------------------
+
+    /// Maximum absolute sample value
+    float (*peakAbs)(const float* data, size_t count);
+
+    /// Sum of squared samples (accumulated in double precision)
+    double (*sumOfSquares)(const float* data, size_t count);
+
+    // --- Layout ------------------------------------------------------------
+
+    /// Planar channels to interleaved frames
+    void (*interleave)(const float* const* planes, float* out,
+                       size_t frames, size_t channels);
+
+    /// Interleaved frames to planar channels
+    void (*deinterleave)(const float* in, float* const* planes,
+                         size_t frames, size_t channels);
+
+    /// Average all channels of interleaved frames into one mono channel
+    void (*downmixToMono)(const float* in, float* out,
+                          size_t frames, size_t channels);
+
+    // --- Sanitization ------------------------------------------------------
+
+    /// Replace NaN/Inf and denormals with 0 and clamp to [-limit, limit]
+    /// @return Number of non-finite samples that were replaced
+    size_t (*sanitize)(float* data, size_t count, float limit);
+};
+
+/// Select the best kernel table for this CPU
+/// @note Call once at plugin startup, before any real-time thread runs.
+///       Safe to call again; later calls are no-ops.
+void initialize();
+
+/// Kernel table selected by initialize() (scalar until then)
+const KernelTable& active();
+
+/// The scalar reference kernel table
+const KernelTable& scalar();
+
+/// Kernel table for a specific instruction set
+/// @return nullptr if the ISA is not compiled in or not supported by this CPU
+const KernelTable* forISA(ISA isa);
+
+/// Human-readable name of an instruction set
+const char* isaName(ISA isa);
+
+} // namespace Kernels
+} // namespace Cymax
+
+#endif /* SampleKernels_hpp */
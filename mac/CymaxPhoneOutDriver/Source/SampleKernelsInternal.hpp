@@ -0,0 +1,59 @@
+//
+//  SampleKernelsInternal.hpp
+//  CymaxPhoneOutDriver
+//
+//  Shared declarations between the per-ISA kernel translation units.
+//  Not part of the public kernel API - include SampleKernels.hpp instead.
+//
+
+#ifndef SampleKernelsInternal_hpp
+#define SampleKernelsInternal_hpp
+
+#include "SampleKernels.hpp"
+
+namespace Cymax {
+namespace Kernels {
+
+// Scalar reference implementations.
+// SIMD kernels call these for loop tails and unsupported channel counts.
+namespace Scalar {
+
+void floatToInt16(const float* in, int16_t* out, size_t count);
+void int16ToFloat(const int16_t* in, float* out, size_t count);
+void floatToInt24(const float* in, uint8_t* out, size_t count);
+void int24ToFloat(const uint8_t* in, float* out, size_t count);
+void applyGain(float* data, size_t count, float gain);
+void applyGainRamp(float* data, size_t frames, size_t channels,
+                   float startGain, float endGain);
+void multiply(const float* a, const float* b, float* out, size_t count);
+float peakAbs(const float* data, size_t count);
+double sumOfSquares(const float* data, size_t count);
+void interleave(const float* const* planes, float* out, size_t frames, size_t channels);
+void deinterleave(const float* in, float* const* planes, size_t frames, size_t channels);
+void downmixToMono(const float* in, float* out, size_t frames, size_t channels);
+size_t sanitize(float* data, size_t count, float limit);
+
+/// Apply frames [firstFrame, firstFrame + frames) of a gain ramp
+/// Frame i of the ramp is scaled by startGain + step * i. Lets SIMD
+/// kernels hand their tail to the scalar path with identical gains.
+void applyGainRampFrom(float* data, size_t firstFrame, size_t frames, size_t channels,
+                       float startGain, float step);
+
+} // namespace Scalar
+
+// Full-scale constants shared by every implementation so results match
+static constexpr float kInt16Scale = 32767.0f;
+static constexpr float kInt16InvScale = 1.0f / 32768.0f;
+static constexpr float kInt24Scale = 8388607.0f;
+static constexpr float kInt24InvScale = 1.0f / 8388608.0f;
+
+// Per-ISA tables. Each returns nullptr when the ISA is not compiled
+// into this binary; CPU support is checked separately by the dispatcher.
+const KernelTable* sse2Table();
+const KernelTable* avx2Table();
+const KernelTable* neonTable();
+
+} // namespace Kernels
+} // namespace Cymax
+
+#endif /* SampleKernelsInternal_hpp */
@@ -0,0 +1,284 @@
+//
+//  SampleKernelsNEON.cpp
+//  CymaxPhoneOutDriver
+//
+//  NEON sample kernels (Apple Silicon, Linux arm64)
+//
+//  NEON is mandatory on arm64, so no runtime check beyond the build
+//  architecture is needed.
+//
+
+#include "SampleKernelsInternal.hpp"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+#include <cfloat>
+
+namespace Cymax {
+namespace Kernels {
+
+namespace NEON {
+
+static inline float32x4_t clampUnit(float32x4_t x) {
+    return vminq_f32(vmaxq_f32(x, vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+}
+
+static void floatToInt16(const float* in, int16_t* out, size_t count) {
+    const float32x4_t scale = vdupq_n_f32(kInt16Scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int32x4_t a = vcvtnq_s32_f32(vmulq_f32(clampUnit(vld1q_f32(in + i)), scale));
+        const int32x4_t b = vcvtnq_s32_f32(vmulq_f32(clampUnit(vld1q_f32(in + i + 4)), scale));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(a), vqmovn_s32(b)));
+    }
+    Scalar::floatToInt16(in + i, out + i, count - i);
+}
+
+static void int16ToFloat(const int16_t* in, float* out, size_t count) {
+    const float32x4_t scale = vdupq_n_f32(kInt16InvScale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t v = vld1q_s16(in + i);
+        vst1q_f32(out + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+        vst1q_f32(out + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+    }
+    Scalar::int16ToFloat(in + i, out + i, count - i);
+}
+
+/// Narrow four int32x4 vectors to the selected byte of each lane
+static inline uint8x16_t narrowByte(int32x4_t a, int32x4_t b, int32x4_t c, int32x4_t d, int shift) {
+    const int32x4_t s = vdupq_n_s32(-shift);
+    const uint16x8_t ab = vcombine_u16(vmovn_u32(vreinterpretq_u32_s32(vshlq_s32(a, s))),
+                                       vmovn_u32(vreinterpretq_u32_s32(vshlq_s32(b, s))));
+    const uint16x8_t cd = vcombine_u16(vmovn_u32(vreinterpretq_u32_s32(vshlq_s32(c, s))),
+                                       vmovn_u32(vreinterpretq_u32_s32(vshlq_s32(d, s))));
+    return vcombine_u8(vmovn_u16(ab), vmovn_u16(cd));
+}
+
+static void floatToInt24(const float* in, uint8_t* out, size_t count) {
+    const float32x4_t scale = vdupq_n_f32(kInt24Scale);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const int32x4_t a = vcvtnq_s32_f32(vmulq_f32(clampUnit(vld1q_f32(in + i)), scale));
+        const int32x4_t b = vcvtnq_s32_f32(vmulq_f32(clampUnit(vld1q_f32(in + i + 4)), scale));
+        const int32x4_t c = vcvtnq_s32_f32(vmulq_f32(clampUnit(vld1q_f32(in + i + 8)), scale));
+        const int32x4_t d = vcvtnq_s32_f32(vmulq_f32(clampUnit(vld1q_f32(in + i + 12)), scale));
+        uint8x16x3_t bytes;
+        bytes.val[0] = narrowByte(a, b, c, d, 0);
+        bytes.val[1] = narrowByte(a, b, c, d, 8);
+        bytes.val[2] = narrowByte(a, b, c, d, 16);
+        vst3q_u8(out + i * 3, bytes);
+    }
+    Scalar::floatToInt24(in + i, out + i * 3, count - i);
+}
+
+/// Assemble four 24-bit samples from byte planes and convert to float
+static inline float32x4_t widen24(uint16x4_t b0, uint16x4_t b1, uint16x4_t b2, float32x4_t scale) {
+    const uint32x4_t u = vorrq_u32(vorrq_u32(vshlq_n_u32(vmovl_u16(b0), 8),
+                                             vshlq_n_u32(vmovl_u16(b1), 16)),
+                                   vshlq_n_u32(vmovl_u16(b2), 24));
+    const int32x4_t s = vshrq_n_s32(vreinterpretq_s32_u32(u), 8);
+    return vmulq_f32(vcvtq_f32_s32(s), scale);
+}
+
+static void int24ToFloat(const uint8_t* in, float* out, size_t count) {
+    const float32x4_t scale = vdupq_n_f32(kInt24InvScale);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16x3_t bytes = vld3q_u8(in + i * 3);
+        const uint16x8_t lo0 = vmovl_u8(vget_low_u8(bytes.val[0]));
+        const uint16x8_t lo1 = vmovl_u8(vget_low_u8(bytes.val[1]));
+        const uint16x8_t lo2 = vmovl_u8(vget_low_u8(bytes.val[2]));
+        const uint16x8_t hi0 = vmovl_u8(vget_high_u8(bytes.val[0]));
+        const uint16x8_t hi1 = vmovl_u8(vget_high_u8(bytes.val[1]));
+        const uint16x8_t hi2 = vmovl_u8(vget_high_u8(bytes.val[2]));
+        vst1q_f32(out + i,      widen24(vget_low_u16(lo0), vget_low_u16(lo1), vget_low_u16(lo2), scale));
+        vst1q_f32(out + i + 4,  widen24(vget_high_u16(lo0), vget_high_u16(lo1), vget_high_u16(lo2), scale));
+        vst1q_f32(out + i + 8,  widen24(vget_low_u16(hi0), vget_low_u16(hi1), vget_low_u16(hi2), scale));
+        vst1q_f32(out + i + 12, widen24(vget_high_u16(hi0), vget_high_u16(hi1), vget_high_u16(hi2), scale));
+    }
+    Scalar::int24ToFloat(in + i * 3, out + i, count - i);
+}
+
+static void applyGain(float* data, size_t count, float gain) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        vst1q_f32(data + i, vmulq_n_f32(vld1q_f32(data + i), gain));
+        vst1q_f32(data + i + 4, vmulq_n_f32(vld1q_f32(data + i + 4), gain));
+    }
+    Scalar::applyGain(data + i, count - i, gain);
+}
+
+static void applyGainRamp(float* data, size_t frames, size_t channels,
+                          float startGain, float endGain) {
+    if (frames == 0) return;
+    const float step = (endGain - startGain) / static_cast<float>(frames);
+    const float32x4_t vStart = vdupq_n_f32(startGain);
+    const float32x4_t vStep = vdupq_n_f32(step);
+    size_t f = 0;
+
+    if (channels == 1) {
+        static const float kIdx[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+        float32x4_t idx = vld1q_f32(kIdx);
+        const float32x4_t inc = vdupq_n_f32(4.0f);
+        for (; f + 4 <= frames; f += 4) {
+            const float32x4_t delta = vmulq_f32(vStep, idx);
+            const float32x4_t gain = vaddq_f32(vStart, delta);
+            vst1q_f32(data + f, vmulq_f32(vld1q_f32(data + f), gain));
+            idx = vaddq_f32(idx, inc);
+        }
+    } else if (channels == 2) {
+        static const float kIdx[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+        float32x4_t idx = vld1q_f32(kIdx);
+        const float32x4_t inc = vdupq_n_f32(2.0f);
+        for (; f + 2 <= frames; f += 2) {
+            const float32x4_t delta = vmulq_f32(vStep, idx);
+            const float32x4_t gain = vaddq_f32(vStart, delta);
+            vst1q_f32(data + f * 2, vmulq_f32(vld1q_f32(data + f * 2), gain));
+            idx = vaddq_f32(idx, inc);
+        }
+    }
+
+    Scalar::applyGainRampFrom(data + f * channels, f, frames - f, channels, startGain, step);
+}
+
+static void multiply(const float* a, const float* b, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(out + i, vmulq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+    }
+    Scalar::multiply(a + i, b + i, out + i, count - i);
+}
+
+static float peakAbs(const float* data, size_t count) {
+    float32x4_t peak0 = vdupq_n_f32(0.0f);
+    float32x4_t peak1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // vmaxnm ignores a NaN operand, matching std::max(peak, x)
+        peak0 = vmaxnmq_f32(peak0, vabsq_f32(vld1q_f32(data + i)));
+        peak1 = vmaxnmq_f32(peak1, vabsq_f32(vld1q_f32(data + i + 4)));
+    }
+    const float head = vmaxvq_f32(vmaxq_f32(peak0, peak1));
+    const float tail = Scalar::peakAbs(data + i, count - i);
+    return head > tail ? head : tail;
+}
+
+static double sumOfSquares(const float* data, size_t count) {
+    float64x2_t acc0 = vdupq_n_f64(0.0);
+    float64x2_t acc1 = vdupq_n_f64(0.0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t v = vld1q_f32(data + i);
+        const float32x4_t sq = vmulq_f32(v, v);
+        acc0 = vaddq_f64(acc0, vcvt_f64_f32(vget_low_f32(sq)));
+        acc1 = vaddq_f64(acc1, vcvt_high_f64_f32(sq));
+    }
+    return vaddvq_f64(vaddq_f64(acc0, acc1)) + Scalar::sumOfSquares(data + i, count - i);
+}
+
+static void interleave(const float* const* planes, float* out, size_t frames, size_t channels) {
+    if (channels != 2) {
+        Scalar::interleave(planes, out, frames, channels);
+        return;
+    }
+    const float* left = planes[0];
+    const float* right = planes[1];
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4) {
+        float32x4x2_t lr;
+        lr.val[0] = vld1q_f32(left + f);
+        lr.val[1] = vld1q_f32(right + f);
+        vst2q_f32(out + f * 2, lr);
+    }
+    const float* tailPlanes[2] = { left + f, right + f };
+    Scalar::interleave(tailPlanes, out + f * 2, frames - f, 2);
+}
+
+static void deinterleave(const float* in, float* const* planes, size_t frames, size_t channels) {
+    if (channels != 2) {
+        Scalar::deinterleave(in, planes, frames, channels);
+        return;
+    }
+    float* left = planes[0];
+    float* right = planes[1];
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4) {
+        const float32x4x2_t lr = vld2q_f32(in + f * 2);
+        vst1q_f32(left + f, lr.val[0]);
+        vst1q_f32(right + f, lr.val[1]);
+    }
+    float* tailPlanes[2] = { left + f, right + f };
+    Scalar::deinterleave(in + f * 2, tailPlanes, frames - f, 2);
+}
+
+static void downmixToMono(const float* in, float* out, size_t frames, size_t channels) {
+    if (channels != 2) {
+        Scalar::downmixToMono(in, out, frames, channels);
+        return;
+    }
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4) {
+        const float32x4x2_t lr = vld2q_f32(in + f * 2);
+        vst1q_f32(out + f, vmulq_n_f32(vaddq_f32(lr.val[0], lr.val[1]), 0.5f));
+    }
+    Scalar::downmixToMono(in + f * 2, out + f, frames - f, 2);
+}
+
+static size_t sanitize(float* data, size_t count, float limit) {
+    const float32x4_t maxFinite = vdupq_n_f32(FLT_MAX);
+    const float32x4_t minNormal = vdupq_n_f32(FLT_MIN);
+    const float32x4_t hi = vdupq_n_f32(limit);
+    const float32x4_t lo = vdupq_n_f32(-limit);
+    uint32x4_t nonFinite = vdupq_n_u32(0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t x = vld1q_f32(data + i);
+        const float32x4_t a = vabsq_f32(x);
+        const uint32x4_t finite = vcleq_f32(a, maxFinite);   // false for NaN/Inf
+        const uint32x4_t keep = vandq_u32(finite, vcgeq_f32(a, minNormal));
+        const float32x4_t clamped = vminq_f32(vmaxq_f32(x, lo), hi);
+        vst1q_f32(data + i, vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(clamped), keep)));
+        // Each non-finite lane adds 1
+        nonFinite = vsubq_u32(nonFinite, vmvnq_u32(finite));
+    }
+    return static_cast<size_t>(vaddvq_u32(nonFinite)) + Scalar::sanitize(data + i, count - i, limit);
+}
+
+} // namespace NEON
+
+static const KernelTable kNEONTable = {
+    ISA::NEON,
+    "neon",
+    NEON::floatToInt16,
+    NEON::int16ToFloat,
+    NEON::floatToInt24,
+    NEON::int24ToFloat,
+    NEON::applyGain,
+    NEON::applyGainRamp,
+    NEON::multiply,
+    NEON::peakAbs,
+    NEON::sumOfSquares,
+    NEON::interleave,
+    NEON::deinterleave,
+    NEON::downmixToMono,
+    NEON::sanitize,
+};
+
+const KernelTable* neonTable() { return &kNEONTable; }
+
+} // namespace Kernels
+} // namespace Cymax
+
+#else
+
+namespace Cymax {
+namespace Kernels {
+
+const KernelTable* neonTable() { return nullptr; }
+
+} // namespace Kernels
+} // namespace Cymax
+
+#endif
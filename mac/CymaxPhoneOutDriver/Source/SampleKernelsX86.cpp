@@ -0,0 +1,526 @@
+//
+//  SampleKernelsX86.cpp
+//  CymaxPhoneOutDriver
+//
+//  SSE2 and AVX2 sample kernels (Intel Macs, Linux x86_64)
+//
+//  SSE2 is baseline on x86_64 and needs no special compiler flags.
+//  AVX2 functions are compiled with a per-function target attribute so
+//  this file builds without -mavx2 and is only entered after the
+//  dispatcher has confirmed CPU support.
+//
+
+#include "SampleKernelsInternal.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+#include <cfloat>
+#include <cstring>
+
+#define CYMAX_AVX2 __attribute__((target("avx2")))
+
+namespace Cymax {
+namespace Kernels {
+
+namespace SSE2 {
+
+static inline __m128 clampUnit(__m128 x) {
+    return _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+}
+
+static inline __m128 absMask() {
+    return _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+}
+
+static void floatToInt16(const float* in, int16_t* out, size_t count) {
+    const __m128 scale = _mm_set1_ps(kInt16Scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i a = _mm_cvtps_epi32(_mm_mul_ps(clampUnit(_mm_loadu_ps(in + i)), scale));
+        const __m128i b = _mm_cvtps_epi32(_mm_mul_ps(clampUnit(_mm_loadu_ps(in + i + 4)), scale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+    }
+    Scalar::floatToInt16(in + i, out + i, count - i);
+}
+
+static void int16ToFloat(const int16_t* in, float* out, size_t count) {
+    const __m128 scale = _mm_set1_ps(kInt16InvScale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // Sign-extend by placing each int16 in the high half and shifting down
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    Scalar::int16ToFloat(in + i, out + i, count - i);
+}
+
+static void floatToInt24(const float* in, uint8_t* out, size_t count) {
+    // SSE2 has no byte shuffle; convert in vector, pack bytes in scalar
+    const __m128 scale = _mm_set1_ps(kInt24Scale);
+    alignas(16) int32_t tmp[4];
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_store_si128(reinterpret_cast<__m128i*>(tmp),
+                        _mm_cvtps_epi32(_mm_mul_ps(clampUnit(_mm_loadu_ps(in + i)), scale)));
+        for (size_t k = 0; k < 4; ++k) {
+            uint8_t* dst = out + (i + k) * 3;
+            dst[0] = static_cast<uint8_t>(tmp[k]);
+            dst[1] = static_cast<uint8_t>(tmp[k] >> 8);
+            dst[2] = static_cast<uint8_t>(tmp[k] >> 16);
+        }
+    }
+    Scalar::floatToInt24(in + i, out + i * 3, count - i);
+}
+
+static void applyGain(float* data, size_t count, float gain) {
+    const __m128 g = _mm_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm_storeu_ps(data + i, _mm_mul_ps(_mm_loadu_ps(data + i), g));
+        _mm_storeu_ps(data + i + 4, _mm_mul_ps(_mm_loadu_ps(data + i + 4), g));
+    }
+    Scalar::applyGain(data + i, count - i, gain);
+}
+
+static void applyGainRamp(float* data, size_t frames, size_t channels,
+                          float startGain, float endGain) {
+    if (frames == 0) return;
+    const float step = (endGain - startGain) / static_cast<float>(frames);
+    const __m128 vStart = _mm_set1_ps(startGain);
+    const __m128 vStep = _mm_set1_ps(step);
+    size_t f = 0;
+
+    if (channels == 1) {
+        __m128 idx = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        const __m128 inc = _mm_set1_ps(4.0f);
+        for (; f + 4 <= frames; f += 4) {
+            const __m128 gain = _mm_add_ps(vStart, _mm_mul_ps(vStep, idx));
+            _mm_storeu_ps(data + f, _mm_mul_ps(_mm_loadu_ps(data + f), gain));
+            idx = _mm_add_ps(idx, inc);
+        }
+    } else if (channels == 2) {
+        // Two stereo frames per vector: gains [g0 g0 g1 g1]
+        __m128 idx = _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+        const __m128 inc = _mm_set1_ps(2.0f);
+        for (; f + 2 <= frames; f += 2) {
+            const __m128 gain = _mm_add_ps(vStart, _mm_mul_ps(vStep, idx));
+            _mm_storeu_ps(data + f * 2, _mm_mul_ps(_mm_loadu_ps(data + f * 2), gain));
+            idx = _mm_add_ps(idx, inc);
+        }
+    }
+
+    Scalar::applyGainRampFrom(data + f * channels, f, frames - f, channels, startGain, step);
+}
+
+static void multiply(const float* a, const float* b, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    Scalar::multiply(a + i, b + i, out + i, count - i);
+}
+
+static inline float horizontalMax(__m128 v) {
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(v);
+}
+
+static float peakAbs(const float* data, size_t count) {
+    const __m128 mask = absMask();
+    __m128 peak0 = _mm_setzero_ps();
+    __m128 peak1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // Sample second: maxps returns it on NaN, matching std::max(peak, x)
+        peak0 = _mm_max_ps(_mm_and_ps(_mm_loadu_ps(data + i), mask), peak0);
+        peak1 = _mm_max_ps(_mm_and_ps(_mm_loadu_ps(data + i + 4), mask), peak1);
+    }
+    const float peak = horizontalMax(_mm_max_ps(peak0, peak1));
+    const float tail = Scalar::peakAbs(data + i, count - i);
+    return peak > tail ? peak : tail;
+}
+
+static double sumOfSquares(const float* data, size_t count) {
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 v = _mm_loadu_ps(data + i);
+        const __m128 sq = _mm_mul_ps(v, v);
+        acc0 = _mm_add_pd(acc0, _mm_cvtps_pd(sq));
+        acc1 = _mm_add_pd(acc1, _mm_cvtps_pd(_mm_movehl_ps(sq, sq)));
+    }
+    const __m128d acc = _mm_add_pd(acc0, acc1);
+    double lanes[2];
+    _mm_storeu_pd(lanes, acc);
+    return lanes[0] + lanes[1] + Scalar::sumOfSquares(data + i, count - i);
+}
+
+static void interleave(const float* const* planes, float* out, size_t frames, size_t channels) {
+    if (channels != 2) {
+        Scalar::interleave(planes, out, frames, channels);
+        return;
+    }
+    const float* left = planes[0];
+    const float* right = planes[1];
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4) {
+        const __m128 l = _mm_loadu_ps(left + f);
+        const __m128 r = _mm_loadu_ps(right + f);
+        _mm_storeu_ps(out + f * 2, _mm_unpacklo_ps(l, r));
+        _mm_storeu_ps(out + f * 2 + 4, _mm_unpackhi_ps(l, r));
+    }
+    const float* tailPlanes[2] = { left + f, right + f };
+    Scalar::interleave(tailPlanes, out + f * 2, frames - f, 2);
+}
+
+static void deinterleave(const float* in, float* const* planes, size_t frames, size_t channels) {
+    if (channels != 2) {
+        Scalar::deinterleave(in, planes, frames, channels);
+        return;
+    }
+    float* left = planes[0];
+    float* right = planes[1];
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4) {
+        const __m128 a = _mm_loadu_ps(in + f * 2);       // L0 R0 L1 R1
+        const __m128 b = _mm_loadu_ps(in + f * 2 + 4);   // L2 R2 L3 R3
+        _mm_storeu_ps(left + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+    float* tailPlanes[2] = { left + f, right + f };
+    Scalar::deinterleave(in + f * 2, tailPlanes, frames - f, 2);
+}
+
+static void downmixToMono(const float* in, float* out, size_t frames, size_t channels) {
+    if (channels != 2) {
+        Scalar::downmixToMono(in, out, frames, channels);
+        return;
+    }
+    const __m128 half = _mm_set1_ps(0.5f);
+    size_t f = 0;
+    for (; f + 4 <= frames; f += 4) {
+        const __m128 a = _mm_loadu_ps(in + f * 2);
+        const __m128 b = _mm_loadu_ps(in + f * 2 + 4);
+        const __m128 l = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 r = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + f, _mm_mul_ps(_mm_add_ps(l, r), half));
+    }
+    Scalar::downmixToMono(in + f * 2, out + f, frames - f, 2);
+}
+
+static size_t sanitize(float* data, size_t count, float limit) {
+    const __m128 mask = absMask();
+    const __m128 maxFinite = _mm_set1_ps(FLT_MAX);
+    const __m128 minNormal = _mm_set1_ps(FLT_MIN);
+    const __m128 hi = _mm_set1_ps(limit);
+    const __m128 lo = _mm_set1_ps(-limit);
+    size_t replaced = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 x = _mm_loadu_ps(data + i);
+        const __m128 a = _mm_and_ps(x, mask);
+        const __m128 finite = _mm_cmple_ps(a, maxFinite);   // false for NaN/Inf
+        const __m128 normal = _mm_cmpge_ps(a, minNormal);
+        const __m128 keep = _mm_and_ps(finite, normal);
+        const __m128 clamped = _mm_min_ps(_mm_max_ps(x, lo), hi);
+        _mm_storeu_ps(data + i, _mm_and_ps(clamped, keep));
+        replaced += static_cast<size_t>(__builtin_popcount(~_mm_movemask_ps(finite) & 0xF));
+    }
+    return replaced + Scalar::sanitize(data + i, count - i, limit);
+}
+
+} // namespace SSE2
+
+namespace AVX2 {
+
+CYMAX_AVX2 static inline __m256 clampUnit(__m256 x) {
+    return _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+}
+
+CYMAX_AVX2 static inline __m256 absMask() {
+    return _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+}
+
+CYMAX_AVX2 static void floatToInt16(const float* in, int16_t* out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(kInt16Scale);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i a = _mm256_cvtps_epi32(_mm256_mul_ps(clampUnit(_mm256_loadu_ps(in + i)), scale));
+        const __m256i b = _mm256_cvtps_epi32(_mm256_mul_ps(clampUnit(_mm256_loadu_ps(in + i + 8)), scale));
+        // packs works per 128-bit lane; restore sample order afterwards
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    SSE2::floatToInt16(in + i, out + i, count - i);
+}
+
+CYMAX_AVX2 static void int16ToFloat(const int16_t* in, float* out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(kInt16InvScale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v)), scale));
+    }
+    Scalar::int16ToFloat(in + i, out + i, count - i);
+}
+
+CYMAX_AVX2 static void floatToInt24(const float* in, uint8_t* out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(kInt24Scale);
+    // Per 128-bit lane: keep the low three bytes of each int32
+    const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                          0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_cvtps_epi32(_mm256_mul_ps(clampUnit(_mm256_loadu_ps(in + i)), scale));
+        const __m256i bytes = _mm256_shuffle_epi8(v, pack);
+        alignas(32) uint8_t tmp[32];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(tmp), bytes);
+        std::memcpy(out + i * 3, tmp, 12);
+        std::memcpy(out + i * 3 + 12, tmp + 16, 12);
+    }
+    Scalar::floatToInt24(in + i, out + i * 3, count - i);
+}
+
+CYMAX_AVX2 static void int24ToFloat(const uint8_t* in, float* out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(kInt24InvScale);
+    // Per lane: move each 3-byte sample into the top of an int32
+    const __m256i unpack = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                                            -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    size_t i = 0;
+    // Each iteration reads 28 bytes (two 16-byte loads 12 bytes apart) for
+    // 8 samples, so stop while at least 10 samples remain
+    for (; i + 10 <= count; i += 8) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 3));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i * 3 + 12));
+        const __m256i v = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), unpack);
+        const __m256i s = _mm256_srai_epi32(v, 8);
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(s), scale));
+    }
+    Scalar::int24ToFloat(in + i * 3, out + i, count - i);
+}
+
+CYMAX_AVX2 static void applyGain(float* data, size_t count, float gain) {
+    const __m256 g = _mm256_set1_ps(gain);
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), g));
+        _mm256_storeu_ps(data + i + 8, _mm256_mul_ps(_mm256_loadu_ps(data + i + 8), g));
+    }
+    Scalar::applyGain(data + i, count - i, gain);
+}
+
+CYMAX_AVX2 static void applyGainRamp(float* data, size_t frames, size_t channels,
+                                     float startGain, float endGain) {
+    if (frames == 0) return;
+    const float step = (endGain - startGain) / static_cast<float>(frames);
+    const __m256 vStart = _mm256_set1_ps(startGain);
+    const __m256 vStep = _mm256_set1_ps(step);
+    size_t f = 0;
+
+    if (channels == 1) {
+        __m256 idx = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+        const __m256 inc = _mm256_set1_ps(8.0f);
+        for (; f + 8 <= frames; f += 8) {
+            const __m256 gain = _mm256_add_ps(vStart, _mm256_mul_ps(vStep, idx));
+            _mm256_storeu_ps(data + f, _mm256_mul_ps(_mm256_loadu_ps(data + f), gain));
+            idx = _mm256_add_ps(idx, inc);
+        }
+    } else if (channels == 2) {
+        __m256 idx = _mm256_setr_ps(0.0f, 0.0f, 1.0f, 1.0f, 2.0f, 2.0f, 3.0f, 3.0f);
+        const __m256 inc = _mm256_set1_ps(4.0f);
+        for (; f + 4 <= frames; f += 4) {
+            const __m256 gain = _mm256_add_ps(vStart, _mm256_mul_ps(vStep, idx));
+            _mm256_storeu_ps(data + f * 2, _mm256_mul_ps(_mm256_loadu_ps(data + f * 2), gain));
+            idx = _mm256_add_ps(idx, inc);
+        }
+    }
+
+    Scalar::applyGainRampFrom(data + f * channels, f, frames - f, channels, startGain, step);
+}
+
+CYMAX_AVX2 static void multiply(const float* a, const float* b, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    Scalar::multiply(a + i, b + i, out + i, count - i);
+}
+
+CYMAX_AVX2 static float peakAbs(const float* data, size_t count) {
+    const __m256 mask = absMask();
+    __m256 peak0 = _mm256_setzero_ps();
+    __m256 peak1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        peak0 = _mm256_max_ps(_mm256_and_ps(_mm256_loadu_ps(data + i), mask), peak0);
+        peak1 = _mm256_max_ps(_mm256_and_ps(_mm256_loadu_ps(data + i + 8), mask), peak1);
+    }
+    const __m256 peak = _mm256_max_ps(peak0, peak1);
+    __m128 v = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)));
+    const float head = _mm_cvtss_f32(v);
+    const float tail = Scalar::peakAbs(data + i, count - i);
+    return head > tail ? head : tail;
+}
+
+CYMAX_AVX2 static double sumOfSquares(const float* data, size_t count) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 v = _mm256_loadu_ps(data + i);
+        const __m256 sq = _mm256_mul_ps(v, v);
+        acc0 = _mm256_add_pd(acc0, _mm256_cvtps_pd(_mm256_castps256_ps128(sq)));
+        acc1 = _mm256_add_pd(acc1, _mm256_cvtps_pd(_mm256_extractf128_ps(sq, 1)));
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, _mm256_add_pd(acc0, acc1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + Scalar::sumOfSquares(data + i, count - i);
+}
+
+CYMAX_AVX2 static void interleave(const float* const* planes, float* out, size_t frames, size_t channels) {
+    if (channels != 2) {
+        Scalar::interleave(planes, out, frames, channels);
+        return;
+    }
+    const float* left = planes[0];
+    const float* right = planes[1];
+    size_t f = 0;
+    for (; f + 8 <= frames; f += 8) {
+        const __m256 l = _mm256_loadu_ps(left + f);
+        const __m256 r = _mm256_loadu_ps(right + f);
+        const __m256 lo = _mm256_unpacklo_ps(l, r);   // L0 R0 L1 R1 | L4 R4 L5 R5
+        const __m256 hi = _mm256_unpackhi_ps(l, r);   // L2 R2 L3 R3 | L6 R6 L7 R7
+        _mm256_storeu_ps(out + f * 2, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(out + f * 2 + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    const float* tailPlanes[2] = { left + f, right + f };
+    SSE2::interleave(tailPlanes, out + f * 2, frames - f, 2);
+}
+
+CYMAX_AVX2 static void deinterleave(const float* in, float* const* planes, size_t frames, size_t channels) {
+    if (channels != 2) {
+        Scalar::deinterleave(in, planes, frames, channels);
+        return;
+    }
+    float* left = planes[0];
+    float* right = planes[1];
+    size_t f = 0;
+    for (; f + 8 <= frames; f += 8) {
+        const __m256 a = _mm256_loadu_ps(in + f * 2);
+        const __m256 b = _mm256_loadu_ps(in + f * 2 + 8);
+        // Per lane gather, then fix the 64-bit chunk order across lanes
+        const __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm256_storeu_ps(left + f, _mm256_castpd_ps(
+            _mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3, 1, 2, 0))));
+        _mm256_storeu_ps(right + f, _mm256_castpd_ps(
+            _mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0))));
+    }
+    float* tailPlanes[2] = { left + f, right + f };
+    SSE2::deinterleave(in + f * 2, tailPlanes, frames - f, 2);
+}
+
+CYMAX_AVX2 static void downmixToMono(const float* in, float* out, size_t frames, size_t channels) {
+    if (channels != 2) {
+        Scalar::downmixToMono(in, out, frames, channels);
+        return;
+    }
+    const __m256 half = _mm256_set1_ps(0.5f);
+    size_t f = 0;
+    for (; f + 8 <= frames; f += 8) {
+        const __m256 a = _mm256_loadu_ps(in + f * 2);
+        const __m256 b = _mm256_loadu_ps(in + f * 2 + 8);
+        const __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        const __m256 sum = _mm256_mul_ps(_mm256_add_ps(l, r), half);
+        _mm256_storeu_ps(out + f, _mm256_castpd_ps(
+            _mm256_permute4x64_pd(_mm256_castps_pd(sum), _MM_SHUFFLE(3, 1, 2, 0))));
+    }
+    SSE2::downmixToMono(in + f * 2, out + f, frames - f, 2);
+}
+
+CYMAX_AVX2 static size_t sanitize(float* data, size_t count, float limit) {
+    const __m256 mask = absMask();
+    const __m256 maxFinite = _mm256_set1_ps(FLT_MAX);
+    const __m256 minNormal = _mm256_set1_ps(FLT_MIN);
+    const __m256 hi = _mm256_set1_ps(limit);
+    const __m256 lo = _mm256_set1_ps(-limit);
+    size_t replaced = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 x = _mm256_loadu_ps(data + i);
+        const __m256 a = _mm256_and_ps(x, mask);
+        const __m256 finite = _mm256_cmp_ps(a, maxFinite, _CMP_LE_OQ);
+        const __m256 normal = _mm256_cmp_ps(a, minNormal, _CMP_GE_OQ);
+        const __m256 keep = _mm256_and_ps(finite, normal);
+        const __m256 clamped = _mm256_min_ps(_mm256_max_ps(x, lo), hi);
+        _mm256_storeu_ps(data + i, _mm256_and_ps(clamped, keep));
+        replaced += static_cast<size_t>(__builtin_popcount(~_mm256_movemask_ps(finite) & 0xFF));
+    }
+    return replaced + SSE2::sanitize(data + i, count - i, limit);
+}
+
+} // namespace AVX2
+
+static const KernelTable kSSE2Table = {
+    ISA::SSE2,
+    "sse2",
+    SSE2::floatToInt16,
+    SSE2::int16ToFloat,
+    SSE2::floatToInt24,
+    Scalar::int24ToFloat,   // Needs a byte shuffle (SSSE3); scalar is as fast
+    SSE2::applyGain,
+    SSE2::applyGainRamp,
+    SSE2::multiply,
+    SSE2::peakAbs,
+    SSE2::sumOfSquares,
+    SSE2::interleave,
+    SSE2::deinterleave,
+    SSE2::downmixToMono,
+    SSE2::sanitize,
+};
+
+static const KernelTable kAVX2Table = {
+    ISA::AVX2,
+    "avx2",
+    AVX2::floatToInt16,
+    AVX2::int16ToFloat,
+    AVX2::floatToInt24,
+    AVX2::int24ToFloat,
+    AVX2::applyGain,
+    AVX2::applyGainRamp,
+    AVX2::multiply,
+    AVX2::peakAbs,
+    AVX2::sumOfSquares,
+    AVX2::interleave,
+    AVX2::deinterleave,
+    AVX2::downmixToMono,
+    AVX2::sanitize,
+};
+
+const KernelTable* sse2Table() { return &kSSE2Table; }
+const KernelTable* avx2Table() { return &kAVX2Table; }
+
+} // namespace Kernels
+} // namespace Cymax
+
+#else
+
+namespace Cymax {
+namespace Kernels {
+
+const KernelTable* sse2Table() { return nullptr; }
+const KernelTable* avx2Table() { return nullptr; }
+
+} // namespace Kernels
+} // namespace Cymax
+
+#endif
@@ -0,0 +1,81 @@
+//
+//  SenderEnvironment.hpp
+//  CymaxPhoneOutDriver
+//
+//  Clock, sleeper and transport used by UDPSender's threads
+//
+//  Everything the sender does that depends on real time or the network
+//  goes through SenderEnvironment: reading the clock, timed sleeps,
+//  sendto(), recvfrom() and waiting for the socket to drain. The type is chosen at
+//  compile time, so the driver calls the system directly (every member
+//  is a static inline that compiles to the same code as before).
+//
+//  A simulation build swaps in its own environment by pre-including a
+//  header that defines it and naming it in CYMAX_SENDER_ENVIRONMENT, e.g.
+//      -include SimulatedEnvironment.hpp
+//      -DCYMAX_SENDER_ENVIRONMENT=SimulatedEnvironment
+//  It must provide the same static members with the same semantics:
+//  sendTo() and receiveFrom() return -1 and set errno like sendto() and
+//  recvfrom(), and nowNanos() only moves forward. Waits on other threads (parking, queue hand-off) are
+//  not timing behavior and stay on the real primitives.
+//
+
+#ifndef SenderEnvironment_hpp
+#define SenderEnvironment_hpp
+
+#include "MonotonicClock.hpp"
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <time.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace Cymax {
+
+/// The real clock, nanosleep() and a BSD socket
+struct SystemSenderEnvironment {
+    /// Monotonic time in nanoseconds
+    static uint64_t nowNanos() {
+        return MonotonicClock::nowNanos();
+    }
+
+    /// Sleep for up to a second (may wake late, never early)
+    static void sleepNanos(uint64_t nanos) {
+        struct timespec ts = {0, static_cast<long>(nanos)};
+        nanosleep(&ts, nullptr);
+    }
+
+    /// sendto() on a non-blocking datagram socket
+    /// @return Bytes sent, or -1 with errno set
+    static ssize_t sendTo(int socket, const uint8_t* data, size_t size, const struct sockaddr_in& addr) {
+        return sendto(socket, data, size, 0, reinterpret_cast<const struct sockaddr*>(&addr), sizeof(addr));
+    }
+
+    /// recvfrom() without waiting
+    /// @return Bytes received, or -1 with errno set (EAGAIN if none)
+    static ssize_t receiveFrom(int socket, uint8_t* data, size_t capacity, struct sockaddr_in& from) {
+        socklen_t length = sizeof(from);
+        return recvfrom(socket, data, capacity, MSG_DONTWAIT, reinterpret_cast<struct sockaddr*>(&from), &length);
+    }
+
+    /// Wait until the socket reports room to send, or the timeout passes
+    /// @return true if writable
+    static bool waitWritable(int socket, uint64_t timeoutNanos) {
+        struct pollfd pfd = {socket, POLLOUT, 0};
+        const int timeoutMs = static_cast<int>((timeoutNanos + 999999) / 1000000);
+        return poll(&pfd, 1, timeoutMs) > 0;
+    }
+};
+
+#ifndef CYMAX_SENDER_ENVIRONMENT
+#define CYMAX_SENDER_ENVIRONMENT SystemSenderEnvironment
+#endif
+
+/// Environment the sender is compiled against
+using SenderEnvironment = CYMAX_SENDER_ENVIRONMENT;
+
+} // namespace Cymax
+
+#endif /* SenderEnvironment_hpp */
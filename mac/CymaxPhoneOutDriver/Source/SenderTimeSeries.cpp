@@ -0,0 +1,149 @@
+//
+//  SenderTimeSeries.cpp
+//  CymaxPhoneOutDriver
+//
+//  Sender time series implementation
+//
+
+#include "SenderTimeSeries.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace Cymax {
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "Shared page sequence must be lock-free to work across processes");
+
+bool SenderTimeSeries::openSharedPage(const char* name) {
+    if (!m_sharedRegion.open(name, sizeof(SenderStatsSharedPage))) {
+        return false;
+    }
+
+    SenderStatsSharedPage* page = new (m_sharedRegion.data()) SenderStatsSharedPage;
+    page->magic = SenderStatsSharedPage::kMagic;
+    page->version = SenderStatsSharedPage::kVersion;
+    page->sequence.store(0, std::memory_order_relaxed);
+    page->reserved = 0;
+    std::memset(&page->snapshot, 0, sizeof(page->snapshot));
+    return true;
+}
+
+void SenderTimeSeries::reset(const SenderCounterTotals& totals) {
+    m_newest = 0;
+    m_count = 0;
+    m_sequence = 0;
+    m_lastTotals = totals;
+
+    SenderRateSnapshot& out = m_published.writeSlot();
+    std::memset(&out, 0, sizeof(out));
+    publish(out);
+}
+
+void SenderTimeSeries::closeSecond(uint64_t elapsedNanos, const SenderCounterTotals& totals, uint64_t maxSendNanos,
+                                   uint64_t fillSamples, double meanFillFrames, size_t maxFillFrames) {
+    m_newest = (m_newest + 1) % SenderRateSnapshot::kHistorySeconds;
+    m_count = std::min(m_count + 1, SenderRateSnapshot::kHistorySeconds);
+
+    Second& second = m_seconds[m_newest];
+    second.elapsedNanos = std::max<uint64_t>(1, elapsedNanos);
+    second.delta.packetsSent = totals.packetsSent - m_lastTotals.packetsSent;
+    second.delta.bytesSent = totals.bytesSent - m_lastTotals.bytesSent;
+    second.delta.packetsDropped = totals.packetsDropped - m_lastTotals.packetsDropped;
+    second.delta.framesDropped = totals.framesDropped - m_lastTotals.framesDropped;
+    second.delta.wouldBlock = totals.wouldBlock - m_lastTotals.wouldBlock;
+    second.delta.sendCount = totals.sendCount - m_lastTotals.sendCount;
+    second.delta.sendNanos = totals.sendNanos - m_lastTotals.sendNanos;
+    second.maxSendNanos = maxSendNanos;
+    second.fillSamples = fillSamples;
+    second.fillSum = meanFillFrames * static_cast<double>(fillSamples);
+    second.maxFillFrames = maxFillFrames;
+    m_lastTotals = totals;
+
+    SenderRateSnapshot& out = m_published.writeSlot();
+    out.sequence = ++m_sequence;
+    out.historyCount = m_count;
+    for (uint32_t w = 0; w < SenderRateSnapshot::kWindows; ++w) {
+        out.windows[w] = summarize(SenderRateSnapshot::kWindowSeconds[w]);
+    }
+    for (uint32_t i = 0; i < SenderRateSnapshot::kHistorySeconds; ++i) {
+        SenderRateSecond& entry = out.history[i];
+        if (i >= m_count) {
+            std::memset(&entry, 0, sizeof(entry));
+            continue;
+        }
+        const Second& s = m_seconds[(m_newest + SenderRateSnapshot::kHistorySeconds - i) % SenderRateSnapshot::kHistorySeconds];
+        entry.packetsSent = static_cast<uint32_t>(s.delta.packetsSent);
+        entry.packetsDropped = static_cast<uint32_t>(s.delta.packetsDropped);
+        entry.framesDropped = static_cast<uint32_t>(s.delta.framesDropped);
+        entry.wouldBlock = static_cast<uint32_t>(s.delta.wouldBlock);
+        entry.maxSendLatencyMicros = static_cast<float>(s.maxSendNanos) / 1000.0f;
+        entry.maxFillFrames = static_cast<uint32_t>(s.maxFillFrames);
+    }
+    publish(out);
+}
+
+SenderRateWindow SenderTimeSeries::summarize(uint32_t seconds) const {
+    SenderRateWindow window = {};
+    window.seconds = std::min(seconds, m_count);
+    if (window.seconds == 0) {
+        return window;
+    }
+
+    SenderCounterTotals sum;
+    uint64_t elapsedNanos = 0;
+    uint64_t maxSendNanos = 0;
+    uint64_t fillSamples = 0;
+    double fillSum = 0.0;
+    size_t maxFill = 0;
+    for (uint32_t i = 0; i < window.seconds; ++i) {
+        const Second& s = m_seconds[(m_newest + SenderRateSnapshot::kHistorySeconds - i) % SenderRateSnapshot::kHistorySeconds];
+        elapsedNanos += s.elapsedNanos;
+        sum.packetsSent += s.delta.packetsSent;
+        sum.bytesSent += s.delta.bytesSent;
+        sum.packetsDropped += s.delta.packetsDropped;
+        sum.framesDropped += s.delta.framesDropped;
+        sum.wouldBlock += s.delta.wouldBlock;
+        sum.sendCount += s.delta.sendCount;
+        sum.sendNanos += s.delta.sendNanos;
+        maxSendNanos = std::max(maxSendNanos, s.maxSendNanos);
+        fillSamples += s.fillSamples;
+        fillSum += s.fillSum;
+        maxFill = std::max(maxFill, s.maxFillFrames);
+    }
+
+    const double perSecond = 1e9 / static_cast<double>(elapsedNanos);
+    window.packetsPerSecond = static_cast<float>(static_cast<double>(sum.packetsSent) * perSecond);
+    window.bitsPerSecond = static_cast<float>(static_cast<double>(sum.bytesSent) * 8.0 * perSecond);
+    const uint64_t attempted = sum.packetsSent + sum.packetsDropped;
+    window.lossPercent = attempted > 0
+        ? static_cast<float>(100.0 * static_cast<double>(sum.packetsDropped) / static_cast<double>(attempted))
+        : 0.0f;
+    window.framesDroppedPerSecond = static_cast<float>(static_cast<double>(sum.framesDropped) * perSecond);
+    window.wouldBlockPerSecond = static_cast<float>(static_cast<double>(sum.wouldBlock) * perSecond);
+    window.meanSendLatencyMicros = sum.sendCount > 0
+        ? static_cast<float>(static_cast<double>(sum.sendNanos) / static_cast<double>(sum.sendCount) / 1000.0)
+        : 0.0f;
+    window.maxSendLatencyMicros = static_cast<float>(maxSendNanos) / 1000.0f;
+    window.meanFillFrames = fillSamples > 0 ? static_cast<float>(fillSum / static_cast<double>(fillSamples)) : 0.0f;
+    window.maxFillFrames = static_cast<uint32_t>(maxFill);
+    return window;
+}
+
+void SenderTimeSeries::publish(const SenderRateSnapshot& snapshot) {
+    if (SenderStatsSharedPage* page = static_cast<SenderStatsSharedPage*>(m_sharedRegion.data())) {
+        const uint32_t seq = page->sequence.load(std::memory_order_relaxed);
+        page->sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&page->snapshot, &snapshot, sizeof(snapshot));
+        page->sequence.store(seq + 2, std::memory_order_release);
+    }
+    m_published.publish();
+}
+
+SenderRateSnapshot SenderTimeSeries::latest() const {
+    return m_published.read();
+}
+
+} // namespace Cymax
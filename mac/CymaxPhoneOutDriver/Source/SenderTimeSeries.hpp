@@ -0,0 +1,168 @@
+//
+//  SenderTimeSeries.hpp
+//  CymaxPhoneOutDriver
+//
+//  Rolling per-second history of the UDP sender's counters
+//
+//  The sender's counters are lifetime totals. Once a second the thread
+//  reading the source hands their current values to closeSecond(), which
+//  keeps the difference as one entry of a kHistorySeconds ring (fixed
+//  memory, nothing allocated after construction) and derives rates over
+//  the last 1, 10 and 60 seconds from it. Results go to:
+//  - a TripleBuffer the device reads for its rates property
+//  - a shared page (kSharedPageName, read-only to others) for the
+//    menubar app
+//  Both hold one complete SenderRateSnapshot, so every reader sees a
+//  consistent second.
+//
+
+#ifndef SenderTimeSeries_hpp
+#define SenderTimeSeries_hpp
+
+#include "SharedMemoryRegion.hpp"
+#include "TripleBuffer.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Cymax {
+
+/// Lifetime sender totals sampled once a second
+struct SenderCounterTotals {
+    uint64_t packetsSent = 0;        // Audio packets that left the socket
+    uint64_t bytesSent = 0;          // All packets, headers included
+    uint64_t packetsDropped = 0;     // Dropped by the sender (errors, deadline, overflow)
+    uint64_t framesDropped = 0;      // Source frames dropped (sender behind)
+    uint64_t wouldBlock = 0;         // sendto() pushed back (EAGAIN/ENOBUFS)
+    uint64_t sendCount = 0;          // Transmit stage packets
+    uint64_t sendNanos = 0;          // Transmit stage latency, summed
+};
+
+/// Rates over one rolling window
+struct SenderRateWindow {
+    uint32_t seconds;                // Seconds of history covered (less right after start)
+    float packetsPerSecond;          // Audio packets sent
+    float bitsPerSecond;             // All packets, headers included
+    float lossPercent;               // Dropped / (sent + dropped), sender side only
+    float framesDroppedPerSecond;
+    float wouldBlockPerSecond;
+    float meanSendLatencyMicros;     // Transmit stage, including queue wait
+    float maxSendLatencyMicros;
+    float meanFillFrames;            // Source ring fill seen by the sender
+    uint32_t maxFillFrames;
+};
+
+/// One second of history
+struct SenderRateSecond {
+    uint32_t packetsSent;
+    uint32_t packetsDropped;
+    uint32_t framesDropped;
+    uint32_t wouldBlock;
+    float maxSendLatencyMicros;
+    uint32_t maxFillFrames;
+};
+
+/// Everything published once a second
+struct SenderRateSnapshot {
+    static constexpr uint32_t kHistorySeconds = 60;
+    static constexpr uint32_t kWindows = 3;
+
+    /// Window lengths in seconds, in windows[] order
+    static constexpr uint32_t kWindowSeconds[kWindows] = {1, 10, 60};
+
+    /// Seconds closed since the session started (0 = nothing yet)
+    uint32_t sequence;
+
+    /// Valid entries in history
+    uint32_t historyCount;
+
+    SenderRateWindow windows[kWindows];
+
+    /// history[0] is the last completed second, history[1] the one
+    /// before, and so on
+    SenderRateSecond history[kHistorySeconds];
+};
+
+static_assert(sizeof(SenderRateWindow) == 40, "SenderRateWindow is read by the menubar app");
+static_assert(sizeof(SenderRateSecond) == 24, "SenderRateSecond is read by the menubar app");
+static_assert(sizeof(SenderRateSnapshot) == 8 + 3 * 40 + 60 * 24, "SenderRateSnapshot is read by the menubar app");
+
+/// Layout of the shared stats page
+/// Seqlock: sequence is odd while the driver is writing. Readers copy
+/// the snapshot and retry if sequence was odd or changed meanwhile.
+struct SenderStatsSharedPage {
+    static constexpr uint32_t kMagic = 0x43535453;  // 'CSTS'
+    static constexpr uint32_t kVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> sequence;
+    uint32_t reserved;
+    SenderRateSnapshot snapshot;
+};
+
+/// Per-second history and rolling rates of the sender
+/// reset() and closeSecond() from one thread at a time (the sender
+/// thread that reads the source); latest() from any thread.
+class SenderTimeSeries {
+public:
+    SenderTimeSeries() = default;
+
+    // Non-copyable
+    SenderTimeSeries(const SenderTimeSeries&) = delete;
+    SenderTimeSeries& operator=(const SenderTimeSeries&) = delete;
+
+    /// Map the shared page (optional; skipped if not open)
+    /// @param name Page name in SharedMemoryRegion::kDirectory
+    bool openSharedPage(const char* name);
+
+    /// Start a new session from these totals (history is cleared)
+    void reset(const SenderCounterTotals& totals);
+
+    /// Close the second that just ended and publish
+    /// @param elapsedNanos How long the second actually lasted
+    /// @param totals Current lifetime totals
+    /// @param maxSendNanos Longest transmit during the second
+    /// @param fillSamples Fill observations during the second
+    /// @param meanFillFrames Their mean
+    /// @param maxFillFrames Their maximum
+    void closeSecond(uint64_t elapsedNanos, const SenderCounterTotals& totals, uint64_t maxSendNanos,
+                     uint64_t fillSamples, double meanFillFrames, size_t maxFillFrames);
+
+    /// Latest published snapshot
+    SenderRateSnapshot latest() const;
+
+    static constexpr const char* kSharedPageName = "stats.shm";
+
+private:
+    /// One closed second (deltas of the totals)
+    struct Second {
+        uint64_t elapsedNanos;
+        SenderCounterTotals delta;
+        uint64_t maxSendNanos;
+        uint64_t fillSamples;
+        double fillSum;
+        size_t maxFillFrames;
+    };
+
+    /// Rates over the newest `seconds` entries
+    SenderRateWindow summarize(uint32_t seconds) const;
+
+    void publish(const SenderRateSnapshot& snapshot);
+
+    // Writer thread only
+    Second m_seconds[SenderRateSnapshot::kHistorySeconds] = {};
+    uint32_t m_newest = 0;           // Index of the newest entry
+    uint32_t m_count = 0;
+    uint32_t m_sequence = 0;
+    SenderCounterTotals m_lastTotals;
+
+    // latest() may be called from several HAL threads
+    SharedTripleBuffer<SenderRateSnapshot> m_published;
+
+    SharedMemoryRegion m_sharedRegion;
+};
+
+} // namespace Cymax
+
+#endif /* SenderTimeSeries_hpp */
@@ -0,0 +1,139 @@
+//
+//  SharedMemoryRegion.cpp
+//  CymaxPhoneOutDriver
+//
+//  File-backed shared memory mapping implementation
+//
+
+#include "SharedMemoryRegion.hpp"
+#include "AudioFile.hpp"
+#include "Logging.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+
+namespace Cymax {
+
+/// Open kDirectory, creating it if needed, if it belongs to us alone
+/// @return Directory descriptor, or -1
+static int openSharedDirectory() {
+    const char* path = SharedMemoryRegion::kDirectory;
+    if (mkdir(path, 0755) < 0 && errno != EEXIST) {
+        CYMAX_LOG_ERROR("SharedMemoryRegion: cannot create %{public}s: %{public}s", path, strerror(errno));
+        return -1;
+    }
+
+    // Someone else may have made the directory (or a symlink in its place)
+    const int directory = ::open(path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+    if (directory < 0) {
+        CYMAX_LOG_ERROR("SharedMemoryRegion: cannot open %{public}s: %{public}s", path, strerror(errno));
+        return -1;
+    }
+    struct stat info;
+    if (fstat(directory, &info) < 0 || info.st_uid != geteuid() || (info.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+        CYMAX_LOG_ERROR("SharedMemoryRegion: %{public}s isn't ours alone, not sharing pages in it", path);
+        ::close(directory);
+        return -1;
+    }
+    return directory;
+}
+
+/// Whether an existing page can be reused as is
+static bool isOurPage(int fd, mode_t mode) {
+    struct stat info;
+    return fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_uid == geteuid() && info.st_nlink == 1 &&
+           (info.st_mode & 07777) == mode;
+}
+
+/// Open the page, reusing ours or creating it afresh
+/// @param created Set when this call made the file
+/// @return File descriptor, or -1
+static int openPage(int directory, const char* name, mode_t mode, bool& created) {
+    created = false;
+    const int existing = openat(directory, name, O_RDWR | O_NOFOLLOW);
+    if (existing >= 0 && isOurPage(existing, mode)) {
+        return existing;
+    }
+    if (existing >= 0 || errno != ENOENT) {
+        // Left by an older driver with another mode, or not a file of ours
+        // at all; only we can write the directory, so it's ours to remove
+        if (existing >= 0) {
+            ::close(existing);
+        }
+        CYMAX_LOG_INFO("SharedMemoryRegion: replacing %{public}s", name);
+        if (unlinkat(directory, name, 0) < 0 && errno != ENOENT) {
+            return -1;
+        }
+    }
+
+    const int fd = openat(directory, name, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW, mode);
+    if (fd < 0) {
+        return -1;
+    }
+    // umask may have narrowed the mode; the file is ours, we just made it
+    fchmod(fd, mode);
+    created = true;
+    return fd;
+}
+
+SharedMemoryRegion::~SharedMemoryRegion() {
+    close();
+}
+
+bool SharedMemoryRegion::open(const char* name, size_t size, mode_t mode) {
+    close();
+
+    if (!AudioFile::isPlainFileName(name)) {
+        CYMAX_LOG_ERROR("SharedMemoryRegion: rejected page name (plain file names only)");
+        return false;
+    }
+    const int directory = openSharedDirectory();
+    if (directory < 0) {
+        return false;
+    }
+    bool created = false;
+    const int fd = openPage(directory, name, mode, created);
+    const int error = errno;
+    ::close(directory);
+    if (fd < 0) {
+        CYMAX_LOG_ERROR("SharedMemoryRegion: open %{public}s in %{public}s failed: %{public}s", name, kDirectory,
+                        strerror(error));
+        return false;
+    }
+
+    // Leave a page already sized alone (readers may have it mapped)
+    struct stat info;
+    const bool sized = !created && fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(size);
+    if (!sized && ftruncate(fd, static_cast<off_t>(size)) < 0) {
+        CYMAX_LOG_ERROR("SharedMemoryRegion: ftruncate %{public}s failed: %{public}s", name, strerror(errno));
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping keeps the file referenced
+
+    if (data == MAP_FAILED) {
+        CYMAX_LOG_ERROR("SharedMemoryRegion: mmap %{public}s failed: %{public}s", name, strerror(errno));
+        return false;
+    }
+
+    m_data = data;
+    m_size = size;
+    CYMAX_LOG_INFO("SharedMemoryRegion: mapped %{public}s/%{public}s (%zu bytes)", kDirectory, name, size);
+    return true;
+}
+
+void SharedMemoryRegion::close() {
+    if (m_data) {
+        munmap(m_data, m_size);
+        m_data = nullptr;
+        m_size = 0;
+    }
+}
+
+} // namespace Cymax
@@ -0,0 +1,65 @@
+//
+//  SharedMemoryRegion.hpp
+//  CymaxPhoneOutDriver
+//
+//  File-backed shared memory mapping
+//
+//  The driver runs inside coreaudiod, so pages it shares with the
+//  menubar app are files mapped MAP_SHARED. They live in kDirectory,
+//  which belongs to the driver's user and is writable by nobody else:
+//  install_driver.sh creates it (owned by _coreaudiod, group admin, so
+//  the console user can reach the pages), and the driver creates it on
+//  first use otherwise. Nobody else can plant a symlink or a file of
+//  their own there, and the driver only ever changes files it made.
+//
+
+#ifndef SharedMemoryRegion_hpp
+#define SharedMemoryRegion_hpp
+
+#include <cstddef>
+#include <sys/types.h>
+
+namespace Cymax {
+
+/// A read-write MAP_SHARED mapping of a file
+class SharedMemoryRegion {
+public:
+    /// Directory holding every shared page
+#if defined(__APPLE__)
+    static constexpr const char* kDirectory = "/Users/Shared/CymaxPhoneOutShared";
+#else
+    static constexpr const char* kDirectory = "/tmp/CymaxPhoneOutShared";
+#endif
+
+    SharedMemoryRegion() = default;
+    ~SharedMemoryRegion();
+
+    // Non-copyable
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    /// Create (or reuse) a page in kDirectory, size it and map it
+    /// A file already there is reused only if it is a regular file of
+    /// ours with exactly this mode; anything else is replaced.
+    /// @param name Plain file name within kDirectory
+    /// @param size Mapping size in bytes
+    /// @param mode File mode (0644: only the driver writes; 0660 for pages
+    ///        the menubar app writes, through the directory's group)
+    /// @return true if the region is mapped
+    bool open(const char* name, size_t size, mode_t mode = 0644);
+
+    /// Unmap the region (the file is left in place for readers)
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    void* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    void* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+} // namespace Cymax
+
+#endif /* SharedMemoryRegion_hpp */
@@ -0,0 +1,173 @@
+//
+//  SpectrumAnalyzer.cpp
+//  CymaxPhoneOutDriver
+//
+//  Log-frequency spectrum implementation
+//
+
+#include "SpectrumAnalyzer.hpp"
+#include "SampleKernels.hpp"
+#include "Logging.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+
+namespace Cymax {
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "Shared page sequence must be lock-free to work across processes");
+
+SpectrumAnalyzer::SpectrumAnalyzer()
+    : m_fft(kFFTSize)
+{
+    const double pi = 3.14159265358979323846;
+
+    m_window.resize(kFFTSize);
+    double windowSum = 0.0;
+    for (size_t i = 0; i < kFFTSize; ++i) {
+        m_window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * static_cast<double>(i) / kFFTSize));
+        windowSum += m_window[i];
+    }
+    // A full-scale sine peaks at |X| = windowSum / 2
+    m_normDB = static_cast<float>(20.0 * std::log10(windowSum / 2.0));
+
+    m_history.assign(kFFTSize, 0.0f);
+    m_frame.assign(kFFTSize, 0.0f);
+    m_power.assign(m_fft.binCount(), 0.0f);
+    computeBandEdges();
+}
+
+void SpectrumAnalyzer::computeBandEdges() {
+    const double binHz = m_sampleRate / static_cast<double>(kFFTSize);
+    const size_t bins = m_fft.binCount();
+    const double ratio = static_cast<double>(kMaxFrequency) / kMinFrequency;
+
+    m_bandEdges[0] = std::min(bins, static_cast<size_t>(std::lround(kMinFrequency / binHz)));
+    for (size_t b = 1; b <= SpectrumSnapshot::kBands; ++b) {
+        const double f = kMinFrequency * std::pow(ratio, static_cast<double>(b) / SpectrumSnapshot::kBands);
+        size_t edge = static_cast<size_t>(std::lround(f / binHz));
+        // Low bands are narrower than a bin; give each at least one
+        edge = std::max(edge, m_bandEdges[b - 1] + 1);
+        m_bandEdges[b] = std::min(edge, bins);
+    }
+}
+
+void SpectrumAnalyzer::prepare(double sampleRate, size_t channels, size_t maxFrames) {
+    m_sampleRate = sampleRate;
+    m_channels = std::max<size_t>(1, channels);
+    m_mono.assign(maxFrames, 0.0f);
+    std::fill(m_history.begin(), m_history.end(), 0.0f);
+    m_historyPos = 0;
+    computeBandEdges();
+
+    if (SpectrumSharedPage* page = static_cast<SpectrumSharedPage*>(m_sharedRegion.data())) {
+        page->sampleRate = static_cast<uint32_t>(sampleRate);
+    }
+}
+
+bool SpectrumAnalyzer::openSharedPage(const char* name) {
+    if (!m_sharedRegion.open(name, sizeof(SpectrumSharedPage))) {
+        return false;
+    }
+
+    SpectrumSharedPage* page = new (m_sharedRegion.data()) SpectrumSharedPage;
+    page->magic = SpectrumSharedPage::kMagic;
+    page->version = SpectrumSharedPage::kVersion;
+    page->sequence.store(0, std::memory_order_relaxed);
+    page->bandCount = SpectrumSnapshot::kBands;
+    page->sampleRate = static_cast<uint32_t>(m_sampleRate);
+    page->minFrequency = kMinFrequency;
+    page->maxFrequency = kMaxFrequency;
+    page->floorDB = kFloorDB;
+    std::fill(std::begin(page->bandsDB), std::end(page->bandsDB), kFloorDB);
+    return true;
+}
+
+void SpectrumAnalyzer::process(const float* samples, size_t frames) {
+    const Kernels::KernelTable& kernels = Kernels::active();
+
+    // Only the newest kFFTSize samples matter
+    if (frames > kFFTSize) {
+        samples += (frames - kFFTSize) * m_channels;
+        frames = kFFTSize;
+    }
+    kernels.downmixToMono(samples, m_mono.data(), frames, m_channels);
+    appendHistory(frames);
+}
+
+void SpectrumAnalyzer::processPlanar(const float* const* planes, size_t frames) {
+    if (m_channels == 0) {
+        return;
+    }
+    const size_t skip = frames > kFFTSize ? frames - kFFTSize : 0;
+    frames -= skip;
+
+    // Channels summed in order, then scaled, as downmixToMono does
+    float* mono = m_mono.data();
+    std::memcpy(mono, planes[0] + skip, frames * sizeof(float));
+    for (size_t c = 1; c < m_channels; ++c) {
+        const float* plane = planes[c] + skip;
+        for (size_t f = 0; f < frames; ++f) {
+            mono[f] += plane[f];
+        }
+    }
+    Kernels::active().applyGain(mono, frames, 1.0f / static_cast<float>(m_channels));
+    appendHistory(frames);
+}
+
+void SpectrumAnalyzer::appendHistory(size_t frames) {
+    const size_t first = std::min(frames, kFFTSize - m_historyPos);
+    std::memcpy(m_history.data() + m_historyPos, m_mono.data(), first * sizeof(float));
+    std::memcpy(m_history.data(), m_mono.data() + first, (frames - first) * sizeof(float));
+    m_historyPos = (m_historyPos + frames) % kFFTSize;
+}
+
+void SpectrumAnalyzer::publish() {
+    const Kernels::KernelTable& kernels = Kernels::active();
+
+    // Unroll the history oldest-first and window it
+    const size_t tail = kFFTSize - m_historyPos;
+    std::memcpy(m_frame.data(), m_history.data() + m_historyPos, tail * sizeof(float));
+    std::memcpy(m_frame.data() + tail, m_history.data(), m_historyPos * sizeof(float));
+    kernels.multiply(m_frame.data(), m_window.data(), m_frame.data(), kFFTSize);
+
+    m_fft.powerSpectrum(m_frame.data(), m_power.data());
+
+    SpectrumSnapshot& out = m_published.writeSlot();
+    out.sequence = ++m_sequence;
+    for (size_t b = 0; b < SpectrumSnapshot::kBands; ++b) {
+        float peak = 0.0f;
+        for (size_t k = m_bandEdges[b]; k < m_bandEdges[b + 1]; ++k) {
+            peak = std::max(peak, m_power[k]);
+        }
+        const float db = peak > 0.0f ? 10.0f * std::log10(peak) - m_normDB : kFloorDB;
+        out.bandsDB[b] = std::max(kFloorDB, db);
+    }
+
+    if (SpectrumSharedPage* page = static_cast<SpectrumSharedPage*>(m_sharedRegion.data())) {
+        const uint32_t seq = page->sequence.load(std::memory_order_relaxed);
+        page->sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(page->bandsDB, out.bandsDB, sizeof(page->bandsDB));
+        page->sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    m_published.publish();
+}
+
+bool SpectrumAnalyzer::takeLatest(SpectrumSnapshot& out) {
+    if (!m_published.hasNewData()) {
+        return false;
+    }
+    const SpectrumSnapshot& latest = m_published.read();
+    if (latest.sequence == m_lastTaken) {
+        return false;
+    }
+    m_lastTaken = latest.sequence;
+    out = latest;
+    return true;
+}
+
+} // namespace Cymax
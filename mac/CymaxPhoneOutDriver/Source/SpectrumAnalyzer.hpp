@@ -0,0 +1,119 @@
+//
+//  SpectrumAnalyzer.hpp
+//  CymaxPhoneOutDriver
+//
+//  Log-frequency spectrum for visualizers
+//
+//  Downmixes to mono, applies a Hann window to the latest kFFTSize
+//  samples and folds the power spectrum into kBands log-spaced bands
+//  (the loudest bin in each band). Results go to:
+//  - a shared page (kSharedPageName, read-only to others) for the
+//    menubar app
+//  - a TripleBuffer the UDP sender reads for side-channel packets
+//
+
+#ifndef SpectrumAnalyzer_hpp
+#define SpectrumAnalyzer_hpp
+
+#include "AudioAnalyzer.hpp"
+#include "RealFFT.hpp"
+#include "SharedMemoryRegion.hpp"
+#include "TripleBuffer.hpp"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace Cymax {
+
+/// One spectrum frame
+struct SpectrumSnapshot {
+    static constexpr uint32_t kBands = 64;
+
+    /// Incremented on every publish (0 = never published)
+    uint32_t sequence;
+
+    /// Band levels in dB relative to a full-scale sine
+    float bandsDB[kBands];
+};
+
+/// Layout of the shared spectrum page
+/// Seqlock: sequence is odd while the driver is writing. Readers copy
+/// the page and retry if sequence was odd or changed meanwhile.
+struct SpectrumSharedPage {
+    static constexpr uint32_t kMagic = 0x43535043;  // 'CSPC'
+    static constexpr uint32_t kVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> sequence;
+    uint32_t bandCount;
+    uint32_t sampleRate;
+    float minFrequency;
+    float maxFrequency;
+    float floorDB;
+    float bandsDB[SpectrumSnapshot::kBands];
+};
+
+/// Spectrum analyzer
+class SpectrumAnalyzer : public AudioAnalyzer {
+public:
+    SpectrumAnalyzer();
+    ~SpectrumAnalyzer() override = default;
+
+    // AudioAnalyzer overrides
+    const char* name() const override { return "spectrum"; }
+    void prepare(double sampleRate, size_t channels, size_t maxFrames) override;
+    void process(const float* samples, size_t frames) override;
+    bool acceptsPlanar() const override { return true; }
+    void processPlanar(const float* const* planes, size_t frames) override;
+    void publish() override;
+
+    /// Map the shared page (optional; publish() skips it if not open)
+    /// @param name Page name in SharedMemoryRegion::kDirectory
+    bool openSharedPage(const char* name);
+
+    /// Take the latest spectrum if newer than the last call
+    /// Single reader only (the UDP sender thread)
+    bool takeLatest(SpectrumSnapshot& out);
+
+    static constexpr size_t kFFTSize = 2048;
+    static constexpr float kMinFrequency = 20.0f;
+    static constexpr float kMaxFrequency = 20000.0f;
+    static constexpr float kFloorDB = -120.0f;
+    static constexpr const char* kSharedPageName = "spectrum.shm";
+
+private:
+    void computeBandEdges();
+
+    /// Append the first frames of m_mono to the history
+    void appendHistory(size_t frames);
+
+    double m_sampleRate = 48000.0;
+    size_t m_channels = 2;
+
+    RealFFT m_fft;
+
+    // Hann window and its amplitude normalization
+    std::vector<float> m_window;
+    float m_normDB = 0.0f;
+
+    // Mono history (circular, kFFTSize) and scratch
+    std::vector<float> m_history;
+    size_t m_historyPos = 0;
+    std::vector<float> m_mono;
+    std::vector<float> m_frame;
+    std::vector<float> m_power;
+
+    // First FFT bin of each band; band b covers [edge[b], edge[b+1])
+    size_t m_bandEdges[SpectrumSnapshot::kBands + 1] = {};
+
+    uint32_t m_sequence = 0;
+    TripleBuffer<SpectrumSnapshot> m_published;
+    uint32_t m_lastTaken = 0;
+
+    SharedMemoryRegion m_sharedRegion;
+};
+
+} // namespace Cymax
+
+#endif /* SpectrumAnalyzer_hpp */
@@ -0,0 +1,197 @@
+//
+//  ThreadPriority.cpp
+//  CymaxPhoneOutDriver
+//
+//  Real-time scheduling implementation
+//
+
+#include "ThreadPriority.hpp"
+#include "Logging.hpp"
+#include "MonotonicClock.hpp"
+
+#include <pthread.h>
+#include <errno.h>
+#include <cstring>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#include <mach/thread_policy.h>
+#elif defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Cymax {
+
+namespace ThreadPriority {
+
+#if defined(__APPLE__)
+
+static uint32_t nanosToMachTime(uint64_t nanos) {
+    return static_cast<uint32_t>(MonotonicClock::toTicks(nanos));
+}
+
+ThreadSchedulingClass setRealtime(const RealtimeSchedule& schedule) {
+    thread_time_constraint_policy_data_t policy;
+    policy.period = nanosToMachTime(schedule.periodNanos);
+    policy.computation = nanosToMachTime(schedule.computationNanos);
+    policy.constraint = nanosToMachTime(schedule.constraintNanos);
+    policy.preemptible = 1;
+
+    const kern_return_t result = thread_policy_set(pthread_mach_thread_np(pthread_self()),
+                                                   THREAD_TIME_CONSTRAINT_POLICY,
+                                                   reinterpret_cast<thread_policy_t>(&policy),
+                                                   THREAD_TIME_CONSTRAINT_POLICY_COUNT);
+    if (result != KERN_SUCCESS) {
+        CYMAX_LOG_ERROR("ThreadPriority: time-constraint policy refused (%d)", result);
+        setInteractive();
+        return ThreadSchedulingClass::Interactive;
+    }
+    return ThreadSchedulingClass::TimeConstraint;
+}
+
+void clearRealtime() {
+    thread_standard_policy_data_t policy = {};
+    const kern_return_t result = thread_policy_set(pthread_mach_thread_np(pthread_self()),
+                                                   THREAD_STANDARD_POLICY,
+                                                   reinterpret_cast<thread_policy_t>(&policy),
+                                                   THREAD_STANDARD_POLICY_COUNT);
+    if (result != KERN_SUCCESS) {
+        CYMAX_LOG_ERROR("ThreadPriority: can't restore the standard policy (%d)", result);
+    }
+    setInteractive();
+}
+
+void setInteractive() {
+    pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+}
+
+void setUtility() {
+    pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+}
+
+#elif defined(__linux__)
+
+// sched_setattr() has no glibc wrapper
+struct SchedAttr {
+    uint32_t size;
+    uint32_t schedPolicy;
+    uint64_t schedFlags;
+    int32_t schedNice;
+    uint32_t schedPriority;
+    uint64_t schedRuntime;
+    uint64_t schedDeadline;
+    uint64_t schedPeriod;
+};
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+// Above ordinary FIFO work, below the kernel's own threads (99)
+static constexpr int kFIFOPriority = 80;
+
+ThreadSchedulingClass setRealtime(const RealtimeSchedule& schedule) {
+    if (schedule.cpu < 0) {
+        SchedAttr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.schedPolicy = SCHED_DEADLINE;
+        attr.schedRuntime = schedule.computationNanos;
+        attr.schedDeadline = schedule.constraintNanos;
+        attr.schedPeriod = schedule.periodNanos;
+        if (syscall(SYS_sched_setattr, 0, &attr, 0) == 0) {
+            return ThreadSchedulingClass::Deadline;
+        }
+        CYMAX_LOG_DEBUG("ThreadPriority: SCHED_DEADLINE refused: %{public}s", strerror(errno));
+    } else {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(schedule.cpu, &cpus);
+        const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (error != 0) {
+            CYMAX_LOG_ERROR("ThreadPriority: can't pin to CPU %d: %{public}s", schedule.cpu, strerror(error));
+        }
+    }
+
+    struct sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = kFIFOPriority;
+    const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error != 0) {
+        CYMAX_LOG_ERROR("ThreadPriority: SCHED_FIFO refused: %{public}s", strerror(error));
+        setInteractive();
+        return ThreadSchedulingClass::Interactive;
+    }
+    return ThreadSchedulingClass::FIFO;
+}
+
+void clearRealtime() {
+    // Leaving SCHED_DEADLINE or SCHED_FIFO needs no privilege
+    struct sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    const int error = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+    if (error != 0) {
+        CYMAX_LOG_ERROR("ThreadPriority: can't restore SCHED_OTHER: %{public}s", strerror(error));
+    }
+    setInteractive();
+}
+
+void setInteractive() {
+    // No QoS classes; the default policy is all an unprivileged thread gets
+}
+
+void setUtility() {
+    // Lower the nice value of this thread only (Linux applies it per thread)
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+}
+
+#endif
+
+const char* className(ThreadSchedulingClass schedulingClass) {
+    switch (schedulingClass) {
+        case ThreadSchedulingClass::TimeConstraint: return "time-constraint";
+        case ThreadSchedulingClass::Deadline:       return "deadline";
+        case ThreadSchedulingClass::FIFO:           return "fifo";
+        case ThreadSchedulingClass::Interactive:    return "interactive";
+    }
+    return "unknown";
+}
+
+} // namespace ThreadPriority
+
+void LatenessHistogram::reset() {
+    for (std::atomic<uint64_t>& count : m_counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    m_maxNanos.store(0, std::memory_order_relaxed);
+}
+
+LatenessStats LatenessHistogram::snapshot() const {
+    LatenessStats stats;
+    for (size_t i = 0; i < LatenessStats::kBuckets; ++i) {
+        stats.counts[i] = m_counts[i].load(std::memory_order_relaxed);
+        stats.samples += stats.counts[i];
+    }
+    stats.maxMicros = static_cast<double>(m_maxNanos.load(std::memory_order_relaxed)) / 1000.0;
+    return stats;
+}
+
+double LatenessStats::percentileMicros(double percentile) const {
+    if (samples == 0) {
+        return 0.0;
+    }
+    const double target = static_cast<double>(samples) * percentile / 100.0;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets - 1; ++i) {
+        seen += counts[i];
+        if (static_cast<double>(seen) >= target) {
+            return static_cast<double>(1ULL << i);
+        }
+    }
+    return maxMicros;
+}
+
+} // namespace Cymax
@@ -0,0 +1,113 @@
+//
+//  ThreadPriority.hpp
+//  CymaxPhoneOutDriver
+//
+//  Real-time scheduling for periodic worker threads
+//
+//  A QoS class only biases the scheduler; under load a USER_INTERACTIVE
+//  thread can still be preempted for milliseconds. setRealtime() asks for
+//  a periodic real-time reservation instead:
+//  - macOS: Mach time-constraint policy (period, computation, constraint)
+//  - Linux: SCHED_DEADLINE with the same parameters, or SCHED_FIFO when a
+//    CPU is pinned (deadline tasks can't be restricted to one CPU) or
+//    SCHED_DEADLINE is refused
+//  Failure is not fatal: the thread falls back to setInteractive().
+//
+//  LatenessHistogram records how late timed sleeps wake up, which is what
+//  the scheduling policy is meant to bound.
+//
+
+#ifndef ThreadPriority_hpp
+#define ThreadPriority_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Cymax {
+
+/// Periodic real-time reservation
+struct RealtimeSchedule {
+    uint64_t periodNanos = 0;        // Wake-up interval
+    uint64_t computationNanos = 0;   // CPU time needed per period
+    uint64_t constraintNanos = 0;    // Work must finish this long after wake-up
+    int cpu = -1;                    // Pin to this CPU (Linux; -1 = any)
+};
+
+/// Scheduling actually obtained
+enum class ThreadSchedulingClass {
+    TimeConstraint,  // Mach time-constraint policy
+    Deadline,        // SCHED_DEADLINE
+    FIFO,            // SCHED_FIFO
+    Interactive      // QoS / default policy only
+};
+
+namespace ThreadPriority {
+
+/// Ask for real-time scheduling for the calling thread, falling back to
+/// setInteractive() if the system refuses
+ThreadSchedulingClass setRealtime(const RealtimeSchedule& schedule);
+
+/// Give up a reservation from setRealtime() and go back to setInteractive()
+/// @note A thread that blocks for long stretches (e.g. parked between
+///       sessions) should drop its reservation first: a SCHED_DEADLINE
+///       thread only runs again at its next period, so waking it costs up
+///       to a whole period
+void clearRealtime();
+
+/// Elevated but not real-time priority for the calling thread
+void setInteractive();
+
+/// Background priority for work that may lag behind audio (analysis,
+/// disk writes)
+void setUtility();
+
+/// Short display name for a scheduling class
+const char* className(ThreadSchedulingClass schedulingClass);
+
+} // namespace ThreadPriority
+
+/// Lateness histogram snapshot
+struct LatenessStats {
+    static constexpr size_t kBuckets = 16;
+
+    /// Bucket 0: under 1 us; bucket i: [2^(i-1), 2^i) us; the last bucket
+    /// holds everything from 2^(kBuckets-2) us (16 ms) up
+    uint64_t counts[kBuckets] = {0};
+    uint64_t samples = 0;
+    double maxMicros = 0.0;
+
+    /// Upper bound of the bucket holding the given percentile (0-100)
+    double percentileMicros(double percentile) const;
+};
+
+/// Histogram of wake-up lateness
+/// Single writer; snapshot() may run on any thread.
+class LatenessHistogram {
+public:
+    /// Record one wake-up
+    /// @param latenessNanos How long after the requested time the thread ran
+    void record(uint64_t latenessNanos) {
+        const uint64_t micros = latenessNanos / 1000;
+        size_t bucket = 0;
+        while (bucket < LatenessStats::kBuckets - 1 && (1ULL << bucket) <= micros) {
+            ++bucket;
+        }
+        m_counts[bucket].fetch_add(1, std::memory_order_relaxed);
+        if (latenessNanos > m_maxNanos.load(std::memory_order_relaxed)) {
+            m_maxNanos.store(latenessNanos, std::memory_order_relaxed);
+        }
+    }
+
+    void reset();
+
+    LatenessStats snapshot() const;
+
+private:
+    std::atomic<uint64_t> m_counts[LatenessStats::kBuckets] = {};
+    std::atomic<uint64_t> m_maxNanos{0};
+};
+
+} // namespace Cymax
+
+#endif /* ThreadPriority_hpp */
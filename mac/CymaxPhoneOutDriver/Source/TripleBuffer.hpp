@@ -0,0 +1,107 @@
+//
+//  TripleBuffer.hpp
+//  CymaxPhoneOutDriver
+//
+//  Lock-free single-writer single-reader triple buffer
+//
+//  Used to publish analysis results (meters, spectra) from the analysis
+//  thread. The writer never waits for the reader and the reader always
+//  sees the most recent complete value; intermediate values may be
+//  skipped. No allocation after construction. SharedTripleBuffer adds
+//  readers on any number of threads (the HAL's property getters).
+//
+
+#ifndef TripleBuffer_hpp
+#define TripleBuffer_hpp
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+namespace Cymax {
+
+/// Triple buffer for a trivially-copyable value type
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+
+    // Non-copyable, non-movable
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /// Slot the writer fills next (writer thread only)
+    T& writeSlot() {
+        return m_slots[m_writeIndex];
+    }
+
+    /// Publish the write slot (writer thread only)
+    void publish() {
+        // Swap our slot with the shared middle slot and flag it fresh
+        const uint32_t previous = m_middle.exchange(m_writeIndex | kFreshBit, std::memory_order_acq_rel);
+        m_writeIndex = previous & kIndexMask;
+    }
+
+    /// Get the most recently published value (reader thread only)
+    /// The reference stays valid until the next call to read()
+    const T& read() {
+        if (m_middle.load(std::memory_order_relaxed) & kFreshBit) {
+            const uint32_t previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+            m_readIndex = previous & kIndexMask;
+        }
+        return m_slots[m_readIndex];
+    }
+
+    /// Whether a value newer than the last read() is available
+    bool hasNewData() const {
+        return (m_middle.load(std::memory_order_relaxed) & kFreshBit) != 0;
+    }
+
+private:
+    static constexpr uint32_t kIndexMask = 0x3;
+    static constexpr uint32_t kFreshBit = 0x4;
+
+    T m_slots[3] = {};
+
+    // Writer and reader own one slot each; the third is in m_middle
+    alignas(64) uint32_t m_writeIndex = 0;
+    alignas(64) std::atomic<uint32_t> m_middle{1};
+    alignas(64) uint32_t m_readIndex = 2;
+};
+
+/// Triple buffer that any number of threads may read
+/// Readers take turns on a mutex the writer never touches, so publishing
+/// stays lock-free.
+template<typename T>
+class SharedTripleBuffer {
+public:
+    SharedTripleBuffer() = default;
+
+    // Non-copyable, non-movable
+    SharedTripleBuffer(const SharedTripleBuffer&) = delete;
+    SharedTripleBuffer& operator=(const SharedTripleBuffer&) = delete;
+
+    /// Slot the writer fills next (writer thread only)
+    T& writeSlot() {
+        return m_buffer.writeSlot();
+    }
+
+    /// Publish the write slot (writer thread only)
+    void publish() {
+        m_buffer.publish();
+    }
+
+    /// Copy of the most recently published value (any thread)
+    T read() const {
+        std::lock_guard<std::mutex> lock(m_readMutex);
+        return m_buffer.read();
+    }
+
+private:
+    mutable TripleBuffer<T> m_buffer;
+    mutable std::mutex m_readMutex;
+};
+
+} // namespace Cymax
+
+#endif /* TripleBuffer_hpp */
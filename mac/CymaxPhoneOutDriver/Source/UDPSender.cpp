@@ -6,17 +6,21 @@
 //
 
 #include "UDPSender.hpp"
+#include "CapabilityNegotiation.hpp"
 #include "RingBuffer.hpp"
+#include "PacketRing.hpp"
 #include "Logging.hpp"
+#include "SampleKernels.hpp"
+#include "SpectrumAnalyzer.hpp"
+#include "SenderEnvironment.hpp"
 
-#include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
-#include <unistd.h>
-#include <fcntl.h>
 #include <errno.h>
-#include <mach/mach_time.h>
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <vector>
 
 namespace Cymax {
 
@@ -39,24 +43,37 @@ struct AudioPacketHeader {
 #pragma pack(pop)
 
 static_assert(sizeof(AudioPacketHeader) == 28, "AudioPacketHeader must be 28 bytes");
+static_assert(AudioPacketHeader::kSize == kPacketHeaderBytes, "kPacketHeaderBytes must match AudioPacketHeader");
 
-// Convert mach_absolute_time to nanoseconds
-static uint64_t machTimeToNanos(uint64_t machTime) {
-    static mach_timebase_info_data_t timebaseInfo = {0, 0};
-    if (timebaseInfo.denom == 0) {
-        mach_timebase_info(&timebaseInfo);
-    }
-    return machTime * timebaseInfo.numer / timebaseInfo.denom;
-}
+// Volume changes sweep full scale in no less than this, so they never click
+static constexpr float kGainRampSeconds = 0.010f;
+
+// While muted, one DTX keepalive per this much silence
+static constexpr float kDTXIntervalSeconds = 0.100f;
+
+// Real-time reservation per packet interval: CPU time needed, and how soon
+// after waking it must be done
+static constexpr double kRealtimeComputationFraction = 0.25;
+static constexpr double kRealtimeConstraintFraction = 0.5;
+
+// SO_SNDBUF never shrinks below this many packets, however tight the budget
+static constexpr size_t kMinSendBufferPackets = 8;
+
+// Back-off when poll() says writable but the send still fails (ENOBUFS
+// reflects the interface queue, which poll() doesn't see)
+static constexpr uint64_t kRetryBackoffNanos = 250000;
+
+// Pending pool floor: room for parity and spectrum packets between audio
+static constexpr size_t kMinPendingPackets = 4;
 
 UDPSender::UDPSender() {
-    std::memset(&m_destAddr, 0, sizeof(m_destAddr));
     std::memset(m_packetBuffer, 0, sizeof(m_packetBuffer));
 }
 
 UDPSender::~UDPSender() {
     stop();
-    closeSocket();
+    shutdownThreads();
+    m_udp.close();
 }
 
 bool UDPSender::initialize(RingBuffer<float>* ringBuffer, const UDPSenderConfig& config) {
@@ -76,72 +93,170 @@ bool UDPSender::initialize(RingBuffer<float>* ringBuffer, const UDPSenderConfig&
 
 bool UDPSender::setDestination(const char* ipAddress) {
     if (!ipAddress || strlen(ipAddress) == 0) {
-        m_hasDestination.store(false, std::memory_order_release);
+        storeDestinations(nullptr, 0, m_config.destPort);
         CYMAX_LOG_INFO("UDPSender: destination cleared");
         return false;
     }
     
+    if (isLocalTransportSpec(ipAddress)) {
+        return setLocalDestination(ipAddress);
+    }
+    
     // Parse IP address
     struct in_addr addr;
     if (inet_pton(AF_INET, ipAddress, &addr) != 1) {
         CYMAX_LOG_ERROR("UDPSender: invalid IP address: %{public}s", ipAddress);
-        m_hasDestination.store(false, std::memory_order_release);
+        storeDestinations(nullptr, 0, m_config.destPort);
         return false;
     }
     
-    // Store destination
-    std::memset(&m_destAddr, 0, sizeof(m_destAddr));
-    m_destAddr.sin_family = AF_INET;
-    m_destAddr.sin_addr = addr;
-    m_destAddr.sin_port = htons(m_config.destPort);
-    
     strncpy(m_config.destIP, ipAddress, sizeof(m_config.destIP) - 1);
-    m_hasDestination.store(true, std::memory_order_release);
+    storeDestinations(&addr.s_addr, 1, m_config.destPort);
     
     CYMAX_LOG_INFO("UDPSender: destination set to %{public}s:%u", ipAddress, m_config.destPort);
     return true;
 }
 
-bool UDPSender::createSocket() {
-    if (m_socket >= 0) {
-        return true;  // Already created
+bool UDPSender::setLocalDestination(const char* destination) {
+    // The transmitting thread uses the backend without a lock
+    if (m_running.load(std::memory_order_acquire)) {
+        CYMAX_LOG_ERROR("UDPSender: local destination can only change while stopped");
+        return false;
     }
     
-    // Create UDP socket
-    m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
-    if (m_socket < 0) {
-        CYMAX_LOG_ERROR("UDPSender: failed to create socket: %{public}s", strerror(errno));
-        return false;
+    // stop() doesn't wait: the transmitting thread may still be sending
+    // to (or flushing) the old backend until it parks
+    waitForThreadsParked();
+    m_localTransport.reset();
+    if (destination && *destination != '\0') {
+        m_localTransport = createLocalTransport(destination);
+        if (!m_localTransport) {
+            CYMAX_LOG_ERROR("UDPSender: can't open local destination %{public}s", destination);
+        } else {
+            CYMAX_LOG_INFO("UDPSender: local destination %{public}s", destination);
+        }
     }
+    m_hasDestination.store(m_destinationCount.load(std::memory_order_relaxed) > 0 || m_localTransport,
+                           std::memory_order_release);
+    return m_localTransport || !destination || *destination == '\0';
+}
+
+void UDPSender::storeDestinations(const uint32_t* addresses, size_t count, uint16_t port) {
+    count = std::min(count, ControlBlockPage::kMaxDestinations);
     
-    // Set non-blocking mode
-    int flags = fcntl(m_socket, F_GETFL, 0);
-    if (flags < 0 || fcntl(m_socket, F_SETFL, flags | O_NONBLOCK) < 0) {
-        CYMAX_LOG_ERROR("UDPSender: failed to set non-blocking: %{public}s", strerror(errno));
-        closeSocket();
-        return false;
+    // Shrink first so a reader never sees a slot before it is written
+    m_destinationCount.store(std::min(count, m_destinationCount.load(std::memory_order_relaxed)),
+                             std::memory_order_release);
+    for (size_t i = 0; i < count; ++i) {
+        m_destinations[i].store(UDPTransport::packAddress(addresses[i], port), std::memory_order_relaxed);
+    }
+    m_destinationCount.store(count, std::memory_order_release);
+    m_hasDestination.store(count > 0 || m_localTransport, std::memory_order_release);
+    m_negotiator.restart();
+}
+
+void UDPSender::pollControlBlock() {
+    ControlSettings settings;
+    if (!m_controlBlock || !m_controlBlock->readIfChanged(m_controlGeneration, settings)) {
+        return;
     }
     
-    // Set send buffer size
-    int sendBufSize = 262144;  // 256KB
-    if (setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, &sendBufSize, sizeof(sendBufSize)) < 0) {
-        CYMAX_LOG_DEBUG("UDPSender: couldn't set send buffer size (non-fatal)");
+    const uint16_t port = settings.destPort != 0 ? settings.destPort : m_config.destPort;
+    storeDestinations(settings.destinations, settings.destinationCount, port);
+    m_config.useFloat32 = settings.profile == StreamProfile::Float32;
+    if (!m_config.negotiateProfile) {
+        m_useFloat32.store(m_config.useFloat32, std::memory_order_relaxed);
     }
     
-    // Disable SIGPIPE
-    int nosigpipe = 1;
-    setsockopt(m_socket, SOL_SOCKET, SO_NOSIGPIPE, &nosigpipe, sizeof(nosigpipe));
+    CYMAX_LOG_INFO("UDPSender: control block generation %u: %zu destination(s), port %u, %{public}s",
+                   settings.generation, settings.destinationCount, port,
+                   m_config.useFloat32 ? "float32" : "int16");
+}
+
+void UDPSender::pollNegotiation() {
+    if (!m_config.negotiateProfile) {
+        return;
+    }
     
-    CYMAX_LOG_INFO("UDPSender: socket created");
-    return true;
+    uint64_t destinations[ControlBlockPage::kMaxDestinations];
+    const size_t count = m_destinationCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; ++i) {
+        destinations[i] = m_destinations[i].load(std::memory_order_relaxed);
+    }
+    if (count == 0) {
+        // Nobody to ask (a local backend at most): send as configured
+        m_useFloat32.store(m_config.useFloat32, std::memory_order_relaxed);
+        m_fecGroupSize.store(m_config.fecGroupSize, std::memory_order_relaxed);
+    }
+    
+    NegotiationOffer offer;
+    offer.sampleRate = m_config.sampleRate;
+    offer.channels = m_config.channels;
+    offer.framesPerPacket = static_cast<uint16_t>(m_framesPerPacket);
+    offer.legacyFloat32 = m_config.useFloat32;
+    offer.legacyFECGroup = m_config.fecGroupSize;
+    offer.maxFECGroup = m_config.maxNegotiatedFECGroup;
+    
+    NegotiatedProfile profile;
+    const bool finished = m_negotiator.poll(nowNanos(), m_udp, destinations, count, offer,
+                                            m_sendErrors.load(std::memory_order_relaxed), profile);
+    
+    // Receivers that resynced get the pre-roll from the transmitting thread
+    uint64_t resync = 0;
+    while (m_negotiator.takeResync(resync)) {
+        const uint32_t ip = static_cast<uint32_t>(resync >> 16);
+        for (std::atomic<uint32_t>& request : m_preRollRequests) {
+            uint32_t expected = 0;
+            if (request.load(std::memory_order_relaxed) == ip ||
+                request.compare_exchange_strong(expected, ip, std::memory_order_release, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+    }
+    if (!finished) {
+        return;
+    }
+    
+    m_useFloat32.store(profile.useFloat32, std::memory_order_relaxed);
+    m_fecGroupSize.store(profile.fecGroupSize, std::memory_order_relaxed);
+    m_negotiatedBufferMs.store(profile.bufferMs, std::memory_order_relaxed);
+    m_negotiationRounds.fetch_add(1, std::memory_order_relaxed);
+    
+    const double kbps = wireBytesPerSecond(offer.sampleRate, offer.channels, offer.framesPerPacket,
+                                           profile.useFloat32, profile.fecGroupSize) * 8.0 / 1000.0;
+    CYMAX_LOG_INFO("UDPSender: negotiated %{public}s%{public}s, FEC group %u, buffer %u ms, %.0f kbit/s "
+                   "(%zu answered, %zu legacy)",
+                   profile.useFloat32 ? "float32" : "int16", profile.agreed ? "" : " (no common profile, legacy)",
+                   profile.fecGroupSize, profile.bufferMs, kbps, profile.responders, profile.legacy);
 }
 
-void UDPSender::closeSocket() {
-    if (m_socket >= 0) {
-        close(m_socket);
-        m_socket = -1;
-        CYMAX_LOG_INFO("UDPSender: socket closed");
+void UDPSender::configureSendBuffer() {
+    // Enough for the latency budget and no more: a bigger kernel queue only
+    // hides latency, and a full one is what makes sendto() push back
+    // (sized for the larger format if negotiation may switch to it)
+    const bool float32 = m_config.useFloat32 || m_config.negotiateProfile;
+    const size_t sampleBytes = float32 ? sizeof(float) : sizeof(int16_t);
+    const size_t packetBytes = AudioPacketHeader::kSize + m_framesPerPacket * m_config.channels * sampleBytes;
+    const double packetsPerSecond = static_cast<double>(m_config.sampleRate) / static_cast<double>(m_framesPerPacket);
+    const double budgetBytes = packetsPerSecond * m_config.sendLatencyMs / 1000.0 * static_cast<double>(packetBytes);
+    
+    m_udp.setSendBufferBytes(static_cast<int>(std::max(budgetBytes, static_cast<double>(kMinSendBufferPackets * packetBytes))));
+}
+
+bool UDPSender::setPacketRing(PacketRing* packetRing) {
+    m_packetRing = packetRing;
+    if (!packetRingFits()) {
+        CYMAX_LOG_ERROR("UDPSender: packet ring slots don't hold a whole packet, using the sample ring");
+        m_packetRing = nullptr;
+        return false;
     }
+    return true;
+}
+
+bool UDPSender::packetRingFits() const {
+    return !m_packetRing || (m_packetRing->channelCount() == m_config.channels &&
+                             slotFitsPacket(m_packetRing->headerRoom(), m_packetRing->framesPerSlot(),
+                                            m_packetRing->channelCount()));
 }
 
 bool UDPSender::start() {
@@ -155,22 +270,184 @@ bool UDPSender::start() {
         return false;
     }
     
-    if (!createSocket()) {
+    // Slots are sent in place and copied whole into the pending pool and
+    // pipeline packets; updateConfig() may have changed the channels
+    if (!packetRingFits()) {
+        CYMAX_LOG_ERROR("UDPSender: packet ring slots don't hold a whole packet");
+        return false;
+    }
+    
+    // The socket stays open across sessions
+    if (!m_udp.open()) {
         return false;
     }
     
+    // Threads from a different mode can't be reused
+    if (m_threadCount > 0 && m_threadsPipelined != m_config.pipelined) {
+        shutdownThreads();
+    }
+    
+    // A stop() may still be finishing: wait for every thread to park
+    // before touching state they use (normally they parked long ago)
+    waitForThreadsParked();
+    
     // Reset state
-    m_shouldStop.store(false, std::memory_order_release);
+    m_startNanos = nowNanos();
+    m_firstPacketNanos.store(0, std::memory_order_relaxed);
+    m_steadyStateFaults.store(0, std::memory_order_relaxed);
     m_sequence.store(0, std::memory_order_relaxed);
     m_packetsSent.store(0, std::memory_order_relaxed);
+    m_bytesSent.store(0, std::memory_order_relaxed);
     m_packetsDropped.store(0, std::memory_order_relaxed);
     m_framesDropped.store(0, std::memory_order_relaxed);
+    m_dtxPacketsSent.store(0, std::memory_order_relaxed);
+    m_dtxFrames.store(0, std::memory_order_relaxed);
+    m_spectrumPacketsSent.store(0, std::memory_order_relaxed);
+    m_fecPacketsSent.store(0, std::memory_order_relaxed);
+    m_preRollPacketsSent.store(0, std::memory_order_relaxed);
+    m_preRollBursts.store(0, std::memory_order_relaxed);
+    m_copies.store(0, std::memory_order_relaxed);
+    m_sentFirstTry.store(0, std::memory_order_relaxed);
+    m_sentAfterRetry.store(0, std::memory_order_relaxed);
+    m_wouldBlock.store(0, std::memory_order_relaxed);
+    m_droppedDeadline.store(0, std::memory_order_relaxed);
+    m_droppedOverflow.store(0, std::memory_order_relaxed);
+    m_sendErrors.store(0, std::memory_order_relaxed);
+    for (StageCounters& counters : m_stageCounters) {
+        counters.packets.store(0, std::memory_order_relaxed);
+        counters.dropped.store(0, std::memory_order_relaxed);
+        counters.stalls.store(0, std::memory_order_relaxed);
+        counters.totalNanos.store(0, std::memory_order_relaxed);
+        counters.maxNanos.store(0, std::memory_order_relaxed);
+        counters.intervalMaxNanos.store(0, std::memory_order_relaxed);
+    }
+    m_wakeLateness.reset();
+    m_fecCount = 0;
+    
+    // Configured profile until a negotiation round says otherwise
+    m_useFloat32.store(m_config.useFloat32, std::memory_order_relaxed);
+    m_fecGroupSize.store(m_config.fecGroupSize, std::memory_order_relaxed);
+    m_negotiationRounds.store(0, std::memory_order_relaxed);
+    m_negotiatedBufferMs.store(0, std::memory_order_relaxed);
+    m_negotiator.reset();
+    
+    // Apply whatever the control block holds on the first packet
+    m_controlGeneration = 0;
+    
+    // Packets are read straight into the packet buffer or a slot
+    const size_t maxFrames = (kMaxPacketSize - AudioPacketHeader::kSize) / (m_config.channels * sizeof(float));
+    m_framesPerPacket = m_packetRing ? m_packetRing->framesPerSlot()
+                                     : std::min<size_t>(m_config.framesPerPacket, maxFrames);
+    
+    m_sourceFill.configure(m_packetRing ? m_packetRing->slotCount() * m_packetRing->framesPerSlot()
+                                        : m_ringBuffer->capacity(),
+                           m_framesPerPacket);
+    m_timeSeries.reset(counterTotals());
+    m_statsSecondStart = 0;
     
-    // Start sender thread
-    m_senderThread = std::thread(&UDPSender::senderThreadFunc, this);
+    configureSendBuffer();
+    
+    // Pending pool holds one latency budget of audio packets plus slack
+    // for every copy a packet fans out to. The pool is shared, so one
+    // backed-up destination mustn't evict the others' packets: room for
+    // every destination the control block can add mid-session, and the
+    // local backend (fixed while running)
+    const double budgetSeconds = m_config.sendLatencyMs / 1000.0;
+    const size_t budgetPackets = static_cast<size_t>(
+        std::ceil(budgetSeconds * m_config.sampleRate / static_cast<double>(m_framesPerPacket)));
+    const size_t fanOut = ControlBlockPage::kMaxDestinations + (m_localTransport ? 1 : 0);
+    const size_t pendingCapacity = fanOut * std::min(kMaxPendingPackets, budgetPackets + kMinPendingPackets);
+    
+    // Pre-roll holds preRollMs of audio packets
+    const size_t preRollCapacity = static_cast<size_t>(
+        std::ceil(m_config.preRollMs / 1000.0 * m_config.sampleRate / static_cast<double>(m_framesPerPacket)));
+    
+    // Session buffers come from the locked arena, so the sender threads
+    // never fault on them (not even on the first packet that is held)
+    const size_t scratchSamples = m_framesPerPacket * m_config.channels;
+    const size_t pipelineCount = m_config.pipelined ? kPipelinePackets + kPipelineParityPackets : 0;
+    const size_t deliveryCount = pendingCapacity + 1;
+    const size_t arenaBytes = RealtimeArena::footprint(pendingCapacity * sizeof(PendingPacket)) +
+                              RealtimeArena::footprint(deliveryCount * sizeof(Delivery)) +
+                              RealtimeArena::footprint(deliveryCount * sizeof(uint32_t)) +
+                              RealtimeArena::footprint(pipelineCount * sizeof(PipelinePacket)) +
+                              RealtimeArena::footprint(scratchSamples * sizeof(int16_t)) +
+                              RealtimeArena::footprint(preRollCapacity * sizeof(PreRollPacket));
+    if (arenaBytes > m_sessionArena.capacity() && !m_sessionArena.reserve(arenaBytes)) {
+        CYMAX_LOG_ERROR("UDPSender: cannot allocate session buffers");
+        return false;
+    }
+    m_sessionArena.rewind();
+    m_pending = m_sessionArena.allocateArray<PendingPacket>(pendingCapacity);
+    m_pendingCapacity = pendingCapacity;
+    m_deliveries = m_sessionArena.allocateArray<Delivery>(deliveryCount);
+    m_freeDeliveries = m_sessionArena.allocateArray<uint32_t>(deliveryCount);
+    for (size_t i = 0; i < deliveryCount; ++i) {
+        m_freeDeliveries[i] = static_cast<uint32_t>(i);
+    }
+    m_freeDeliveryCount = deliveryCount;
+    m_pipelinePackets = pipelineCount > 0 ? m_sessionArena.allocateArray<PipelinePacket>(pipelineCount) : nullptr;
+    m_int16Scratch = m_sessionArena.allocateArray<int16_t>(scratchSamples);
+    m_preRoll = preRollCapacity > 0 ? m_sessionArena.allocateArray<PreRollPacket>(preRollCapacity) : nullptr;
+    m_preRollCapacity = preRollCapacity;
+    m_preRollWritten = 0;
+    m_listenerCount = 0;
+    for (std::atomic<uint32_t>& request : m_preRollRequests) {
+        request.store(0, std::memory_order_relaxed);
+    }
+    m_pendingHead = 0;
+    m_pendingCount = 0;
+    m_sendDeadlineNanos = static_cast<uint64_t>(m_config.sendLatencyMs) * 1000000ULL;
+    
+    // Start at the target gain so a stream that begins muted sends no audio
+    m_currentGain = 1.0f;
+    if (m_controlState) {
+        const float scalar = m_controlState->volumeScalar.load(std::memory_order_relaxed);
+        m_currentGain = m_controlState->muted.load(std::memory_order_relaxed) ? 0.0f : scalar * scalar;
+    }
+    
+    if (m_config.pipelined) {
+        // Every packet starts out free; anything a stopped session left in
+        // flight is discarded
+        const size_t total = kPipelinePackets + kPipelineParityPackets;
+        if (!m_freePackets) {
+            m_freePackets = std::make_unique<SPSCQueue<PipelinePacket*>>(total);
+            m_freeParity = std::make_unique<SPSCQueue<PipelinePacket*>>(total);
+            m_encodedQueue = std::make_unique<SPSCQueue<PipelinePacket*>>(total);
+            m_sendQueue = std::make_unique<SPSCQueue<PipelinePacket*>>(total);
+        }
+        PipelinePacket* discarded = nullptr;
+        for (SPSCQueue<PipelinePacket*>* queue : {m_freePackets.get(), m_freeParity.get(),
+                                                  m_encodedQueue.get(), m_sendQueue.get()}) {
+            while (queue->tryPop(discarded)) {}
+        }
+        for (size_t i = 0; i < total; ++i) {
+            (i < kPipelinePackets ? m_freePackets : m_freeParity)->tryPush(&m_pipelinePackets[i]);
+        }
+    }
+    
+    // Threads are created once and parked between sessions
+    if (m_threadCount == 0) {
+        m_shutdown.store(false, std::memory_order_release);
+        m_threadsPipelined = m_config.pipelined;
+        if (m_config.pipelined) {
+            m_threadCount = 3;
+            m_transmitThread = std::thread(&UDPSender::threadMain, this, "transmit", &UDPSender::transmitSession, true);
+            m_fecThread = std::thread(&UDPSender::threadMain, this, "FEC", &UDPSender::fecSession, false);
+            m_senderThread = std::thread(&UDPSender::threadMain, this, "encoder", &UDPSender::encoderSession, false);
+        } else {
+            m_threadCount = 1;
+            m_senderThread = std::thread(&UDPSender::threadMain, this, "sender", &UDPSender::senderSession, true);
+        }
+    }
+    
+    // Unpark
     m_running.store(true, std::memory_order_release);
+    m_active.store(true, std::memory_order_release);
+    m_sessionSignal.fetch_add(1, std::memory_order_release);
+    m_sessionSignal.notify_all();
     
-    CYMAX_LOG_INFO("UDPSender: started");
+    CYMAX_LOG_INFO("UDPSender: started (%{public}s)", m_config.pipelined ? "pipelined" : "inline");
     return true;
 }
 
@@ -179,17 +456,147 @@ void UDPSender::stop() {
         return;
     }
     
-    // Signal thread to stop
-    m_shouldStop.store(true, std::memory_order_release);
+    // Don't wait: the threads finish their current packet, log the
+    // session and park on their own. start() waits for that if needed.
+    m_active.store(false, std::memory_order_release);
+    m_running.store(false, std::memory_order_release);
+    wakeQueues();
+}
+
+void UDPSender::wakeQueues() {
+    if (m_threadsPipelined && m_freePackets) {
+        m_freePackets->wake();
+        m_encodedQueue->wake();
+        m_sendQueue->wake();
+    }
+}
+
+void UDPSender::waitForThreadsParked() {
+    // Re-wake queue waiters: a wake can land just before a stage starts
+    // waiting, and this is rare enough that polling beats a handshake
+    while (m_parkedThreads.load(std::memory_order_acquire) < m_threadCount) {
+        wakeQueues();
+        struct timespec ts = {0, 50000};  // 50us
+        nanosleep(&ts, nullptr);
+    }
+}
+
+void UDPSender::releaseResources() {
+    if (m_running.load(std::memory_order_acquire)) {
+        CYMAX_LOG_ERROR("UDPSender: cannot release resources while running");
+        return;
+    }
+    
+    shutdownThreads();
+    m_udp.close();
+    
+    m_freePackets.reset();
+    m_freeParity.reset();
+    m_encodedQueue.reset();
+    m_sendQueue.reset();
+    m_pending = nullptr;
+    m_pendingCapacity = 0;
+    m_pendingCount = 0;
+    m_deliveries = nullptr;
+    m_freeDeliveries = nullptr;
+    m_freeDeliveryCount = 0;
+    m_pipelinePackets = nullptr;
+    m_int16Scratch = nullptr;
+    m_sessionArena.release();
+    
+    m_ringBuffer = nullptr;
+    m_packetRing = nullptr;
+    
+    CYMAX_LOG_INFO("UDPSender: resources released");
+}
+
+bool UDPSender::waitForSession() {
+    m_parkedThreads.fetch_add(1, std::memory_order_release);
+    
+    for (;;) {
+        const uint32_t seen = m_sessionSignal.load(std::memory_order_acquire);
+        if (m_shutdown.load(std::memory_order_acquire)) {
+            return false;
+        }
+        if (m_active.load(std::memory_order_acquire)) {
+            break;
+        }
+        m_sessionSignal.wait(seen, std::memory_order_acquire);
+    }
+    
+    m_parkedThreads.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void UDPSender::shutdownThreads() {
+    if (m_threadCount == 0) {
+        return;
+    }
+    
+    waitForThreadsParked();
+    m_shutdown.store(true, std::memory_order_release);
+    m_sessionSignal.fetch_add(1, std::memory_order_release);
+    m_sessionSignal.notify_all();
     
-    // Wait for thread to finish
     if (m_senderThread.joinable()) {
         m_senderThread.join();
     }
+    if (m_fecThread.joinable()) {
+        m_fecThread.join();
+    }
+    if (m_transmitThread.joinable()) {
+        m_transmitThread.join();
+    }
+    m_threadCount = 0;
+    m_parkedThreads.store(0, std::memory_order_relaxed);
+}
+
+void UDPSender::logSessionStats() {
+    CYMAX_LOG_INFO("UDPSender: stopped (sent: %llu, dropped: %llu, dtx: %llu, fec: %llu, first packet %.0f us)",
+                   m_packetsSent.load(), m_packetsDropped.load(), m_dtxPacketsSent.load(),
+                   m_fecPacketsSent.load(), timeToFirstPacketMicros());
     
-    m_running.store(false, std::memory_order_release);
-    CYMAX_LOG_INFO("UDPSender: stopped (sent: %llu, dropped: %llu)",
-                   m_packetsSent.load(), m_packetsDropped.load());
+    if (m_preRollBursts.load() > 0) {
+        CYMAX_LOG_INFO("UDPSender: pre-roll: %llu packets in %llu bursts",
+                       m_preRollPacketsSent.load(), m_preRollBursts.load());
+    }
+    
+    const SendOutcomeStats outcomes = sendOutcomes();
+    CYMAX_LOG_INFO("UDPSender: send outcomes of %llu copies: %llu first try, %llu after retry, %llu would-block, "
+                   "%llu past deadline, %llu evicted, %llu errors, %zu pending discarded",
+                   outcomes.copies, outcomes.sentFirstTry, outcomes.sentAfterRetry, outcomes.wouldBlock,
+                   outcomes.droppedDeadline, outcomes.droppedOverflow, outcomes.sendErrors,
+                   m_pendingCount);
+    
+    CYMAX_LOG_INFO("UDPSender: %llu minor page faults after the first packet (session buffers %{public}s)",
+                   steadyStateMinorFaults(), m_sessionArena.isLocked() ? "locked" : "not locked");
+    
+    const FillLevelStats fill = sourceFillLevel();
+    CYMAX_LOG_INFO("UDPSender: source fill p50 <= %zu, p99 <= %zu, mean %.0f, max %zu of %zu frames "
+                   "(%llu samples, %llu windows)",
+                   fill.session.percentileFrames(50.0, fill.bucketFrames),
+                   fill.session.percentileFrames(99.0, fill.bucketFrames),
+                   fill.session.meanFrames, fill.session.maxFrames, fill.capacityFrames,
+                   fill.session.samples, fill.windows);
+    
+    const LatenessStats lateness = wakeLateness();
+    CYMAX_LOG_INFO("UDPSender: wake lateness p50 <= %.0f us, p99 <= %.0f us, max %.1f us (%llu waits)",
+                   lateness.percentileMicros(50.0), lateness.percentileMicros(99.0),
+                   lateness.maxMicros, lateness.samples);
+    
+    static const char* const kStageNames[] = {"encode", "fec", "transmit"};
+    for (size_t i = 0; i < static_cast<size_t>(SenderStage::Count); ++i) {
+        const SenderStageStats stats = stageStats(static_cast<SenderStage>(i));
+        CYMAX_LOG_INFO("UDPSender: %{public}s stage: %llu packets, %llu dropped, %llu stalls, "
+                       "latency mean %.1f us max %.1f us",
+                       kStageNames[i], stats.packets, stats.dropped, stats.stalls,
+                       stats.meanLatencyMicros, stats.maxLatencyMicros);
+    }
+}
+
+double UDPSender::timeToFirstPacketMicros() const {
+    const uint64_t first = m_firstPacketNanos.load(std::memory_order_acquire);
+    return first > m_startNanos ? static_cast<double>(first - m_startNanos) / 1000.0 : 0.0;
 }
 
 void UDPSender::updateConfig(const UDPSenderConfig& config) {
@@ -204,91 +611,839 @@ void UDPSender::updateConfig(const UDPSenderConfig& config) {
                    config.sampleRate, config.channels);
 }
 
-size_t UDPSender::ringBufferHighWater() const {
-    if (m_ringBuffer) {
-        return m_ringBuffer->highWaterMark();
+uint64_t UDPSender::nowNanos() {
+    return SenderEnvironment::nowNanos();
+}
+
+void UDPSender::drainSource() {
+    if (m_packetRing) {
+        const size_t slots = m_packetRing->dropSlots(m_packetRing->slotCount());
+        m_framesDropped.fetch_add(slots * m_packetRing->framesPerSlot(), std::memory_order_relaxed);
+        return;
+    }
+    size_t available = m_ringBuffer->availableForRead();
+    if (available > 0) {
+        m_ringBuffer->dropFrames(available);
+        m_framesDropped.fetch_add(available, std::memory_order_relaxed);
+    }
+}
+
+void UDPSender::updateStatistics() {
+    const uint64_t now = nowNanos();
+    if (m_statsSecondStart == 0) {
+        m_statsSecondStart = now;
+        return;
+    }
+    if (now - m_statsSecondStart < kStatsIntervalNanos) {
+        return;
+    }
+    
+    const FillLevelSummary fill = m_sourceFill.closeWindow();
+    StageCounters& transmit = m_stageCounters[static_cast<size_t>(SenderStage::Transmit)];
+    m_timeSeries.closeSecond(now - m_statsSecondStart, counterTotals(),
+                             transmit.intervalMaxNanos.exchange(0, std::memory_order_relaxed),
+                             fill.samples, fill.meanFrames, fill.maxFrames);
+    m_statsSecondStart = now;
+}
+
+SenderCounterTotals UDPSender::counterTotals() const {
+    const StageCounters& transmit = m_stageCounters[static_cast<size_t>(SenderStage::Transmit)];
+    SenderCounterTotals totals;
+    totals.packetsSent = m_packetsSent.load(std::memory_order_relaxed);
+    totals.bytesSent = m_bytesSent.load(std::memory_order_relaxed);
+    totals.packetsDropped = m_packetsDropped.load(std::memory_order_relaxed);
+    totals.framesDropped = m_framesDropped.load(std::memory_order_relaxed);
+    totals.wouldBlock = m_wouldBlock.load(std::memory_order_relaxed);
+    totals.sendCount = transmit.packets.load(std::memory_order_relaxed);
+    totals.sendNanos = transmit.totalNanos.load(std::memory_order_relaxed);
+    return totals;
+}
+
+uint8_t* UDPSender::acquireAudio(size_t& framesRead) {
+    framesRead = 0;
+    
+    if (m_packetRing) {
+        // Discard the oldest slots rather than let latency build up
+        const size_t maxBacklogSlots = m_packetRing->slotCount() * 3 / 4;
+        const size_t backlog = m_packetRing->availableSlots();
+        recordSourceFill(backlog * m_packetRing->framesPerSlot());
+        if (backlog > maxBacklogSlots) {
+            const size_t dropped = m_packetRing->dropSlots(backlog - maxBacklogSlots / 2);
+            m_framesDropped.fetch_add(dropped * m_packetRing->framesPerSlot(), std::memory_order_relaxed);
+        }
+        uint8_t* slot = m_packetRing->peek();
+        if (slot) {
+            framesRead = m_packetRing->framesPerSlot();
+        }
+        return slot;
+    }
+    
+    // Only take whole packets so a partial read isn't lost
+    const size_t available = m_ringBuffer->availableForRead();
+    recordSourceFill(available);
+    if (available < m_framesPerPacket) {
+        return nullptr;
     }
-    return 0;
+    float* samples = reinterpret_cast<float*>(m_packetBuffer + AudioPacketHeader::kSize);
+    framesRead = m_ringBuffer->read(samples, m_framesPerPacket);
+    return m_packetBuffer;
 }
 
-void UDPSender::resetRingBufferHighWater() {
-    if (m_ringBuffer) {
-        m_ringBuffer->resetHighWaterMark();
+void UDPSender::releaseAudio() {
+    if (m_packetRing) {
+        m_packetRing->release();
     }
 }
 
-void UDPSender::senderThreadFunc() {
-    CYMAX_LOG_INFO("UDPSender: thread started");
+bool UDPSender::isFullyMuted() const {
+    return m_currentGain == 0.0f &&
+           m_controlState && m_controlState->muted.load(std::memory_order_relaxed);
+}
+
+void UDPSender::writeHeader(uint8_t* packet, uint32_t sequence, uint16_t frameCount, uint16_t flags) const {
+    AudioPacketHeader* header = reinterpret_cast<AudioPacketHeader*>(packet);
+    header->magic = AudioPacketHeader::kMagic;
+    header->sequence = sequence;
+    header->timestamp = nowNanos();
+    header->sampleRate = m_config.sampleRate;
+    header->channels = m_config.channels;
+    header->frameCount = frameCount;
+    header->format = m_useFloat32.load(std::memory_order_relaxed) ? kSampleFormatFloat32 : kSampleFormatInt16;
+    header->flags = flags;
+}
+
+size_t UDPSender::buildAudioPacket(uint8_t* packet, const float* samples, size_t frames) {
+    writeHeader(packet, m_sequence.fetch_add(1, std::memory_order_relaxed),
+                static_cast<uint16_t>(frames), 0);
     
-    // Set thread priority (not real-time, but elevated)
-    pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+    uint8_t* payload = packet + AudioPacketHeader::kSize;
+    const size_t count = frames * m_config.channels;
+    if (m_useFloat32.load(std::memory_order_relaxed)) {
+        // Already in place when reading from a slot or the packet buffer
+        if (reinterpret_cast<const uint8_t*>(samples) != payload) {
+            std::memcpy(payload, samples, count * sizeof(float));
+        }
+        return AudioPacketHeader::kSize + count * sizeof(float);
+    }
     
-    // Preallocate read buffer for audio samples
-    const size_t samplesPerPacket = m_config.framesPerPacket * m_config.channels;
-    std::vector<float> audioSamples(samplesPerPacket);
+    // Samples may be in the payload itself, so convert via scratch
+    Kernels::active().floatToInt16(samples, m_int16Scratch, count);
+    std::memcpy(payload, m_int16Scratch, count * sizeof(int16_t));
+    return AudioPacketHeader::kSize + count * sizeof(int16_t);
+}
+
+size_t UDPSender::buildKeepalive(uint8_t* packet, uint32_t frames) {
+    writeHeader(packet, m_sequence.fetch_add(1, std::memory_order_relaxed),
+                static_cast<uint16_t>(std::min<uint32_t>(frames, UINT16_MAX)), kPacketFlagDTX);
+    return AudioPacketHeader::kSize;
+}
+
+size_t UDPSender::buildSpectrum(uint8_t* packet) {
+    if (!m_spectrumSource || !m_sendSpectrum.load(std::memory_order_relaxed)) {
+        return 0;
+    }
     
-    while (!m_shouldStop.load(std::memory_order_acquire)) {
+    SpectrumSnapshot spectrum;
+    if (!m_spectrumSource->takeLatest(spectrum)) {
+        return 0;
+    }
+    
+    // Side-channel packets don't consume sequence numbers, so audio loss
+    // detection is unaffected
+    writeHeader(packet, m_sequence.load(std::memory_order_relaxed), 0, kPacketFlagSpectrum);
+    
+    // Quantize floor..0 dB to 0..255
+    uint8_t* bands = packet + AudioPacketHeader::kSize;
+    const float scale = 255.0f / -SpectrumAnalyzer::kFloorDB;
+    for (uint32_t b = 0; b < SpectrumSnapshot::kBands; ++b) {
+        const float level = (spectrum.bandsDB[b] - SpectrumAnalyzer::kFloorDB) * scale;
+        bands[b] = static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, level + 0.5f)));
+    }
+    
+    return AudioPacketHeader::kSize + SpectrumSnapshot::kBands;
+}
+
+bool UDPSender::addToParity(const uint8_t* packet, size_t size) {
+    const uint16_t groupSize = m_fecGroupSize.load(std::memory_order_relaxed);
+    if (groupSize == 0) {
+        return false;
+    }
+    
+    const AudioPacketHeader* header = reinterpret_cast<const AudioPacketHeader*>(packet);
+    const uint8_t* payload = packet + AudioPacketHeader::kSize;
+    const size_t payloadBytes = size - AudioPacketHeader::kSize;
+    
+    // A group covers consecutive, equal-sized packets; start over otherwise
+    if (m_fecCount > 0 &&
+        (payloadBytes != m_fecPayloadBytes || header->sequence != m_fecFirstSequence + m_fecCount)) {
+        m_fecCount = 0;
+    }
+    if (m_fecCount == 0) {
+        m_fecFirstSequence = header->sequence;
+        m_fecPayloadBytes = payloadBytes;
+        std::memcpy(m_fecParity, payload, payloadBytes);
+    } else {
+        for (size_t i = 0; i < payloadBytes; ++i) {
+            m_fecParity[i] ^= payload[i];
+        }
+    }
+    
+    // >= in case negotiation shrank the group mid-way
+    return ++m_fecCount >= groupSize;
+}
+
+size_t UDPSender::buildParity(uint8_t* packet) {
+    // Parity packets don't consume sequence numbers; the header names the
+    // first packet covered and frameCount the number of packets
+    writeHeader(packet, m_fecFirstSequence, static_cast<uint16_t>(m_fecCount), kPacketFlagFECParity);
+    std::memcpy(packet + AudioPacketHeader::kSize, m_fecParity, m_fecPayloadBytes);
+    m_fecCount = 0;
+    return AudioPacketHeader::kSize + m_fecPayloadBytes;
+}
+
+void UDPSender::transmit(const uint8_t* packet, size_t size, PacketKind kind) {
+    trackListeners();
+    uint32_t copies = m_localTransport ? 1 : 0;
+    for (size_t i = 0; i < m_listenerCount; ++i) {
+        copies += m_listeners[i].catchingUp ? 0 : 1;
+    }
+    if (copies > 0) {
+        const uint32_t delivery = beginDelivery(copies);
+        for (size_t i = 0; i < m_listenerCount; ++i) {
+            // Receivers catching up get this packet from the pre-roll, in order
+            if (!m_listeners[i].catchingUp) {
+                transmitTo(packet, size, kind, delivery, &m_udp, m_listeners[i].address);
+            }
+        }
+        if (m_localTransport) {
+            transmitTo(packet, size, kind, delivery, m_localTransport.get(), 0);
+        }
+    }
+    
+    // Parity and spectrum packets are only worth anything live
+    if (m_preRollCapacity > 0 && (kind == PacketKind::Audio || kind == PacketKind::Keepalive)) {
+        recordPreRoll(packet, size);
+        sendPreRoll();
+    }
+}
+
+void UDPSender::trackListeners() {
+    const uint64_t now = nowNanos();
+    const size_t count = m_destinationCount.load(std::memory_order_acquire);
+    bool changed = count != m_listenerCount;
+    for (size_t i = 0; i < count && !changed; ++i) {
+        changed = m_listeners[i].address != m_destinations[i].load(std::memory_order_relaxed);
+    }
+    
+    if (changed) {
+        // Keep the state of destinations still listed, wherever they moved;
+        // the rest joined (at session start there's no pre-roll to send yet)
+        Listener previous[ControlBlockPage::kMaxDestinations];
+        const size_t previousCount = m_listenerCount;
+        std::copy(m_listeners, m_listeners + previousCount, previous);
+        for (size_t i = 0; i < count; ++i) {
+            const uint64_t address = m_destinations[i].load(std::memory_order_relaxed);
+            const Listener* known = std::find_if(previous, previous + previousCount,
+                                                 [address](const Listener& l) { return l.address == address; });
+            m_listeners[i] = known != previous + previousCount ? *known : Listener();
+            m_listeners[i].address = address;
+            if (known == previous + previousCount) {
+                startCatchUp(m_listeners[i], now);
+            }
+        }
+        m_listenerCount = count;
+    }
+    
+    for (std::atomic<uint32_t>& request : m_preRollRequests) {
+        if (request.load(std::memory_order_relaxed) == 0) {
+            continue;
+        }
+        const uint32_t ip = request.exchange(0, std::memory_order_acquire);
+        for (size_t i = 0; i < m_listenerCount; ++i) {
+            if (static_cast<uint32_t>(m_listeners[i].address >> 16) == ip) {
+                startCatchUp(m_listeners[i], now);
+            }
+        }
+    }
+}
+
+void UDPSender::startCatchUp(Listener& listener, uint64_t now) {
+    if (listener.catchingUp || m_preRollWritten == 0) {
+        return;
+    }
+    
+    // Fill the receiver's buffer, not more: anything deeper only adds latency
+    uint64_t depthMs = m_config.preRollMs;
+    const uint16_t bufferMs = m_negotiatedBufferMs.load(std::memory_order_relaxed);
+    if (bufferMs > 0) {
+        depthMs = std::min<uint64_t>(depthMs, bufferMs);
+    }
+    const uint64_t depthNanos = depthMs * 1000000ULL;
+    
+    const uint64_t oldest = m_preRollWritten > m_preRollCapacity ? m_preRollWritten - m_preRollCapacity : 0;
+    uint64_t first = m_preRollWritten;
+    while (first > oldest && now - m_preRoll[(first - 1) % m_preRollCapacity].sentNanos <= depthNanos) {
+        --first;
+    }
+    if (first == m_preRollWritten) {
+        return;
+    }
+    
+    listener.nextPacket = first;
+    listener.catchingUp = true;
+    m_preRollBursts.fetch_add(1, std::memory_order_relaxed);
+    CYMAX_LOG_NETWORK("UDPSender: pre-roll of %llu packets (%llu ms) for a joining receiver",
+                      m_preRollWritten - first, depthMs);
+}
+
+void UDPSender::recordPreRoll(const uint8_t* packet, size_t size) {
+    PreRollPacket& kept = m_preRoll[m_preRollWritten % m_preRollCapacity];
+    std::memcpy(kept.data, packet, size);
+    kept.size = size;
+    kept.sentNanos = nowNanos();
+    ++m_preRollWritten;
+}
+
+void UDPSender::sendPreRoll() {
+    // A few pre-roll packets per live one: faster than real time, but
+    // paced so the burst doesn't overrun the socket or the link
+    const uint64_t oldest = m_preRollWritten > m_preRollCapacity ? m_preRollWritten - m_preRollCapacity : 0;
+    const size_t perPacket = std::max<size_t>(m_config.preRollSpeedup, 2);
+    for (size_t i = 0; i < m_listenerCount; ++i) {
+        Listener& listener = m_listeners[i];
+        if (!listener.catchingUp) {
+            continue;
+        }
+        
+        listener.nextPacket = std::max(listener.nextPacket, oldest);
+        for (size_t n = 0; n < perPacket && listener.nextPacket < m_preRollWritten; ++n) {
+            const PreRollPacket& kept = m_preRoll[listener.nextPacket++ % m_preRollCapacity];
+            transmitTo(kept.data, kept.size, PacketKind::PreRoll, beginDelivery(1), &m_udp, listener.address);
+        }
+        listener.catchingUp = listener.nextPacket < m_preRollWritten;
+    }
+}
+
+bool UDPSender::transmitTo(const uint8_t* packet, size_t size, PacketKind kind, uint32_t delivery,
+                           PacketTransport* transport, uint64_t address) {
+    m_copies.fetch_add(1, std::memory_order_relaxed);
+    
+    // Older packets are still held: queue behind them to keep order
+    if (m_pendingCount > 0) {
+        holdPending(packet, size, kind, delivery, transport, address);
+        flushPending(0);
+        return false;
+    }
+    
+    switch (transport->send(packet, size, address)) {
+        case TransportResult::Sent:
+            m_sentFirstTry.fetch_add(1, std::memory_order_relaxed);
+            settleCopy(delivery, true, packet, size, kind);
+            return true;
+        case TransportResult::WouldBlock:
+            m_wouldBlock.fetch_add(1, std::memory_order_relaxed);
+            holdPending(packet, size, kind, delivery, transport, address);
+            return false;
+        case TransportResult::Failed:
+            m_sendErrors.fetch_add(1, std::memory_order_relaxed);
+            settleCopy(delivery, false, packet, size, kind);
+            CYMAX_LOG_NETWORK("UDPSender: %{public}s send failed: %{public}s", transport->name(), strerror(errno));
+            return false;
+    }
+    return false;
+}
+
+uint32_t UDPSender::beginDelivery(uint32_t copies) {
+    // Never empty: every record in use but this one has a copy held
+    const uint32_t delivery = m_freeDeliveries[--m_freeDeliveryCount];
+    m_deliveries[delivery].outstanding = copies;
+    m_deliveries[delivery].sent = false;
+    return delivery;
+}
+
+void UDPSender::settleCopy(uint32_t delivery, bool sent, const uint8_t* packet, size_t size, PacketKind kind) {
+    Delivery& record = m_deliveries[delivery];
+    if (sent && !record.sent) {
+        record.sent = true;
+        countSent(packet, size, kind);
+    }
+    if (--record.outstanding == 0) {
+        if (!record.sent) {
+            m_packetsDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        m_freeDeliveries[m_freeDeliveryCount++] = delivery;
+    }
+}
+
+void UDPSender::holdPending(const uint8_t* packet, size_t size, PacketKind kind, uint32_t delivery,
+                            PacketTransport* transport, uint64_t address) {
+    if (m_pendingCount == m_pendingCapacity) {
+        // Drop-oldest: the newest audio is the most useful to the receiver
+        const PendingPacket& evicted = m_pending[m_pendingHead];
+        m_droppedOverflow.fetch_add(1, std::memory_order_relaxed);
+        settleCopy(evicted.delivery, false, evicted.data, evicted.size, evicted.kind);
+        m_pendingHead = (m_pendingHead + 1) % m_pendingCapacity;
+        --m_pendingCount;
+    }
+    
+    PendingPacket& held = m_pending[(m_pendingHead + m_pendingCount) % m_pendingCapacity];
+    std::memcpy(held.data, packet, size);
+    held.size = size;
+    held.kind = kind;
+    held.transport = transport;
+    held.address = address;
+    held.delivery = delivery;
+    held.heldNanos = nowNanos();
+    ++m_pendingCount;
+}
+
+void UDPSender::flushPending(uint64_t maxWaitNanos) {
+    const uint64_t waitUntil = nowNanos() + maxWaitNanos;
+    bool reportedWritable = false;
+    
+    while (m_pendingCount > 0) {
+        PendingPacket& oldest = m_pending[m_pendingHead];
+        const uint64_t now = nowNanos();
+        const uint64_t expires = oldest.heldNanos + m_sendDeadlineNanos;
+        
+        bool done = true;
+        if (now >= expires) {
+            m_droppedDeadline.fetch_add(1, std::memory_order_relaxed);
+            settleCopy(oldest.delivery, false, oldest.data, oldest.size, oldest.kind);
+        } else {
+            switch (oldest.transport->send(oldest.data, oldest.size, oldest.address)) {
+                case TransportResult::Sent:
+                    m_sentAfterRetry.fetch_add(1, std::memory_order_relaxed);
+                    settleCopy(oldest.delivery, true, oldest.data, oldest.size, oldest.kind);
+                    break;
+                case TransportResult::WouldBlock:
+                    m_wouldBlock.fetch_add(1, std::memory_order_relaxed);
+                    done = false;
+                    break;
+                case TransportResult::Failed:
+                    m_sendErrors.fetch_add(1, std::memory_order_relaxed);
+                    settleCopy(oldest.delivery, false, oldest.data, oldest.size, oldest.kind);
+                    CYMAX_LOG_NETWORK("UDPSender: %{public}s send failed: %{public}s",
+                                      oldest.transport->name(), strerror(errno));
+                    break;
+            }
+        }
+        
+        if (done) {
+            reportedWritable = false;
+            m_pendingHead = (m_pendingHead + 1) % m_pendingCapacity;
+            --m_pendingCount;
+            continue;
+        }
+        
+        // Still full: wait for room, but not past the caller's limit or the
+        // oldest packet's deadline
+        const uint64_t until = std::min(waitUntil, expires);
+        if (until <= now) {
+            return;
+        }
+        if (reportedWritable) {
+            SenderEnvironment::sleepNanos(std::min(until - now, kRetryBackoffNanos));
+            reportedWritable = false;
+            continue;
+        }
+        if (oldest.transport->waitWritable(until - now)) {
+            reportedWritable = true;
+        } else if (nowNanos() >= waitUntil) {
+            return;
+        }
+    }
+}
+
+void UDPSender::countSent(const uint8_t* packet, size_t size, PacketKind kind) {
+    m_bytesSent.fetch_add(size, std::memory_order_relaxed);
+    switch (kind) {
+        case PacketKind::Audio: {
+            const uint64_t sent = m_packetsSent.fetch_add(1, std::memory_order_relaxed);
+            if (sent == 0) {
+                m_firstPacketNanos.store(nowNanos(), std::memory_order_release);
+                m_faultBaseline = currentThreadMinorFaults();
+            } else if (sent % kFaultSampleInterval == 0) {
+                m_steadyStateFaults.store(currentThreadMinorFaults() - m_faultBaseline, std::memory_order_relaxed);
+            }
+            break;
+        }
+        case PacketKind::Keepalive: {
+            const AudioPacketHeader* header = reinterpret_cast<const AudioPacketHeader*>(packet);
+            m_dtxPacketsSent.fetch_add(1, std::memory_order_relaxed);
+            m_dtxFrames.fetch_add(header->frameCount, std::memory_order_relaxed);
+            break;
+        }
+        case PacketKind::Spectrum:
+            m_spectrumPacketsSent.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case PacketKind::Parity:
+            m_fecPacketsSent.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case PacketKind::PreRoll:
+            m_preRollPacketsSent.fetch_add(1, std::memory_order_relaxed);
+            break;
+    }
+}
+
+void UDPSender::idleWait(uint64_t nanos) {
+    if (m_pendingCount > 0) {
+        flushPending(nanos);
+        return;
+    }
+    sleepFor(nanos);
+}
+
+void UDPSender::sleepFor(uint64_t nanos) {
+    const uint64_t due = nowNanos() + nanos;
+    SenderEnvironment::sleepNanos(nanos);
+    const uint64_t woke = nowNanos();
+    m_wakeLateness.record(woke > due ? woke - due : 0);
+}
+
+void UDPSender::applyThreadPriority(const char* threadName) {
+    if (!m_config.realtimeScheduling) {
+        ThreadPriority::setInteractive();
+        return;
+    }
+    
+    const double periodNanos = 1e9 * static_cast<double>(m_framesPerPacket) / m_config.sampleRate;
+    RealtimeSchedule schedule;
+    schedule.periodNanos = static_cast<uint64_t>(periodNanos);
+    schedule.computationNanos = static_cast<uint64_t>(periodNanos * kRealtimeComputationFraction);
+    schedule.constraintNanos = static_cast<uint64_t>(periodNanos * kRealtimeConstraintFraction);
+    schedule.cpu = m_config.cpuAffinity;
+    
+    const ThreadSchedulingClass obtained = ThreadPriority::setRealtime(schedule);
+    CYMAX_LOG_INFO("UDPSender: %{public}s thread scheduling %{public}s (period %.0f us)",
+                   threadName, ThreadPriority::className(obtained), periodNanos / 1000.0);
+}
+
+SendOutcomeStats UDPSender::sendOutcomes() const {
+    SendOutcomeStats stats;
+    stats.copies = m_copies.load(std::memory_order_relaxed);
+    stats.sentFirstTry = m_sentFirstTry.load(std::memory_order_relaxed);
+    stats.sentAfterRetry = m_sentAfterRetry.load(std::memory_order_relaxed);
+    stats.wouldBlock = m_wouldBlock.load(std::memory_order_relaxed);
+    stats.droppedDeadline = m_droppedDeadline.load(std::memory_order_relaxed);
+    stats.droppedOverflow = m_droppedOverflow.load(std::memory_order_relaxed);
+    stats.sendErrors = m_sendErrors.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void UDPSender::recordStage(SenderStage stage, uint64_t enteredNanos) {
+    StageCounters& counters = m_stageCounters[static_cast<size_t>(stage)];
+    const uint64_t elapsed = nowNanos() - enteredNanos;
+    counters.packets.fetch_add(1, std::memory_order_relaxed);
+    counters.totalNanos.fetch_add(elapsed, std::memory_order_relaxed);
+    if (elapsed > counters.maxNanos.load(std::memory_order_relaxed)) {
+        counters.maxNanos.store(elapsed, std::memory_order_relaxed);  // Single writer per stage
+    }
+    // The statistics second exchanges this with 0; losing a race only
+    // moves one sample into the neighbouring second
+    if (elapsed > counters.intervalMaxNanos.load(std::memory_order_relaxed)) {
+        counters.intervalMaxNanos.store(elapsed, std::memory_order_relaxed);
+    }
+}
+
+SenderStageStats UDPSender::stageStats(SenderStage stage) const {
+    const StageCounters& counters = m_stageCounters[static_cast<size_t>(stage)];
+    SenderStageStats stats;
+    stats.packets = counters.packets.load(std::memory_order_relaxed);
+    stats.dropped = counters.dropped.load(std::memory_order_relaxed);
+    stats.stalls = counters.stalls.load(std::memory_order_relaxed);
+    if (stats.packets > 0) {
+        stats.meanLatencyMicros = static_cast<double>(counters.totalNanos.load(std::memory_order_relaxed)) /
+                                  static_cast<double>(stats.packets) / 1000.0;
+    }
+    stats.maxLatencyMicros = static_cast<double>(counters.maxNanos.load(std::memory_order_relaxed)) / 1000.0;
+    return stats;
+}
+
+void UDPSender::threadMain(const char* name, void (UDPSender::*session)(), bool ownsTransmit) {
+    CYMAX_LOG_INFO("UDPSender: %{public}s thread started", name);
+    
+    while (waitForSession()) {
+        applyThreadPriority(name);
+        (this->*session)();
+        
+        // Parked threads hold no reservation, so the next start() wakes
+        // them at once instead of at their next period
+        ThreadPriority::clearRealtime();
+        
+        if (ownsTransmit) {
+            if (m_localTransport) {
+                m_localTransport->flush();
+            }
+            if (m_firstPacketNanos.load(std::memory_order_acquire) != 0) {
+                m_steadyStateFaults.store(currentThreadMinorFaults() - m_faultBaseline, std::memory_order_relaxed);
+            }
+            logSessionStats();
+        }
+    }
+    
+    CYMAX_LOG_INFO("UDPSender: %{public}s thread exiting", name);
+}
+
+void UDPSender::senderSession() {
+    // Silent frames not yet covered by a DTX keepalive
+    uint32_t pendingDTXFrames = 0;
+    const uint32_t dtxIntervalFrames = static_cast<uint32_t>(m_config.sampleRate * kDTXIntervalSeconds);
+    
+    while (m_active.load(std::memory_order_acquire)) {
+        pollControlBlock();
+        pollNegotiation();
+        updateStatistics();
+        
         // Check if we have a destination
         if (!m_hasDestination.load(std::memory_order_acquire)) {
             // No destination, just drain the ring buffer to prevent buildup
-            size_t available = m_ringBuffer->availableForRead();
-            if (available > 0) {
-                m_ringBuffer->dropFrames(available);
-                m_framesDropped.fetch_add(available, std::memory_order_relaxed);
-            }
+            drainSource();
             
             // Sleep briefly and continue
-            struct timespec ts = {0, 1000000};  // 1ms
-            nanosleep(&ts, nullptr);
+            SenderEnvironment::sleepNanos(1000000);  // 1ms
             continue;
         }
         
-        // Try to read enough frames for a packet
-        size_t framesRead = m_ringBuffer->read(audioSamples.data(), m_config.framesPerPacket);
+        // Get one packet's worth of audio, with header room in front
+        size_t framesRead = 0;
+        uint8_t* packet = acquireAudio(framesRead);
+        if (!packet) {
+            // Not enough data yet, wait a bit (retrying held packets)
+            idleWait(500000);  // 0.5ms
+            continue;
+        }
+        const uint64_t acquired = nowNanos();
+        
+        float* audioSamples = reinterpret_cast<float*>(packet + AudioPacketHeader::kSize);
+        applyOutputGain(audioSamples, framesRead);
         
-        if (framesRead < m_config.framesPerPacket) {
-            // Not enough data yet, wait a bit
-            struct timespec ts = {0, 500000};  // 0.5ms
-            nanosleep(&ts, nullptr);
+        // Fully muted: stop sending audio, keep the receiver's session alive
+        if (isFullyMuted()) {
+            pendingDTXFrames += static_cast<uint32_t>(framesRead);
+            releaseAudio();
+            if (pendingDTXFrames >= dtxIntervalFrames) {
+                transmit(m_packetBuffer, buildKeepalive(m_packetBuffer, pendingDTXFrames), PacketKind::Keepalive);
+                pendingDTXFrames = 0;
+            }
             continue;
         }
+        pendingDTXFrames = 0;
         
-        // Build the packet header
-        AudioPacketHeader* header = reinterpret_cast<AudioPacketHeader*>(m_packetBuffer);
-        header->magic = AudioPacketHeader::kMagic;
-        header->sequence = m_sequence.fetch_add(1, std::memory_order_relaxed);
-        header->timestamp = machTimeToNanos(mach_absolute_time());
-        header->sampleRate = m_config.sampleRate;
-        header->channels = m_config.channels;
-        header->frameCount = static_cast<uint16_t>(framesRead);
-        header->format = m_config.useFloat32 ? 1 : 2;
-        header->flags = 0;
+        // Build the header in the room reserved in front of the samples
+        const size_t packetSize = buildAudioPacket(packet, audioSamples, framesRead);
+        recordStage(SenderStage::Encode, acquired);
         
-        // Copy audio data after header
-        const size_t audioBytes = framesRead * m_config.channels * sizeof(float);
-        std::memcpy(m_packetBuffer + AudioPacketHeader::kSize, audioSamples.data(), audioBytes);
+        const uint64_t sending = nowNanos();
+        transmit(packet, packetSize, PacketKind::Audio);
+        recordStage(SenderStage::Transmit, sending);
         
-        // Send the packet
-        const size_t packetSize = AudioPacketHeader::kSize + audioBytes;
-        ssize_t sent = sendto(m_socket, m_packetBuffer, packetSize, 0,
-                              reinterpret_cast<struct sockaddr*>(&m_destAddr),
-                              sizeof(m_destAddr));
+        const bool parityReady = addToParity(packet, packetSize);
+        releaseAudio();
+        if (parityReady) {
+            transmit(m_packetBuffer, buildParity(m_packetBuffer), PacketKind::Parity);
+        }
         
-        if (sent < 0) {
-            if (errno != EAGAIN && errno != EWOULDBLOCK) {
-                m_packetsDropped.fetch_add(1, std::memory_order_relaxed);
-                CYMAX_LOG_NETWORK("UDPSender: send failed: %{public}s", strerror(errno));
-            }
-        } else {
-            m_packetsSent.fetch_add(1, std::memory_order_relaxed);
+        if (const size_t spectrumSize = buildSpectrum(m_packetBuffer)) {
+            transmit(m_packetBuffer, spectrumSize, PacketKind::Spectrum);
         }
         
         // Small yield to prevent CPU spinning
-        struct timespec ts = {0, 100000};  // 0.1ms
-        nanosleep(&ts, nullptr);
+        idleWait(100000);  // 0.1ms
+    }
+    
+    // Publish the partial last window for the session log
+    m_sourceFill.closeWindow();
+}
+
+#pragma mark - Pipeline
+
+UDPSender::PipelinePacket* UDPSender::takeFreePacket(bool wait) {
+    PipelinePacket* packet = nullptr;
+    while (!m_freePackets->tryPop(packet)) {
+        if (!wait || !m_active.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        // Downstream is behind: hold off reading so the source ring drops
+        // its oldest audio instead of this stage queueing stale packets
+        m_stageCounters[static_cast<size_t>(SenderStage::Encode)].stalls.fetch_add(1, std::memory_order_relaxed);
+        m_freePackets->waitForData();
+    }
+    return packet;
+}
+
+void UDPSender::encoderSession() {
+    StageCounters& counters = m_stageCounters[static_cast<size_t>(SenderStage::Encode)];
+    PipelinePacket* spare = nullptr;
+    uint32_t pendingDTXFrames = 0;
+    const uint32_t dtxIntervalFrames = static_cast<uint32_t>(m_config.sampleRate * kDTXIntervalSeconds);
+    
+    auto forward = [this](PipelinePacket* packet, uint64_t entered) {
+        recordStage(SenderStage::Encode, entered);
+        packet->enteredNanos = nowNanos();
+        m_encodedQueue->tryPush(packet);  // Sized for the whole pool; can't fail
+    };
+    
+    while (m_active.load(std::memory_order_acquire)) {
+        pollControlBlock();
+        pollNegotiation();
+        updateStatistics();
+        
+        if (!m_hasDestination.load(std::memory_order_acquire)) {
+            drainSource();
+            SenderEnvironment::sleepNanos(1000000);  // 1ms
+            continue;
+        }
+        
+        size_t framesRead = 0;
+        uint8_t* source = acquireAudio(framesRead);
+        if (!source) {
+            sleepFor(500000);  // 0.5ms
+            continue;
+        }
+        const uint64_t acquired = nowNanos();
+        
+        float* audioSamples = reinterpret_cast<float*>(source + AudioPacketHeader::kSize);
+        applyOutputGain(audioSamples, framesRead);
+        
+        if (isFullyMuted()) {
+            pendingDTXFrames += static_cast<uint32_t>(framesRead);
+            releaseAudio();
+            if (pendingDTXFrames >= dtxIntervalFrames) {
+                PipelinePacket* packet = spare ? spare : takeFreePacket(true);
+                spare = nullptr;
+                if (packet) {
+                    packet->size = buildKeepalive(packet->data, pendingDTXFrames);
+                    packet->kind = PacketKind::Keepalive;
+                    forward(packet, acquired);
+                }
+                pendingDTXFrames = 0;
+            }
+            continue;
+        }
+        pendingDTXFrames = 0;
+        
+        PipelinePacket* packet = spare ? spare : takeFreePacket(true);
+        spare = nullptr;
+        if (!packet) {
+            releaseAudio();
+            break;  // Stopping
+        }
+        packet->size = buildAudioPacket(packet->data, audioSamples, framesRead);
+        packet->kind = PacketKind::Audio;
+        releaseAudio();
+        forward(packet, acquired);
+        
+        // Spectra are best-effort: never wait for a buffer. A buffer taken
+        // when no spectrum was ready is kept for next time (only the
+        // transmitter may return buffers to the free queue).
+        if (m_spectrumSource && m_sendSpectrum.load(std::memory_order_relaxed)) {
+            PipelinePacket* side = spare ? spare : takeFreePacket(false);
+            spare = nullptr;
+            if (!side) {
+                counters.dropped.fetch_add(1, std::memory_order_relaxed);
+            } else if ((side->size = buildSpectrum(side->data)) > 0) {
+                side->kind = PacketKind::Spectrum;
+                forward(side, nowNanos());
+            } else {
+                spare = side;
+            }
+        }
+        
+        sleepFor(100000);  // 0.1ms
+    }
+    
+    m_sourceFill.closeWindow();
+}
+
+void UDPSender::fecSession() {
+    StageCounters& counters = m_stageCounters[static_cast<size_t>(SenderStage::FEC)];
+    
+    while (m_active.load(std::memory_order_acquire)) {
+        PipelinePacket* packet = nullptr;
+        if (!m_encodedQueue->tryPop(packet)) {
+            m_encodedQueue->waitForData();
+            continue;
+        }
+        
+        const bool parityReady = packet->kind == PacketKind::Audio &&
+                                 addToParity(packet->data, packet->size);
+        
+        recordStage(SenderStage::FEC, packet->enteredNanos);
+        packet->enteredNanos = nowNanos();
+        m_sendQueue->tryPush(packet);  // Sized for the whole pool; can't fail
+        
+        if (parityReady) {
+            // Parity is expendable: if the transmitter is holding every
+            // parity buffer, skip this group rather than delay audio
+            PipelinePacket* parity = nullptr;
+            if (m_freeParity->tryPop(parity)) {
+                parity->size = buildParity(parity->data);
+                parity->kind = PacketKind::Parity;
+                parity->enteredNanos = nowNanos();
+                m_sendQueue->tryPush(parity);
+            } else {
+                m_fecCount = 0;
+                counters.dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void UDPSender::transmitSession() {
+    while (m_active.load(std::memory_order_acquire)) {
+        PipelinePacket* packet = nullptr;
+        if (!m_sendQueue->tryPop(packet)) {
+            if (m_pendingCount > 0) {
+                // Poll for writability in short steps so new packets
+                // are still noticed
+                flushPending(1000000);  // 1ms
+            } else {
+                m_sendQueue->waitForData();
+            }
+            continue;
+        }
+        
+        transmit(packet->data, packet->size, packet->kind);
+        recordStage(SenderStage::Transmit, packet->enteredNanos);
+        
+        if (packet->kind == PacketKind::Parity) {
+            m_freeParity->tryPush(packet);
+        } else {
+            m_freePackets->tryPush(packet);
+        }
+    }
+}
+
+void UDPSender::applyOutputGain(float* samples, size_t frames) {
+    if (!m_controlState) {
+        return;
+    }
+    
+    const float scalar = m_controlState->volumeScalar.load(std::memory_order_relaxed);
+    const float target = m_controlState->muted.load(std::memory_order_relaxed) ? 0.0f : scalar * scalar;
+    
+    const Kernels::KernelTable& kernels = Kernels::active();
+    const size_t count = frames * m_config.channels;
+    
+    if (target == m_currentGain) {
+        if (m_currentGain != 1.0f) {
+            kernels.applyGain(samples, count, m_currentGain);
+        }
+        return;
+    }
+    
+    // Limit the change this packet so a full-scale jump takes kGainRampSeconds
+    const float maxStep = static_cast<float>(frames) / (m_config.sampleRate * kGainRampSeconds);
+    float endGain = target;
+    if (endGain > m_currentGain + maxStep) {
+        endGain = m_currentGain + maxStep;
+    } else if (endGain < m_currentGain - maxStep) {
+        endGain = m_currentGain - maxStep;
     }
     
-    CYMAX_LOG_INFO("UDPSender: thread exiting");
+    kernels.applyGainRamp(samples, frames, m_config.channels, m_currentGain, endGain);
+    m_currentGain = endGain;
 }
 
 bool UDPSender::sendPacket() {
@@ -6,7 +6,8 @@
 //
 //  SAFETY CONSTRAINTS:
 //  - Runs on a dedicated non-real-time thread
-//  - Uses non-blocking sockets only
+//  - Uses non-blocking sockets only (or a local backend, see
+//    PacketTransport.hpp)
 //  - NO TCP sockets in this class
 //  - If it falls behind, it drops audio frames (never blocks render)
 //
@@ -22,15 +23,26 @@
 #ifndef UDPSender_hpp
 #define UDPSender_hpp
 
+#include "CapabilityNegotiation.hpp"
+#include "ControlBlock.hpp"
+#include "FillLevelHistogram.hpp"
+#include "PacketTransport.hpp"
+#include "SenderTimeSeries.hpp"
+#include "SPSCQueue.hpp"
+#include "ThreadPriority.hpp"
+#include "RealtimeArena.hpp"
 #include <atomic>
+#include <memory>
 #include <thread>
 #include <cstdint>
-#include <netinet/in.h>
+#include <vector>
 
 namespace Cymax {
 
-// Forward declaration
+// Forward declarations
 template<typename T> class RingBuffer;
+class PacketRing;
+class SpectrumAnalyzer;
 
 /// Configuration for the UDP sender
 struct UDPSenderConfig {
@@ -46,11 +58,107 @@ struct UDPSenderConfig {
     /// Target destination port
     uint16_t destPort = 19620;
     
-    /// Destination IP address (set via setDestination)
+    /// Destination IP address (set via setDestination or the control block)
     char destIP[64] = {0};
     
-    /// Whether to use Float32 (true) or Int16 (false)
+    /// Whether to use Float32 (true) or Int16 (false). With negotiation
+    /// this is what receivers that don't negotiate get.
     bool useFloat32 = true;
+    
+    /// Run encode, FEC and transmit on separate threads connected by
+    /// queues, so slow stages overlap instead of serializing
+    bool pipelined = false;
+    
+    /// Audio packets per XOR parity packet (0 = no FEC). Parity packets
+    /// carry kPacketFlagFECParity, which older receivers would misread.
+    uint16_t fecGroupSize = 0;
+    
+    /// Ask UDP destinations what they play at session start and send the
+    /// cheapest profile they share (see CapabilityNegotiation.hpp)
+    bool negotiateProfile = true;
+    
+    /// Largest parity group offered to receivers that negotiate FEC
+    /// (0 = never offer it); larger groups cost less bandwidth
+    uint16_t maxNegotiatedFECGroup = 8;
+    
+    /// Audio kept for receivers that join or resync mid-session, in
+    /// milliseconds (0 = off). They get it as a burst, so playback starts
+    /// at their buffer depth instead of filling it in real time.
+    uint16_t preRollMs = 150;
+    
+    /// Pre-roll packets sent to a catching-up receiver per live packet
+    /// (at least 2, or it never catches up)
+    uint16_t preRollSpeedup = 4;
+    
+    /// Latency budget for the send path in milliseconds. Sizes SO_SNDBUF so
+    /// the kernel can't queue much more than this, and bounds how long a
+    /// packet the socket pushed back on is retried before it is dropped.
+    uint16_t sendLatencyMs = 20;
+    
+    /// Run sender threads under a real-time reservation derived from the
+    /// packet interval (see ThreadPriority); otherwise QoS only
+    bool realtimeScheduling = true;
+    
+    /// Pin sender threads to this CPU where supported (-1 = any)
+    int cpuAffinity = -1;
+};
+
+/// Output volume/mute state
+/// Written by the HAL control objects, read by the sender thread which
+/// ramps towards it so changes never click.
+struct OutputControlState {
+    /// Volume slider position (0.0 - 1.0); gain applied is scalar^2
+    std::atomic<float> volumeScalar{1.0f};
+    
+    /// When muted the sender stops sending audio and sends DTX keepalives
+    std::atomic<bool> muted{false};
+};
+
+/// Size of the header in front of every packet's payload
+static constexpr size_t kPacketHeaderBytes = 28;
+
+/// Packet header flags
+/// DTX: header-only keepalive standing in for frameCount silent frames
+static constexpr uint16_t kPacketFlagDTX = 0x0001;
+/// Spectrum: side-channel packet, frameCount 0, payload is one byte per
+/// band (0 = floor, 255 = 0 dB) instead of audio
+static constexpr uint16_t kPacketFlagSpectrum = 0x0002;
+/// FEC parity: payload is the XOR of the payloads of frameCount consecutive
+/// audio packets starting at sequence; does not consume a sequence number
+static constexpr uint16_t kPacketFlagFECParity = 0x0004;
+
+/// Sender pipeline stages (see UDPSenderConfig::pipelined)
+enum class SenderStage {
+    Encode,    // Ring read, gain, DTX, header and payload
+    FEC,       // Parity generation
+    Transmit,  // sendto()
+    Count
+};
+
+/// Per-stage sender statistics
+/// Latency is from entering the stage (including queue wait) to leaving it.
+struct SenderStageStats {
+    uint64_t packets = 0;            // Packets that left the stage
+    uint64_t dropped = 0;            // Packets the stage discarded by policy
+    uint64_t stalls = 0;             // Waits on a full downstream
+    double meanLatencyMicros = 0.0;
+    double maxLatencyMicros = 0.0;
+};
+
+/// What happened to each copy of a packet handed to a transport
+/// A packet goes out as one copy per destination. Every copy ends up in
+/// exactly one of sentFirstTry, sentAfterRetry, droppedDeadline,
+/// droppedOverflow or sendErrors (or is still pending). The packet itself
+/// is counted once: in packetsSent (or the counter for its kind) when its
+/// first copy leaves, in packetsDropped when none does.
+struct SendOutcomeStats {
+    uint64_t copies = 0;             // Copies handed to a transport
+    uint64_t sentFirstTry = 0;       // Accepted by the first sendto()
+    uint64_t sentAfterRetry = 0;     // Held after the socket pushed back, sent later
+    uint64_t wouldBlock = 0;         // sendto() calls that returned EAGAIN/ENOBUFS
+    uint64_t droppedDeadline = 0;    // Still unsent when the latency budget ran out
+    uint64_t droppedOverflow = 0;    // Oldest held packet evicted for a newer one
+    uint64_t sendErrors = 0;         // Other sendto() errors
 };
 
 /// UDP audio packet sender
@@ -69,18 +177,78 @@ public:
     /// @return true if initialization succeeded
     bool initialize(RingBuffer<float>* ringBuffer, const UDPSenderConfig& config);
     
-    /// Set the destination IP address
-    /// @param ipAddress IPv4 address string (e.g., "172.20.10.1")
+    /// Set the volume/mute state the sender applies (owned by device)
+    /// Call before start(); nullptr means unity gain, never muted
+    void setControlState(const OutputControlState* state) { m_controlState = state; }
+    
+    /// Send from a ring of packet slots filled by the render thread instead
+    /// of re-framing the sample ring. Call before start(); not owned;
+    /// nullptr reverts to the sample ring.
+    /// @return false (and the sample ring is used) unless every slot holds
+    ///         a whole packet of the configured channels (slotFitsPacket())
+    bool setPacketRing(PacketRing* packetRing);
+    
+    /// Whether packet slots of this shape hold a whole packet: room for
+    /// the header in front, and header plus samples within one packet
+    static constexpr bool slotFitsPacket(size_t headerRoom, size_t framesPerSlot, size_t channels) {
+        return headerRoom >= kPacketHeaderBytes && framesPerSlot > 0 && channels > 0 &&
+               headerRoom + framesPerSlot * channels * sizeof(float) <= kMaxPacketSize;
+    }
+    
+    /// Set the analyzer whose spectra may be sent as side-channel packets
+    /// Call before start(); not owned
+    void setSpectrumSource(SpectrumAnalyzer* analyzer) { m_spectrumSource = analyzer; }
+    
+    /// Enable/disable spectrum side-channel packets (off by default;
+    /// receivers that predate kPacketFlagSpectrum would misread them)
+    void setSpectrumSideChannel(bool enabled) { m_sendSpectrum.store(enabled, std::memory_order_relaxed); }
+    bool spectrumSideChannel() const { return m_sendSpectrum.load(std::memory_order_relaxed); }
+    
+    /// Set the control block the sender follows (owned by device)
+    /// Checked once per packet; a new generation replaces the destinations
+    /// and profile within a packet. Call before start(); nullptr = none.
+    void setControlBlock(const ControlBlock* controlBlock) { m_controlBlock = controlBlock; }
+    
+    /// Set a single destination IP address
+    /// @param ipAddress IPv4 address string (e.g., "172.20.10.1"), or a
+    ///        local backend, passed to setLocalDestination()
     /// @return true if address is valid
     bool setDestination(const char* ipAddress);
     
-    /// Start the sender thread
+    /// Also send every packet to a local backend: "shm:" (packet ring for
+    /// a local consumer), "file:name" (capture file in the driver's output
+    /// directory) or "null:"
+    /// Kept alongside the UDP destinations, which the control block may
+    /// replace. Call while stopped (waits for a stop() still finishing);
+    /// nullptr removes it.
+    /// @return true if the backend was opened (or removed)
+    bool setLocalDestination(const char* destination);
+    
+    /// Number of UDP destinations each packet is sent to
+    size_t destinationCount() const { return m_destinationCount.load(std::memory_order_acquire); }
+    
+    /// The local backend, if any (valid until setLocalDestination())
+    const PacketTransport* localTransport() const { return m_localTransport.get(); }
+    
+    /// Start sending (creates the sender threads on first use, otherwise
+    /// unparks them)
     /// @return true if started successfully
     bool start();
     
-    /// Stop the sender thread
+    /// Stop sending without waiting: the sender threads finish their
+    /// current packet and park, keeping the socket, buffers and threads
+    /// for the next start()
     void stop();
     
+    /// Block until a previous stop() has taken effect: every sender thread
+    /// parked and no longer touching the rings. Normally returns at once.
+    void waitUntilIdle() { waitForThreadsParked(); }
+    
+    /// Free everything a session needs after stop(): join the threads,
+    /// close the socket, free the pending pool and pipeline packets, and
+    /// forget the ring (initialize() again before the next start())
+    void releaseResources();
+    
     /// Check if sender is running
     bool isRunning() const { return m_running.load(std::memory_order_acquire); }
     
@@ -93,30 +261,218 @@ public:
     /// Get packets sent count
     uint64_t packetsSent() const { return m_packetsSent.load(std::memory_order_relaxed); }
     
-    /// Get packets dropped count (due to network errors)
+    /// Get packets dropped count: packets no destination got (network
+    /// errors, or not sent within the latency budget; per-destination
+    /// outcomes are in sendOutcomes())
     uint64_t packetsDropped() const { return m_packetsDropped.load(std::memory_order_relaxed); }
     
     /// Get frames dropped count (due to falling behind)
     uint64_t framesDropped() const { return m_framesDropped.load(std::memory_order_relaxed); }
     
-    /// Get ring buffer high water mark (peak fill level in frames)
-    size_t ringBufferHighWater() const;
+    /// Get DTX keepalive packets sent while muted
+    uint64_t dtxPacketsSent() const { return m_dtxPacketsSent.load(std::memory_order_relaxed); }
+    
+    /// Get frames represented by DTX keepalives instead of audio
+    uint64_t dtxFrames() const { return m_dtxFrames.load(std::memory_order_relaxed); }
+    
+    /// Get spectrum side-channel packets sent
+    uint64_t spectrumPacketsSent() const { return m_spectrumPacketsSent.load(std::memory_order_relaxed); }
+    
+    /// Get FEC parity packets sent
+    uint64_t fecPacketsSent() const { return m_fecPacketsSent.load(std::memory_order_relaxed); }
+    
+    /// Get pre-roll packets sent to joining receivers (not in packetsSent),
+    /// and the bursts they were sent in
+    uint64_t preRollPacketsSent() const { return m_preRollPacketsSent.load(std::memory_order_relaxed); }
+    uint64_t preRollBursts() const { return m_preRollBursts.load(std::memory_order_relaxed); }
+    
+    /// Profile in use: sample format and parity group (0 = no FEC)
+    bool isSendingFloat32() const { return m_useFloat32.load(std::memory_order_relaxed); }
+    uint16_t activeFECGroupSize() const { return m_fecGroupSize.load(std::memory_order_relaxed); }
+    
+    /// Negotiation rounds finished this session
+    uint32_t negotiationRounds() const { return m_negotiationRounds.load(std::memory_order_relaxed); }
+    
+    /// Deepest jitter buffer the negotiating receivers asked for (0 = none said)
+    uint16_t negotiatedBufferMs() const { return m_negotiatedBufferMs.load(std::memory_order_relaxed); }
+    
+    /// Get the per-packet send outcomes (since start)
+    SendOutcomeStats sendOutcomes() const;
+    
+    /// Get how late the sender's timed waits woke up (since start)
+    LatenessStats wakeLateness() const { return m_wakeLateness.snapshot(); }
     
-    /// Reset ring buffer high water mark
-    void resetRingBufferHighWater();
+    /// Time from the last start() to its first audio packet leaving the
+    /// socket (0 until one has)
+    double timeToFirstPacketMicros() const;
+    
+    /// Minor page faults the sending thread has taken since its first
+    /// audio packet this session (sampled every kFaultSampleInterval
+    /// packets and at the end of the session); 0 is the steady state
+    uint64_t steadyStateMinorFaults() const { return m_steadyStateFaults.load(std::memory_order_relaxed); }
+    
+    /// Get statistics for one sender stage (since start)
+    SenderStageStats stageStats(SenderStage stage) const;
+    
+    /// Get the fill-level distribution of the ring the sender reads
+    /// (sampled on every read attempt; per kStatsIntervalNanos window and
+    /// since start)
+    FillLevelStats sourceFillLevel() const { return m_sourceFill.latest(); }
+    
+    /// Get rates over the last 1, 10 and 60 seconds and the per-second
+    /// history of this session (updated every kStatsIntervalNanos)
+    SenderRateSnapshot rateStats() const { return m_timeSeries.latest(); }
+    
+    /// Also publish rateStats() to a shared page (optional, non-fatal)
+    bool openStatsPage(const char* name) { return m_timeSeries.openSharedPage(name); }
     
     /// Update configuration (call when not running)
     void updateConfig(const UDPSenderConfig& config);
     
 private:
-    /// Main sender thread function
-    void senderThreadFunc();
+    enum class PacketKind : uint8_t { Audio, Keepalive, Spectrum, Parity, PreRoll };
+    struct Listener;
+    
+    /// Body of every sender thread: park until start(), run one session
+    /// until stop(), repeat until shutdownThreads()
+    /// @param ownsTransmit The thread that sends (logs the session stats)
+    void threadMain(const char* name, void (UDPSender::*session)(), bool ownsTransmit);
+    
+    /// One session of the single sender thread (all stages inline)
+    void senderSession();
+    
+    /// One session of each pipeline stage thread
+    void encoderSession();
+    void fecSession();
+    void transmitSession();
+    
+    /// Park the calling thread until a session starts
+    /// @return false when the thread should exit
+    bool waitForSession();
+    
+    /// Block until every sender thread is parked (start/shutdown)
+    void waitForThreadsParked();
+    
+    /// Wake pipeline stages blocked on their queues
+    void wakeQueues();
+    
+    /// Join the sender threads (destructor, or a pipelined/inline switch)
+    void shutdownThreads();
+    
+    void logSessionStats();
     
-    /// Create and configure the UDP socket
-    bool createSocket();
+    /// Ramp the current gain towards the control state target and apply it
+    /// @param samples Interleaved packet samples, modified in place
+    /// @param frames Frames in samples
+    void applyOutputGain(float* samples, size_t frames);
     
-    /// Close the socket
-    void closeSocket();
+    /// Drop everything queued in the audio source
+    void drainSource();
+    
+    /// Sample the source fill level (reading thread)
+    void recordSourceFill(size_t fillFrames) { m_sourceFill.record(fillFrames); }
+    
+    /// Close the statistics second once kStatsIntervalNanos have passed:
+    /// the fill window and a time series entry (reading thread, once per
+    /// loop)
+    void updateStatistics();
+    
+    /// Current lifetime totals for the time series
+    SenderCounterTotals counterTotals() const;
+    
+    /// Take one packet's worth of audio from the source
+    /// @return Packet start (header room, then framesRead frames), or
+    ///         nullptr if a whole packet isn't available yet
+    uint8_t* acquireAudio(size_t& framesRead);
+    
+    /// Return the audio from acquireAudio() to the source
+    void releaseAudio();
+    
+    /// Muted with the gain ramp finished
+    bool isFullyMuted() const;
+    
+    void writeHeader(uint8_t* packet, uint32_t sequence, uint16_t frameCount, uint16_t flags) const;
+    
+    /// Packet builders; each returns the packet size (0 = nothing to send)
+    size_t buildAudioPacket(uint8_t* packet, const float* samples, size_t frames);
+    size_t buildKeepalive(uint8_t* packet, uint32_t frames);
+    size_t buildSpectrum(uint8_t* packet);
+    size_t buildParity(uint8_t* packet);
+    
+    /// Fold an audio packet into the parity group
+    /// @return true when the group is complete and buildParity() is due
+    bool addToParity(const uint8_t* packet, size_t size);
+    
+    /// Whether m_packetRing (if any) fits slotFitsPacket() and the config
+    bool packetRingFits() const;
+    
+    /// Send a built packet to every destination
+    void transmit(const uint8_t* packet, size_t size, PacketKind kind);
+    
+    /// Send a copy of a built packet to one destination, or hold it in the
+    /// pending pool if the transport pushes back or older packets are
+    /// still held (keeps packets in order)
+    /// @param delivery The packet's record from beginDelivery()
+    /// @param address Destination within the transport
+    /// @return true if the copy was sent now
+    bool transmitTo(const uint8_t* packet, size_t size, PacketKind kind, uint32_t delivery,
+                    PacketTransport* transport, uint64_t address);
+    
+    /// Take a delivery record for a packet about to go out as copies
+    uint32_t beginDelivery(uint32_t copies);
+    
+    /// One copy of a packet was sent or dropped; counts the packet once,
+    /// on its first copy sent or its last copy dropped
+    void settleCopy(uint32_t delivery, bool sent, const uint8_t* packet, size_t size, PacketKind kind);
+    
+    /// Notice destinations that joined and receivers that asked to resync,
+    /// and start their pre-roll (transmitting thread)
+    void trackListeners();
+    
+    /// Keep a sequenced packet for the pre-roll
+    void recordPreRoll(const uint8_t* packet, size_t size);
+    
+    /// Send the next pre-roll packets to every receiver catching up
+    void sendPreRoll();
+    
+    /// Start sending a receiver the pre-roll from its buffer depth back
+    void startCatchUp(Listener& listener, uint64_t now);
+    
+    /// Apply a newer control block generation, if any (encoding thread)
+    void pollControlBlock();
+    
+    /// Run the capability negotiator and apply what a finished round chose
+    void pollNegotiation();
+    
+    /// Replace the destination list
+    void storeDestinations(const uint32_t* addresses, size_t count, uint16_t port);
+    
+    /// Retry held packets oldest first, dropping any past the deadline
+    /// @param maxWaitNanos How long to wait for the socket to become
+    ///        writable (0 = try once, never block)
+    void flushPending(uint64_t maxWaitNanos);
+    
+    /// Copy a packet into the pending pool, evicting the oldest if full
+    void holdPending(const uint8_t* packet, size_t size, PacketKind kind, uint32_t delivery,
+                     PacketTransport* transport, uint64_t address);
+    
+    /// Count a packet that left the socket (once, whatever its fan-out)
+    void countSent(const uint8_t* packet, size_t size, PacketKind kind);
+    
+    /// Sleep while idle, or spend the time retrying held packets
+    void idleWait(uint64_t nanos);
+    
+    /// Sleep, recording how late the thread woke
+    void sleepFor(uint64_t nanos);
+    
+    /// Apply the configured scheduling to the calling sender thread
+    void applyThreadPriority(const char* threadName);
+    
+    /// Size SO_SNDBUF from the latency budget
+    void configureSendBuffer();
+    
+    static uint64_t nowNanos();
+    void recordStage(SenderStage stage, uint64_t enteredNanos);
     
     /// Build and send one audio packet
     /// @return true if packet was sent successfully
@@ -125,17 +481,71 @@ private:
     // Ring buffer reference (owned by device)
     RingBuffer<float>* m_ringBuffer = nullptr;
     
+    // Packet slot ring, used instead of m_ringBuffer when set (owned by device)
+    PacketRing* m_packetRing = nullptr;
+    
     // Configuration
     UDPSenderConfig m_config;
     
-    // Socket
-    int m_socket = -1;
-    struct sockaddr_in m_destAddr;
+    // Volume/mute state (owned by device)
+    const OutputControlState* m_controlState = nullptr;
+    
+    // Gain currently applied (sender thread only)
+    float m_currentGain = 1.0f;
+    
+    // Frames per audio packet for this run
+    size_t m_framesPerPacket = 0;
+    
+    // Int16 payload conversion scratch
+    int16_t* m_int16Scratch = nullptr;               // In m_sessionArena
+    
+    // Spectrum side channel (analyzer not owned)
+    SpectrumAnalyzer* m_spectrumSource = nullptr;
+    std::atomic<bool> m_sendSpectrum{false};
     
-    // Sender thread
+    // UDP socket, open across sessions
+    UDPTransport m_udp;
+    
+    // Local backend, changed only while stopped
+    std::unique_ptr<PacketTransport> m_localTransport;
+    
+    // UDP destinations packed by UDPTransport::packAddress(), so the
+    // transmitting thread can read them while they're replaced
+    std::atomic<uint64_t> m_destinations[ControlBlockPage::kMaxDestinations] = {};
+    std::atomic<size_t> m_destinationCount{0};
+    
+    // Control block (owned by device) and the generation last applied
+    const ControlBlock* m_controlBlock = nullptr;
+    uint32_t m_controlGeneration = 0;
+    
+    // Profile in use: starts as configured, then what negotiation chose.
+    // Written by the encoding thread, read by the FEC thread too.
+    std::atomic<bool> m_useFloat32{true};
+    std::atomic<uint16_t> m_fecGroupSize{0};
+    CapabilityNegotiator m_negotiator;
+    std::atomic<uint32_t> m_negotiationRounds{0};
+    std::atomic<uint16_t> m_negotiatedBufferMs{0};
+    
+    // Sender thread, or the encoder when pipelined; parked between sessions
     std::thread m_senderThread;
+    std::thread m_fecThread;
+    std::thread m_transmitThread;
+    uint32_t m_threadCount = 0;
+    bool m_threadsPipelined = false;
     std::atomic<bool> m_running{false};
-    std::atomic<bool> m_shouldStop{false};
+    std::atomic<bool> m_active{false};             // Threads should be sending
+    std::atomic<bool> m_shutdown{false};           // Threads should exit
+    std::atomic<uint32_t> m_sessionSignal{0};      // Bumped to wake parked threads
+    std::atomic<uint32_t> m_parkedThreads{0};
+    
+    // Time to first packet
+    uint64_t m_startNanos = 0;
+    std::atomic<uint64_t> m_firstPacketNanos{0};
+    
+    // Minor faults on the sending thread since its first packet
+    static constexpr uint64_t kFaultSampleInterval = 512;  // Audio packets (~1.4 s)
+    uint64_t m_faultBaseline = 0;                          // Sending thread only
+    std::atomic<uint64_t> m_steadyStateFaults{0};
     std::atomic<bool> m_hasDestination{false};
     
     // Packet sequence number
@@ -143,15 +553,136 @@ private:
     
     // Statistics
     std::atomic<uint64_t> m_packetsSent{0};
+    std::atomic<uint64_t> m_bytesSent{0};
     std::atomic<uint64_t> m_packetsDropped{0};
     std::atomic<uint64_t> m_framesDropped{0};
+    std::atomic<uint64_t> m_dtxPacketsSent{0};
+    std::atomic<uint64_t> m_dtxFrames{0};
+    std::atomic<uint64_t> m_spectrumPacketsSent{0};
+    std::atomic<uint64_t> m_fecPacketsSent{0};
+    std::atomic<uint64_t> m_preRollPacketsSent{0};
+    std::atomic<uint64_t> m_preRollBursts{0};
+    std::atomic<uint64_t> m_copies{0};
+    std::atomic<uint64_t> m_sentFirstTry{0};
+    std::atomic<uint64_t> m_sentAfterRetry{0};
+    std::atomic<uint64_t> m_wouldBlock{0};
+    std::atomic<uint64_t> m_droppedDeadline{0};
+    std::atomic<uint64_t> m_droppedOverflow{0};
+    std::atomic<uint64_t> m_sendErrors{0};
+    
+    struct StageCounters {
+        std::atomic<uint64_t> packets{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> stalls{0};
+        std::atomic<uint64_t> totalNanos{0};
+        std::atomic<uint64_t> maxNanos{0};
+        std::atomic<uint64_t> intervalMaxNanos{0};  // Since the last statistics second
+    };
+    StageCounters m_stageCounters[static_cast<size_t>(SenderStage::Count)];
+    
+    // Wake-up lateness of timed waits (sender thread, or the encoder)
+    LatenessHistogram m_wakeLateness;
+    
+    // Source ring fill level and the rolling time series, both kept by
+    // whichever thread reads the source
+    static constexpr uint64_t kStatsIntervalNanos = 1000000000ULL;
+    FillLevelHistogram m_sourceFill;
+    SenderTimeSeries m_timeSeries;
+    uint64_t m_statsSecondStart = 0;               // Reading thread only
     
     // Preallocated packet buffer (no allocation in hot path)
     // Size = 28 byte header + max audio payload
     // For 128 frames stereo float32: 28 + 128*2*4 = 1052 bytes
     // Keep at 1500 to match MTU and allow some headroom
     static constexpr size_t kMaxPacketSize = 1500;
+    static_assert(kMaxPacketSize <= SharedPacketRingPage::kMaxPacketBytes, "Packets must fit a shared ring slot");
     uint8_t m_packetBuffer[kMaxPacketSize];
+    
+    // FEC parity group (sender thread, or FEC thread when pipelined)
+    uint8_t m_fecParity[kMaxPacketSize];
+    size_t m_fecPayloadBytes = 0;
+    uint32_t m_fecFirstSequence = 0;
+    uint32_t m_fecCount = 0;
+    
+    // Locked, pre-faulted memory for the session buffers the sender threads
+    // touch: pending pool, pipeline packets and int16 scratch. Carved again
+    // in every start(); re-reserved only if they outgrow it.
+    RealtimeArena m_sessionArena;
+    
+    // Pending pool: copies of packets the socket pushed back on, oldest at
+    // m_pendingHead. Allocated in start(), touched only by the thread that
+    // calls transmit().
+    struct PendingPacket {
+        uint8_t data[kMaxPacketSize];
+        size_t size = 0;
+        uint64_t heldNanos = 0;  // When the transport first pushed back
+        PacketTransport* transport = nullptr;
+        uint64_t address = 0;
+        uint32_t delivery = 0;   // Its packet's Delivery
+        PacketKind kind = PacketKind::Audio;
+    };
+    static constexpr size_t kMaxPendingPackets = 64;  // Per destination
+    PendingPacket* m_pending = nullptr;              // In m_sessionArena
+    size_t m_pendingCapacity = 0;
+    size_t m_pendingHead = 0;
+    size_t m_pendingCount = 0;
+    uint64_t m_sendDeadlineNanos = 0;
+    
+    // Deliveries: per built packet, the copies still unsettled. A record
+    // outlives transmit() only while a copy is held, so the pool needs one
+    // more than the pending pool; free ones are a stack of indices.
+    struct Delivery {
+        uint32_t outstanding = 0;  // Copies neither sent nor dropped yet
+        bool sent = false;         // A copy has left, the packet is counted
+    };
+    Delivery* m_deliveries = nullptr;                // In m_sessionArena
+    uint32_t* m_freeDeliveries = nullptr;            // In m_sessionArena
+    size_t m_freeDeliveryCount = 0;
+    
+    // Pre-roll: the last preRollMs of sequenced packets, and where each UDP
+    // destination is in it. Allocated in start(), touched only by the
+    // thread that calls transmit().
+    struct PreRollPacket {
+        uint8_t data[kMaxPacketSize];
+        size_t size = 0;
+        uint64_t sentNanos = 0;
+    };
+    struct Listener {
+        uint64_t address = 0;
+        uint64_t nextPacket = 0;  // Pre-roll index it gets next
+        bool catchingUp = false;  // Not sent live packets until caught up
+    };
+    PreRollPacket* m_preRoll = nullptr;              // In m_sessionArena
+    size_t m_preRollCapacity = 0;
+    uint64_t m_preRollWritten = 0;
+    Listener m_listeners[ControlBlockPage::kMaxDestinations];
+    size_t m_listenerCount = 0;
+    
+    // IPs of receivers that asked to resync (0 = free slot), handed from
+    // the encoding thread to the transmitting thread
+    std::atomic<uint32_t> m_preRollRequests[ControlBlockPage::kMaxDestinations] = {};
+    
+    // Pipeline: preallocated packets cycle encoder -> FEC -> transmitter
+    // and back through the free queues; every queue holds the whole pool,
+    // so pushes never fail and backpressure shows up as an empty free queue
+    struct PipelinePacket {
+        uint8_t data[kMaxPacketSize];
+        size_t size = 0;
+        uint64_t enteredNanos = 0;  // When the packet entered its current stage
+        PacketKind kind = PacketKind::Audio;
+    };
+    static constexpr size_t kPipelinePackets = 16;
+    static constexpr size_t kPipelineParityPackets = 4;
+    
+    /// Take a free pipeline packet (encoder thread)
+    /// @param wait Block while downstream holds every packet
+    PipelinePacket* takeFreePacket(bool wait);
+    
+    PipelinePacket* m_pipelinePackets = nullptr;     // In m_sessionArena
+    std::unique_ptr<SPSCQueue<PipelinePacket*>> m_freePackets;    // Transmitter -> encoder
+    std::unique_ptr<SPSCQueue<PipelinePacket*>> m_freeParity;     // Transmitter -> FEC
+    std::unique_ptr<SPSCQueue<PipelinePacket*>> m_encodedQueue;   // Encoder -> FEC
+    std::unique_ptr<SPSCQueue<PipelinePacket*>> m_sendQueue;      // FEC -> transmitter
 };
 
 } // namespace Cymax
@@ -0,0 +1,307 @@
+//
+//  CapabilityNegotiationTest.cpp
+//  CymaxPhoneOutDriver Tests
+//
+//  chooseProfile for receivers with different capabilities, legacy-only
+//  sets and mixes of the two; then CapabilityNegotiator rounds over
+//  SimulatedEnvironment's scripted socket: peers that never answer, short
+//  datagrams, wrong magic or type, answers to a stale round or from an
+//  unknown address, and round-0 resync requests, which only a configured
+//  destination may make
+//
+//  The negotiator is polled with its own clock values, so no sender runs.
+//
+
+#include "CapabilityNegotiation.hpp"
+#include "Check.hpp"
+#include "PacketTransport.hpp"
+#include "UDPSender.hpp"
+
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+using namespace Cymax;
+using Environment = SimulatedEnvironment;
+
+static constexpr uint64_t kMillis = 1000000;
+static constexpr uint16_t kAudioPort = 5000;
+
+static NegotiationOffer offer() {
+    NegotiationOffer offer;
+    offer.sampleRate = 48000;
+    offer.channels = 2;
+    offer.framesPerPacket = 128;
+    offer.legacyFloat32 = true;
+    offer.legacyFECGroup = 0;
+    offer.maxFECGroup = 8;
+    return offer;
+}
+
+static ReceiverCapabilities receiver(bool float32, bool int16, uint16_t maxFECGroup, uint16_t bufferMs) {
+    ReceiverCapabilities capabilities = {};
+    capabilities.maxChannels = 2;
+    capabilities.formats = static_cast<uint16_t>((float32 ? 1u << kSampleFormatFloat32 : 0u) |
+                                                 (int16 ? 1u << kSampleFormatInt16 : 0u));
+    capabilities.codecs = 1u << kCodecPCM;
+    capabilities.maxPacketBytes = 1500;
+    capabilities.maxFECGroup = maxFECGroup;
+    capabilities.bufferMs = bufferMs;
+    return capabilities;
+}
+
+static void testChooseProfile() {
+    NegotiatedProfile profile;
+
+    // Only one of them plays int16; FEC at the smaller of their groups
+    const ReceiverCapabilities mixed[] = {receiver(true, true, 4, 40), receiver(true, false, 8, 80)};
+    Test::check(chooseProfile(offer(), mixed, 2, 0, profile) && profile.useFloat32 && profile.fecGroupSize == 4 &&
+                    profile.bufferMs == 80 && profile.responders == 2 && profile.legacy == 0,
+                "mixed receivers get the format they share, FEC they all decode, the deepest buffer");
+
+    const ReceiverCapabilities compact[] = {receiver(true, true, 2, 40), receiver(false, true, 8, 20)};
+    Test::check(chooseProfile(offer(), compact, 2, 0, profile) && !profile.useFloat32 && profile.fecGroupSize == 2,
+                "receivers that all play int16 get int16");
+
+    ReceiverCapabilities small = receiver(true, true, 0, 0);
+    small.maxPacketBytes = static_cast<uint16_t>(kPacketHeaderBytes + 128 * 2 * sizeof(int16_t));
+    Test::check(chooseProfile(offer(), &small, 1, 0, profile) && !profile.useFloat32 && profile.fecGroupSize == 0,
+                "a float32 packet too big for the receiver falls back to int16");
+
+    NegotiationOffer legacyFEC = offer();
+    legacyFEC.legacyFECGroup = 4;
+    Test::check(chooseProfile(legacyFEC, nullptr, 0, 3, profile) && profile.useFloat32 &&
+                    profile.fecGroupSize == 4 && profile.responders == 0 && profile.legacy == 3,
+                "legacy-only receivers keep the legacy profile");
+
+    const ReceiverCapabilities int16Only = receiver(false, true, 8, 0);
+    Test::check(!chooseProfile(offer(), &int16Only, 1, 1, profile) && profile.useFloat32 &&
+                    profile.fecGroupSize == 0 && !profile.agreed && profile.responders == 1 && profile.legacy == 1,
+                "a responder that can't play the legacy profile next to a legacy receiver: no agreement");
+
+    ReceiverCapabilities mono = receiver(true, true, 8, 0);
+    mono.maxChannels = 1;
+    Test::check(!chooseProfile(offer(), &mono, 1, 0, profile), "too few channels: no agreement");
+
+    ReceiverCapabilities rates = receiver(true, true, 8, 0);
+    rates.sampleRates[0] = 44100;
+    Test::check(!chooseProfile(offer(), &rates, 1, 0, profile), "an unlisted sample rate: no agreement");
+    rates.sampleRates[1] = 48000;
+    Test::check(chooseProfile(offer(), &rates, 1, 0, profile), "a listed sample rate agrees");
+}
+
+#pragma mark - Negotiator
+
+/// Datagrams waiting at the sender's socket
+struct Datagram {
+    std::vector<uint8_t> bytes;
+    struct sockaddr_in from;
+};
+
+static std::deque<Datagram> gInbox;
+
+/// Messages the negotiator sent, by type
+static uint32_t gQueries = 0;
+static uint32_t gSelects = 0;
+static uint32_t gLastRound = 0;
+
+static uint32_t ipAddress(const char* ip) {
+    return inet_addr(ip);
+}
+
+static uint64_t destination(const char* ip) {
+    return UDPTransport::packAddress(ipAddress(ip), kAudioPort);
+}
+
+/// A Capabilities message as a receiver sends it
+static std::vector<uint8_t> capabilitiesMessage(uint32_t round, const ReceiverCapabilities& capabilities,
+                                                uint32_t magic = NegotiationHeader::kMagic,
+                                                NegotiationMessage type = NegotiationMessage::Capabilities) {
+    NegotiationHeader header;
+    header.magic = magic;
+    header.version = NegotiationHeader::kVersion;
+    header.type = static_cast<uint16_t>(type);
+    header.round = round;
+    std::vector<uint8_t> message(sizeof(header) + sizeof(capabilities));
+    std::memcpy(message.data(), &header, sizeof(header));
+    std::memcpy(message.data() + sizeof(header), &capabilities, sizeof(capabilities));
+    return message;
+}
+
+static void arrive(std::vector<uint8_t> bytes, const char* ip, uint16_t port = kAudioPort) {
+    Datagram datagram;
+    datagram.bytes = std::move(bytes);
+    std::memset(&datagram.from, 0, sizeof(datagram.from));
+    datagram.from.sin_family = AF_INET;
+    datagram.from.sin_addr.s_addr = ipAddress(ip);
+    datagram.from.sin_port = htons(port);
+    gInbox.push_back(datagram);
+}
+
+static void installEnvironment() {
+    Environment::advance = [](uint64_t) {};
+    Environment::oversleep = [](uint64_t) -> uint64_t { return 0; };
+    Environment::blocked = [](uint64_t) { return false; };
+    Environment::deliver = [](const uint8_t* data, size_t size, uint64_t) {
+        NegotiationHeader header;
+        if (size < sizeof(header)) {
+            return;
+        }
+        std::memcpy(&header, data, sizeof(header));
+        gLastRound = header.round;
+        if (header.type == static_cast<uint16_t>(NegotiationMessage::Query)) {
+            ++gQueries;
+        } else if (header.type == static_cast<uint16_t>(NegotiationMessage::Select)) {
+            ++gSelects;
+        }
+    };
+    Environment::arrive = [](uint8_t* data, size_t capacity, struct sockaddr_in& from) -> ssize_t {
+        if (gInbox.empty()) {
+            return -1;
+        }
+        const Datagram datagram = gInbox.front();
+        gInbox.pop_front();
+        const size_t size = std::min(capacity, datagram.bytes.size());
+        std::memcpy(data, datagram.bytes.data(), size);
+        from = datagram.from;
+        return static_cast<ssize_t>(size);
+    };
+}
+
+/// Poll every millisecond from start until a round finishes or until passes
+/// @return Time the round finished, or 0 if none did
+static uint64_t pollUntil(CapabilityNegotiator& negotiator, UDPTransport& udp, const uint64_t* destinations,
+                          size_t count, uint64_t start, uint64_t until, NegotiatedProfile& profile) {
+    for (uint64_t now = start; now <= until; now += kMillis) {
+        if (negotiator.poll(now, udp, destinations, count, offer(), 0, profile)) {
+            return now;
+        }
+    }
+    return 0;
+}
+
+static void resetMessages() {
+    gInbox.clear();
+    gQueries = 0;
+    gSelects = 0;
+}
+
+static void testNoAnswer(UDPTransport& udp) {
+    resetMessages();
+    CapabilityNegotiator negotiator;
+    negotiator.reset();
+    const uint64_t destinations[] = {destination("10.0.0.2"), destination("10.0.0.3")};
+    NegotiatedProfile profile;
+    const uint64_t finished = pollUntil(negotiator, udp, destinations, 2, kMillis, 2000 * kMillis, profile);
+    Test::check(finished > 0 && gQueries == 2 * CapabilityNegotiator::kQueryAttempts && gSelects == 0,
+                "peers that never answer get every query and no Select");
+    Test::check(finished >= kMillis + CapabilityNegotiator::kQueryAttempts * CapabilityNegotiator::kQueryIntervalNanos,
+                "a round nobody answers lasts the whole query window");
+    Test::check(profile.responders == 0 && profile.legacy == 2 && profile.useFloat32 && profile.fecGroupSize == 0,
+                "peers that never answer keep the legacy profile");
+}
+
+static void testOneAnswers(UDPTransport& udp) {
+    resetMessages();
+    CapabilityNegotiator negotiator;
+    negotiator.reset();
+    const uint64_t destinations[] = {destination("10.0.0.2"), destination("10.0.0.3")};
+    NegotiatedProfile profile;
+    Test::check(pollUntil(negotiator, udp, destinations, 2, kMillis, kMillis, profile) == 0 && gQueries == 2,
+                "a round starts by querying every destination");
+
+    arrive(capabilitiesMessage(gLastRound, receiver(true, true, 8, 60)), "10.0.0.2");
+    const uint64_t finished = pollUntil(negotiator, udp, destinations, 2, 2 * kMillis, 2000 * kMillis, profile);
+    Test::check(finished > 0 && profile.responders == 1 && profile.legacy == 1 && profile.useFloat32 &&
+                    profile.fecGroupSize == 0 && profile.bufferMs == 60 && gSelects == 1,
+                "one answer next to a silent peer: legacy profile, Select to the one that answered");
+}
+
+static void testParsing(UDPTransport& udp) {
+    resetMessages();
+    CapabilityNegotiator negotiator;
+    negotiator.reset();
+    const uint64_t destinations[] = {destination("10.0.0.2")};
+    const ReceiverCapabilities capabilities = receiver(true, true, 4, 40);
+    NegotiatedProfile profile;
+
+    // Round 1, answered at once
+    pollUntil(negotiator, udp, destinations, 1, kMillis, kMillis, profile);
+    arrive(capabilitiesMessage(gLastRound, capabilities), "10.0.0.2");
+    uint64_t now = pollUntil(negotiator, udp, destinations, 1, 2 * kMillis, 2 * kMillis, profile);
+    Test::check(now > 0 && negotiator.rounds() == 1 && !profile.useFloat32 && profile.fecGroupSize == 4,
+                "an answer to the current round finishes it");
+
+    // Round 2: everything malformed, stale or from elsewhere is ignored
+    negotiator.restart();
+    now += CapabilityNegotiator::kMinRoundIntervalNanos;
+    pollUntil(negotiator, udp, destinations, 1, now, now, profile);
+    const uint32_t round = gLastRound;
+    std::vector<uint8_t> shortMessage = capabilitiesMessage(round, capabilities);
+    shortMessage.pop_back();
+    arrive(shortMessage, "10.0.0.2");
+    arrive(std::vector<uint8_t>(shortMessage.begin(), shortMessage.begin() + sizeof(NegotiationHeader)), "10.0.0.2");
+    arrive({}, "10.0.0.2");
+    arrive(capabilitiesMessage(round, capabilities, 0x584D4143), "10.0.0.2");
+    arrive(capabilitiesMessage(round, capabilities, NegotiationHeader::kMagic, NegotiationMessage::Query), "10.0.0.2");
+    arrive(capabilitiesMessage(round - 1, capabilities), "10.0.0.2");
+    arrive(capabilitiesMessage(round + 1, capabilities), "10.0.0.2");
+    arrive(capabilitiesMessage(round, capabilities), "10.0.0.7");
+    Test::check(pollUntil(negotiator, udp, destinations, 1, now + kMillis, now + 10 * kMillis, profile) == 0 &&
+                    gInbox.empty() && negotiator.rounds() == 1,
+                "short, wrong-magic, wrong-type, stale and unknown-address answers don't finish a round");
+    uint64_t resync = 0;
+    Test::check(!negotiator.takeResync(resync), "ignored answers don't ask for a resync");
+
+    // A later version's longer message is still read
+    std::vector<uint8_t> longer = capabilitiesMessage(round, capabilities);
+    longer.resize(longer.size() + 8, 0xEE);
+    arrive(longer, "10.0.0.2");
+    Test::check(pollUntil(negotiator, udp, destinations, 1, now + 11 * kMillis, now + 11 * kMillis, profile) > 0 &&
+                    negotiator.rounds() == 2 && profile.responders == 1,
+                "a longer answer from a later version finishes the round");
+}
+
+static void testResync(UDPTransport& udp) {
+    resetMessages();
+    CapabilityNegotiator negotiator;
+    negotiator.reset();
+    const uint64_t destinations[] = {destination("10.0.0.2")};
+    NegotiatedProfile profile;
+    pollUntil(negotiator, udp, destinations, 1, kMillis, kMillis, profile);
+    arrive(capabilitiesMessage(gLastRound, receiver(true, true, 4, 40)), "10.0.0.2");
+    uint64_t now = pollUntil(negotiator, udp, destinations, 1, 2 * kMillis, 2 * kMillis, profile);
+    const uint32_t firstRound = gLastRound;
+
+    // Unsolicited, from an address that isn't a destination
+    now += CapabilityNegotiator::kMinRoundIntervalNanos;
+    arrive(capabilitiesMessage(0, receiver(true, true, 4, 40)), "10.0.0.9");
+    const uint32_t queries = gQueries;
+    pollUntil(negotiator, udp, destinations, 1, now, now + 300 * kMillis, profile);
+    uint64_t resync = 0;
+    Test::check(!negotiator.takeResync(resync) && gQueries == queries && negotiator.rounds() == 1,
+                "a round-0 resync from an unknown address is ignored");
+
+    // From the destination (its audio port), it restarts the round
+    now += 300 * kMillis;
+    arrive(capabilitiesMessage(0, receiver(true, true, 4, 40)), "10.0.0.2");
+    pollUntil(negotiator, udp, destinations, 1, now, now + 30 * kMillis, profile);
+    Test::check(negotiator.takeResync(resync) && resync == destinations[0] && !negotiator.takeResync(resync),
+                "a round-0 resync from a destination is handed out once, as that destination");
+    Test::check(gQueries > queries && gLastRound == firstRound + 1, "a round-0 resync starts a new round");
+}
+
+int main() {
+    testChooseProfile();
+
+    installEnvironment();
+    UDPTransport udp;  // Never opened: the environment stands in for the socket
+    testNoAnswer(udp);
+    testOneAnswers(udp);
+    testParsing(udp);
+    testResync(udp);
+    return Test::finish("CapabilityNegotiationTest");
+}
@@ -0,0 +1,42 @@
+//
+//  Check.hpp
+//  CymaxPhoneOutDriver Tests
+//
+//  Minimal expectation helpers shared by the test executables: each test
+//  checks what it needs, prints the failures and exits non-zero if any
+//
+
+#ifndef Check_hpp
+#define Check_hpp
+
+#include <cstdio>
+
+namespace Cymax {
+namespace Test {
+
+/// Failed expectations so far
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+/// Record an expectation; prints it if it failed
+inline bool check(bool condition, const char* what) {
+    if (!condition) {
+        std::printf("FAIL: %s\n", what);
+        ++failures();
+    }
+    return condition;
+}
+
+/// Print the verdict
+/// @return Exit status for main()
+inline int finish(const char* name) {
+    std::printf("%s: %s\n", name, failures() == 0 ? "PASS" : "FAILED");
+    return failures() == 0 ? 0 : 1;
+}
+
+} // namespace Test
+} // namespace Cymax
+
+#endif /* Check_hpp */
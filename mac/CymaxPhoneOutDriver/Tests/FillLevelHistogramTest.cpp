@@ -0,0 +1,191 @@
+//
+//  FillLevelHistogramTest.cpp
+//  CymaxPhoneOutDriver Tests
+//
+//  FillLevelHistogram bucket edges (the last bucket takes everything past
+//  it), min/mean/max, percentiles, window rollover into the session
+//  totals, empty windows and configure() starting over. Then a consumer
+//  thread closes windows while readers on other threads take latest():
+//  every snapshot must be one whole window and the session as of that
+//  window, never a mix of two.
+//
+
+#include "Check.hpp"
+#include "FillLevelHistogram.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr size_t kCapacity = 48000;
+static constexpr size_t kBucketFrames = 128;
+static constexpr size_t kBuckets = FillLevelSummary::kBuckets;
+
+static uint64_t sumOfCounts(const FillLevelSummary& summary) {
+    uint64_t sum = 0;
+    for (uint64_t count : summary.counts) {
+        sum += count;
+    }
+    return sum;
+}
+
+static void testBuckets() {
+    FillLevelHistogram histogram;
+    histogram.configure(kCapacity, kBucketFrames);
+    const FillLevelStats configured = histogram.latest();
+    Test::check(configured.capacityFrames == kCapacity && configured.bucketFrames == kBucketFrames &&
+                    configured.windows == 0 && configured.session.samples == 0,
+                "configure publishes an empty session");
+
+    // Each edge and the value just below it
+    const size_t fills[] = {0, kBucketFrames - 1, kBucketFrames, 2 * kBucketFrames - 1,
+                            (kBuckets - 1) * kBucketFrames - 1, (kBuckets - 1) * kBucketFrames, kCapacity};
+    for (size_t fill : fills) {
+        histogram.record(fill);
+    }
+    const FillLevelSummary window = histogram.closeWindow();
+    Test::check(window.counts[0] == 2 && window.counts[1] == 2 && window.counts[kBuckets - 2] == 1 &&
+                    window.counts[kBuckets - 1] == 2 && sumOfCounts(window) == window.samples && window.samples == 7,
+                "fills land in [i, i + 1) * bucketFrames, and the last bucket takes the rest");
+    Test::check(window.minFrames == 0 && window.maxFrames == kCapacity, "min and max are exact");
+    double sum = 0.0;
+    for (size_t fill : fills) {
+        sum += static_cast<double>(fill);
+    }
+    Test::check(window.meanFrames == sum / 7.0, "mean is exact");
+
+    FillLevelHistogram one;
+    one.configure(kCapacity, 0);
+    Test::check(one.latest().bucketFrames == 1, "a zero bucket width becomes one frame");
+}
+
+static void testPercentiles() {
+    FillLevelHistogram histogram;
+    histogram.configure(kCapacity, kBucketFrames);
+    // 100 fills, 5 to 995 in steps of 10; the 50th (495) is in bucket 3
+    for (size_t i = 0; i < 100; ++i) {
+        histogram.record(5 + 10 * i);
+    }
+    const FillLevelSummary window = histogram.closeWindow();
+    Test::check(window.percentileFrames(0.0, kBucketFrames) == kBucketFrames,
+                "the 0th percentile is the first bucket's top");
+    Test::check(window.percentileFrames(50.0, kBucketFrames) == 4 * kBucketFrames,
+                "the median is the top of the bucket holding the 50th sample");
+    Test::check(window.percentileFrames(100.0, kBucketFrames) == window.maxFrames && window.maxFrames == 995,
+                "the 100th percentile is clamped to the maximum");
+    Test::check(FillLevelSummary().percentileFrames(99.0, kBucketFrames) == 0, "an empty summary has no percentiles");
+
+    // Everything past the histogram: the last bucket has no top, so maxFrames
+    histogram.record(100 * kBucketFrames);
+    Test::check(histogram.closeWindow().percentileFrames(50.0, kBucketFrames) == 100 * kBucketFrames,
+                "a percentile in the last bucket is the maximum");
+}
+
+static void testRollover() {
+    FillLevelHistogram histogram;
+    histogram.configure(kCapacity, kBucketFrames);
+
+    histogram.record(100);
+    histogram.record(300);
+    histogram.closeWindow();
+    histogram.record(1000);
+    const FillLevelSummary second = histogram.closeWindow();
+    Test::check(second.samples == 1 && second.minFrames == 1000 && second.maxFrames == 1000 &&
+                    second.meanFrames == 1000.0 && second.counts[0] == 0,
+                "a new window starts from nothing");
+
+    FillLevelStats stats = histogram.latest();
+    Test::check(stats.windows == 2 && stats.window.samples == 1 && stats.session.samples == 3 &&
+                    stats.session.minFrames == 100 && stats.session.maxFrames == 1000 &&
+                    stats.session.meanFrames == 1400.0 / 3.0 && sumOfCounts(stats.session) == 3,
+                "the session folds in every window");
+
+    const FillLevelSummary empty = histogram.closeWindow();
+    stats = histogram.latest();
+    Test::check(empty.samples == 0 && stats.windows == 2 && stats.window.samples == 1,
+                "closing an empty window publishes nothing");
+
+    histogram.configure(kCapacity, 2 * kBucketFrames);
+    histogram.record(kBucketFrames);
+    histogram.closeWindow();
+    stats = histogram.latest();
+    Test::check(stats.windows == 1 && stats.session.samples == 1 && stats.bucketFrames == 2 * kBucketFrames &&
+                    stats.window.counts[0] == 1,
+                "configure starts a new session");
+}
+
+/// The nth window holds n samples, all of fill n - 1 (mod the capacity), so
+/// every field of a snapshot follows from stats.windows
+static bool consistent(const FillLevelStats& stats) {
+    const uint64_t n = stats.windows;
+    if (n == 0) {
+        return stats.window.samples == 0 && stats.session.samples == 0;
+    }
+    const size_t fill = static_cast<size_t>((n - 1) % kCapacity);
+    const uint64_t sessionSamples = n * (n + 1) / 2;
+    return stats.window.samples == n && sumOfCounts(stats.window) == n &&
+           stats.window.counts[std::min(fill / kBucketFrames, kBuckets - 1)] == n &&
+           stats.window.minFrames == fill && stats.window.maxFrames == fill &&
+           stats.session.samples == sessionSamples && sumOfCounts(stats.session) == sessionSamples &&
+           stats.session.maxFrames == std::min<size_t>(n - 1, kCapacity - 1);
+}
+
+static void testConcurrentReaders() {
+    FillLevelHistogram histogram;
+    histogram.configure(kCapacity, kBucketFrames);
+
+    constexpr uint64_t kWindows = 3000;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> torn{0};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> backwards{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            uint64_t last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                const FillLevelStats stats = histogram.latest();
+                if (!consistent(stats)) {
+                    torn.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (stats.windows < last) {
+                    backwards.fetch_add(1, std::memory_order_relaxed);
+                }
+                last = stats.windows;
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    for (uint64_t n = 1; n <= kWindows; ++n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            histogram.record(static_cast<size_t>((n - 1) % kCapacity));
+        }
+        histogram.closeWindow();
+        if (n % 64 == 0) {
+            std::this_thread::yield();  // Let the readers in on a single CPU
+        }
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    std::printf("concurrent readers: %llu snapshots\n", static_cast<unsigned long long>(reads.load()));
+    Test::check(torn.load() == 0, "every snapshot is one whole window and its session");
+    Test::check(backwards.load() == 0, "a reader never sees an older window after a newer one");
+    Test::check(histogram.latest().windows == kWindows && consistent(histogram.latest()),
+                "the last window is what remains published");
+}
+
+int main() {
+    testBuckets();
+    testPercentiles();
+    testRollover();
+    testConcurrentReaders();
+    return Test::finish("FillLevelHistogramTest");
+}
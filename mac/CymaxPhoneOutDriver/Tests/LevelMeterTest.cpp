@@ -0,0 +1,120 @@
+//
+//  LevelMeterTest.cpp
+//  CymaxPhoneOutDriver Tests
+//
+//  LevelMeter's readings for signals with known values: a 1 kHz sine at
+//  -20 dBFS reads 0.1 peak, 0.0707 RMS and, per BS.1770, -23.01 LUFS per
+//  channel (the K-weighting's +0.69 dB at 1 kHz cancels its -0.691
+//  offset) and -20.0 LUFS for two such channels together. The same sine on
+//  one channel only reads -23.01 in total, and silence reads kSilenceLUFS.
+//  Checked at 44.1 and 48 kHz, through process and processPlanar, to the
+//  0.1 LU EBU Tech 3341 allows.
+//
+
+#include "Check.hpp"
+#include "LevelMeter.hpp"
+#include "SampleKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr size_t kChannels = 2;
+static constexpr size_t kChunkFrames = 1024;
+static constexpr double kSeconds = 4.0;          // Past the 3 s short-term window
+static constexpr double kAmplitude = 0.1;        // -20 dBFS
+static constexpr double kToleranceLU = 0.1;
+
+static char gWhat[160];
+
+static const char* describe(const char* check, double sampleRate, bool planar) {
+    std::snprintf(gWhat, sizeof(gWhat), "%s (%.1f kHz, %s)", check, sampleRate / 1000.0,
+                  planar ? "planar" : "interleaved");
+    return gWhat;
+}
+
+/// Meter kSeconds of a 1 kHz sine at kAmplitude on the channels in use
+static LevelMeterSnapshot meter(double sampleRate, bool planar, bool left, bool right) {
+    LevelMeter meter;
+    meter.prepare(sampleRate, kChannels, kChunkFrames);
+
+    const size_t frames = static_cast<size_t>(kSeconds * sampleRate);
+    // Every 100 ms, a whole number of cycles, so peak and RMS are exact;
+    // the last publish falls on the last frame
+    const size_t publishFrames = static_cast<size_t>(sampleRate / 10.0);
+    std::vector<float> interleaved(kChunkFrames * kChannels);
+    std::vector<float> planes[kChannels] = {std::vector<float>(kChunkFrames), std::vector<float>(kChunkFrames)};
+    size_t sincePublish = 0;
+    for (size_t done = 0; done < frames;) {
+        const size_t n = std::min(kChunkFrames, frames - done);
+        for (size_t i = 0; i < n; ++i) {
+            const double t = static_cast<double>(done + i) / sampleRate;
+            const float value = static_cast<float>(kAmplitude * std::sin(2.0 * M_PI * 1000.0 * t));
+            planes[0][i] = interleaved[i * kChannels] = left ? value : 0.0f;
+            planes[1][i] = interleaved[i * kChannels + 1] = right ? value : 0.0f;
+        }
+        if (planar) {
+            const float* rows[kChannels] = {planes[0].data(), planes[1].data()};
+            meter.processPlanar(rows, n);
+        } else {
+            meter.process(interleaved.data(), n);
+        }
+        done += n;
+        sincePublish += n;
+        if (sincePublish >= publishFrames) {
+            meter.publish();
+            sincePublish -= publishFrames;
+        }
+    }
+    return meter.latest();
+}
+
+static bool near(float value, double expected, double tolerance) {
+    return std::fabs(static_cast<double>(value) - expected) <= tolerance;
+}
+
+static void testSine(double sampleRate, bool planar) {
+    // The K-weighting's gain at 1 kHz cancels the -0.691 dB offset
+    const double perChannelLUFS = 10.0 * std::log10(kAmplitude * kAmplitude / 2.0);
+
+    const LevelMeterSnapshot both = meter(sampleRate, planar, true, true);
+    Test::check(both.sequence > 0 && both.channels == kChannels, describe("published for both channels", sampleRate,
+                                                                         planar));
+    for (size_t c = 0; c < kChannels; ++c) {
+        Test::check(near(both.peak[c], kAmplitude, 1e-4), describe("-20 dBFS sine peaks at 0.1", sampleRate, planar));
+        Test::check(near(both.rms[c], kAmplitude / std::sqrt(2.0), 1e-4),
+                    describe("-20 dBFS sine has RMS 0.0707", sampleRate, planar));
+        if (!Test::check(near(both.shortTermLUFS[c], perChannelLUFS, kToleranceLU),
+                         describe("-20 dBFS 1 kHz sine reads -23.01 LUFS per channel", sampleRate, planar))) {
+            std::printf("  channel %zu read %.3f LUFS\n", c, both.shortTermLUFS[c]);
+        }
+    }
+    if (!Test::check(near(both.shortTermLUFSTotal, perChannelLUFS + 10.0 * std::log10(2.0), kToleranceLU),
+                     describe("the sine on both channels reads -20.0 LUFS together", sampleRate, planar))) {
+        std::printf("  read %.3f LUFS\n", both.shortTermLUFSTotal);
+    }
+
+    const LevelMeterSnapshot leftOnly = meter(sampleRate, planar, true, false);
+    Test::check(near(leftOnly.shortTermLUFSTotal, perChannelLUFS, kToleranceLU) &&
+                    near(leftOnly.shortTermLUFS[0], perChannelLUFS, kToleranceLU),
+                describe("the sine on one channel reads -23.01 LUFS together", sampleRate, planar));
+    Test::check(leftOnly.shortTermLUFS[1] == LevelMeter::kSilenceLUFS && leftOnly.peak[1] == 0.0f,
+                describe("the silent channel reads silence", sampleRate, planar));
+
+    const LevelMeterSnapshot silence = meter(sampleRate, planar, false, false);
+    Test::check(silence.shortTermLUFSTotal == LevelMeter::kSilenceLUFS && silence.rms[0] == 0.0f,
+                describe("silence reads kSilenceLUFS", sampleRate, planar));
+}
+
+int main() {
+    Kernels::initialize();
+    const double sampleRates[] = {44100.0, 48000.0};
+    for (double sampleRate : sampleRates) {
+        testSine(sampleRate, false);
+        testSine(sampleRate, true);
+    }
+    return Test::finish("LevelMeterTest");
+}
@@ -0,0 +1,225 @@
+//
+//  LosslessCodecTest.cpp
+//  CymaxPhoneOutDriver Tests
+//
+//  LosslessCodec and the ReplayBuffer built on it give back exactly what
+//  went in: white noise over the whole 24-bit range, silence, full scale
+//  (both rails, and the channels at opposite rails so the side channel
+//  needs its extra bit), a square wave and a sine, at block sizes from one
+//  frame up through odd ones to the largest, for one to three channels.
+//  encodePlanar must write the same bitstream as encode.
+//
+//  The replay buffer is fed interleaved and planar chunks of odd sizes and
+//  read back across block boundaries; its output must match the kernels'
+//  own float -> int24 -> float round trip bit for bit.
+//
+
+#include "Check.hpp"
+#include "LosslessCodec.hpp"
+#include "ReplayBuffer.hpp"
+#include "SampleKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr int32_t kMax24 = (1 << 23) - 1;
+static constexpr int32_t kMin24 = -(1 << 23);
+static constexpr size_t kMaxChannels = 3;
+static constexpr size_t kBlockSizes[] = {1, 2, 3, 4, 5, 7, 31, 127, 1000, 4093, ReplayBuffer::kBlockFrames};
+static constexpr size_t kMaxFrames = ReplayBuffer::kBlockFrames;
+static constexpr double kSampleRate = 48000.0;
+
+enum class Material { Noise, Silence, FullScale, OppositeRails, Square, Sine };
+
+static constexpr Material kMaterials[] = {Material::Noise,         Material::Silence, Material::FullScale,
+                                          Material::OppositeRails, Material::Square,  Material::Sine};
+
+static const char* materialName(Material material) {
+    switch (material) {
+        case Material::Silence: return "silence";
+        case Material::FullScale: return "full scale";
+        case Material::OppositeRails: return "opposite rails";
+        case Material::Square: return "square";
+        case Material::Sine: return "sine";
+        case Material::Noise: break;
+    }
+    return "noise";
+}
+
+static std::mt19937 gRandom(1);
+
+static char gWhat[160];
+
+static const char* describe(const char* check, Material material, size_t channels, size_t frames) {
+    std::snprintf(gWhat, sizeof(gWhat), "%s (%s, %zu ch, %zu frames)", check, materialName(material), channels,
+                  frames);
+    return gWhat;
+}
+
+/// Interleaved 24-bit samples of the material
+static std::vector<int32_t> samples(Material material, size_t frames, size_t channels) {
+    std::uniform_int_distribution<int32_t> noise(kMin24, kMax24);
+    std::vector<int32_t> out(frames * channels);
+    for (size_t f = 0; f < frames; ++f) {
+        for (size_t c = 0; c < channels; ++c) {
+            int32_t value = 0;
+            switch (material) {
+                case Material::Noise: value = noise(gRandom); break;
+                case Material::Silence: break;
+                case Material::FullScale: value = (f / 3) % 2 == 0 ? kMax24 : kMin24; break;
+                case Material::OppositeRails: value = (f + c) % 2 == 0 ? kMax24 : kMin24; break;
+                case Material::Square: value = (f / 24) % 2 == 0 ? kMax24 / 2 : -kMax24 / 2; break;
+                case Material::Sine:
+                    value = static_cast<int32_t>(std::lround(
+                        kMax24 * std::sin(2.0 * M_PI * 997.0 * static_cast<double>(f) / kSampleRate + c)));
+                    break;
+            }
+            out[f * channels + c] = value;
+        }
+    }
+    return out;
+}
+
+/// encode, encodePlanar and decode of one block
+static void testBlock(LosslessCodec& codec, Material material, size_t frames) {
+    const size_t channels = codec.channels();
+    const std::vector<int32_t> input = samples(material, frames, channels);
+    std::vector<uint8_t> encoded(codec.maxEncodedBytes(frames));
+    const size_t bytes = codec.encode(input.data(), frames, encoded.data());
+    Test::check(bytes > 0 && bytes <= encoded.size(),
+                describe("encoded size within maxEncodedBytes", material, channels, frames));
+
+    std::vector<int32_t> decoded(input.size(), 0x55555555);
+    Test::check(codec.decode(encoded.data(), bytes, frames, decoded.data()),
+                describe("block decodes", material, channels, frames));
+    Test::check(decoded == input, describe("decode is bit-exact", material, channels, frames));
+
+    std::vector<std::vector<int32_t>> planes(channels, std::vector<int32_t>(frames));
+    std::vector<const int32_t*> rows;
+    for (size_t c = 0; c < channels; ++c) {
+        for (size_t f = 0; f < frames; ++f) {
+            planes[c][f] = input[f * channels + c];
+        }
+        rows.push_back(planes[c].data());
+    }
+    std::vector<uint8_t> planarEncoded(encoded.size());
+    const size_t planarBytes = codec.encodePlanar(rows.data(), frames, planarEncoded.data());
+    Test::check(planarBytes == bytes && std::memcmp(planarEncoded.data(), encoded.data(), bytes) == 0,
+                describe("encodePlanar writes the same bitstream", material, channels, frames));
+}
+
+/// Float samples of the material, past full scale now and then so the
+/// quantizer's clamp is in the round trip
+static std::vector<float> floatSamples(Material material, size_t frames, size_t channels) {
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    std::vector<float> out(frames * channels);
+    for (size_t f = 0; f < frames; ++f) {
+        for (size_t c = 0; c < channels; ++c) {
+            float value = 0.0f;
+            switch (material) {
+                case Material::Noise: value = noise(gRandom); break;
+                case Material::Silence: break;
+                case Material::FullScale: value = (f / 3) % 2 == 0 ? 1.0f : -1.0f; break;
+                case Material::OppositeRails: value = (f + c) % 2 == 0 ? 1.5f : -1.5f; break;
+                case Material::Square: value = (f / 24) % 2 == 0 ? 0.5f : -0.5f; break;
+                case Material::Sine:
+                    value = static_cast<float>(
+                        std::sin(2.0 * M_PI * 997.0 * static_cast<double>(f) / kSampleRate + c));
+                    break;
+            }
+            out[f * channels + c] = value;
+        }
+    }
+    return out;
+}
+
+/// What the replay buffer should hand back: the kernels' int24 round trip
+static std::vector<float> int24RoundTrip(const std::vector<float>& input) {
+    const Kernels::KernelTable& kernels = Kernels::active();
+    std::vector<uint8_t> packed(input.size() * Kernels::kInt24Bytes);
+    std::vector<float> out(input.size());
+    kernels.floatToInt24(input.data(), packed.data(), input.size());
+    kernels.int24ToFloat(packed.data(), out.data(), input.size());
+    return out;
+}
+
+/// Odd-sized chunks in, odd-sized reads across block boundaries out
+static void testReplay(Material material, size_t channels, bool planar) {
+    const size_t blocks = 3;
+    const size_t frames = blocks * ReplayBuffer::kBlockFrames + 517;  // A partial block stays staged
+    const std::vector<float> input = floatSamples(material, frames, channels);
+    std::vector<std::vector<float>> planes(channels, std::vector<float>(frames));
+    for (size_t f = 0; f < frames; ++f) {
+        for (size_t c = 0; c < channels; ++c) {
+            planes[c][f] = input[f * channels + c];
+        }
+    }
+
+    ReplayBuffer replay(1.0);
+    replay.prepare(kSampleRate, channels, 1024);
+    std::uniform_int_distribution<size_t> chunkSize(1, 1024);
+    for (size_t written = 0; written < frames;) {
+        const size_t n = std::min(chunkSize(gRandom), frames - written);
+        if (planar) {
+            const float* rows[kMaxChannels];
+            for (size_t c = 0; c < channels; ++c) {
+                rows[c] = planes[c].data() + written;
+            }
+            replay.processPlanar(rows, n);
+        } else {
+            replay.process(input.data() + written * channels, n);
+        }
+        written += n;
+    }
+
+    const char* how = planar ? "planar" : "interleaved";
+    std::snprintf(gWhat, sizeof(gWhat), "whole blocks held (%s, %zu ch, %s)", materialName(material), channels, how);
+    if (!Test::check(replay.oldestPosition() == 0 && replay.newestPosition() == blocks * ReplayBuffer::kBlockFrames,
+                     gWhat)) {
+        return;
+    }
+
+    const size_t held = blocks * ReplayBuffer::kBlockFrames;
+    std::vector<float> output;
+    std::vector<float> chunk(1024 * channels);
+    std::uniform_int_distribution<size_t> readSize(1, 1000);
+    while (output.size() < held * channels) {
+        const size_t got = replay.read(output.size() / channels, chunk.data(), readSize(gRandom));
+        if (got == 0) {
+            break;
+        }
+        output.insert(output.end(), chunk.begin(), chunk.begin() + got * channels);
+    }
+    std::vector<float> expected = int24RoundTrip(input);
+    expected.resize(held * channels);
+    std::snprintf(gWhat, sizeof(gWhat), "replay reads back the int24 round trip (%s, %zu ch, %s)",
+                  materialName(material), channels, how);
+    Test::check(output.size() == expected.size() &&
+                    std::memcmp(output.data(), expected.data(), output.size() * sizeof(float)) == 0,
+                gWhat);
+    Test::check(replay.read(held, chunk.data(), 1) == 0, "nothing is read past the newest block");
+}
+
+int main() {
+    Kernels::initialize();
+    std::printf("kernels: %s\n", Kernels::active().name);
+    for (size_t channels = 1; channels <= kMaxChannels; ++channels) {
+        const int failuresBefore = Test::failures();
+        LosslessCodec codec(kMaxFrames, channels);
+        for (Material material : kMaterials) {
+            for (size_t frames : kBlockSizes) {
+                testBlock(codec, material, frames);
+            }
+            testReplay(material, channels, false);
+            testReplay(material, channels, true);
+        }
+        std::printf("%zu ch %s\n", channels, Test::failures() == failuresBefore ? "ok" : "FAILED");
+    }
+    return Test::finish("LosslessCodecTest");
+}
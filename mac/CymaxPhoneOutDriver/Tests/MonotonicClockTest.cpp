@@ -0,0 +1,81 @@
+//
+//  MonotonicClockTest.cpp
+//  CymaxPhoneOutDriver Tests
+//
+//  MonotonicClock conversions at the timebases in use - Intel Macs and
+//  Linux (1/1) and Apple Silicon (125/3, 24 MHz ticks) - from one second
+//  to extreme uptimes: exact past the point where 64-bit ticks * numer
+//  wraps, saturating where the result no longer fits, and round-tripping.
+//  Those are checked at compile time. At run time the system clock must
+//  not go backwards, nanosSince() must agree with nowNanos(), and the
+//  system timebase must round-trip.
+//
+
+#include "Check.hpp"
+#include "MonotonicClock.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <thread>
+
+using namespace Cymax;
+using MonotonicClock::Timebase;
+using MonotonicClock::nanosToTicks;
+using MonotonicClock::ticksToNanos;
+
+static constexpr Timebase kAppleSilicon = {125, 3};
+static constexpr Timebase kIdentity = {1, 1};
+static constexpr uint64_t kTicksPerDay = 24000000ULL * 86400;
+static constexpr uint64_t kMax = std::numeric_limits<uint64_t>::max();
+
+// Exact at ordinary and extreme uptimes
+static_assert(ticksToNanos(24000000, kAppleSilicon) == 1000000000ULL, "one second");
+static_assert(ticksToNanos(kTicksPerDay * 49, kAppleSilicon) == 49ULL * 86400 * 1000000000ULL, "49 days");
+static_assert(ticksToNanos(kTicksPerDay * 36500, kAppleSilicon) == 36500ULL * 86400 * 1000000000ULL, "100 years");
+
+// Where 64-bit ticks * numer wraps (about 195 years at 24 MHz)
+static constexpr uint64_t kWrapTicks = kMax / 125 + 1;
+static_assert(ticksToNanos(kWrapTicks, kAppleSilicon) ==
+              static_cast<uint64_t>(static_cast<unsigned __int128>(kWrapTicks) * 125 / 3), "past the 64-bit wrap");
+static_assert(ticksToNanos(kWrapTicks, kAppleSilicon) > ticksToNanos(kWrapTicks - 1, kAppleSilicon), "monotonic");
+
+// Results past 2^64 ns saturate, both ways
+static_assert(ticksToNanos(kMax, kAppleSilicon) == kMax, "saturates");
+static_assert(nanosToTicks(kMax, Timebase{3, 125}) == kMax, "saturates converting back");
+
+// Round trips, and identity on 1/1 timebases
+static_assert(nanosToTicks(ticksToNanos(kTicksPerDay * 400, kAppleSilicon), kAppleSilicon) == kTicksPerDay * 400,
+              "round trip");
+static_assert(ticksToNanos(kMax, kIdentity) == kMax && nanosToTicks(kMax, kIdentity) == kMax, "identity");
+
+int main() {
+    const Timebase timebase = MonotonicClock::timebase();
+    std::printf("timebase %u/%u\n", timebase.numer, timebase.denom);
+    Test::check(timebase.numer != 0 && timebase.denom != 0, "the system timebase is usable");
+    Test::check(MonotonicClock::toTicks(MonotonicClock::toNanos(kTicksPerDay * 30)) == kTicksPerDay * 30,
+                "the system timebase round-trips a month of ticks");
+
+    // The clock never goes backwards, in ticks or nanoseconds
+    uint64_t previousTicks = MonotonicClock::nowTicks();
+    uint64_t previousNanos = MonotonicClock::nowNanos();
+    bool forward = true;
+    for (int i = 0; i < 100000; ++i) {
+        const uint64_t ticks = MonotonicClock::nowTicks();
+        const uint64_t nanos = MonotonicClock::nowNanos();
+        forward = forward && ticks >= previousTicks && nanos >= previousNanos;
+        previousTicks = ticks;
+        previousNanos = nanos;
+    }
+    Test::check(forward, "nowTicks and nowNanos never go backwards");
+
+    // Time since a start point in ticks matches the same span in nanoseconds
+    const uint64_t startTicks = MonotonicClock::nowTicks();
+    const uint64_t startNanos = MonotonicClock::nowNanos();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const uint64_t since = MonotonicClock::nanosSince(startTicks);
+    const uint64_t elapsed = MonotonicClock::nowNanos() - startNanos;
+    Test::check(since >= 20000000 && since <= elapsed + 1000000,
+                "nanosSince covers a 20 ms sleep and agrees with nowNanos");
+    return Test::finish("MonotonicClockTest");
+}
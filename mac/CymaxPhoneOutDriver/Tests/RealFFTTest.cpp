@@ -0,0 +1,139 @@
+//
+//  RealFFTTest.cpp
+//  CymaxPhoneOutDriver Tests
+//
+//  RealFFT against a naive DFT computed in double, for every size from 4
+//  to 4096: white noise, impulses, DC, Nyquist and bin-centred sines.
+//  Every bin must agree to within a few float roundings per stage, relative
+//  to the spectrum's overall level, and powerSpectrum must be the squared
+//  magnitude of forward.
+//
+
+#include "Check.hpp"
+#include "RealFFT.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr size_t kMinSize = 4;
+static constexpr size_t kMaxSize = 4096;  // Twice SpectrumAnalyzer::kFFTSize
+
+// Allowed error per radix-2 stage, relative to the spectrum's RMS level
+static constexpr double kTolerancePerStage = 5e-8;
+
+static std::mt19937 gRandom(1);
+
+static char gWhat[160];
+
+static const char* describe(const char* check, const char* signal, size_t size) {
+    std::snprintf(gWhat, sizeof(gWhat), "%s (%s, %zu points)", check, signal, size);
+    return gWhat;
+}
+
+/// X[k] = sum x[n] e^(-2 pi i k n / N), DC to Nyquist
+static void naiveDFT(const std::vector<float>& input, std::vector<double>& re, std::vector<double>& im) {
+    const size_t n = input.size();
+    // e^(-2 pi i m / N) for every m; k * t is reduced mod N, so the angles stay exact
+    std::vector<double> cosine(n), sine(n);
+    for (size_t m = 0; m < n; ++m) {
+        const double angle = -2.0 * M_PI * static_cast<double>(m) / static_cast<double>(n);
+        cosine[m] = std::cos(angle);
+        sine[m] = std::sin(angle);
+    }
+    re.assign(n / 2 + 1, 0.0);
+    im.assign(n / 2 + 1, 0.0);
+    for (size_t k = 0; k <= n / 2; ++k) {
+        size_t m = 0;
+        for (size_t t = 0; t < n; ++t) {
+            re[k] += input[t] * cosine[m];
+            im[k] += input[t] * sine[m];
+            m += k;
+            m = m >= n ? m - n : m;
+        }
+    }
+}
+
+static void testSignal(RealFFT& fft, const char* name, const std::vector<float>& input) {
+    const size_t size = fft.size();
+    std::vector<double> expectedRe, expectedIm;
+    naiveDFT(input, expectedRe, expectedIm);
+
+    std::vector<float> re(fft.binCount()), im(fft.binCount()), power(fft.binCount());
+    fft.forward(input.data(), re.data(), im.data());
+    fft.powerSpectrum(input.data(), power.data());
+
+    // Parseval: the spectrum's RMS over all N bins is sqrt(N) times the
+    // input's, so scale the tolerance by that
+    double energy = 0.0;
+    for (float x : input) {
+        energy += static_cast<double>(x) * x;
+    }
+    const double level = std::max(std::sqrt(energy), 1e-30);
+    const double stages = std::log2(static_cast<double>(size));
+    const double tolerance = kTolerancePerStage * stages * level * std::sqrt(static_cast<double>(size));
+
+    double worst = 0.0;
+    double worstPower = 0.0;
+    for (size_t k = 0; k < fft.binCount(); ++k) {
+        worst = std::max({worst, std::fabs(re[k] - expectedRe[k]), std::fabs(im[k] - expectedIm[k])});
+        const double magnitude = static_cast<double>(re[k]) * re[k] + static_cast<double>(im[k]) * im[k];
+        worstPower = std::max(worstPower, std::fabs(power[k] - magnitude) / std::max(magnitude, level * level));
+    }
+    if (!Test::check(worst <= tolerance, describe("every bin matches the naive DFT", name, size))) {
+        std::printf("  worst error %.3g, allowed %.3g\n", worst, tolerance);
+    }
+    Test::check(worstPower <= 1e-5, describe("powerSpectrum is |forward|^2", name, size));
+}
+
+static void testSize(size_t size) {
+    RealFFT fft(size);
+    Test::check(fft.size() == size && fft.binCount() == size / 2 + 1, "sizes as constructed");
+
+    std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+    std::vector<float> input(size);
+    for (float& x : input) {
+        x = noise(gRandom);
+    }
+    testSignal(fft, "noise", input);
+
+    std::fill(input.begin(), input.end(), 0.0f);
+    input[0] = 1.0f;
+    testSignal(fft, "impulse at 0", input);
+
+    std::fill(input.begin(), input.end(), 0.0f);
+    input[3 % size] = 1.0f;
+    testSignal(fft, "impulse at 3", input);
+
+    std::fill(input.begin(), input.end(), 0.5f);
+    testSignal(fft, "DC", input);
+
+    for (size_t n = 0; n < size; ++n) {
+        input[n] = n % 2 == 0 ? 1.0f : -1.0f;
+    }
+    testSignal(fft, "Nyquist", input);
+
+    // On bin 1, and on a bin near the top (odd, so both halves of the
+    // split step are involved)
+    const size_t bins[] = {1, size / 2 - 1};
+    for (size_t bin : bins) {
+        for (size_t n = 0; n < size; ++n) {
+            const double phase = 2.0 * M_PI * static_cast<double>((bin * n) % size) / static_cast<double>(size);
+            input[n] = static_cast<float>(0.7 * std::sin(phase + 0.3));
+        }
+        testSignal(fft, bin == 1 ? "sine on bin 1" : "sine near Nyquist", input);
+    }
+}
+
+int main() {
+    for (size_t size = kMinSize; size <= kMaxSize; size *= 2) {
+        const int failuresBefore = Test::failures();
+        testSize(size);
+        std::printf("%5zu points %s\n", size, Test::failures() == failuresBefore ? "ok" : "FAILED");
+    }
+    return Test::finish("RealFFTTest");
+}
@@ -0,0 +1,293 @@
+//
+//  RingBufferTest.cpp
+//  CymaxPhoneOutDriver Tests
+//
+//  RingBuffer<float> in every storage format and the planar layout:
+//  samples come back as the active kernels' round trip (within one
+//  quantization step of what was written), and random-sized sequences of
+//  writes and reads (read, tapRead, readPlanar, tapReadPlanar) over many
+//  laps return every frame in order, however the blocks fall across the
+//  wrap. Taps also follow a reset and skip what the writer laps.
+//
+
+#include "Check.hpp"
+#include "RingBuffer.hpp"
+#include "SampleKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr size_t kCapacity = 256;        // Frames; a power of two, so no rounding
+static constexpr size_t kSequenceFrames = 40 * kCapacity;
+static constexpr size_t kMaxChannels = 3;
+
+/// Storage and layout of one ring under test
+struct Format {
+    const char* name;
+    RingStorage storage;
+    RingLayout layout;
+};
+
+static constexpr Format kFormats[] = {
+    {"float32", RingStorage::Native, RingLayout::Interleaved},
+    {"int16", RingStorage::Int16, RingLayout::Interleaved},
+    {"int24", RingStorage::Int24, RingLayout::Interleaved},
+    {"planar", RingStorage::Native, RingLayout::Planar},
+};
+
+static std::mt19937 gRandom(1);
+
+enum class Reader {
+    Read,        // Consuming read()
+    Tap,         // tapRead() behind a cursor
+    ReadPlanar,  // Consuming readPlanar()
+    TapPlanar    // tapReadPlanar() behind a cursor
+};
+
+static constexpr Reader kReaders[] = {Reader::Read, Reader::Tap, Reader::ReadPlanar, Reader::TapPlanar};
+
+static const char* readerName(Reader reader) {
+    switch (reader) {
+        case Reader::Tap: return "tapRead";
+        case Reader::ReadPlanar: return "readPlanar";
+        case Reader::TapPlanar: return "tapReadPlanar";
+        case Reader::Read: break;
+    }
+    return "read";
+}
+
+static bool isTap(Reader reader) {
+    return reader == Reader::Tap || reader == Reader::TapPlanar;
+}
+
+static char gWhat[160];
+
+static const char* describe(const char* check, const Format& format, size_t channels, Reader reader = Reader::Read) {
+    std::snprintf(gWhat, sizeof(gWhat), "%s (%s, %zu ch, %s)", check, format.name, channels, readerName(reader));
+    return gWhat;
+}
+
+/// Read up to frameCount frames with the given reader, interleaved into out
+static size_t readFrames(RingBuffer<float>& ring, TapCursor& tap, Reader reader, float* out, size_t frameCount) {
+    if (reader == Reader::Read) {
+        return ring.read(out, frameCount);
+    }
+    if (reader == Reader::Tap) {
+        return ring.tapRead(tap, out, frameCount);
+    }
+
+    const size_t channels = ring.channelCount();
+    std::vector<std::vector<float>> planes(channels, std::vector<float>(frameCount));
+    std::vector<float*> pointers;
+    for (std::vector<float>& plane : planes) {
+        pointers.push_back(plane.data());
+    }
+    const size_t got = reader == Reader::ReadPlanar ? ring.readPlanar(pointers.data(), frameCount)
+                                                    : ring.tapReadPlanar(tap, pointers.data(), frameCount);
+    for (size_t f = 0; f < got; ++f) {
+        for (size_t c = 0; c < channels; ++c) {
+            out[f * channels + c] = planes[c][f];
+        }
+    }
+    return got;
+}
+
+/// Frames of random samples, past full scale now and then so the clamp runs
+static std::vector<float> randomFrames(size_t frames, size_t channels) {
+    std::uniform_real_distribution<float> value(-1.1f, 1.1f);
+    std::vector<float> out(frames * channels);
+    for (float& x : out) {
+        x = value(gRandom);
+    }
+    if (out.size() > 3) {
+        out[0] = 1.0f;
+        out[1] = -1.0f;
+        out[2] = 0.0f;
+        out[3] = -0.0f;
+    }
+    return out;
+}
+
+/// What a ring in this format should hand back for these samples
+static std::vector<float> roundTrip(const std::vector<float>& samples, RingStorage storage) {
+    const Kernels::KernelTable& kernels = Kernels::active();
+    std::vector<float> out(samples.size());
+    if (storage == RingStorage::Int16) {
+        std::vector<int16_t> stored(samples.size());
+        kernels.floatToInt16(samples.data(), stored.data(), samples.size());
+        kernels.int16ToFloat(stored.data(), out.data(), samples.size());
+    } else if (storage == RingStorage::Int24) {
+        std::vector<uint8_t> stored(samples.size() * Kernels::kInt24Bytes);
+        kernels.floatToInt24(samples.data(), stored.data(), samples.size());
+        kernels.int24ToFloat(stored.data(), out.data(), samples.size());
+    } else {
+        out = samples;
+    }
+    return out;
+}
+
+/// Bitwise equality (== would let -0 match 0)
+static bool sameBits(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+/// One quantization step of the format (the float -> int scale is one
+/// short of the int -> float one, so a step covers both roundings)
+static float quantizationStep(RingStorage storage) {
+    switch (storage) {
+        case RingStorage::Int16: return 2.0f / 32768.0f;
+        case RingStorage::Int24: return 2.0f / 8388608.0f;
+        case RingStorage::Native: break;
+    }
+    return 0.0f;
+}
+
+/// The round trip stays within a step of the clamped input
+static void testRoundTrip(const Format& format, size_t channels) {
+    const std::vector<float> input = randomFrames(kCapacity / 2, channels);
+    const std::vector<float> expected = roundTrip(input, format.storage);
+    RingBuffer<float> ring(kCapacity, channels, format.storage, nullptr, format.layout);
+    Test::check(ring.storage() == format.storage && ring.layout() == format.layout,
+                describe("ring keeps the requested format", format, channels));
+
+    std::vector<float> output(input.size());
+    ring.write(input.data(), kCapacity / 2);
+    Test::check(ring.read(output.data(), kCapacity) == kCapacity / 2,
+                describe("read returns what was written", format, channels));
+    Test::check(sameBits(output, expected), describe("samples match the kernel round trip", format, channels));
+    if (format.storage == RingStorage::Native) {
+        return;
+    }
+
+    float worst = 0.0f;
+    for (size_t i = 0; i < input.size(); ++i) {
+        worst = std::max(worst, std::fabs(output[i] - std::clamp(input[i], -1.0f, 1.0f)));
+    }
+    Test::check(worst <= quantizationStep(format.storage), describe("within a quantization step", format, channels));
+}
+
+/// A block written and read back across the wrap
+static void testWrap(const Format& format, size_t channels, Reader reader) {
+    RingBuffer<float> ring(kCapacity, channels, format.storage, nullptr, format.layout);
+    std::vector<float> filler((kCapacity - 3) * channels);
+    ring.write(filler.data(), kCapacity - 3);
+    ring.read(filler.data(), kCapacity - 3);
+    TapCursor tap = ring.makeTap();
+
+    const std::vector<float> input = randomFrames(7, channels);
+    std::vector<float> output(input.size());
+    ring.write(input.data(), 7);
+    Test::check(ring.availableForRead() == 7, describe("fill counts across the wrap", format, channels, reader));
+    Test::check(readFrames(ring, tap, reader, output.data(), 7) == 7 &&
+                    sameBits(output, roundTrip(input, format.storage)),
+                describe("block split by the wrap comes back whole", format, channels, reader));
+    if (!isTap(reader)) {
+        Test::check(ring.isEmpty(), describe("empty after reading across the wrap", format, channels, reader));
+    }
+}
+
+/// Writes and reads of random sizes; the writer never gets more than the
+/// tap's lag limit (three quarters of the ring) ahead, so nothing is lost
+static void testSequence(const Format& format, size_t channels, Reader reader) {
+    const std::vector<float> input = randomFrames(kSequenceFrames, channels);
+    const std::vector<float> expected = roundTrip(input, format.storage);
+    RingBuffer<float> ring(kCapacity, channels, format.storage, nullptr, format.layout);
+    TapCursor tap = ring.makeTap();
+
+    const size_t maxLag = kCapacity - kCapacity / 4;
+    std::uniform_int_distribution<size_t> blockSize(1, kCapacity / 3);
+    std::vector<float> output;
+    std::vector<float> block(kCapacity * channels);
+    size_t written = 0;
+    size_t consumed = 0;
+    while (consumed < kSequenceFrames) {
+        const size_t toWrite = std::min({blockSize(gRandom), kSequenceFrames - written, maxLag - (written - consumed)});
+        ring.write(input.data() + written * channels, toWrite);
+        written += toWrite;
+
+        const size_t wanted = blockSize(gRandom);
+        const size_t got = readFrames(ring, tap, reader, block.data(), wanted);
+        if (!Test::check(got == std::min(wanted, written - consumed),
+                         describe("reads get everything pending up to the block size", format, channels, reader))) {
+            return;
+        }
+        output.insert(output.end(), block.begin(), block.begin() + got * channels);
+        consumed += got;
+    }
+
+    Test::check(sameBits(output, expected), describe("every frame arrives in order", format, channels, reader));
+    Test::check(readFrames(ring, tap, reader, block.data(), kCapacity) == 0,
+                describe("nothing left after the last read", format, channels, reader));
+    if (isTap(reader)) {
+        Test::check(tap.framesSkipped == 0, describe("a tap within its lag skips nothing", format, channels, reader));
+    }
+}
+
+/// A tap moves to the start of the new epoch after a reset, and skips
+/// what the writer is about to lap instead of reading it
+static void testTapRecovery(const Format& format, size_t channels, Reader reader) {
+    RingBuffer<float> ring(kCapacity, channels, format.storage, nullptr, format.layout);
+    TapCursor tap = ring.makeTap();
+    std::vector<float> block(kCapacity * channels);
+
+    const std::vector<float> before = randomFrames(40, channels);
+    const std::vector<float> after = randomFrames(30, channels);
+    ring.write(before.data(), 40);
+    ring.reset();
+    ring.write(after.data(), 30);
+    block.resize(after.size());
+    Test::check(readFrames(ring, tap, reader, block.data(), kCapacity) == 30 &&
+                    sameBits(block, roundTrip(after, format.storage)),
+                describe("after a reset a tap reads only the new epoch", format, channels, reader));
+
+    // Fall behind by nearly a lap (a whole one looks empty), in blocks that
+    // straddle the wrap
+    const size_t behind = kCapacity - 16;
+    const std::vector<float> input = randomFrames(behind, channels);
+    for (size_t written = 0; written < behind; written += 50) {
+        ring.write(input.data() + written * channels, std::min<size_t>(50, behind - written));
+    }
+    const size_t maxLag = kCapacity - kCapacity / 4;
+    block.resize(kCapacity * channels);
+    const size_t got = readFrames(ring, tap, reader, block.data(), kCapacity);
+    block.resize(got * channels);
+    const std::vector<float> newest(input.end() - maxLag * channels, input.end());
+    Test::check(got == maxLag && tap.framesSkipped == behind - maxLag &&
+                    sameBits(block, roundTrip(newest, format.storage)),
+                describe("a lagging tap skips the oldest frames and reads the rest in order", format, channels,
+                         reader));
+}
+
+int main() {
+    Kernels::initialize();
+    std::printf("kernels: %s\n", Kernels::active().name);
+    for (const Format& format : kFormats) {
+        const int failuresBefore = Test::failures();
+        for (size_t channels = 1; channels <= kMaxChannels; ++channels) {
+            testRoundTrip(format, channels);
+            for (Reader reader : kReaders) {
+                testWrap(format, channels, reader);
+                testSequence(format, channels, reader);
+                if (isTap(reader)) {
+                    testTapRecovery(format, channels, reader);
+                }
+            }
+        }
+        std::printf("%-8s %s\n", format.name, Test::failures() == failuresBefore ? "ok" : "FAILED");
+    }
+
+    // Planar keeps float samples, and needs a plane per channel
+    RingBuffer<float> compact(kCapacity, 2, RingStorage::Int16, nullptr, RingLayout::Planar);
+    Test::check(compact.layout() == RingLayout::Planar && compact.storage() == RingStorage::Native,
+                "a planar ring keeps float32 samples");
+    RingBuffer<float> wide(kCapacity, RingBuffer<float>::kMaxPlanarChannels + 1, RingStorage::Native, nullptr,
+                           RingLayout::Planar);
+    Test::check(wide.layout() == RingLayout::Interleaved, "a ring with too many channels for planes interleaves");
+    return Test::finish("RingBufferTest");
+}
@@ -0,0 +1,240 @@
+//
+//  SampleKernelsTest.cpp
+//  CymaxPhoneOutDriver Tests
+//
+//  Every kernel of every instruction set this CPU supports against the
+//  scalar reference, for every length up to two of the widest loop steps
+//  and at unaligned offsets, so each SIMD body and each tail hand-off runs
+//
+//  Outputs must be bit-identical (sumOfSquares: equal within rounding),
+//  and nothing past the requested count may be written.
+//
+
+#include "Check.hpp"
+#include "SampleKernels.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace Cymax;
+using Kernels::KernelTable;
+
+// Widest loop step of any kernel: AVX2 unrolls two 8-float vectors
+static constexpr size_t kMaxStep = 16;
+static constexpr size_t kMaxCount = 2 * kMaxStep;
+static constexpr size_t kMaxChannels = 3;
+static constexpr size_t kMaxOffset = 3;
+static constexpr size_t kGuard = 8;
+static constexpr uint8_t kSentinel = 0xA5;
+
+static std::mt19937 gRandom(1);
+
+static std::vector<float> randomFloats(size_t count, float range) {
+    std::uniform_real_distribution<float> value(-range, range);
+    std::vector<float> out(count);
+    for (float& x : out) {
+        x = value(gRandom);
+    }
+    // Exact full scale and zero hit the clamp and rounding edges
+    if (count > 2) {
+        out[0] = 1.0f;
+        out[1] = -1.0f;
+        out[2] = 0.0f;
+    }
+    return out;
+}
+
+/// Output buffer with a guard band, identical for both implementations
+class Output {
+public:
+    explicit Output(size_t bytes) : m_storage(bytes + kMaxOffset * sizeof(float) + kGuard, kSentinel) {}
+
+    uint8_t* at(size_t offset) { return m_storage.data() + offset * sizeof(float); }
+
+    bool operator==(const Output& other) const { return m_storage == other.m_storage; }
+
+private:
+    std::vector<uint8_t> m_storage;
+};
+
+/// Bitwise equality (== would let -0 match 0)
+static bool sameBits(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+static char gWhat[160];
+
+static const char* describe(const KernelTable& table, const char* kernel, size_t count, size_t offset,
+                            size_t channels = 1) {
+    std::snprintf(gWhat, sizeof(gWhat), "%s %s matches scalar (count %zu, offset %zu, %zu ch)", table.name,
+                  kernel, count, offset, channels);
+    return gWhat;
+}
+
+static void testConversions(const KernelTable& table, const KernelTable& reference, size_t count, size_t offset) {
+    const std::vector<float> floats = randomFloats(count + kMaxOffset, 1.25f);
+    {
+        Output expected(count * sizeof(int16_t)), actual(count * sizeof(int16_t));
+        reference.floatToInt16(floats.data() + offset, reinterpret_cast<int16_t*>(expected.at(offset)), count);
+        table.floatToInt16(floats.data() + offset, reinterpret_cast<int16_t*>(actual.at(offset)), count);
+        Test::check(expected == actual, describe(table, "floatToInt16", count, offset));
+    }
+    {
+        Output expected(count * Kernels::kInt24Bytes), actual(count * Kernels::kInt24Bytes);
+        reference.floatToInt24(floats.data() + offset, expected.at(offset), count);
+        table.floatToInt24(floats.data() + offset, actual.at(offset), count);
+        Test::check(expected == actual, describe(table, "floatToInt24", count, offset));
+    }
+    {
+        std::vector<int16_t> int16(count + kMaxOffset);
+        std::uniform_int_distribution<int> value(-32768, 32767);
+        for (int16_t& x : int16) {
+            x = static_cast<int16_t>(value(gRandom));
+        }
+        Output expected(count * sizeof(float)), actual(count * sizeof(float));
+        reference.int16ToFloat(int16.data() + offset, reinterpret_cast<float*>(expected.at(offset)), count);
+        table.int16ToFloat(int16.data() + offset, reinterpret_cast<float*>(actual.at(offset)), count);
+        Test::check(expected == actual, describe(table, "int16ToFloat", count, offset));
+    }
+    {
+        std::vector<uint8_t> int24((count + kMaxOffset) * Kernels::kInt24Bytes);
+        std::uniform_int_distribution<int> value(0, 255);
+        for (uint8_t& x : int24) {
+            x = static_cast<uint8_t>(value(gRandom));
+        }
+        Output expected(count * sizeof(float)), actual(count * sizeof(float));
+        const uint8_t* in = int24.data() + offset * Kernels::kInt24Bytes;
+        reference.int24ToFloat(in, reinterpret_cast<float*>(expected.at(offset)), count);
+        table.int24ToFloat(in, reinterpret_cast<float*>(actual.at(offset)), count);
+        Test::check(expected == actual, describe(table, "int24ToFloat", count, offset));
+    }
+}
+
+static void testArithmetic(const KernelTable& table, const KernelTable& reference, size_t count, size_t offset) {
+    const std::vector<float> a = randomFloats(count + kMaxOffset, 1.0f);
+    const std::vector<float> b = randomFloats(count + kMaxOffset, 2.0f);
+    {
+        std::vector<float> expected(a), actual(a);
+        reference.applyGain(expected.data() + offset, count, 0.7f);
+        table.applyGain(actual.data() + offset, count, 0.7f);
+        Test::check(sameBits(expected, actual), describe(table, "applyGain", count, offset));
+    }
+    {
+        Output expected(count * sizeof(float)), actual(count * sizeof(float));
+        reference.multiply(a.data() + offset, b.data() + offset, reinterpret_cast<float*>(expected.at(offset)), count);
+        table.multiply(a.data() + offset, b.data() + offset, reinterpret_cast<float*>(actual.at(offset)), count);
+        Test::check(expected == actual, describe(table, "multiply", count, offset));
+
+        // In place, as the header allows
+        std::vector<float> expectedInPlace(a), actualInPlace(a);
+        reference.multiply(expectedInPlace.data() + offset, b.data() + offset, expectedInPlace.data() + offset, count);
+        table.multiply(actualInPlace.data() + offset, b.data() + offset, actualInPlace.data() + offset, count);
+        Test::check(sameBits(expectedInPlace, actualInPlace), describe(table, "multiply in place", count, offset));
+    }
+    {
+        const float expected = reference.peakAbs(a.data() + offset, count);
+        const float actual = table.peakAbs(a.data() + offset, count);
+        Test::check(std::memcmp(&expected, &actual, sizeof(float)) == 0, describe(table, "peakAbs", count, offset));
+    }
+    {
+        // Summation order differs, so only within rounding
+        const double expected = reference.sumOfSquares(a.data() + offset, count);
+        const double actual = table.sumOfSquares(a.data() + offset, count);
+        Test::check(std::fabs(expected - actual) <= 1e-6 * expected + 1e-12,
+                    describe(table, "sumOfSquares", count, offset));
+    }
+    {
+        // Every class sanitize() handles, scattered through the block
+        const float specials[] = {std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity(),
+                                  -std::numeric_limits<float>::infinity(), FLT_MIN / 4.0f, -FLT_MIN / 4.0f,
+                                  -0.0f, 3.0f, -3.0f};
+        std::vector<float> input = randomFloats(count + kMaxOffset, 2.0f);
+        std::uniform_int_distribution<size_t> pick(0, sizeof(specials) / sizeof(specials[0]) - 1);
+        for (size_t i = 0; i < input.size(); i += 3) {
+            input[i] = specials[pick(gRandom)];
+        }
+        std::vector<float> expected(input), actual(input);
+        const size_t expectedReplaced = reference.sanitize(expected.data() + offset, count, 1.5f);
+        const size_t actualReplaced = table.sanitize(actual.data() + offset, count, 1.5f);
+        Test::check(sameBits(expected, actual) && expectedReplaced == actualReplaced,
+                    describe(table, "sanitize", count, offset));
+    }
+}
+
+static void testLayouts(const KernelTable& table, const KernelTable& reference, size_t frames, size_t channels,
+                        size_t offset) {
+    const std::vector<float> interleaved = randomFloats((frames + kMaxOffset) * channels, 1.0f);
+    {
+        std::vector<float> expected(interleaved), actual(interleaved);
+        reference.applyGainRamp(expected.data() + offset * channels, frames, channels, 0.2f, 1.1f);
+        table.applyGainRamp(actual.data() + offset * channels, frames, channels, 0.2f, 1.1f);
+        Test::check(sameBits(expected, actual), describe(table, "applyGainRamp", frames, offset, channels));
+    }
+    {
+        std::vector<Output> expected, actual;
+        std::vector<float*> expectedPlanes, actualPlanes;
+        for (size_t c = 0; c < channels; ++c) {
+            expected.emplace_back(frames * sizeof(float));
+            actual.emplace_back(frames * sizeof(float));
+        }
+        for (size_t c = 0; c < channels; ++c) {
+            expectedPlanes.push_back(reinterpret_cast<float*>(expected[c].at(offset)));
+            actualPlanes.push_back(reinterpret_cast<float*>(actual[c].at(offset)));
+        }
+        reference.deinterleave(interleaved.data() + offset * channels, expectedPlanes.data(), frames, channels);
+        table.deinterleave(interleaved.data() + offset * channels, actualPlanes.data(), frames, channels);
+        Test::check(expected == actual, describe(table, "deinterleave", frames, offset, channels));
+    }
+    {
+        std::vector<std::vector<float>> planes;
+        std::vector<const float*> pointers;
+        for (size_t c = 0; c < channels; ++c) {
+            planes.push_back(randomFloats(frames + kMaxOffset, 1.0f));
+        }
+        for (size_t c = 0; c < channels; ++c) {
+            pointers.push_back(planes[c].data() + offset);
+        }
+        Output expected(frames * channels * sizeof(float)), actual(frames * channels * sizeof(float));
+        reference.interleave(pointers.data(), reinterpret_cast<float*>(expected.at(offset)), frames, channels);
+        table.interleave(pointers.data(), reinterpret_cast<float*>(actual.at(offset)), frames, channels);
+        Test::check(expected == actual, describe(table, "interleave", frames, offset, channels));
+    }
+    {
+        Output expected(frames * sizeof(float)), actual(frames * sizeof(float));
+        reference.downmixToMono(interleaved.data() + offset * channels, reinterpret_cast<float*>(expected.at(offset)),
+                                frames, channels);
+        table.downmixToMono(interleaved.data() + offset * channels, reinterpret_cast<float*>(actual.at(offset)),
+                            frames, channels);
+        Test::check(expected == actual, describe(table, "downmixToMono", frames, offset, channels));
+    }
+}
+
+int main() {
+    const KernelTable& reference = Kernels::scalar();
+    for (Kernels::ISA isa : {Kernels::ISA::Scalar, Kernels::ISA::SSE2, Kernels::ISA::AVX2, Kernels::ISA::NEON}) {
+        const KernelTable* table = Kernels::forISA(isa);
+        if (!table) {
+            std::printf("%-8s not supported here, skipped\n", Kernels::isaName(isa));
+            continue;
+        }
+        const int failuresBefore = Test::failures();
+        for (size_t offset = 0; offset <= kMaxOffset; ++offset) {
+            // Lengths 0..2 steps, then one long block for the steady state
+            for (size_t count = 0; count <= kMaxCount + 1; ++count) {
+                const size_t length = count <= kMaxCount ? count : 1021;
+                testConversions(*table, reference, length, offset);
+                testArithmetic(*table, reference, length, offset);
+                for (size_t channels = 1; channels <= kMaxChannels; ++channels) {
+                    testLayouts(*table, reference, length, channels, offset);
+                }
+            }
+        }
+        std::printf("%-8s %s\n", table->name, Test::failures() == failuresBefore ? "matches scalar" : "MISMATCH");
+    }
+    return Test::finish("SampleKernelsTest");
+}
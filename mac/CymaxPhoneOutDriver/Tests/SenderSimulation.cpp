@@ -0,0 +1,235 @@
+//
+//  SenderSimulation.cpp
+//  CymaxPhoneOutDriver Tests
+//
+//  Runs UDPSender against SimulatedEnvironment for simulated hours with
+//  scripted render bursts, EAGAIN storms and scheduling stalls, and checks
+//  its latency, pacing and drop invariants
+//
+//  Every frame carries its index, so the receiver side can tell exactly
+//  which audio arrived, how late, and what went missing. The run is
+//  deterministic: the printed hash only changes when the packets sent or
+//  their timing do.
+//
+//  Usage: SenderSimulation [seconds]
+//
+
+#include "Check.hpp"
+#include "PacketRing.hpp"
+#include "RingBuffer.hpp"
+#include "UDPSender.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace Cymax;
+using Environment = SimulatedEnvironment;
+
+static constexpr uint64_t kMillis = 1000000;
+static constexpr uint64_t kSecond = 1000 * kMillis;
+static constexpr size_t kRenderFrames = 512;
+static constexpr size_t kRingFrames = 4096;
+static constexpr uint64_t kRenderPeriod = kRenderFrames * kSecond / 48000;
+
+// The longest scripted disruption: a 400 ms scheduling stall
+static constexpr uint64_t kLongestStall = 400 * kMillis;
+
+/// When render block k reaches the ring: every period, except that a 50 ms
+/// render stall 40 s into every minute delivers its blocks in one burst
+static uint64_t renderTime(uint64_t block) {
+    const uint64_t due = block * kRenderPeriod;
+    const uint64_t phase = due % (60 * kSecond);
+    if (phase >= 40 * kSecond && phase < 40 * kSecond + 50 * kMillis) {
+        return due - phase + 40 * kSecond + 50 * kMillis;
+    }
+    return due;
+}
+
+/// A 4 ms EAGAIN storm every 7 s (retries get through) and a 30 ms one
+/// every 45 s (past the 20 ms budget, so packets must be dropped)
+static bool transportBlocked(uint64_t time) {
+    return (time % (7 * kSecond) >= 3 * kSecond && time % (7 * kSecond) < 3 * kSecond + 4 * kMillis) ||
+           (time % (45 * kSecond) >= 20 * kSecond && time % (45 * kSecond) < 20 * kSecond + 30 * kMillis);
+}
+
+int main(int argc, char** argv) {
+    const uint64_t duration = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 3600) * kSecond;
+
+    RingBuffer<float> ring(kRingFrames, 2);
+    UDPSenderConfig config;
+    config.realtimeScheduling = false;
+    UDPSender sender;
+    sender.initialize(&ring, config);
+    sender.setDestination("127.0.0.1");
+
+    // Packet rings whose slots can't hold a whole packet are refused
+    PacketRing oversized(4, 200, 2, kPacketHeaderBytes);
+    PacketRing noHeaderRoom(4, 128, 2, kPacketHeaderBytes - 4);
+    PacketRing wrongChannels(4, 128, 1, kPacketHeaderBytes);
+    Test::check(!sender.setPacketRing(&oversized) && !sender.setPacketRing(&noHeaderRoom) &&
+                    !sender.setPacketRing(&wrongChannels),
+                "packet rings with slots that don't fit a packet are refused");
+
+    // Render thread: frame i carries i (low 23 bits left, the rest right),
+    // exact in float
+    std::vector<uint64_t> renderedAt;
+    std::vector<float> block(kRenderFrames * 2);
+    uint64_t nextBlock = 0;
+    uint64_t frameIndex = 0;
+    uint64_t framesLostAtWriter = 0;
+    bool stopped = false;
+    Environment::advance = [&](uint64_t time) {
+        while (renderTime(nextBlock) <= time) {
+            for (size_t i = 0; i < kRenderFrames; ++i, ++frameIndex) {
+                block[2 * i] = static_cast<float>(frameIndex & 0x7FFFFF);
+                block[2 * i + 1] = static_cast<float>(frameIndex >> 23);
+            }
+            framesLostAtWriter += kRenderFrames - ring.write(block.data(), kRenderFrames);
+            renderedAt.push_back(time);
+            ++nextBlock;
+        }
+        if (time >= duration && !stopped) {
+            stopped = true;
+            sender.stop();
+        }
+    };
+    Environment::blocked = transportBlocked;
+
+    // Scheduler: one 15 ms late wake every 30 s, one 400 ms stall every
+    // 10 minutes
+    uint64_t lateWindow = UINT64_MAX;
+    uint64_t stallWindow = UINT64_MAX;
+    Environment::oversleep = [&](uint64_t time) -> uint64_t {
+        if (time / (600 * kSecond) != stallWindow && time % (600 * kSecond) >= 300 * kSecond) {
+            stallWindow = time / (600 * kSecond);
+            return kLongestStall;
+        }
+        if (time / (30 * kSecond) != lateWindow && time % (30 * kSecond) >= 10 * kSecond) {
+            lateWindow = time / (30 * kSecond);
+            return 15 * kMillis;
+        }
+        return 0;
+    };
+
+    // Receiver
+    uint64_t received = 0;
+    uint64_t framesReceived = 0;
+    uint64_t sequenceGaps = 0;
+    uint64_t outOfOrder = 0;
+    uint64_t maxLatency = 0;
+    uint64_t lastSend = 0;
+    uint64_t maxSendGap = 0;
+    uint64_t controlMessages = 0;
+    uint64_t hash = 1469598103934665603ULL;  // FNV-1a over packets and send times
+    int64_t lastSequence = -1;
+    std::vector<uint32_t> latencyHistogram(1000);  // 0.1 ms buckets
+    Environment::deliver = [&](const uint8_t* packet, size_t size, uint64_t time) {
+        uint32_t magic = 0;
+        std::memcpy(&magic, packet, sizeof(magic));
+        if (magic != 0x584D4143) {
+            ++controlMessages;  // Negotiation queries nobody answers
+            return;
+        }
+
+        uint32_t sequence = 0;
+        uint16_t frames = 0;
+        std::memcpy(&sequence, packet + 4, sizeof(sequence));
+        std::memcpy(&frames, packet + 22, sizeof(frames));
+        float firstSamples[2];
+        std::memcpy(firstSamples, packet + kPacketHeaderBytes, sizeof(firstSamples));
+        const uint64_t first = static_cast<uint64_t>(firstSamples[0]) | (static_cast<uint64_t>(firstSamples[1]) << 23);
+
+        if (lastSequence >= 0 && sequence != static_cast<uint64_t>(lastSequence) + 1) {
+            if (sequence <= lastSequence) {
+                ++outOfOrder;
+            } else {
+                sequenceGaps += sequence - lastSequence - 1;
+            }
+        }
+        lastSequence = sequence;
+
+        // From the render block holding the packet's last frame to the wire
+        const uint64_t latency = time - renderedAt[(first + frames - 1) / kRenderFrames];
+        maxLatency = std::max(maxLatency, latency);
+        ++latencyHistogram[std::min<uint64_t>(latencyHistogram.size() - 1, latency / 100000)];
+        if (received > 0) {
+            maxSendGap = std::max(maxSendGap, time - lastSend);
+        }
+        lastSend = time;
+        ++received;
+        framesReceived += frames;
+
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ packet[i]) * 1099511628211ULL;
+        }
+        hash = (hash ^ time) * 1099511628211ULL;
+    };
+
+    const auto wallStart = std::chrono::steady_clock::now();
+    sender.start();
+    while (sender.isRunning()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    sender.waitUntilIdle();
+    const double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+
+    const SendOutcomeStats outcomes = sender.sendOutcomes();
+    uint64_t p99Bucket = 0;
+    uint64_t counted = 0;
+    for (size_t i = 0; i < latencyHistogram.size(); ++i) {
+        counted += latencyHistogram[i];
+        if (counted * 100 >= received * 99) {
+            p99Bucket = i;
+            break;
+        }
+    }
+    const uint64_t rendered = nextBlock * kRenderFrames;
+    const uint64_t accounted = framesReceived + sequenceGaps * config.framesPerPacket + sender.framesDropped() +
+                               framesLostAtWriter + ring.availableForRead();
+    const uint64_t unaccounted = rendered - accounted;
+    const uint64_t laps = unaccounted / ring.capacity();
+
+    std::printf("simulated %.0f s in %.0f ms, %llu control messages\n", Environment::now / 1e9, wallMs,
+                static_cast<unsigned long long>(controlMessages));
+    std::printf("packets %llu, sequence gaps %llu, dropped %llu (deadline %llu, overflow %llu), "
+                "would-block %llu, sent after retry %llu\n",
+                static_cast<unsigned long long>(received), static_cast<unsigned long long>(sequenceGaps),
+                static_cast<unsigned long long>(sender.packetsDropped()),
+                static_cast<unsigned long long>(outcomes.droppedDeadline),
+                static_cast<unsigned long long>(outcomes.droppedOverflow),
+                static_cast<unsigned long long>(outcomes.wouldBlock),
+                static_cast<unsigned long long>(outcomes.sentAfterRetry));
+    std::printf("frames rendered %llu, accounted %llu, unaccounted %llu = %llu ring laps of %zu\n",
+                static_cast<unsigned long long>(rendered), static_cast<unsigned long long>(accounted),
+                static_cast<unsigned long long>(unaccounted), static_cast<unsigned long long>(laps), ring.capacity());
+    std::printf("latency p99 <= %.1f ms, max %.2f ms; longest send gap %.2f ms; hash %016llx\n",
+                (p99Bucket + 1) / 10.0, maxLatency / 1e6, maxSendGap / 1e6, static_cast<unsigned long long>(hash));
+
+    Test::check(outOfOrder == 0, "audio packets arrive in order");
+    Test::check(sequenceGaps == sender.packetsDropped(), "every sequence gap is a counted drop");
+    Test::check(received == sender.packetsSent(), "packetsSent matches what was delivered");
+    // One destination: every copy sent is a packet counted once by kind
+    Test::check(outcomes.sentFirstTry + outcomes.sentAfterRetry ==
+                    sender.packetsSent() + sender.dtxPacketsSent() + sender.spectrumPacketsSent() +
+                        sender.fecPacketsSent() + sender.preRollPacketsSent(),
+                "each copy sent is counted as one packet");
+    Test::check(outcomes.droppedDeadline + outcomes.droppedOverflow + outcomes.sendErrors == sender.packetsDropped(),
+                "each copy dropped is counted as one dropped packet");
+    // The sample ring overwrites when full, so a stall longer than the ring
+    // loses whole laps that no counter sees
+    Test::check(accounted <= rendered && unaccounted % ring.capacity() == 0,
+                "every rendered frame is sent, dropped, queued or lost in whole ring laps");
+    Test::check(laps <= 5 * (Environment::now / (600 * kSecond)), "ring laps are only lost in the 400 ms stalls");
+    Test::check(outcomes.droppedDeadline > 0 && outcomes.sentAfterRetry > 0,
+                "storms exercised both retry and the deadline");
+    Test::check(p99Bucket < 10, "p99 latency under 1 ms");
+    Test::check(maxLatency <= kLongestStall + 20 * kMillis, "latency bounded by the longest scripted stall");
+    Test::check(maxSendGap <= kLongestStall + 20 * kMillis, "send gaps bounded by the longest scripted stall");
+    Test::check(sender.preRollBursts() == 0, "no pre-roll for the destination present from the start");
+    return Test::finish("SenderSimulation");
+}
@@ -0,0 +1,243 @@
+//
+//  SenderTimeSeriesTest.cpp
+//  CymaxPhoneOutDriver Tests
+//
+//  SenderTimeSeries: per-second deltas of the lifetime totals, the 1, 10
+//  and 60 second windows while history fills and after it rolls over, a
+//  second that lasted longer than a second, and reset(). Then one thread
+//  closes seconds while others read latest() and the shared stats page
+//  through a read-only mapping of their own, retrying on the seqlock as the
+//  menubar app does: every snapshot must be one whole second.
+//
+
+#include "Check.hpp"
+#include "SenderTimeSeries.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Cymax;
+
+static constexpr uint64_t kSecond = 1000000000;
+static constexpr uint32_t kHistory = SenderRateSnapshot::kHistorySeconds;
+static constexpr const char* kPageName = "stats-test.shm";
+
+/// Totals after n seconds in which second k sent k packets of 100 bytes
+/// and dropped k of each kind, so every delta equals its second's number
+static SenderCounterTotals totalsAfter(uint64_t n) {
+    const uint64_t sum = n * (n + 1) / 2;
+    SenderCounterTotals totals;
+    totals.packetsSent = sum;
+    totals.bytesSent = 100 * sum;
+    totals.packetsDropped = sum;
+    totals.framesDropped = sum;
+    totals.wouldBlock = sum;
+    totals.sendCount = sum;
+    totals.sendNanos = 2000 * sum;
+    return totals;
+}
+
+/// Close second n of the pattern above
+static void closeSecond(SenderTimeSeries& series, uint64_t n, uint64_t elapsedNanos = kSecond) {
+    series.closeSecond(elapsedNanos, totalsAfter(n), n * 1000, 1, static_cast<double>(n), static_cast<size_t>(n));
+}
+
+static bool near(float value, double expected) {
+    return std::fabs(static_cast<double>(value) - expected) <= 1e-4 * std::max(1.0, std::fabs(expected));
+}
+
+/// Every field follows from the sequence when seconds were closed with
+/// closeSecond(n) for n = 1, 2, ... sequence, each lasting a second
+static bool consistent(const SenderRateSnapshot& snapshot) {
+    const uint32_t seq = snapshot.sequence;
+    const uint32_t count = std::min(seq, kHistory);
+    if (snapshot.historyCount != count) {
+        return false;
+    }
+    for (uint32_t i = 0; i < kHistory; ++i) {
+        const SenderRateSecond& entry = snapshot.history[i];
+        const uint32_t n = i < count ? seq - i : 0;
+        if (entry.packetsSent != n || entry.packetsDropped != n || entry.framesDropped != n ||
+            entry.wouldBlock != n || entry.maxFillFrames != n || entry.maxSendLatencyMicros != static_cast<float>(n)) {
+            return false;
+        }
+    }
+    for (uint32_t w = 0; w < SenderRateSnapshot::kWindows; ++w) {
+        const SenderRateWindow& window = snapshot.windows[w];
+        const uint32_t seconds = std::min(SenderRateSnapshot::kWindowSeconds[w], seq);
+        if (window.seconds != seconds) {
+            return false;
+        }
+        if (seconds == 0) {
+            continue;
+        }
+        // The newest `seconds` seconds average seq - (seconds - 1) / 2
+        const double mean = static_cast<double>(seq) - (static_cast<double>(seconds) - 1.0) / 2.0;
+        if (!near(window.packetsPerSecond, mean) || !near(window.bitsPerSecond, 800.0 * mean) ||
+            !near(window.lossPercent, 50.0) || !near(window.framesDroppedPerSecond, mean) ||
+            !near(window.wouldBlockPerSecond, mean) || !near(window.meanSendLatencyMicros, 2.0) ||
+            window.maxSendLatencyMicros != static_cast<float>(seq) || !near(window.meanFillFrames, mean) ||
+            window.maxFillFrames != seq) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void testWindows() {
+    SenderTimeSeries series;
+    series.reset(totalsAfter(0));
+    Test::check(series.latest().sequence == 0 && consistent(series.latest()), "reset publishes an empty history");
+
+    bool filling = true;
+    for (uint64_t n = 1; n <= 5; ++n) {
+        closeSecond(series, n);
+        filling = filling && consistent(series.latest());
+    }
+    const SenderRateSnapshot five = series.latest();
+    Test::check(filling && five.windows[1].seconds == 5 && five.windows[2].seconds == 5,
+                "while history fills, windows cover what there is");
+
+    bool rolling = true;
+    for (uint64_t n = 6; n <= 3 * kHistory + 7; ++n) {
+        closeSecond(series, n);
+        rolling = rolling && consistent(series.latest());
+    }
+    const SenderRateSnapshot full = series.latest();
+    Test::check(rolling && full.historyCount == kHistory && full.windows[2].seconds == kHistory &&
+                    full.history[kHistory - 1].packetsSent == full.sequence - (kHistory - 1),
+                "after history rolls over it holds the newest 60 seconds, newest first");
+
+    // A second the sender overslept by a whole second counts at half rate
+    const uint64_t next = full.sequence + 1;
+    closeSecond(series, next, 2 * kSecond);
+    const SenderRateSnapshot slow = series.latest();
+    Test::check(near(slow.windows[0].packetsPerSecond, static_cast<double>(next) / 2.0) &&
+                    slow.history[0].packetsSent == next,
+                "rates divide by how long the second actually lasted");
+
+    series.reset(totalsAfter(next));
+    const SenderRateSnapshot cleared = series.latest();
+    Test::check(cleared.sequence == 0 && cleared.historyCount == 0 && cleared.windows[2].seconds == 0 &&
+                    cleared.history[0].packetsSent == 0,
+                "reset clears the history");
+    series.closeSecond(kSecond, totalsAfter(next), 0, 0, 0.0, 0);
+    Test::check(series.latest().history[0].packetsSent == 0 && series.latest().windows[0].lossPercent == 0.0f,
+                "deltas after a reset start from the totals it was given");
+}
+
+/// The page as a separate read-only mapping, as another process sees it
+struct PageReader {
+    PageReader() {
+        const std::string path = std::string(SharedMemoryRegion::kDirectory) + "/" + kPageName;
+        const int fd = open(path.c_str(), O_RDONLY | O_NOFOLLOW);
+        if (fd < 0) {
+            return;
+        }
+        void* mapped = mmap(nullptr, sizeof(SenderStatsSharedPage), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped != MAP_FAILED) {
+            page = static_cast<const SenderStatsSharedPage*>(mapped);
+        }
+    }
+
+    ~PageReader() {
+        if (page) {
+            munmap(const_cast<SenderStatsSharedPage*>(page), sizeof(SenderStatsSharedPage));
+        }
+    }
+
+    /// Copy a snapshot, retrying while the driver is mid-write
+    SenderRateSnapshot read(uint64_t& retries) const {
+        SenderRateSnapshot snapshot;
+        for (;;) {
+            const uint32_t before = page->sequence.load(std::memory_order_acquire);
+            if ((before & 1) == 0) {
+                std::memcpy(&snapshot, &page->snapshot, sizeof(snapshot));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (page->sequence.load(std::memory_order_relaxed) == before) {
+                    return snapshot;
+                }
+            }
+            ++retries;
+        }
+    }
+
+    const SenderStatsSharedPage* page = nullptr;
+};
+
+static void testConcurrentReaders() {
+    SenderTimeSeries series;
+    if (!Test::check(series.openSharedPage(kPageName), "the shared stats page opens")) {
+        return;
+    }
+    series.reset(totalsAfter(0));
+    PageReader reader;
+    if (!Test::check(reader.page != nullptr && reader.page->magic == SenderStatsSharedPage::kMagic &&
+                         reader.page->version == SenderStatsSharedPage::kVersion,
+                     "another mapping sees the page header")) {
+        return;
+    }
+
+    constexpr uint64_t kSeconds = 5000;
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> torn{0};
+    std::atomic<uint64_t> backwards{0};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> retries{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        const bool fromPage = r % 2 == 1;
+        readers.emplace_back([&, fromPage] {
+            uint32_t last = 0;
+            uint64_t retried = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                const SenderRateSnapshot snapshot = fromPage ? reader.read(retried) : series.latest();
+                if (!consistent(snapshot)) {
+                    torn.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (snapshot.sequence < last) {
+                    backwards.fetch_add(1, std::memory_order_relaxed);
+                }
+                last = snapshot.sequence;
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+            retries.fetch_add(retried, std::memory_order_relaxed);
+        });
+    }
+
+    for (uint64_t n = 1; n <= kSeconds; ++n) {
+        closeSecond(series, n);
+        if (n % 16 == 0) {
+            std::this_thread::yield();  // Let the readers in on a single CPU
+        }
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& thread : readers) {
+        thread.join();
+    }
+
+    std::printf("concurrent readers: %llu snapshots, %llu seqlock retries\n",
+                static_cast<unsigned long long>(reads.load()), static_cast<unsigned long long>(retries.load()));
+    Test::check(torn.load() == 0, "every snapshot, from latest() or the page, is one whole second");
+    Test::check(backwards.load() == 0, "a reader never sees an older second after a newer one");
+    uint64_t unused = 0;
+    Test::check(reader.read(unused).sequence == kSeconds && series.latest().sequence == kSeconds,
+                "the last second is what remains published");
+}
+
+int main() {
+    testWindows();
+    testConcurrentReaders();
+    unlink((std::string(SharedMemoryRegion::kDirectory) + "/" + kPageName).c_str());
+    return Test::finish("SenderTimeSeriesTest");
+}
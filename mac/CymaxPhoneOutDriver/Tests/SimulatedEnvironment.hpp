@@ -0,0 +1,92 @@
+//
+//  SimulatedEnvironment.hpp
+//  CymaxPhoneOutDriver Tests
+//
+//  Discrete-event SenderEnvironment: a virtual clock, a scripted
+//  transport and scripted scheduling delays
+//
+//  Time only moves when the sender sleeps or waits for the socket, so
+//  hours of streaming run in seconds and every run is identical. The
+//  test supplies the script as callbacks before starting the sender.
+//  Pre-included into the simulated build of the core (see
+//  Tests/CMakeLists.txt and SenderEnvironment.hpp).
+//
+
+#ifndef SimulatedEnvironment_hpp
+#define SimulatedEnvironment_hpp
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace Cymax {
+
+struct SimulatedEnvironment {
+    /// Virtual time in nanoseconds
+    static inline uint64_t now = 0;
+
+    /// Called with the new time whenever the clock moves (runs the events
+    /// due by then, e.g. render blocks arriving)
+    static inline std::function<void(uint64_t)> advance;
+
+    /// Whether the transport pushes back (EAGAIN) at a time
+    static inline std::function<bool(uint64_t)> blocked;
+
+    /// A datagram the transport accepted, and when
+    static inline std::function<void(const uint8_t*, size_t, uint64_t)> deliver;
+
+    /// How late the sleep starting at a time wakes
+    static inline std::function<uint64_t(uint64_t)> oversleep;
+
+    /// The next datagram waiting at the socket: fills data and from and
+    /// returns its size, or -1 if none (unset: nobody ever answers)
+    static inline std::function<ssize_t(uint8_t*, size_t, struct sockaddr_in&)> arrive;
+
+    static void advanceTo(uint64_t time) {
+        if (time > now) {
+            now = time;
+            advance(now);
+        }
+    }
+
+    static uint64_t nowNanos() { return now; }
+
+    static void sleepNanos(uint64_t nanos) { advanceTo(now + nanos + oversleep(now)); }
+
+    static ssize_t sendTo(int socket, const uint8_t* data, size_t size, const struct sockaddr_in& addr) {
+        if (blocked(now)) {
+            errno = EAGAIN;
+            return -1;
+        }
+        deliver(data, size, now);
+        return static_cast<ssize_t>(size);
+    }
+
+    /// What arrive scripts; without it nobody answers (receivers that
+    /// predate negotiation)
+    static ssize_t receiveFrom(int socket, uint8_t* data, size_t capacity, struct sockaddr_in& from) {
+        const ssize_t size = arrive ? arrive(data, capacity, from) : -1;
+        if (size < 0) {
+            errno = EAGAIN;
+        }
+        return size;
+    }
+
+    /// Writable again as soon as a storm ends (checked in 100 us steps)
+    static bool waitWritable(int socket, uint64_t timeoutNanos) {
+        const uint64_t until = now + timeoutNanos;
+        while (now < until && blocked(now)) {
+            advanceTo(std::min(until, now + 100000));
+        }
+        return !blocked(now);
+    }
+};
+
+} // namespace Cymax
+
+#endif /* SimulatedEnvironment_hpp */
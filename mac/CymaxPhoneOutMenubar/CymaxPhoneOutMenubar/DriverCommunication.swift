@@ -7,10 +7,13 @@
 //  The menubar app communicates with the driver to:
 //  - Set the destination IP address for UDP audio packets
 //  - Query/set sample rate and buffer size
+//  - Read the driver's level meters and spectrum
+//  - Start/stop recording what the driver sends
 //
-//  MVP Implementation:
-//  Uses a file at /tmp/cymax_dest_ip.txt as a simple IPC mechanism.
-//  The driver reads from this file when startIO() is called.
+//  Destinations, port and stream profile go through a shared control
+//  block (control.shm in the driver's shared directory, ControlBlockPage
+//  in the driver's ControlBlock.hpp). The driver's sender checks its generation once per
+//  packet, so changes take effect immediately, even mid-stream.
 //
 //  For web mode, we set the destination to 127.0.0.1 (localhost)
 //  so the audio is sent to the menubar app's UDP receiver,
@@ -20,10 +23,92 @@
 import Foundation
 import CoreAudio
 
+/// Level meter readings published by the driver
+/// Mirrors LevelMeterSnapshot in the driver's LevelMeter.hpp
+struct DriverLevelMeters {
+    /// Increments on every driver publish (30 Hz while IO is running)
+    let sequence: UInt32
+    
+    /// Linear sample peak per channel
+    let peak: [Float]
+    
+    /// Linear RMS per channel
+    let rms: [Float]
+    
+    /// Short-term (3 s) loudness per channel, LUFS
+    let shortTermLUFS: [Float]
+    
+    /// Short-term loudness of all channels combined, LUFS
+    let shortTermLUFSTotal: Float
+}
+
+/// Sender rates over one rolling window
+/// Mirrors SenderRateWindow in the driver's SenderTimeSeries.hpp
+struct DriverRateWindow {
+    /// Seconds of history covered (less than the window right after start)
+    let seconds: UInt32
+    let packetsPerSecond: Float
+    let bitsPerSecond: Float
+    
+    /// Packets the driver dropped, percent of those it tried to send
+    let lossPercent: Float
+    let framesDroppedPerSecond: Float
+    let wouldBlockPerSecond: Float
+    let meanSendLatencyMicros: Float
+    let maxSendLatencyMicros: Float
+    let meanFillFrames: Float
+    let maxFillFrames: UInt32
+}
+
+/// One second of sender history
+/// Mirrors SenderRateSecond in the driver's SenderTimeSeries.hpp
+struct DriverRateSecond {
+    let packetsSent: UInt32
+    let packetsDropped: UInt32
+    let framesDropped: UInt32
+    let wouldBlock: UInt32
+    let maxSendLatencyMicros: Float
+    let maxFillFrames: UInt32
+}
+
+/// Sender rates published by the driver once a second
+/// Mirrors SenderRateSnapshot in the driver's SenderTimeSeries.hpp
+struct DriverSenderRates {
+    /// Seconds closed since streaming started
+    let sequence: UInt32
+    
+    /// Last 1 s, 10 s and 60 s
+    let windows: [DriverRateWindow]
+    
+    /// Newest first: history[30] is the second that ended 30 s ago
+    let history: [DriverRateSecond]
+}
+
+/// Audio payload format the driver sends
+/// Mirrors StreamProfile in the driver's ControlBlock.hpp
+enum DriverStreamProfile: UInt16 {
+    case float32 = 0
+    case int16 = 1
+}
+
 /// Communication with the Cymax Phone Out audio driver
 class DriverCommunication {
-    /// File path for destination IP (shared with driver)
-    private let destIPFilePath = "/tmp/cymax_dest_ip.txt"
+    /// Shared control block read by the driver's sender (ControlBlockPage)
+    /// magic(4) version(4) generation(4) port(2) profile(2) count(4)
+    /// destinations(4 x 4, IPv4 network order) idleTeardown(4), padded to
+    /// 64 bytes
+    private let controlBlockPath = "/Users/Shared/CymaxPhoneOutShared/control.shm"
+    private let controlBlockSize = 64
+    private let controlBlockMagic: UInt32 = 0x4C544343
+    private let controlBlockVersion: UInt32 = 1
+    private let maxDestinations = 4
+    private var controlBlock: UnsafeMutableRawPointer?
+    
+    /// Settings last written to the control block
+    private var destinations: [String] = []
+    private var destinationPort: UInt16 = 19620
+    private var streamProfile: DriverStreamProfile = .float32
+    private var idleTeardownSeconds: UInt32 = 0
     
     /// CFPreferences domain for driver communication (legacy)
     private let preferencesDomain = "com.cymax.phoneoutdriver" as CFString
@@ -38,6 +123,27 @@ class DriverCommunication {
     /// Device UID for the Cymax Phone Out device
     private let deviceUID = "CymaxPhoneOutMVP"
     
+    /// Custom device property for level meters ('CMtr')
+    private let levelMetersSelector: AudioObjectPropertySelector = 0x434D7472
+    
+    /// Custom device property for sender rates ('CRat', SenderRateSnapshot)
+    private let senderRatesSelector: AudioObjectPropertySelector = 0x43526174
+    
+    /// Shared spectrum page written by the driver (SpectrumSharedPage)
+    private let spectrumPagePath = "/Users/Shared/CymaxPhoneOutShared/spectrum.shm"
+    private let spectrumPageSize = 32 + 64 * 4
+    private var spectrumPage: UnsafeRawPointer?
+    
+    /// Custom device property for the recording path ('CRec', char[256])
+    private let recordingPathSelector: AudioObjectPropertySelector = 0x43526563
+    private let recordingPathSize = 256
+    
+    /// Custom device property to save the replay buffer ('CRpl', char[256])
+    private let replaySavePathSelector: AudioObjectPropertySelector = 0x4352706C
+    
+    /// Device ID cache so polling meters doesn't rescan devices
+    private var cachedDeviceID: AudioObjectID?
+    
     /// Logger callback
     var onLog: ((String) -> Void)?
     
@@ -57,41 +163,103 @@ class DriverCommunication {
     /// For web mode, use "127.0.0.1" to send to local UDP receiver
     func setDestinationIP(_ ipAddress: String) {
         log("Setting destination IP to \(ipAddress)")
-        
-        // Write to /tmp which is accessible to everyone including coreaudiod
-        do {
-            try ipAddress.write(toFile: destIPFilePath, atomically: true, encoding: .utf8)
-            // Make sure it's world-readable
-            try FileManager.default.setAttributes([.posixPermissions: 0o644], ofItemAtPath: destIPFilePath)
-            log("✓ Wrote IP to \(destIPFilePath)")
-        } catch {
-            log("⚠ Failed to write IP file: \(error.localizedDescription)")
+        setDestinations([ipAddress])
+    }
+    
+    /// Send to several receivers at once (up to four IPv4 addresses)
+    func setDestinations(_ ipAddresses: [String]) {
+        destinations = Array(ipAddresses.prefix(maxDestinations))
+        if writeControlBlock() {
+            log("✓ Destinations: \(destinations.joined(separator: ", "))")
         }
     }
     
     /// Clear the destination IP address
     func clearDestinationIP() {
         log("Clearing destination IP")
-        
-        // Remove the file
-        do {
-            if FileManager.default.fileExists(atPath: destIPFilePath) {
-                try FileManager.default.removeItem(atPath: destIPFilePath)
-                log("✓ Removed IP file")
-            }
-        } catch {
-            log("⚠ Failed to remove IP file: \(error.localizedDescription)")
-        }
+        setDestinations([])
     }
     
-    /// Get the current destination IP address from file
+    /// Get the current destination IP address
     func getDestinationIP() -> String? {
-        do {
-            let ip = try String(contentsOfFile: destIPFilePath, encoding: .utf8)
-            return ip.trimmingCharacters(in: .whitespacesAndNewlines)
-        } catch {
+        return destinations.first
+    }
+    
+    /// Select the payload format the driver sends
+    func setStreamProfile(_ profile: DriverStreamProfile) {
+        streamProfile = profile
+        _ = writeControlBlock()
+    }
+    
+    /// How long the driver keeps its stream buffers, threads and socket
+    /// after output stops (0 = driver default)
+    func setIdleTeardown(seconds: UInt32) {
+        idleTeardownSeconds = seconds
+        _ = writeControlBlock()
+    }
+    
+    /// Map the control block once the driver has created it
+    private func mapControlBlock() -> UnsafeMutableRawPointer? {
+        if let block = controlBlock {
+            return block
+        }
+        
+        // The driver creates the page (mode 0660, writable through the
+        // directory's group) and sizes it; never create or resize it here
+        let fd = open(controlBlockPath, O_RDWR | O_NOFOLLOW)
+        guard fd >= 0 else {
+            log("⚠ Failed to open control block: \(String(cString: strerror(errno)))")
+            return nil
+        }
+        defer { close(fd) }
+        
+        var info = stat()
+        guard fstat(fd, &info) == 0, info.st_size >= off_t(controlBlockSize) else { return nil }
+        let mapped = mmap(nil, controlBlockSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+        guard let mapped = mapped, mapped != MAP_FAILED else { return nil }
+        
+        guard mapped.load(fromByteOffset: 0, as: UInt32.self) == controlBlockMagic,
+              mapped.load(fromByteOffset: 4, as: UInt32.self) == controlBlockVersion else {
+            munmap(mapped, controlBlockSize)
             return nil
         }
+        controlBlock = mapped
+        return mapped
+    }
+    
+    /// Publish the current settings
+    /// Seqlock: the generation is odd while writing, so the driver never
+    /// applies a half-written block
+    private func writeControlBlock() -> Bool {
+        guard let block = mapControlBlock() else { return false }
+        
+        var addresses: [UInt32] = []
+        for ip in destinations {
+            var addr = in_addr()
+            if inet_pton(AF_INET, ip, &addr) == 1 {
+                addresses.append(addr.s_addr)
+            } else {
+                log("⚠ Ignoring invalid IPv4 address \(ip)")
+            }
+        }
+        
+        let generation = block.advanced(by: 8).assumingMemoryBound(to: UInt32.self)
+        let start = generation.pointee & ~1
+        generation.pointee = start &+ 1
+        OSMemoryBarrier()
+        
+        block.storeBytes(of: destinationPort, toByteOffset: 12, as: UInt16.self)
+        block.storeBytes(of: streamProfile.rawValue, toByteOffset: 14, as: UInt16.self)
+        block.storeBytes(of: UInt32(addresses.count), toByteOffset: 16, as: UInt32.self)
+        for index in 0..<maxDestinations {
+            let address = index < addresses.count ? addresses[index] : 0
+            block.storeBytes(of: address, toByteOffset: 20 + index * 4, as: UInt32.self)
+        }
+        block.storeBytes(of: idleTeardownSeconds, toByteOffset: 36, as: UInt32.self)
+        
+        OSMemoryBarrier()
+        generation.pointee = start &+ 2
+        return true
     }
     
     // MARK: - Sample Rate
@@ -144,6 +312,198 @@ class DriverCommunication {
         return (value as? UInt32) ?? 256
     }
     
+    // MARK: - Level Meters
+    
+    /// Read the latest level meters from the driver
+    /// Cheap enough to poll at display rate
+    func getLevelMeters() -> DriverLevelMeters? {
+        guard let device = cachedDeviceID ?? findDevice() else { return nil }
+        cachedDeviceID = device
+        
+        var propertyAddress = AudioObjectPropertyAddress(
+            mSelector: levelMetersSelector,
+            mScope: kAudioObjectPropertyScopeGlobal,
+            mElement: kAudioObjectPropertyElementMain
+        )
+        
+        // sequence(4) + channels(4) + 3 x 8 channel floats + total(4)
+        let maxChannels = 8
+        let byteCount = 8 + 3 * maxChannels * 4 + 4
+        var raw = [UInt8](repeating: 0, count: byteCount)
+        var dataSize = UInt32(byteCount)
+        
+        let status = AudioObjectGetPropertyData(device, &propertyAddress, 0, nil, &dataSize, &raw)
+        guard status == noErr, Int(dataSize) == byteCount else {
+            // Device may have gone away; rescan next time
+            cachedDeviceID = nil
+            return nil
+        }
+        
+        return raw.withUnsafeBytes { ptr -> DriverLevelMeters in
+            let sequence = ptr.load(fromByteOffset: 0, as: UInt32.self)
+            let channels = min(Int(ptr.load(fromByteOffset: 4, as: UInt32.self)), maxChannels)
+            func floats(_ index: Int) -> [Float] {
+                let base = 8 + index * maxChannels * 4
+                return (0..<channels).map { ptr.load(fromByteOffset: base + $0 * 4, as: Float.self) }
+            }
+            return DriverLevelMeters(
+                sequence: sequence,
+                peak: floats(0),
+                rms: floats(1),
+                shortTermLUFS: floats(2),
+                shortTermLUFSTotal: ptr.load(fromByteOffset: byteCount - 4, as: Float.self)
+            )
+        }
+    }
+    
+    // MARK: - Sender Rates
+    
+    /// Read the sender's rolling rates and last minute of history
+    /// Updated once a second while IO is running
+    func getSenderRates() -> DriverSenderRates? {
+        guard let device = cachedDeviceID ?? findDevice() else { return nil }
+        cachedDeviceID = device
+        
+        var propertyAddress = AudioObjectPropertyAddress(
+            mSelector: senderRatesSelector,
+            mScope: kAudioObjectPropertyScopeGlobal,
+            mElement: kAudioObjectPropertyElementMain
+        )
+        
+        // sequence(4) + historyCount(4) + 3 windows x 40 + 60 seconds x 24
+        let windowSize = 40
+        let secondSize = 24
+        let byteCount = 8 + 3 * windowSize + 60 * secondSize
+        var raw = [UInt8](repeating: 0, count: byteCount)
+        var dataSize = UInt32(byteCount)
+        
+        let status = AudioObjectGetPropertyData(device, &propertyAddress, 0, nil, &dataSize, &raw)
+        guard status == noErr, Int(dataSize) == byteCount else {
+            cachedDeviceID = nil
+            return nil
+        }
+        
+        return raw.withUnsafeBytes { ptr -> DriverSenderRates in
+            let historyCount = min(Int(ptr.load(fromByteOffset: 4, as: UInt32.self)), 60)
+            let windows = (0..<3).map { index -> DriverRateWindow in
+                let base = 8 + index * windowSize
+                func float(_ field: Int) -> Float { ptr.load(fromByteOffset: base + field * 4, as: Float.self) }
+                return DriverRateWindow(
+                    seconds: ptr.load(fromByteOffset: base, as: UInt32.self),
+                    packetsPerSecond: float(1),
+                    bitsPerSecond: float(2),
+                    lossPercent: float(3),
+                    framesDroppedPerSecond: float(4),
+                    wouldBlockPerSecond: float(5),
+                    meanSendLatencyMicros: float(6),
+                    maxSendLatencyMicros: float(7),
+                    meanFillFrames: float(8),
+                    maxFillFrames: ptr.load(fromByteOffset: base + 36, as: UInt32.self)
+                )
+            }
+            let history = (0..<historyCount).map { index -> DriverRateSecond in
+                let base = 8 + 3 * windowSize + index * secondSize
+                func word(_ field: Int) -> UInt32 { ptr.load(fromByteOffset: base + field * 4, as: UInt32.self) }
+                return DriverRateSecond(
+                    packetsSent: word(0),
+                    packetsDropped: word(1),
+                    framesDropped: word(2),
+                    wouldBlock: word(3),
+                    maxSendLatencyMicros: ptr.load(fromByteOffset: base + 16, as: Float.self),
+                    maxFillFrames: word(5)
+                )
+            }
+            return DriverSenderRates(
+                sequence: ptr.load(fromByteOffset: 0, as: UInt32.self),
+                windows: windows,
+                history: history
+            )
+        }
+    }
+    
+    // MARK: - Recording
+    
+    /// Record the driver's output to a new file (".caf" for CAF, else WAV)
+    /// The driver only takes a file name, and creates it in its output
+    /// directory (/Users/Shared/CymaxPhoneOut); it never overwrites a file.
+    /// Recording stops when the device stops IO.
+    @discardableResult
+    func startRecording(named name: String) -> Bool {
+        var bytes = [UInt8](repeating: 0, count: recordingPathSize)
+        let utf8 = Array(name.utf8.prefix(recordingPathSize - 1))
+        bytes.replaceSubrange(0..<utf8.count, with: utf8)
+        let ok = setPathProperty(recordingPathSelector, bytes)
+        log(ok ? "✓ Recording to \(name)" : "⚠ Failed to start recording to \(name)")
+        return ok
+    }
+    
+    /// Stop recording and finalize the file
+    func stopRecording() {
+        _ = setPathProperty(recordingPathSelector, [UInt8](repeating: 0, count: recordingPathSize))
+    }
+    
+    /// Save the last five minutes of driver output (instant replay)
+    /// Same naming rules as startRecording(named:); the file is written in
+    /// the background and can be saved while the device is stopped.
+    @discardableResult
+    func saveReplay(named name: String) -> Bool {
+        var bytes = [UInt8](repeating: 0, count: recordingPathSize)
+        let utf8 = Array(name.utf8.prefix(recordingPathSize - 1))
+        bytes.replaceSubrange(0..<utf8.count, with: utf8)
+        let ok = setPathProperty(replaySavePathSelector, bytes)
+        log(ok ? "✓ Saving replay to \(name)" : "⚠ Failed to save replay to \(name)")
+        return ok
+    }
+    
+    private func setPathProperty(_ selector: AudioObjectPropertySelector, _ bytes: [UInt8]) -> Bool {
+        guard let device = cachedDeviceID ?? findDevice() else { return false }
+        cachedDeviceID = device
+        
+        var propertyAddress = AudioObjectPropertyAddress(
+            mSelector: selector,
+            mScope: kAudioObjectPropertyScopeGlobal,
+            mElement: kAudioObjectPropertyElementMain
+        )
+        var data = bytes
+        let status = AudioObjectSetPropertyData(device, &propertyAddress, 0, nil, UInt32(data.count), &data)
+        return status == noErr
+    }
+    
+    // MARK: - Spectrum
+    
+    /// Read the latest spectrum band levels (dB re full-scale sine,
+    /// log-spaced 20 Hz - 20 kHz) from the driver's shared page
+    func getSpectrum() -> [Float]? {
+        if spectrumPage == nil {
+            let fd = open(spectrumPagePath, O_RDONLY | O_NOFOLLOW)
+            guard fd >= 0 else { return nil }
+            defer { close(fd) }
+            var info = stat()
+            guard fstat(fd, &info) == 0, info.st_size >= off_t(spectrumPageSize) else { return nil }
+            let mapped = mmap(nil, spectrumPageSize, PROT_READ, MAP_SHARED, fd, 0)
+            guard let mapped = mapped, mapped != MAP_FAILED else { return nil }
+            spectrumPage = UnsafeRawPointer(mapped)
+        }
+        guard let page = spectrumPage,
+              page.load(fromByteOffset: 0, as: UInt32.self) == 0x43535043 else { return nil }
+        
+        let bandCount = min(Int(page.load(fromByteOffset: 12, as: UInt32.self)), 64)
+        let sequence = page.advanced(by: 8).assumingMemoryBound(to: UInt32.self)
+        
+        // Seqlock: retry while the driver is mid-write
+        for _ in 0..<4 {
+            let before = UnsafePointer(sequence).pointee
+            guard before & 1 == 0 else { continue }
+            OSMemoryBarrier()
+            let bands = (0..<bandCount).map { page.load(fromByteOffset: 32 + $0 * 4, as: Float.self) }
+            OSMemoryBarrier()
+            if UnsafePointer(sequence).pointee == before {
+                return bands
+            }
+        }
+        return nil
+    }
+    
     // MARK: - Driver Property Access
     
     /// Find the Cymax Phone Out device
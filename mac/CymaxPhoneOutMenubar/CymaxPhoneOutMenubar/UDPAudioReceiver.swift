@@ -19,7 +19,12 @@ struct AudioPacket {
     /// Parse from raw UDP data
     static func parse(from data: Data) -> AudioPacket? {
         // Header: seq(4) + timestamp(4) + sampleRate(4) + channels(2) + frameCount(2) + format(2) + reserved(10) = 28 bytes
-        guard data.count >= 28 else { return nil }
+        // Header-only packets are DTX keepalives sent while muted; no audio to forward
+        guard data.count > 28 else { return nil }
+        
+        // Spectrum side-channel (0x0002) and FEC parity (0x0004) packets carry no audio
+        let flags = data.withUnsafeBytes { $0.load(fromByteOffset: 26, as: UInt16.self) }
+        guard flags & (0x0002 | 0x0004) == 0 else { return nil }
         
         let sequence = data.withUnsafeBytes { $0.load(fromByteOffset: 0, as: UInt32.self) }
         let timestamp = data.withUnsafeBytes { $0.load(fromByteOffset: 4, as: UInt32.self) }
@@ -15,7 +15,7 @@
 //  │ 20     │ 2    │ channels    │ Number of channels              │
 //  │ 22     │ 2    │ frameCount  │ Number of frames in packet      │
 //  │ 24     │ 2    │ format      │ Sample format (1=f32, 2=i16)    │
-//  │ 26     │ 2    │ flags       │ Reserved flags                  │
+//  │ 26     │ 2    │ flags       │ Packet flags (CymaxPacketFlags) │
 //  │ 28     │ N    │ audioData   │ Interleaved audio samples       │
 //  └──────────────────────────────────────────────────────────────┘
 //
@@ -25,6 +25,24 @@ import Foundation
 /// Magic bytes identifying a Cymax audio packet: "CMAX"
 public let CymaxAudioPacketMagic: UInt32 = 0x584D4143  // 'XMAC' in little-endian = 'CMAX'
 
+/// Header flag bits
+public enum CymaxPacketFlags {
+    /// Discontinuous transmission: header-only keepalive sent while the
+    /// device is muted. frameCount is the silence it stands in for and
+    /// there is no audio data.
+    public static let dtx: UInt16 = 0x0001
+    
+    /// Spectrum side-channel packet (opt-in on the driver): frameCount is 0
+    /// and the payload is one byte per log-spaced band, 0 = -120 dB,
+    /// 255 = 0 dB. Does not consume a sequence number.
+    public static let spectrum: UInt16 = 0x0002
+    
+    /// FEC parity packet (opt-in on the driver): the payload is the XOR of
+    /// the payloads of frameCount consecutive audio packets starting at
+    /// sequence. Does not consume a sequence number.
+    public static let fecParity: UInt16 = 0x0004
+}
+
 /// Audio packet header - 28 bytes total
 /// This struct is designed for direct memory mapping from network bytes
 @frozen
@@ -50,7 +68,7 @@ public struct CymaxAudioPacketHeader: Sendable {
     /// Sample format (CymaxSampleFormat raw value)
     public var format: UInt16
     
-    /// Reserved flags for future use
+    /// Packet flags (CymaxPacketFlags)
     public var flags: UInt16
     
     /// Header size in bytes
@@ -85,9 +103,24 @@ public struct CymaxAudioPacketHeader: Sendable {
         return CymaxSampleFormat(rawValue: format)
     }
     
+    /// Whether this is a DTX keepalive carrying no audio
+    public var isDTX: Bool {
+        return flags & CymaxPacketFlags.dtx != 0
+    }
+    
+    /// Whether this is a spectrum side-channel packet
+    public var isSpectrum: Bool {
+        return flags & CymaxPacketFlags.spectrum != 0
+    }
+    
+    /// Whether this is an FEC parity packet
+    public var isFECParity: Bool {
+        return flags & CymaxPacketFlags.fecParity != 0
+    }
+    
     /// Calculate expected audio data size in bytes
     public var audioDataSize: Int {
-        guard let fmt = sampleFormat else { return 0 }
+        guard !isDTX, !isSpectrum, !isFECParity, let fmt = sampleFormat else { return 0 }
         return Int(frameCount) * Int(channels) * fmt.bytesPerSample
     }
     
@@ -0,0 +1,170 @@
+//
+//  Negotiation.swift
+//  CymaxAudioProtocol
+//
+//  UDP capability negotiation between the driver's sender and receivers
+//
+//  The driver sends a Query to the audio port when a session starts. A
+//  receiver answers, from the same port, with the Capabilities it can play.
+//  The driver picks the cheapest profile all of its destinations share and
+//  announces it with a Select. The audio packet headers then carry that
+//  format. A receiver that has restarted or lost sync can send Capabilities
+//  with round 0 at any time to ask for a new round.
+//
+//  Receivers that never answer keep getting the driver's configured
+//  profile. Every message starts with a 12-byte header:
+//  ┌──────────────────────────────────────────────────────────────┐
+//  │ Offset │ Size │ Field       │ Description                    │
+//  ├──────────────────────────────────────────────────────────────┤
+//  │ 0      │ 4    │ magic       │ 'CNEG' (0x43 0x4E 0x45 0x47)   │
+//  │ 4      │ 2    │ version     │ 1                              │
+//  │ 6      │ 2    │ type        │ CymaxNegotiationMessage        │
+//  │ 8      │ 4    │ round       │ Echoed in Capabilities         │
+//  └──────────────────────────────────────────────────────────────┘
+//  Mirrors CapabilityNegotiation.hpp in the driver. All fields are
+//  little-endian.
+//
+
+import Foundation
+
+/// Magic bytes identifying a negotiation message: "CNEG"
+public let CymaxNegotiationMagic: UInt32 = 0x47454E43
+
+/// Negotiation protocol version
+public let CymaxNegotiationVersion: UInt16 = 1
+
+/// Negotiation message types
+public enum CymaxNegotiationMessage: UInt16, Sendable {
+    /// Driver -> receiver: CymaxStreamDescription of the default profile
+    case query = 1
+    /// Receiver -> driver: CymaxReceiverCapabilities
+    case capabilities = 2
+    /// Driver -> receiver: CymaxStreamDescription of the chosen profile
+    case select = 3
+}
+
+/// Payload codecs (the driver sends PCM only)
+public enum CymaxCodec: UInt16, Sendable {
+    case pcm = 0
+}
+
+/// Negotiation message header - 12 bytes
+public struct CymaxNegotiationHeader: Sendable {
+    public static let size = 12
+
+    public var type: CymaxNegotiationMessage
+    public var round: UInt32
+
+    public init(type: CymaxNegotiationMessage, round: UInt32) {
+        self.type = type
+        self.round = round
+    }
+
+    /// Parse a header (nil if this isn't a negotiation message)
+    public static func fromBytes(_ data: Data) -> CymaxNegotiationHeader? {
+        guard data.count >= size else { return nil }
+        return data.withUnsafeBytes { buffer -> CymaxNegotiationHeader? in
+            let ptr = buffer.baseAddress!
+            guard ptr.load(fromByteOffset: 0, as: UInt32.self).littleEndian == CymaxNegotiationMagic,
+                  ptr.load(fromByteOffset: 4, as: UInt16.self).littleEndian >= CymaxNegotiationVersion,
+                  let type = CymaxNegotiationMessage(
+                      rawValue: ptr.load(fromByteOffset: 6, as: UInt16.self).littleEndian) else {
+                return nil
+            }
+            let round = ptr.load(fromByteOffset: 8, as: UInt32.self).littleEndian
+            return CymaxNegotiationHeader(type: type, round: round)
+        }
+    }
+
+    /// Serialize header to bytes (little-endian)
+    public func toBytes() -> Data {
+        var data = Data(capacity: Self.size)
+        withUnsafeBytes(of: CymaxNegotiationMagic.littleEndian) { data.append(contentsOf: $0) }
+        withUnsafeBytes(of: CymaxNegotiationVersion.littleEndian) { data.append(contentsOf: $0) }
+        withUnsafeBytes(of: type.rawValue.littleEndian) { data.append(contentsOf: $0) }
+        withUnsafeBytes(of: round.littleEndian) { data.append(contentsOf: $0) }
+        return data
+    }
+}
+
+/// A stream as the driver will send it (Query and Select payload) - 16 bytes
+public struct CymaxStreamDescription: Sendable {
+    public static let size = 16
+
+    public var sampleRate: UInt32
+    public var channels: UInt16
+    public var format: UInt16           // CymaxSampleFormat raw value
+    public var codec: UInt16            // CymaxCodec raw value
+    public var framesPerPacket: UInt16
+    public var fecGroupSize: UInt16     // Audio packets per parity packet (0 = none)
+    public var bufferMs: UInt16         // Receiver's preferred depth (Select only)
+
+    /// Parse the payload that follows a negotiation header
+    public static func fromBytes(_ data: Data) -> CymaxStreamDescription? {
+        guard data.count >= size else { return nil }
+        return data.withUnsafeBytes { buffer -> CymaxStreamDescription in
+            let ptr = buffer.baseAddress!
+            return CymaxStreamDescription(
+                sampleRate: ptr.load(fromByteOffset: 0, as: UInt32.self).littleEndian,
+                channels: ptr.load(fromByteOffset: 4, as: UInt16.self).littleEndian,
+                format: ptr.load(fromByteOffset: 6, as: UInt16.self).littleEndian,
+                codec: ptr.load(fromByteOffset: 8, as: UInt16.self).littleEndian,
+                framesPerPacket: ptr.load(fromByteOffset: 10, as: UInt16.self).littleEndian,
+                fecGroupSize: ptr.load(fromByteOffset: 12, as: UInt16.self).littleEndian,
+                bufferMs: ptr.load(fromByteOffset: 14, as: UInt16.self).littleEndian
+            )
+        }
+    }
+}
+
+/// What a receiver can play (Capabilities payload) - 44 bytes
+public struct CymaxReceiverCapabilities: Sendable {
+    public static let size = 44
+    public static let maxSampleRates = 8
+
+    /// Sample rates played (at most 8; empty = any)
+    public var sampleRates: [UInt32]
+    public var maxChannels: UInt16
+    public var formats: [CymaxSampleFormat]
+    public var codecs: [CymaxCodec]
+    /// Largest datagram accepted, header included
+    public var maxPacketBytes: UInt16
+    /// Largest FEC parity group decoded (0 = no FEC)
+    public var maxFECGroup: UInt16
+    /// Preferred jitter buffer depth
+    public var bufferMs: UInt16
+
+    public init(
+        sampleRates: [UInt32],
+        maxChannels: UInt16 = 2,
+        formats: [CymaxSampleFormat],
+        codecs: [CymaxCodec] = [.pcm],
+        maxPacketBytes: UInt16 = UInt16(CymaxNetwork.maxUDPPayload),
+        maxFECGroup: UInt16 = 0,
+        bufferMs: UInt16
+    ) {
+        self.sampleRates = sampleRates
+        self.maxChannels = maxChannels
+        self.formats = formats
+        self.codecs = codecs
+        self.maxPacketBytes = maxPacketBytes
+        self.maxFECGroup = maxFECGroup
+        self.bufferMs = bufferMs
+    }
+
+    /// Serialize as a complete Capabilities message
+    /// - Parameter round: The Query's round, or 0 to ask for a new round
+    public func message(round: UInt32) -> Data {
+        var data = CymaxNegotiationHeader(type: .capabilities, round: round).toBytes()
+        for i in 0..<Self.maxSampleRates {
+            let rate: UInt32 = i < sampleRates.count ? sampleRates[i] : 0
+            withUnsafeBytes(of: rate.littleEndian) { data.append(contentsOf: $0) }
+        }
+        let formatBits = formats.reduce(UInt16(0)) { $0 | (1 << $1.rawValue) }
+        let codecBits = codecs.reduce(UInt16(0)) { $0 | (1 << $1.rawValue) }
+        for value in [maxChannels, formatBits, codecBits, maxPacketBytes, maxFECGroup, bufferMs] {
+            withUnsafeBytes(of: value.littleEndian) { data.append(contentsOf: $0) }
+        }
+        return data
+    }
+}
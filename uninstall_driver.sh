@@ -8,6 +8,7 @@ set -e
 
 DRIVER_NAME="CymaxPhoneOutDriver.driver"
 DRIVER_PATH="/Library/Audio/Plug-Ins/HAL/$DRIVER_NAME"
+SHARED_DIR="/Users/Shared/CymaxPhoneOutShared"
 
 # Colors
 RED='\033[0;31m'
@@ -36,7 +37,7 @@ fi
 
 # Remove driver
 echo "Removing driver from $DRIVER_PATH..."
-rm -rf "$DRIVER_PATH"
+rm -rf "$DRIVER_PATH" "$SHARED_DIR"
 
 # Restart coreaudiod
 echo ""